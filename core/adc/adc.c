@@ -7,9 +7,17 @@
 	
     @section Description
 	
-    SW-based single-channel A/D conversion.  If you wish to convert
-    multiple ADC channels simultaneously, this code will need to be
-    modified to work in BURST mode.
+    SW-based single-channel A/D conversion, and interrupt-driven
+    continuous acquisition on several channels at once.
+
+    adcRead and adcReadSingle start one conversion and wait for the
+    results, so the sample rate depends on how often they are called.
+    For a fixed sample rate, give each channel a ring buffer with
+    adcContinuousSetBuffer and call adcContinuousStart.  Conversions
+    are then started by the ADC in BURST mode or by a timer match, and
+    the ADC interrupt stores the results (optionally oversampled and
+    decimated) in the ring buffers, where they can be collected with
+    adcContinuousRead.
 
     @section Example
 
@@ -31,6 +39,25 @@
     }
     @endcode
 
+    @code
+    // Sample AD0 and AD1 at 10kHz each, and store 12-bit results
+    // (4 samples per result) at 2.5kHz
+    static uint16_t ad0Buffer[64], ad1Buffer[64];
+    uint16_t samples[16];
+    uint16_t count;
+
+    adcInit();
+    adcContinuousSetBuffer(0, ad0Buffer, 64);
+    adcContinuousSetBuffer(1, ad1Buffer, 64);
+    adcContinuousStart(ADC_AD0CR_SEL_AD0 | ADC_AD0CR_SEL_AD1, ADC_TRIGGER_CT16B0, 10000, 1);
+
+    while(1)
+    {
+      count = adcContinuousRead(0, samples, 16);
+      ...
+    }
+    @endcode
+
     @section LICENSE
 
     Software License Agreement (BSD License)
@@ -68,6 +95,31 @@
 static bool _adcInitialised = false;
 static uint8_t _adcLastChannel = 0;
 
+/* Data register for the specified channel (0..7) */
+#define ADC_DR(channelNum)    (*(pREG32(ADC_AD0DR0 + ((channelNum) << 2))))
+
+/* Ring buffer and oversampling state for one channel */
+typedef struct
+{
+  uint16_t *          buffer;
+  uint16_t            length;
+  volatile uint16_t   head;           // Written by the ADC interrupt
+  volatile uint16_t   tail;           // Written by adcContinuousRead
+  uint16_t            last;           // Latest 10-bit conversion result
+  uint16_t            accumulated;    // Conversions in accumulator
+  uint32_t            accumulator;
+  volatile uint32_t   overruns;
+} adcChannel_t;
+
+static adcChannel_t _adcChannels[8];
+static volatile bool _adcContinuous = false;
+static adcTrigger_e _adcTrigger = ADC_TRIGGER_BURST;
+static uint8_t _adcMask = 0;
+static uint8_t _adcCurrentChannel = 0;
+static uint8_t _adcExtraBits = 0;
+static uint16_t _adcDecimation = 1;
+static uint32_t _adcRate = 0;
+
 /**************************************************************************/
 /*! 
     @brief Returns the conversion results on the specified ADC channel.
@@ -81,7 +133,9 @@ static uint8_t _adcLastChannel = 0;
                 configured by default in adcInit.)
 
     @return     0 if an overrun error occured, otherwise a 10-bit value
-                containing the A/D conversion results.
+                containing the A/D conversion results.  During continuous
+                acquisition the latest results for the channel are
+                returned instead (or 0 if it isn't being sampled).
     @warning    Only AD channels 0..3 are configured for A/D in adcInit.
                 If you wish to use A/D pins 4..7 they will also need to
                 be added to the adcInit function.
@@ -100,6 +154,12 @@ uint32_t adcReadSingle (uint8_t channelNum)
     channelNum = 0;
   }
 
+  /* Don't disturb continuous acquisition, return the latest results instead */
+  if (_adcContinuous)
+  {
+    return (_adcMask & (1 << channelNum)) ? _adcChannels[channelNum].last : 0;
+  }
+
   /* Deselect all channels */
   ADC_AD0CR &= ~ADC_AD0CR_SEL_MASK;
 
@@ -107,46 +167,10 @@ uint32_t adcReadSingle (uint8_t channelNum)
   ADC_AD0CR |= ADC_AD0CR_START_STARTNOW | (1 << channelNum);
 				
   /* wait until end of A/D convert */
-  while ( 1 )			
+  do
   {
-    // Get data register results for the requested channel
-    switch (channelNum)
-    {
-      case 0:
-        regVal = (*(pREG32(ADC_AD0DR0)));
-        break;
-      case 1:
-        regVal = (*(pREG32(ADC_AD0DR1)));
-        break;
-      case 2:
-        regVal = (*(pREG32(ADC_AD0DR2)));
-        break;
-      case 3:
-        regVal = (*(pREG32(ADC_AD0DR3)));
-        break;
-      case 4:
-        regVal = (*(pREG32(ADC_AD0DR4)));
-        break;
-      case 5:
-        regVal = (*(pREG32(ADC_AD0DR5)));
-        break;
-      case 6:
-        regVal = (*(pREG32(ADC_AD0DR6)));
-        break;
-      case 7:
-        regVal = (*(pREG32(ADC_AD0DR7)));
-        break;
-      default:
-        regVal = (*(pREG32(ADC_AD0DR0)));
-        break;
-    }
-
-    /* read result of A/D conversion */
-    if (regVal & ADC_DR_DONE)
-    {
-      break;
-    }
-  }
+    regVal = ADC_DR(channelNum);
+  } while (!(regVal & ADC_DR_DONE));
 
   /* stop ADC */
   ADC_AD0CR &= ~ADC_AD0CR_START_MASK;
@@ -290,6 +314,9 @@ void adcInit (void)
   IOCON_JTAG_nTRST_PIO1_2 |=  (IOCON_JTAG_nTRST_PIO1_2_FUNC_AD3 &
                                IOCON_JTAG_nTRST_PIO1_2_ADMODE_ANALOG);
 
+  /* Leave the ADC alone if continuous acquisition is running */
+  if (_adcContinuous) return;
+
   /* Note that in SW mode only one channel can be selected at a time (AD0 in this case)
      To select multiple channels, ADC_AD0CR_BURST_HWSCANMODE must be used */
   ADC_AD0CR = (ADC_AD0CR_SEL_AD0 |                     /* SEL=1,select channel 0 on ADC0 */
@@ -307,3 +334,408 @@ void adcInit (void)
 
   return;
 }
+
+/**************************************************************************/
+/*! 
+    @brief      Stores a conversion result for the specified channel,
+                adding it to the ring buffer once enough samples have
+                been accumulated.
+*/
+/**************************************************************************/
+static void adcContinuousStore (uint8_t channelNum, uint32_t regVal)
+{
+  adcChannel_t *channel = &_adcChannels[channelNum];
+  uint16_t next;
+
+  channel->last = (regVal >> 6) & 0x3FF;
+
+  /* A result was overwritten before it could be read */
+  if (regVal & ADC_DR_OVERRUN)
+  {
+    channel->overruns++;
+  }
+
+  /* Oversample incrementally, so only one value per channel is kept */
+  channel->accumulator += channel->last;
+  if (++channel->accumulated < _adcDecimation)
+  {
+    return;
+  }
+
+  next = channel->head + 1;
+  if (next == channel->length)
+  {
+    next = 0;
+  }
+
+  /* Drop the results if the buffer is full */
+  if (next == channel->tail)
+  {
+    channel->overruns++;
+  }
+  else
+  {
+    channel->buffer[channel->head] = channel->accumulator >> _adcExtraBits;
+    channel->head = next;
+  }
+
+  channel->accumulator = 0;
+  channel->accumulated = 0;
+}
+
+/**************************************************************************/
+/*! 
+    @brief      ADC interrupt handler, used for continuous acquisition
+*/
+/**************************************************************************/
+void ADC_IRQHandler (void)
+{
+  uint32_t regVal;
+  uint8_t channelNum;
+
+  if (_adcTrigger == ADC_TRIGGER_BURST)
+  {
+    /* The interrupt is raised at the end of each scan, so all of the
+       selected channels have new results */
+    for (channelNum = 0; channelNum < 8; channelNum++)
+    {
+      if (_adcMask & (1 << channelNum))
+      {
+        adcContinuousStore(channelNum, ADC_DR(channelNum));
+      }
+    }
+  }
+  else
+  {
+    /* Only one channel is converted per timer period, so select the
+       next one before the next match */
+    channelNum = _adcCurrentChannel;
+    regVal = ADC_DR(channelNum);
+    do
+    {
+      _adcCurrentChannel = (_adcCurrentChannel + 1) & 7;
+    } while (!(_adcMask & (1 << _adcCurrentChannel)));
+    ADC_AD0CR = (ADC_AD0CR & ~ADC_AD0CR_SEL_MASK) | (1 << _adcCurrentChannel);
+    adcContinuousStore(channelNum, regVal);
+  }
+}
+
+/**************************************************************************/
+/*! 
+    @brief      Sets the ring buffer that continuous acquisition stores
+                results for the specified channel in.
+
+    @param[in]  channelNum
+                The A/D channel [0..7]
+    @param[in]  buffer
+                Buffer for the results, or 0 to remove the current one.
+                One entry is kept free to tell a full buffer from an
+                empty one.
+    @param[in]  bufferLength
+                Number of entries in buffer (at least 2)
+
+    @return     ADC_ERROR_OK, or ADC_ERROR_BUSY if the channel is being
+                sampled.
+*/
+/**************************************************************************/
+adcError_e adcContinuousSetBuffer (uint8_t channelNum, uint16_t *buffer, uint16_t bufferLength)
+{
+  adcChannel_t *channel;
+
+  if (channelNum >= 8) return ADC_ERROR_INVALIDCHANNEL;
+  if (buffer && (bufferLength < 2)) return ADC_ERROR_INVALIDPARAM;
+  if (_adcContinuous && (_adcMask & (1 << channelNum))) return ADC_ERROR_BUSY;
+
+  channel = &_adcChannels[channelNum];
+  channel->buffer = buffer;
+  channel->length = buffer ? bufferLength : 0;
+  channel->head = 0;
+  channel->tail = 0;
+
+  return ADC_ERROR_OK;
+}
+
+/**************************************************************************/
+/*! 
+    @brief      Starts continuous acquisition on one or more channels.
+
+    @param[in]  channelMask
+                The channels to sample (ADC_AD0CR_SEL_AD0, etc.).  Each
+                of them needs a buffer set with adcContinuousSetBuffer,
+                and channels 4..7 must be configured as analog inputs.
+    @param[in]  trigger
+                ADC_TRIGGER_BURST to let the ADC scan the channels by
+                itself, or ADC_TRIGGER_CT16B0/CT32B0 to start each
+                conversion with a timer match.  The timer is configured
+                here and can't be used for anything else until
+                adcContinuousStop is called.
+    @param[in]  sampleRate
+                Conversions per second on each channel.  With the timer
+                triggers the rate is exact (within one timer tick).  In
+                BURST mode it is set by dividing the system clock by
+                11 * number of channels * an 8-bit divider, so the
+                nearest higher rate is used, and 0 selects the fastest.
+                adcContinuousGetRate returns the actual rate.
+    @param[in]  extraBits
+                Extra bits of resolution from oversampling (0..6).
+                4^extraBits conversions are summed for each result, so
+                results are stored at sampleRate / 4^extraBits.
+
+    @return     ADC_ERROR_OK if the acquisition was started.
+*/
+/**************************************************************************/
+adcError_e adcContinuousStart (uint8_t channelMask, adcTrigger_e trigger, uint32_t sampleRate, uint8_t extraBits)
+{
+  uint32_t pclk, clkdiv, mindiv, ticks, prescale;
+  uint8_t channelNum, channels, lastChannel;
+
+  if (!_adcInitialised) adcInit();
+  if (_adcContinuous) return ADC_ERROR_BUSY;
+  if (!channelMask) return ADC_ERROR_INVALIDCHANNEL;
+  if ((trigger > ADC_TRIGGER_CT32B0) || (extraBits > ADC_MAXEXTRABITS)) return ADC_ERROR_INVALIDPARAM;
+  if (sampleRate > ADC_MAXCLOCK / 11) return ADC_ERROR_INVALIDRATE;
+
+  channels = 0;
+  lastChannel = 0;
+  for (channelNum = 0; channelNum < 8; channelNum++)
+  {
+    if (channelMask & (1 << channelNum))
+    {
+      if (!_adcChannels[channelNum].buffer) return ADC_ERROR_NOBUFFER;
+      channels++;
+      lastChannel = channelNum;
+    }
+  }
+
+  /* Fastest A/D clock divider */
+  pclk = CFG_CPU_CCLK / SCB_SYSAHBCLKDIV;
+  mindiv = (pclk + ADC_MAXCLOCK - 1) / ADC_MAXCLOCK;
+
+  if (trigger == ADC_TRIGGER_BURST)
+  {
+    clkdiv = sampleRate ? pclk / (sampleRate * 11 * channels) : mindiv;
+    if ((clkdiv < mindiv) || (clkdiv > 256)) return ADC_ERROR_INVALIDRATE;
+    _adcRate = pclk / clkdiv / 11 / channels;
+    ticks = 0;
+    prescale = 0;
+  }
+  else
+  {
+    /* Convert as quickly as possible after each match */
+    clkdiv = mindiv;
+    if (!sampleRate || (sampleRate * channels > pclk / clkdiv / 11)) return ADC_ERROR_INVALIDRATE;
+
+    /* MAT0 toggles on every match and the ADC starts on its rising
+       edge, so there are two matches per conversion */
+    ticks = pclk / (sampleRate * channels * 2);
+    prescale = (trigger == ADC_TRIGGER_CT16B0) ? (ticks - 1) / 0x10000 : 0;
+    ticks /= prescale + 1;
+    _adcRate = pclk / (ticks * (prescale + 1) * 2) / channels;
+  }
+
+  /* Reset the ring buffers and the oversampling state */
+  for (channelNum = 0; channelNum < 8; channelNum++)
+  {
+    _adcChannels[channelNum].head = 0;
+    _adcChannels[channelNum].tail = 0;
+    _adcChannels[channelNum].last = 0;
+    _adcChannels[channelNum].accumulated = 0;
+    _adcChannels[channelNum].accumulator = 0;
+    _adcChannels[channelNum].overruns = 0;
+  }
+
+  _adcTrigger = trigger;
+  _adcMask = channelMask;
+  _adcExtraBits = extraBits;
+  _adcDecimation = 1 << (extraBits * 2);
+  _adcContinuous = true;
+
+  /* Clear any old results */
+  for (channelNum = 0; channelNum < 8; channelNum++)
+  {
+    (void)ADC_DR(channelNum);
+  }
+
+  if (trigger == ADC_TRIGGER_BURST)
+  {
+    /* Scan the selected channels continuously, interrupting when the
+       last one is done (START must be 0 in BURST mode) */
+    ADC_AD0CR = (channelMask |
+                ((clkdiv - 1) << 8) |
+                ADC_AD0CR_BURST_HWSCANMODE |
+                ADC_AD0CR_CLKS_10BITS |
+                ADC_AD0CR_START_NOSTART);
+    *(pREG32(ADC_AD0INTEN)) = (1 << lastChannel);
+    NVIC_EnableIRQ(ADC_IRQn);
+  }
+  else
+  {
+    /* Start with the lowest channel, and interrupt after every conversion */
+    for (channelNum = 0; !(channelMask & (1 << channelNum)); channelNum++);
+    _adcCurrentChannel = channelNum;
+    ADC_AD0CR = ((1 << channelNum) |
+                ((clkdiv - 1) << 8) |
+                ADC_AD0CR_BURST_SWMODE |
+                ADC_AD0CR_CLKS_10BITS |
+                (trigger == ADC_TRIGGER_CT16B0 ? ADC_AD0CR_START_CT16B0_MAT0 : ADC_AD0CR_START_CT32B0_MAT0) |
+                ADC_AD0CR_EDGE_RISING);
+    *(pREG32(ADC_AD0INTEN)) = channelMask;
+    NVIC_EnableIRQ(ADC_IRQn);
+
+    /* Toggle MAT0 and reset the counter on each match (no timer interrupt) */
+    if (trigger == ADC_TRIGGER_CT16B0)
+    {
+      SCB_SYSAHBCLKCTRL |= (SCB_SYSAHBCLKCTRL_CT16B0);
+      TMR_TMR16B0TCR = TMR_TMR16B0TCR_COUNTERRESET_ENABLED;
+      TMR_TMR16B0PR = prescale;
+      TMR_TMR16B0MR0 = ticks - 1;
+      TMR_TMR16B0MCR = TMR_TMR16B0MCR_MR0_RESET_ENABLED;
+      TMR_TMR16B0EMR = TMR_TMR16B0EMR_EMC0_TOGGLE;
+      TMR_TMR16B0TCR = TMR_TMR16B0TCR_COUNTERENABLE_ENABLED;
+    }
+    else
+    {
+      SCB_SYSAHBCLKCTRL |= (SCB_SYSAHBCLKCTRL_CT32B0);
+      TMR_TMR32B0TCR = TMR_TMR32B0TCR_COUNTERRESET_ENABLED;
+      TMR_TMR32B0PR = 0;
+      TMR_TMR32B0MR0 = ticks - 1;
+      TMR_TMR32B0MCR = TMR_TMR32B0MCR_MR0_RESET_ENABLED;
+      TMR_TMR32B0EMR = TMR_TMR32B0EMR_EMC0_TOGGLE;
+      TMR_TMR32B0TCR = TMR_TMR32B0TCR_COUNTERENABLE_ENABLED;
+    }
+  }
+
+  return ADC_ERROR_OK;
+}
+
+/**************************************************************************/
+/*! 
+    @brief      Stops continuous acquisition and returns the ADC to
+                SW-controlled conversions.  Results already in the ring
+                buffers can still be read.
+*/
+/**************************************************************************/
+void adcContinuousStop (void)
+{
+  if (!_adcContinuous) return;
+
+  NVIC_DisableIRQ(ADC_IRQn);
+  *(pREG32(ADC_AD0INTEN)) = 0;
+
+  if (_adcTrigger == ADC_TRIGGER_CT16B0)
+  {
+    TMR_TMR16B0TCR = TMR_TMR16B0TCR_COUNTERENABLE_DISABLED;
+    TMR_TMR16B0MCR = 0;
+    TMR_TMR16B0EMR = 0;
+  }
+  else if (_adcTrigger == ADC_TRIGGER_CT32B0)
+  {
+    TMR_TMR32B0TCR = TMR_TMR32B0TCR_COUNTERENABLE_DISABLED;
+    TMR_TMR32B0MCR = 0;
+    TMR_TMR32B0EMR = 0;
+  }
+
+  _adcContinuous = false;
+
+  /* Same settings as adcInit */
+  ADC_AD0CR = (ADC_AD0CR_SEL_AD0 |
+              (((CFG_CPU_CCLK / SCB_SYSAHBCLKDIV) / 1000000 - 1 ) << 8) |
+              ADC_AD0CR_BURST_SWMODE |
+              ADC_AD0CR_CLKS_10BITS |
+              ADC_AD0CR_START_NOSTART |
+              ADC_AD0CR_EDGE_RISING);
+  _adcLastChannel = 0;
+}
+
+/**************************************************************************/
+/*! 
+    @brief      Returns true if continuous acquisition is running
+*/
+/**************************************************************************/
+bool adcContinuousRunning (void)
+{
+  return _adcContinuous;
+}
+
+/**************************************************************************/
+/*! 
+    @brief      Returns the actual number of conversions per second on
+                each channel set by the last call to adcContinuousStart
+                (before decimation).
+*/
+/**************************************************************************/
+uint32_t adcContinuousGetRate (void)
+{
+  return _adcRate;
+}
+
+/**************************************************************************/
+/*! 
+    @brief      Returns the number of results waiting in the ring buffer
+                for the specified channel
+*/
+/**************************************************************************/
+uint16_t adcContinuousAvailable (uint8_t channelNum)
+{
+  adcChannel_t *channel;
+  uint16_t head;
+
+  if (channelNum >= 8) return 0;
+
+  channel = &_adcChannels[channelNum];
+  head = channel->head;
+  return head >= channel->tail ? head - channel->tail : head + channel->length - channel->tail;
+}
+
+/**************************************************************************/
+/*! 
+    @brief      Removes up to 'count' results (oldest first) from the
+                ring buffer for the specified channel.  This can be
+                called while the acquisition is running.
+
+    @param[in]  channelNum
+                The A/D channel [0..7]
+    @param[out] samples
+                Buffer for the results
+    @param[in]  count
+                Size of samples
+
+    @return     The number of results copied to samples
+*/
+/**************************************************************************/
+uint16_t adcContinuousRead (uint8_t channelNum, uint16_t *samples, uint16_t count)
+{
+  adcChannel_t *channel;
+  uint16_t tail, read;
+
+  if ((channelNum >= 8) || !samples) return 0;
+
+  channel = &_adcChannels[channelNum];
+  tail = channel->tail;
+  for (read = 0; (read < count) && (tail != channel->head); read++)
+  {
+    samples[read] = channel->buffer[tail];
+    if (++tail == channel->length)
+    {
+      tail = 0;
+    }
+  }
+  channel->tail = tail;
+
+  return read;
+}
+
+/**************************************************************************/
+/*! 
+    @brief      Returns the number of conversions lost on the specified
+                channel, either because the results were overwritten
+                before the interrupt could read them or because the
+                ring buffer was full.
+*/
+/**************************************************************************/
+uint32_t adcContinuousGetOverruns (uint8_t channelNum)
+{
+  if (channelNum >= 8) return 0;
+
+  return _adcChannels[channelNum].overruns;
+}
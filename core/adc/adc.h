@@ -41,9 +41,50 @@
 
 #include "projectconfig.h"
 
+#define ADC_MAXCLOCK              (4500000)   // Maximum A/D clock (4.5MHz, 11 clocks per conversion)
+#define ADC_MAXEXTRABITS          (6)         // 4^6 samples per oversampled result (16-bit results)
+
+typedef enum
+{
+  ADC_ERROR_OK = 0,                           // Everything executed normally
+  ADC_ERROR_INVALIDCHANNEL,                   // Channel number > 7 or an empty channel mask
+  ADC_ERROR_NOBUFFER,                         // A selected channel has no ring buffer
+  ADC_ERROR_INVALIDRATE,                      // Sample rate can't be reached with this trigger
+  ADC_ERROR_INVALIDPARAM,                     // Unknown trigger or too many extra bits
+  ADC_ERROR_BUSY,                             // Continuous acquisition is already running
+  ADC_ERROR_LAST
+}
+adcError_e;
+
+/**************************************************************************/
+/*!
+    Starts conversions during continuous acquisition.  In BURST mode the
+    ADC scans the selected channels back to back, and the rate is set by
+    the A/D clock divider.  The timer triggers use MAT0 on the specified
+    timer (which is then unavailable for anything else) to start one
+    conversion per period, giving an exact rate.
+*/
+/**************************************************************************/
+typedef enum
+{
+  ADC_TRIGGER_BURST = 0,                      // Hardware scan mode
+  ADC_TRIGGER_CT16B0,                         // One conversion per CT16B0 MAT0 period
+  ADC_TRIGGER_CT32B0                          // One conversion per CT32B0 MAT0 period
+}
+adcTrigger_e;
+
 uint32_t   adcRead (uint8_t channelNum);
 uint32_t   adcReadOversampled (uint8_t channelNum, uint8_t extraBits);
 uint32_t   adcReadSingle(uint8_t channelNum);
 void       adcInit (void);
 
+adcError_e adcContinuousSetBuffer (uint8_t channelNum, uint16_t *buffer, uint16_t bufferLength);
+adcError_e adcContinuousStart (uint8_t channelMask, adcTrigger_e trigger, uint32_t sampleRate, uint8_t extraBits);
+void       adcContinuousStop (void);
+bool       adcContinuousRunning (void);
+uint32_t   adcContinuousGetRate (void);
+uint16_t   adcContinuousAvailable (uint8_t channelNum);
+uint16_t   adcContinuousRead (uint8_t channelNum, uint16_t *samples, uint16_t count);
+uint32_t   adcContinuousGetOverruns (uint8_t channelNum);
+
 #endif
@@ -59,9 +59,57 @@
   #include "core/gpio/gpio.h"
 #endif
 
+#ifdef CFG_INTERFACE_STATS
+  #include "core/systick/systick.h"
+#endif
+
 static uint8_t msg[CFG_INTERFACE_MAXMSGSIZE];
 static uint8_t *msg_ptr;
 
+#ifdef CFG_INTERFACE_STATS
+#define CMD_STATS_BUCKETS   (4)     // Execution times <1ms, <10ms, <100ms and >=100ms
+
+typedef struct
+{
+  uint32_t count;
+  uint32_t maxUs;
+  uint64_t totalUs;
+  uint32_t bytes;                   // Bytes sent by the handler
+  uint16_t histogram[CMD_STATS_BUCKETS];
+} cmdStats_t;
+
+static cmdStats_t cmdStats[CMD_COUNT];
+volatile uint32_t cmdOutputBytes = 0;
+
+/**************************************************************************/
+/*! 
+    @brief  Adds one execution of a command to its statistics
+*/
+/**************************************************************************/
+static void cmdStatsRecord(size_t index, uint32_t us, uint32_t bytes)
+{
+  cmdStats_t *stats = &cmdStats[index];
+  uint32_t bucket, limit;
+
+  stats->count++;
+  stats->totalUs += us;
+  stats->bytes += bytes;
+  if (us > stats->maxUs)
+  {
+    stats->maxUs = us;
+  }
+
+  for (bucket = 0, limit = 1000; bucket < CMD_STATS_BUCKETS - 1 && us >= limit; bucket++)
+  {
+    limit *= 10;
+  }
+  if (stats->histogram[bucket] != 0xFFFF)
+  {
+    stats->histogram[bucket]++;
+  }
+}
+#endif
+
 /**************************************************************************/
 /*! 
     @brief  Polls the relevant incoming message queue to see if anything
@@ -164,6 +212,9 @@ void cmdParse(char *cmd)
 {
   size_t argc, i = 0;
   char *argv[30];
+  #ifdef CFG_INTERFACE_STATS
+  uint32_t startUs, startBytes;
+  #endif
 
   argv[i] = strtok(cmd, " ");
   do
@@ -208,8 +259,15 @@ void cmdParse(char *cmd)
           // Set the IRQ pin high at start of a command
           gpioSetValue(CFG_INTERFACE_IRQPORT, CFG_INTERFACE_IRQPIN, 1);
           #endif
+          #ifdef CFG_INTERFACE_STATS
+          startUs = systickGetMicroseconds();
+          startBytes = cmdOutputBytes;
+          #endif
           // Dispatch command to the appropriate function
           cmd_tbl[i].func(argc - 1, &argv [1]);
+          #ifdef CFG_INTERFACE_STATS
+          cmdStatsRecord(i, systickGetMicroseconds() - startUs, cmdOutputBytes - startBytes);
+          #endif
           #if CFG_INTERFACE_ENABLEIRQ  != 0
           // Set the IRQ pin low to signal the end of a command
           gpioSetValue(CFG_INTERFACE_IRQPORT, CFG_INTERFACE_IRQPIN, 0);
@@ -293,3 +351,50 @@ void cmd_help(uint8_t argc, char **argv)
 
   printf("%sCommand parameters can be seen by entering: <command-name> ?%s", CFG_PRINTF_NEWLINE, CFG_PRINTF_NEWLINE);
 }
+
+#ifdef CFG_INTERFACE_STATS
+/**************************************************************************/
+/*! 
+    'stats' command handler.  Shows how often each command ran, how long
+    it took and how many bytes it sent.  'stats r' clears the counters.
+*/
+/**************************************************************************/
+void cmd_stats(uint8_t argc, char **argv)
+{
+  size_t i;
+
+  if (argc > 0)
+  {
+    if (strcmp(argv[0], "r"))
+    {
+      printf("Invalid option [r]%s", CFG_PRINTF_NEWLINE);
+      return;
+    }
+    memset(cmdStats, 0, sizeof(cmdStats));
+    printf("Statistics cleared%s", CFG_PRINTF_NEWLINE);
+    return;
+  }
+
+  printf("Command     Count  Total(ms)  Mean(us)   Max(us)     Bytes   <1ms  <10ms <100ms   more%s", CFG_PRINTF_NEWLINE);
+  printf("-------     -----  ---------  --------   -------     -----   ----  ----- ------   ----%s", CFG_PRINTF_NEWLINE);
+
+  for (i=0; i < CMD_COUNT; i++)
+  {
+    cmdStats_t *stats = &cmdStats[i];
+
+    if (stats->count == 0)
+    {
+      continue;
+    }
+    printf("%-8s %8u %10u %9u %9u %9u %6u %6u %6u %6u%s",
+           cmd_tbl[i].command,
+           (unsigned int)stats->count,
+           (unsigned int)(stats->totalUs / 1000),
+           (unsigned int)(stats->totalUs / stats->count),
+           (unsigned int)stats->maxUs,
+           (unsigned int)stats->bytes,
+           stats->histogram[0], stats->histogram[1], stats->histogram[2], stats->histogram[3],
+           CFG_PRINTF_NEWLINE);
+  }
+}
+#endif
@@ -57,4 +57,8 @@ uint8_t cmdRx(uint8_t c);
 void cmdParse(char *cmd);
 void cmdInit();
 
+#ifdef CFG_INTERFACE_STATS
+extern volatile uint32_t cmdOutputBytes;    // Counted in __putchar
+#endif
+
 #endif
\ No newline at end of file
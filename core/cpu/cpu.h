@@ -54,6 +54,37 @@
                                        DWT_CYCCNT = 0;                      \
                                        DWT_CTRL = DWT_CTRL | 1 ; } while(0)
 
+/**************************************************************************/
+/*! 
+    @brief  Disables interrupts, returning the previous PRIMASK state
+            for cpuUnlock.  Lock/unlock pairs can be nested, and can be
+            used from interrupts.  On the host (simulator builds) there
+            are no interrupts to mask, so both do nothing.
+*/
+/**************************************************************************/
+static inline uint32_t cpuLock(void)
+{
+  uint32_t primask = 0;
+  #ifdef __arm__
+    __asm volatile ("mrs %0, primask\n\tcpsid i" : "=r" (primask) :: "memory");
+  #endif
+  return primask;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Restores the interrupt state returned by cpuLock
+*/
+/**************************************************************************/
+static inline void cpuUnlock(uint32_t primask)
+{
+  #ifdef __arm__
+    __asm volatile ("msr primask, %0" :: "r" (primask) : "memory");
+  #else
+    (void)primask;
+  #endif
+}
+
 /**************************************************************************/
 /*! 
     @brief Indicates the value for the PLL multiplier
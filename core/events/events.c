@@ -0,0 +1,233 @@
+/**************************************************************************/
+/*!
+    @file     events.c
+
+    @section DESCRIPTION
+
+    A run-to-completion event loop.
+
+    Interrupt handlers post events with eventsPost, and the main loop
+    calls the handler registered for each event with eventsDispatch.
+    Pending events are kept as one bit per source, so an event that is
+    posted again before its handler runs is only handled once (the
+    data passed with each post is OR'ed together).  The handler should
+    therefore drain everything that is waiting (the whole UART buffer,
+    etc.), not just one item.
+
+    When several events are pending, the one listed first in events_e
+    is dispatched first.  Handlers aren't pre-empted by other handlers,
+    so they should return quickly; long jobs can be split up by posting
+    one of the EVENTS_USERx events again before returning.
+
+    When nothing is pending, eventsIdle puts the MCU to sleep until the
+    next interrupt.  If CFG_SWTIMER is defined, expired software timers
+    are run from the loop before any other event, and the systick
+    interrupt is stopped while sleeping so that the MCU only wakes up
+    for an event or a timer.
+
+    @section Example
+
+    @code
+    #include "core/events/events.h"
+    #include "core/cmd/cmd.h"
+
+    static void cliHandler(uint32_t data)
+    {
+      cmdPoll();
+    }
+
+    static void buttonHandler(uint32_t data)
+    {
+      if (data & (1 << 1))
+      {
+        printf("Button on 2.1 pressed%s", CFG_PRINTF_NEWLINE);
+      }
+    }
+
+    eventsRegister(EVENTS_UARTRX, cliHandler);
+    eventsRegister(EVENTS_USBCDCRX, cliHandler);
+    eventsRegister(EVENTS_GPIO2, buttonHandler);
+
+    // Never returns
+    eventsRun();
+    @endcode
+
+    @section LICENSE
+
+    Software License Agreement (BSD License)
+
+    Copyright (c) 2012, microBuilder SARL
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+    1. Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holders nor the
+    names of its contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ''AS IS'' AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**************************************************************************/
+#include "events.h"
+
+#ifdef CFG_EVENTS
+
+#include "core/cpu/cpu.h"
+#include "core/pmu/pmu.h"
+
+#ifdef CFG_SWTIMER
+  #include "core/swtimer/swtimer.h"
+#endif
+
+static eventsHandler_t _eventsHandlers[EVENTS_LAST];
+static volatile uint32_t _eventsData[EVENTS_LAST];
+static volatile uint32_t _eventsPending = 0;
+
+/**************************************************************************/
+/*!
+    @brief  Sets the function that is called when 'event' is dispatched
+            (or 0 to ignore the event)
+*/
+/**************************************************************************/
+void eventsRegister(events_e event, eventsHandler_t handler)
+{
+  if (event >= EVENTS_LAST) return;
+
+  _eventsHandlers[event] = handler;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Marks an event as pending.  This can be called from interrupt
+            handlers as well as from the main loop.
+
+    @param[in]  event
+                The event source
+    @param[in]  data
+                Passed to the handler, OR'ed with the data of any earlier
+                posts of the same event that haven't been handled yet
+*/
+/**************************************************************************/
+void eventsPost(events_e event, uint32_t data)
+{
+  uint32_t primask;
+
+  if (event >= EVENTS_LAST) return;
+
+  primask = cpuLock();
+  _eventsData[event] |= data;
+  _eventsPending |= (1 << event);
+  cpuUnlock(primask);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Returns true if any event is waiting to be dispatched
+*/
+/**************************************************************************/
+bool eventsPending(void)
+{
+  return _eventsPending != 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Calls the handler of the highest priority pending event
+
+    @return true if an event was dispatched, false if none was pending
+*/
+/**************************************************************************/
+bool eventsDispatch(void)
+{
+  uint32_t primask, data;
+  events_e event;
+
+  primask = cpuLock();
+  if (!_eventsPending)
+  {
+    cpuUnlock(primask);
+    return false;
+  }
+  event = (events_e)__builtin_ctz(_eventsPending);
+  data = _eventsData[event];
+  _eventsData[event] = 0;
+  _eventsPending &= ~(1 << event);
+  cpuUnlock(primask);
+
+  if (_eventsHandlers[event])
+  {
+    _eventsHandlers[event](data);
+  }
+
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sleeps until the next interrupt, unless an event (or a
+            software timer) is already pending.
+
+    Interrupts are disabled while checking for pending events, so an
+    event posted just before going to sleep can't be missed: the
+    pending interrupt still wakes the MCU up from WFI, and is serviced
+    once interrupts are enabled again.
+*/
+/**************************************************************************/
+void eventsIdle(void)
+{
+  __disable_irq();
+#ifdef CFG_SWTIMER
+  if (!_eventsPending && !swtimerPending())
+  {
+    swtimerSuspendTick();
+    pmuSleep();
+    swtimerResumeTick();
+  }
+#else
+  if (!_eventsPending)
+  {
+    pmuSleep();
+  }
+#endif
+  __enable_irq();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Runs the event loop.  This function never returns.
+*/
+/**************************************************************************/
+void eventsRun(void)
+{
+  while (1)
+  {
+    #ifdef CFG_SWTIMER
+    if (swtimerPending())
+    {
+      swtimerTask();
+      continue;
+    }
+    #endif
+
+    if (!eventsDispatch())
+    {
+      eventsIdle();
+    }
+  }
+}
+
+#endif
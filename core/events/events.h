@@ -0,0 +1,73 @@
+/**************************************************************************/
+/*!
+    @file     events.h
+
+    @section LICENSE
+
+    Software License Agreement (BSD License)
+
+    Copyright (c) 2012, microBuilder SARL
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+    1. Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holders nor the
+    names of its contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ''AS IS'' AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**************************************************************************/
+
+#ifndef _EVENTS_H_
+#define _EVENTS_H_
+
+#include "projectconfig.h"
+
+/**************************************************************************/
+/*!
+    Event sources.  Pending events are dispatched in the order they are
+    listed here, so the first entries have the highest priority.
+*/
+/**************************************************************************/
+typedef enum
+{
+  EVENTS_GPIO0 = 0,       // Data is the mask of the pins that interrupted
+  EVENTS_GPIO1,
+  EVENTS_GPIO2,
+  EVENTS_GPIO3,
+  EVENTS_CHIBIRX,         // A frame was received by chibi
+  EVENTS_UARTRX,          // Characters are waiting in the UART RX buffer
+  EVENTS_USBCDCRX,        // Characters are waiting in the USB CDC buffer
+  EVENTS_USER0,           // Free for use by the application
+  EVENTS_USER1,
+  EVENTS_USER2,
+  EVENTS_USER3,
+  EVENTS_LAST
+}
+events_e;
+
+typedef void (*eventsHandler_t)(uint32_t data);
+
+void  eventsRegister (events_e event, eventsHandler_t handler);
+void  eventsPost (events_e event, uint32_t data);
+bool  eventsPending (void);
+bool  eventsDispatch (void);
+void  eventsIdle (void);
+void  eventsRun (void);
+
+#endif
@@ -41,6 +41,7 @@
 /**************************************************************************/
 
 #include "gpio.h"
+#include "core/profile/profile.h"
 
 #ifdef CFG_CHIBI
 #include "drivers/rf/chibi/chb_drvr.h"
@@ -51,6 +52,14 @@ volatile uint32_t chibi_counter  = 0;
 #include "core/cpu/cpu.h"
 #endif
 
+#ifdef GPIO_ENABLE_IRQ3
+#include "drivers/rf/pn532/pn532_bus.h"
+#endif
+
+#ifdef CFG_EVENTS
+#include "core/events/events.h"
+#endif
+
 static bool _gpioInitialised = false;
 
 /**************************************************************************/
@@ -68,11 +77,24 @@ void PIOINT0_IRQHandler(void)
 {
   uint32_t regVal;
 
+  PROFILE_ISR_ENTER(EINT0_IRQn);
+
+#ifdef CFG_EVENTS
+  // Pass the pins that interrupted on to the event loop
+  regVal = GPIO_GPIO0MIS;
+  if (regVal)
+  {
+    GPIO_GPIO0IC = regVal;
+    eventsPost(EVENTS_GPIO0, regVal);
+  }
+#else
   regVal = gpioIntStatus(0, 1);
   if (regVal)
   {
     gpioIntClear(0, 1);
   }		
+#endif
+  PROFILE_ISR_EXIT(EINT0_IRQn);
   return;
 }
 #endif
@@ -87,6 +109,8 @@ void PIOINT1_IRQHandler(void)
 {
   uint32_t regVal;
 
+  PROFILE_ISR_ENTER(EINT1_IRQn);
+
 #if defined CFG_ALTRESET && CFG_ALTRESET_PORT == 1
   regVal = gpioIntStatus(CFG_ALTRESET_PORT, CFG_ALTRESET_PIN);
   if (regVal)
@@ -105,6 +129,16 @@ void PIOINT1_IRQHandler(void)
     chb_ISR_Handler();
     gpioIntClear(1, 8);
   }		
+#endif
+
+#ifdef CFG_EVENTS
+  // Pass the pins that interrupted on to the event loop
+  regVal = GPIO_GPIO1MIS;
+  if (regVal)
+  {
+    GPIO_GPIO1IC = regVal;
+    eventsPost(EVENTS_GPIO1, regVal);
+  }
 #else
   regVal = gpioIntStatus(1, 1);
   if ( regVal )
@@ -113,6 +147,7 @@ void PIOINT1_IRQHandler(void)
   }
 #endif
 
+  PROFILE_ISR_EXIT(EINT1_IRQn);
   return;
 }
 #endif
@@ -132,18 +167,32 @@ void PIOINT2_IRQHandler(void)
 {
   uint32_t regVal;
 
+  PROFILE_ISR_ENTER(EINT2_IRQn);
+
+#ifdef CFG_EVENTS
+  // Pass the pins that interrupted on to the event loop
+  regVal = GPIO_GPIO2MIS;
+  if (regVal)
+  {
+    GPIO_GPIO2IC = regVal;
+    eventsPost(EVENTS_GPIO2, regVal);
+  }
+#else
   regVal = gpioIntStatus(2, 1);
   if ( regVal )
   {
     gpioIntClear(2, 1);
   }		
+#endif
+  PROFILE_ISR_EXIT(EINT2_IRQn);
   return;
 }
 #endif
 
 /**************************************************************************/
 /*! 
-    @brief IRQ Handler for GPIO port 3 (currently checks pin 3.1)
+    @brief IRQ Handler for GPIO port 3 (currently checks pin 3.1, and
+           the PN532 IRQ line on pin 3.2 when the PN532 uses I2C)
 
     @note  By default, this IRQ handler is probably disabled in
            projectconfig.h (see GPIO_ENABLE_IRQ3), but you can use
@@ -156,11 +205,34 @@ void PIOINT3_IRQHandler(void)
 {
   uint32_t regVal;
 
+  PROFILE_ISR_ENTER(EINT3_IRQn);
+
+#ifdef PN532_BUS_I2C
+  // PN532 response ready (only enabled once pn532Init has been called)
+  regVal = gpioIntStatus(PN532_I2C_IRQPORT, PN532_I2C_IRQPIN);
+  if (regVal)
+  {
+    pn532_bus_IRQHandler();
+    gpioIntClear(PN532_I2C_IRQPORT, PN532_I2C_IRQPIN);
+  }
+#endif
+
+#ifdef CFG_EVENTS
+  // Pass the pins that interrupted on to the event loop
+  regVal = GPIO_GPIO3MIS;
+  if (regVal)
+  {
+    GPIO_GPIO3IC = regVal;
+    eventsPost(EVENTS_GPIO3, regVal);
+  }
+#else
   regVal = gpioIntStatus(3, 1);
   if ( regVal )
   {
     gpioIntClear(3, 1);
   }		
+#endif
+  PROFILE_ISR_EXIT(EINT3_IRQn);
   return;
 }
 #endif
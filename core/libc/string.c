@@ -37,6 +37,139 @@
 
 #include <string.h>
 
+//------------------------------------------------------------------------------
+//         Local Functions
+//------------------------------------------------------------------------------
+
+// Word-at-a-time helpers.  A word contains a zero byte if subtracting 1 from
+// every byte borrows into a byte whose top bit was clear.
+#define WORD_ONES   0x01010101UL
+#define WORD_HIGHS  0x80808080UL
+#define WORD_HASZERO(w) (((w) - WORD_ONES) & ~(w) & WORD_HIGHS)
+
+//------------------------------------------------------------------------------
+/// Copies whole words in ascending address order. The destination must be
+/// word aligned, the source may have any alignment. Misaligned sources are
+/// read as aligned words and shift-merged (Cortex-M3 is little endian), so
+/// no unaligned accesses are ever generated. Safe for overlapping buffers as
+/// long as the destination lies below the source.
+/// \param pDestination  Word aligned destination.
+/// \param pSource  Source buffer.
+/// \param words  Number of words to copy.
+//------------------------------------------------------------------------------
+static void copyWordsForward(unsigned int *pDestination,
+                             const unsigned char *pSource, size_t words)
+{
+    unsigned int offset = (unsigned int) pSource & 0x3;
+
+    if (offset == 0) {
+
+        const unsigned int *pAlignedSource = (const unsigned int *) pSource;
+
+        // Move 16 bytes per iteration using LDM/STM
+        while (words >= 4) {
+#if defined(__thumb2__)
+            __asm volatile ("ldmia %1!, {r3-r6}\n\t"
+                            "stmia %0!, {r3-r6}"
+                            : "+r" (pDestination), "+r" (pAlignedSource)
+                            :
+                            : "r3", "r4", "r5", "r6", "memory");
+#else
+            pDestination[0] = pAlignedSource[0];
+            pDestination[1] = pAlignedSource[1];
+            pDestination[2] = pAlignedSource[2];
+            pDestination[3] = pAlignedSource[3];
+            pDestination += 4;
+            pAlignedSource += 4;
+#endif
+            words -= 4;
+        }
+        while (words--) {
+
+            *pDestination++ = *pAlignedSource++;
+        }
+    }
+    else {
+
+        const unsigned int *pAlignedSource = (const unsigned int *) (pSource - offset);
+        unsigned int low = offset * 8;
+        unsigned int high = 32 - low;
+        unsigned int w0 = *pAlignedSource++;
+        unsigned int w1;
+
+        while (words >= 2) {
+
+            w1 = *pAlignedSource++;
+            *pDestination++ = (w0 >> low) | (w1 << high);
+            w0 = *pAlignedSource++;
+            *pDestination++ = (w1 >> low) | (w0 << high);
+            words -= 2;
+        }
+        if (words) {
+
+            w1 = *pAlignedSource;
+            *pDestination = (w0 >> low) | (w1 << high);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/// Copies whole words in descending address order. Both pointers point one
+/// past the end of their buffers. The destination end must be word aligned,
+/// the source may have any alignment. Safe for overlapping buffers as long
+/// as the destination lies above the source.
+/// \param pDestinationEnd  Word aligned end of the destination.
+/// \param pSourceEnd  End of the source buffer.
+/// \param words  Number of words to copy.
+//------------------------------------------------------------------------------
+static void copyWordsBackward(unsigned int *pDestinationEnd,
+                              const unsigned char *pSourceEnd, size_t words)
+{
+    unsigned int offset = (unsigned int) pSourceEnd & 0x3;
+
+    if (offset == 0) {
+
+        const unsigned int *pAlignedSource = (const unsigned int *) pSourceEnd;
+
+        while (words >= 4) {
+#if defined(__thumb2__)
+            __asm volatile ("ldmdb %1!, {r3-r6}\n\t"
+                            "stmdb %0!, {r3-r6}"
+                            : "+r" (pDestinationEnd), "+r" (pAlignedSource)
+                            :
+                            : "r3", "r4", "r5", "r6", "memory");
+#else
+            pDestinationEnd -= 4;
+            pAlignedSource -= 4;
+            pDestinationEnd[3] = pAlignedSource[3];
+            pDestinationEnd[2] = pAlignedSource[2];
+            pDestinationEnd[1] = pAlignedSource[1];
+            pDestinationEnd[0] = pAlignedSource[0];
+#endif
+            words -= 4;
+        }
+        while (words--) {
+
+            *--pDestinationEnd = *--pAlignedSource;
+        }
+    }
+    else {
+
+        const unsigned int *pAlignedSource = (const unsigned int *) (pSourceEnd - offset);
+        unsigned int low = offset * 8;
+        unsigned int high = 32 - low;
+        unsigned int w1 = *pAlignedSource;
+        unsigned int w0;
+
+        while (words--) {
+
+            w0 = *--pAlignedSource;
+            *--pDestinationEnd = (w0 >> low) | (w1 << high);
+            w1 = w0;
+        }
+    }
+}
+
 //------------------------------------------------------------------------------
 //         Global Functions
 //------------------------------------------------------------------------------
@@ -44,33 +177,37 @@
 //------------------------------------------------------------------------------
 /// Copies data from a source buffer into a destination buffer. The two buffers
 /// must NOT overlap. Returns the destination buffer.
+/// The destination is aligned first, after which the bulk of the data is
+/// moved one word (or four words for aligned sources) at a time regardless
+/// of the source alignment.
 /// \param pDestination  Destination buffer.
 /// \param pSource  Source buffer.
 /// \param num  Number of bytes to copy.
 //------------------------------------------------------------------------------
 void * memcpy(void *pDestination, const void *pSource, size_t num)
 {
-    unsigned char *pByteDestination;
-    unsigned char *pByteSource;
-    unsigned int *pAlignedSource = (unsigned int *) pSource;
-    unsigned int *pAlignedDestination = (unsigned int *) pDestination;
+    unsigned char *pByteDestination = (unsigned char *) pDestination;
+    const unsigned char *pByteSource = (const unsigned char *) pSource;
+    size_t words;
 
-    // If num is more than 4 bytes, and both dest. and source are aligned,
-    // then copy dwords
-    if ((((unsigned int) pAlignedDestination & 0x3) == 0)
-        && (((unsigned int) pAlignedSource & 0x3) == 0)
-        && (num >= 4)) {
+    // Short copies are not worth the alignment overhead
+    if (num >= 8) {
 
-        while (num >= 4) {
+        // Align the destination
+        while ((unsigned int) pByteDestination & 0x3) {
 
-            *pAlignedDestination++ = *pAlignedSource++;
-            num -= 4;
+            *pByteDestination++ = *pByteSource++;
+            num--;
         }
+
+        words = num >> 2;
+        copyWordsForward((unsigned int *) pByteDestination, pByteSource, words);
+        pByteDestination += words << 2;
+        pByteSource += words << 2;
+        num &= 0x3;
     }
 
     // Copy remaining bytes
-    pByteDestination = (unsigned char *) pAlignedDestination;
-    pByteSource = (unsigned char *) pAlignedSource;
     while (num--) {
 
         *pByteDestination++ = *pByteSource++;
@@ -88,62 +225,130 @@ void * memcpy(void *pDestination, const void *pSource, size_t num)
 //------------------------------------------------------------------------------
 void * memset(void *pBuffer, int value, size_t num)
 {
-    unsigned char *pByteDestination;
-    unsigned int  *pAlignedDestination = (unsigned int *) pBuffer;
-    unsigned int  alignedValue = (value << 24) | (value << 16) | (value << 8) | value;
+    unsigned char *pByteDestination = (unsigned char *) pBuffer;
+    unsigned int  *pAlignedDestination;
+    unsigned int  alignedValue = (value & 0xFF) * WORD_ONES;
+
+    if (num >= 8) {
 
-    // Set words if possible
-    if ((((unsigned int) pAlignedDestination & 0x3) == 0) && (num >= 4)) {
+        // Align the destination
+        while ((unsigned int) pByteDestination & 0x3) {
+
+            *pByteDestination++ = value;
+            num--;
+        }
+
+        // Set words
+        pAlignedDestination = (unsigned int *) pByteDestination;
+        while (num >= 16) {
+
+            pAlignedDestination[0] = alignedValue;
+            pAlignedDestination[1] = alignedValue;
+            pAlignedDestination[2] = alignedValue;
+            pAlignedDestination[3] = alignedValue;
+            pAlignedDestination += 4;
+            num -= 16;
+        }
         while (num >= 4) {
+
             *pAlignedDestination++ = alignedValue;
             num -= 4;
         }
+        pByteDestination = (unsigned char *) pAlignedDestination;
     }
+
     // Set remaining bytes
-    pByteDestination = (unsigned char *) pAlignedDestination;
     while (num--) {
+
         *pByteDestination++ = value;
     }
     return pBuffer;
 }
 
+//------------------------------------------------------------------------------
+/// Copies data from a source buffer into a destination buffer. The two
+/// buffers may overlap. Returns the destination buffer.
+/// \param s1  Destination buffer.
+/// \param s2  Source buffer.
+/// \param n   Number of bytes to copy.
+//------------------------------------------------------------------------------
 void* memmove(void *s1, const void *s2, size_t n)
 {
-  char *s=(char*)s2, *d=(char*)s1;
-  
-  if(d > s){
-    s+=n-1;
-    d+=n-1;
-    while(n){
-      *d--=*s--;
-      n--;
-    }
-  }else if(d < s)
-    while(n){
-      *d++=*s++;
+  unsigned char *d = (unsigned char *)s1;
+  const unsigned char *s = (const unsigned char *)s2;
+  size_t words;
+
+  if (d == s || n == 0)
+    return s1;
+
+  // Copying forward is safe whenever the destination is below the source
+  // or the buffers don't overlap at all
+  if (d < s || d >= s + n)
+    return memcpy(s1, s2, n);
+
+  // Overlapping with the destination above the source: copy backwards
+  d += n;
+  s += n;
+  if (n >= 8) {
+    while ((unsigned int)d & 0x3) {
+      *--d = *--s;
       n--;
     }
+    words = n >> 2;
+    copyWordsBackward((unsigned int *)d, s, words);
+    d -= words << 2;
+    s -= words << 2;
+    n &= 0x3;
+  }
+  while (n--)
+    *--d = *--s;
+
   return s1;
 }
 
+//------------------------------------------------------------------------------
+/// Compares two memory regions. Returns 0 if they are equal, otherwise the
+/// difference between the first pair of mismatching bytes.
+/// Compares a word at a time when both regions share the same alignment.
+/// \param av   First memory region.
+/// \param bv   Second memory region.
+/// \param len  Number of bytes to compare.
+//------------------------------------------------------------------------------
 int memcmp(const void *av, const void *bv, size_t len)
 {
   const unsigned char *a = av;
   const unsigned char *b = bv;
-  size_t i;
 
-  for (i=0; i<len; i++) 
+  if (len >= 8 && (((unsigned int)a ^ (unsigned int)b) & 0x3) == 0)
   {
-    if (a[i] != b[i]) 
+    while ((unsigned int)a & 0x3)
     {
-      return (int)(a[i] - b[i]);
+      if (*a != *b)
+        return (int)(*a - *b);
+      a++;
+      b++;
+      len--;
+    }
+    // Skip over equal words, the byte loop below finds the exact mismatch
+    while (len >= 4 && *(const unsigned int *)a == *(const unsigned int *)b)
+    {
+      a += 4;
+      b += 4;
+      len -= 4;
     }
   }
+
+  while (len--)
+  {
+    if (*a != *b)
+      return (int)(*a - *b);
+    a++;
+    b++;
+  }
   return 0;
 }
 
 
-
 //-----------------------------------------------------------------------------
 /// Search a character in the given string.
 /// Returns a pointer to the character location.
@@ -170,12 +375,26 @@ char * strchr(const char *pString, int character)
 //-----------------------------------------------------------------------------
 size_t strlen(const char *pString)
 {
-    unsigned int length = 0;
+    const char *p = pString;
+    const unsigned int *pWord;
 
-    while(*pString++ != 0) {
-        length++;
+    // Step bytewise up to a word boundary, then test four bytes at a time.
+    // Aligned word reads never cross into an unmapped region.
+    while ((unsigned int) p & 0x3) {
+        if (*p == 0) {
+            return p - pString;
+        }
+        p++;
+    }
+    pWord = (const unsigned int *) p;
+    while (!WORD_HASZERO(*pWord)) {
+        pWord++;
+    }
+    p = (const char *) pWord;
+    while (*p != 0) {
+        p++;
     }
-    return length;
+    return p - pString;
 }
 
 
@@ -268,6 +487,23 @@ char * strncpy(char *pDestination, const char *pSource, size_t count)
 
 int strcmp(const char *s1, const char *s2)
 {
+  // Compare a word at a time while both strings share the same alignment
+  if ((((unsigned int)s1 ^ (unsigned int)s2) & 0x3) == 0) {
+    while ((unsigned int)s1 & 0x3) {
+      if (*s1 != *s2)
+        return (*(unsigned char *)s1 - *(unsigned char *)s2);
+      if (*s1 == 0)
+        return (0);
+      s1++;
+      s2++;
+    }
+    while (*(const unsigned int *)s1 == *(const unsigned int *)s2 &&
+           !WORD_HASZERO(*(const unsigned int *)s1)) {
+      s1 += 4;
+      s2 += 4;
+    }
+  }
+
   while (*s1 == *s2++)
     if (*s1++ == 0)
       return (0);
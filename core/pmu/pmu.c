@@ -12,6 +12,14 @@
 
     For examples of how to enter either mode, see the comments for the
     functions pmuSleep(), pmuDeepSleep() and pmuPowerDown().
+
+    Drivers that need to prepare for deep-sleep register a suspend and
+    resume hook with pmuRegisterHooks().  Suspend hooks run in
+    registration order before the device sleeps and resume hooks run in
+    reverse order once it is awake and back at full speed.  Any start
+    logic pin can be enabled as a wakeup source with pmuWakeupEnable(),
+    in addition to the wakeup timer supported by pmuDeepSleep().  The
+    time spent in each power state is available through pmuGetStats().
 	
     @section LICENSE
 
@@ -44,58 +52,143 @@
 */
 /**************************************************************************/
 
+#include <string.h>
+
 #include "core/gpio/gpio.h"
 #include "core/cpu/cpu.h"
+#include "core/systick/systick.h"
 #include "core/timer32/timer32.h"
 #include "pmu.h"
 
-#ifdef CFG_CHIBI
-  #include "drivers/rf/chibi/chb_drvr.h"
+#ifdef CFG_SWTIMER
+  #include "core/swtimer/swtimer.h"
 #endif
+
 #define PMU_WDTCLOCKSPEED_HZ 7812
 
 void pmuSetupHW(void);
 void pmuRestoreHW(void);
 
+static pmuHook_t pmuSuspendHooks[PMU_MAXHOOKS];
+static pmuHook_t pmuResumeHooks[PMU_MAXHOOKS];
+static uint32_t pmuHookCount = 0;
+static bool pmuWakeupOnUSB = false;
+
+static pmuStats_t pmuStats;
+static uint32_t pmuLastMs = 0;                  // Time of the last power state change
+static volatile bool pmuDeepSleeping = false;
+static volatile bool pmuClockSaved = false;     // Set while the main clock needs restoring
+static uint32_t pmuSavedMainClk;
 
 /**************************************************************************/
 /*! 
-    Wakeup interrupt handler
+    Returns the time base used for the power state accounting in ms.
+    Neither source runs in deep-sleep mode.
 */
 /**************************************************************************/
-void WAKEUP_IRQHandler(void)
+static uint32_t pmuGetMs(void)
 {
-  uint32_t regVal;
+  #ifdef CFG_SWTIMER
+    // The systick may be suspended while sleeping, see swtimerSuspendTick
+    return (uint32_t)(swtimerGetMicroseconds() / 1000);
+  #else
+    return systickGetTicks() * CFG_SYSTICK_DELAY_IN_MS;
+  #endif
+}
 
-  // Reconfigure system clock/PLL
-  cpuPllSetup(CPU_MULTIPLIER_6);
+/**************************************************************************/
+/*! 
+    Switches the main clock back to the source used before deep-sleep.
+
+    The PLL configuration is retained in deep-sleep and PDAWAKECFG
+    powers the system oscillator and PLL back up as soon as the device
+    wakes, so there is no need to go through cpuPllSetup again: waiting
+    for the PLL to lock and switching the main clock over is enough.
+    This is called from the wakeup interrupt and again once WFI returns
+    in pmuDeepSleep, whichever comes first does the work.
+*/
+/**************************************************************************/
+static void pmuRestoreClock(void)
+{
+  if (!pmuClockSaved)
+    return;
+  pmuClockSaved = false;
 
-  // Clear match bit on timer
-  TMR_TMR32B0EMR = 0;
+  if (pmuSavedMainClk == SCB_MAINCLKSEL_SOURCE_SYSPLLCLKOUT)
+  {
+    // Wait for PLL to lock
+    while (!(SCB_PLLSTAT & SCB_PLLSTAT_LOCK));
+  }
 
-  // Clear pending bits
-  SCB_STARTRSRP0CLR = SCB_STARTRSRP0CLR_MASK;
+  if ((SCB_MAINCLKSEL & SCB_MAINCLKSEL_MASK) != pmuSavedMainClk)
+  {
+    SCB_MAINCLKSEL = pmuSavedMainClk;
+    SCB_MAINCLKUEN = SCB_MAINCLKUEN_UPDATE;     // Update clock source
+    SCB_MAINCLKUEN = SCB_MAINCLKUEN_DISABLE;    // Toggle update register once
+    SCB_MAINCLKUEN = SCB_MAINCLKUEN_UPDATE;
 
-  // Clear SLEEPDEEP bit
-  SCB_SCR &= ~SCB_SCR_SLEEPDEEP;
+    // Wait until the clock is updated
+    while (!(SCB_MAINCLKUEN & SCB_MAINCLKUEN_UPDATE));
+  }
+}
 
-  // Disable the deep sleep timer
-  TMR_TMR32B0TCR = TMR_TMR32B0TCR_COUNTERENABLE_DISABLED;
+/**************************************************************************/
+/*! 
+    Records which start logic inputs woke the device up and clears them
+*/
+/**************************************************************************/
+static void pmuClearStartLogic(void)
+{
+  uint32_t src0, src1;
 
-  /* This handler takes care of all the port pins if they
-  are configured as wakeup source. */
-  regVal = SCB_STARTSRP0;
-  if (regVal != 0)
+  src0 = SCB_STARTSRP0;
+  src1 = SCB_STARTSRP1 & SCB_STARTSRP1_MASK;
+  if (src0)
+    SCB_STARTRSRP0CLR = src0;
+  if (src1)
+    SCB_STARTRSRP1CLR = src1;
+
+  if (pmuDeepSleeping)
   {
-    SCB_STARTRSRP0CLR = regVal;
+    pmuStats.wakeupSources[0] |= src0;
+    pmuStats.wakeupSources[1] |= src1;
   }
+}
 
-  // Reconfigure CT32B0
-  timer32Init(0, TIMER32_DEFAULTINTERVAL);
-  timer32Enable(0);
+/**************************************************************************/
+/*! 
+    Returns the start logic input (and wakeup interrupt) number of a
+    pin, or -1 if the pin isn't connected to the start logic.  PIO0_0
+    to PIO2_7 are inputs 0..31 and PIO2_8 to PIO3_3 are inputs 32..39.
+*/
+/**************************************************************************/
+static int32_t pmuStartLogicInput(uint32_t portNum, uint32_t bitPos)
+{
+  if (portNum < 3 && bitPos < 12)
+    return portNum * 12 + bitPos;
+  if (portNum == 3 && bitPos < 4)
+    return 36 + bitPos;
+  return -1;
+}
 
-  // Perform peripheral specific and custom wakeup tasks
-  pmuRestoreHW();
+/**************************************************************************/
+/*! 
+    Wakeup interrupt handler
+*/
+/**************************************************************************/
+void WAKEUP_IRQHandler(void)
+{
+  // Get back to full speed before doing anything else
+  pmuRestoreClock();
+
+  // Clear SLEEPDEEP bit
+  SCB_SCR &= ~SCB_SCR_SLEEPDEEP;
+
+  /* This handler takes care of all the port pins if they
+  are configured as wakeup source. */
+  pmuClearStartLogic();
+
+  // Drivers are resumed by pmuDeepSleep once WFI returns
 
   /* See tracker for bug report. */
   __asm volatile ("NOP");
@@ -140,22 +233,146 @@ void pmuInit( void )
                     SCB_PDRUNCFG_SYSOSC_MASK | 
                     SCB_PDRUNCFG_ADC_MASK);
 
+  pmuResetStats();
+
   return;
 }
 
+/**************************************************************************/
+/*! 
+    @brief  Registers a pair of functions that put a driver or external
+            part into a low power state before deep-sleep and back into
+            operation after wakeup
+
+    Suspend hooks are called in registration order, resume hooks in the
+    reverse order, so a driver registered after the bus it depends on is
+    suspended first and resumed last.  Resume hooks run with the system
+    clock fully restored.
+
+    @param[in]  suspend
+                Called before entering deep-sleep or deep power-down
+                (can be NULL)
+    @param[in]  resume
+                Called after waking up from deep-sleep (can be NULL)
+
+    @returns    PMU_ERROR_OK, or PMU_ERROR_HOOKSFULL if PMU_MAXHOOKS
+                hooks are already registered
+*/
+/**************************************************************************/
+pmuError_e pmuRegisterHooks(pmuHook_t suspend, pmuHook_t resume)
+{
+  if (pmuHookCount >= PMU_MAXHOOKS)
+    return PMU_ERROR_HOOKSFULL;
+
+  pmuSuspendHooks[pmuHookCount] = suspend;
+  pmuResumeHooks[pmuHookCount] = resume;
+  pmuHookCount++;
+
+  return PMU_ERROR_OK;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Enables a pin as a wakeup source for deep-sleep mode
+
+    The pin should be configured as a GPIO input.  The edge is detected
+    by the start logic, which also raises WAKEUP_IRQHandler while the
+    device is awake.
+
+    @param[in]  portNum
+                The port number (0..3)
+    @param[in]  bitPos
+                The bit position (0..11, or 0..3 on port 3)
+    @param[in]  edge
+                The edge that wakes the device up
+
+    @returns    PMU_ERROR_OK, or PMU_ERROR_INVALIDPIN if the pin isn't
+                connected to the start logic
+*/
+/**************************************************************************/
+pmuError_e pmuWakeupEnable(uint32_t portNum, uint32_t bitPos, pmuWakeupEdge_e edge)
+{
+  int32_t input = pmuStartLogicInput(portNum, bitPos);
+
+  if (input < 0)
+    return PMU_ERROR_INVALIDPIN;
+
+  if (input < 32)
+  {
+    if (edge == PMU_WAKEUPEDGE_RISING)
+      SCB_STARTAPRP0 |= (1 << input);
+    else
+      SCB_STARTAPRP0 &= ~(1 << input);
+    SCB_STARTRSRP0CLR = (1 << input);
+    SCB_STARTERP0 |= (1 << input);
+  }
+  else
+  {
+    if (edge == PMU_WAKEUPEDGE_RISING)
+      SCB_STARTAPRP1 |= (1 << (input - 32));
+    else
+      SCB_STARTAPRP1 &= ~(1 << (input - 32));
+    SCB_STARTRSRP1CLR = (1 << (input - 32));
+    SCB_STARTERP1 |= (1 << (input - 32));
+  }
+
+  NVIC_EnableIRQ((IRQn_t)input);
+
+  return PMU_ERROR_OK;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Removes a pin enabled with pmuWakeupEnable from the wakeup
+            sources
+
+    @returns    PMU_ERROR_OK, or PMU_ERROR_INVALIDPIN if the pin isn't
+                connected to the start logic
+*/
+/**************************************************************************/
+pmuError_e pmuWakeupDisable(uint32_t portNum, uint32_t bitPos)
+{
+  int32_t input = pmuStartLogicInput(portNum, bitPos);
+
+  if (input < 0)
+    return PMU_ERROR_INVALIDPIN;
+
+  NVIC_DisableIRQ((IRQn_t)input);
+
+  if (input < 32)
+    SCB_STARTERP0 &= ~(1 << input);
+  else
+    SCB_STARTERP1 &= ~(1 << (input - 32));
+
+  return PMU_ERROR_OK;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Allows USB resume signalling to wake the device up
+
+    The start logic has no USB input and the USB block is stopped in
+    deep-sleep mode, so while this is enabled pmuDeepSleep enters sleep
+    mode instead: the suspend and resume hooks still run and the wakeup
+    timer still works, but the clocks stay up so the USB interrupt (or
+    any other enabled interrupt) can wake the device.
+*/
+/**************************************************************************/
+void pmuWakeupUSB(bool enable)
+{
+  pmuWakeupOnUSB = enable;
+}
+
 /**************************************************************************/
 /*! 
     @brief Puts select peripherals in sleep mode.
 
-    This function will put the device into sleep mode.  Most gpio pins
-    can be used to wake the device up, but the pins must first be
-    configured for this in pmuInit.
+    This function will put the device into sleep mode.  Any enabled
+    interrupt will wake the device up again.
 
     @section Example
 
     @code 
-    // Configure wakeup sources before going into sleep/deep-sleep.
-    // By default, pin 0.1 is configured as wakeup source (falling edge)
     pmuInit();
   
     // Enter sleep mode
@@ -165,8 +382,16 @@ void pmuInit( void )
 /**************************************************************************/
 void pmuSleep()
 {
+  uint32_t start = pmuGetMs();
+
+  pmuStats.activeMs += start - pmuLastMs;
+
   SCB_PDAWAKECFG = SCB_PDRUNCFG;
   __asm volatile ("WFI");
+
+  pmuLastMs = pmuGetMs();
+  pmuStats.sleepMs += pmuLastMs - start;
+  pmuStats.sleepCount++;
   return;
 }
 
@@ -181,7 +406,13 @@ void pmuSleep()
     after x seconds, waking the device up.  The timer will be configured
     to run off the WDT OSC while in deep-sleep mode, meaning that WDTOSC
     should not be powered off (using the sleepCtrl parameter) when a
-    wakeup delay is specified.
+    wakeup delay is specified.  CT32B0 and pin 0.1 are restored to their
+    previous configuration after wakeup.
+
+    Pins enabled with pmuWakeupEnable also wake the device up.  Drivers
+    are suspended and resumed through the hooks registered with
+    pmuRegisterHooks, and the main clock is restored before any resume
+    hook or interrupt handler other than WAKEUP_IRQHandler runs.
 
     The sleepCtrl parameter is used to indicate which peripherals should
     be put in sleep mode (see the SCB_PDSLEEPCFG register for details).
@@ -210,21 +441,44 @@ void pmuSleep()
                 SCB_PDSLEEPCFG_ADC_PD |
                 SCB_PDSLEEPCFG_BOD_PD;
   
+    // Also wakeup on a falling edge on pin 2.9
+    pmuWakeupEnable(2, 9, PMU_WAKEUPEDGE_FALLING);
+
     // Enter deep sleep mode (wakeup after 5 seconds)
-    // By default, pin 0.1 is configured as wakeup source
     pmuDeepSleep(pmuRegVal, 5);
     @endcode
 */
 /**************************************************************************/
 void pmuDeepSleep(uint32_t sleepCtrl, uint32_t wakeupSeconds)
 {
+  uint32_t start, elapsed, ahbClk, erp0, aprp0;
+  uint32_t tcr = 0, ctcr = 0, pr = 0, mcr = 0, mr0 = 0, emr = 0, iocon = 0;
+  bool deep = !pmuWakeupOnUSB;
+
+  start = pmuGetMs();
+  pmuStats.activeMs += start - pmuLastMs;
+
   // Setup the board for deep sleep mode, shutting down certain
   // peripherals and remapping pins for lower power
   pmuSetupHW();
+
+  // Save everything the wakeup timer changes
+  pmuSavedMainClk = SCB_MAINCLKSEL & SCB_MAINCLKSEL_MASK;
+  ahbClk = SCB_SYSAHBCLKCTRL;
+  erp0 = SCB_STARTERP0;
+  aprp0 = SCB_STARTAPRP0;
+
   SCB_PDAWAKECFG = SCB_PDRUNCFG;
   sleepCtrl |= (1 << 9) | (1 << 11);
   SCB_PDSLEEPCFG = sleepCtrl;
-  SCB_SCR |= SCB_SCR_SLEEPDEEP;
+  if (deep)
+    SCB_SCR |= SCB_SCR_SLEEPDEEP;
+
+  /* Clear all wakeup sources */ 
+  SCB_STARTRSRP0CLR = SCB_STARTRSRP0CLR_MASK;
+  SCB_STARTRSRP1CLR = SCB_STARTRSRP1CLR_MASK;
+  pmuStats.wakeupSources[0] = 0;
+  pmuStats.wakeupSources[1] = 0;
 
   /* Configure system to run from WDT and set TMR32B0 for wakeup          */
   if (wakeupSeconds > 0)
@@ -232,88 +486,113 @@ void pmuDeepSleep(uint32_t sleepCtrl, uint32_t wakeupSeconds)
     // Make sure WDTOSC isn't disabled in PDSLEEPCFG
     SCB_PDSLEEPCFG &= ~(SCB_PDSLEEPCFG_WDTOSC_PD);
 
+    /* Enable the clock for CT32B0 */
+    SCB_SYSAHBCLKCTRL |= (SCB_SYSAHBCLKCTRL_CT32B0);
+
+    // Save the timer's current setup (it's also used by other drivers)
+    tcr = TMR_TMR32B0TCR;
+    ctcr = TMR_TMR32B0CTCR;
+    pr = TMR_TMR32B0PR;
+    mcr = TMR_TMR32B0MCR;
+    mr0 = TMR_TMR32B0MR0;
+    emr = TMR_TMR32B0EMR;
+    iocon = IOCON_PIO0_1;
+
     // Disable 32-bit timer 0 if currently in use
     TMR_TMR32B0TCR = TMR_TMR32B0TCR_COUNTERENABLE_DISABLED;
 
     // Disable internal pullup on 0.1
     gpioSetPullup(&IOCON_PIO0_1, gpioPullupMode_Inactive);
 
-    /* Enable the clock for CT32B0 */
-    SCB_SYSAHBCLKCTRL |= (SCB_SYSAHBCLKCTRL_CT32B0);
-  
     /* Configure 0.1 as Timer0_32 MAT2 */
     IOCON_PIO0_1 &= ~IOCON_PIO0_1_FUNC_MASK;
     IOCON_PIO0_1 |= IOCON_PIO0_1_FUNC_CT32B0_MAT2;
 
+    /* Count at PMU_WDTCLOCKSPEED_HZ, from the WDT OSC in deep-sleep or
+       from the main clock when staying in sleep mode for USB */
+    TMR_TMR32B0CTCR = 0;
+    TMR_TMR32B0PR = deep ? 0 : (CFG_CPU_CCLK / PMU_WDTCLOCKSPEED_HZ) - 1;
+    TMR_TMR32B0TC = 0;
+
     /* Set appropriate timer delay */
     TMR_TMR32B0MR0 = PMU_WDTCLOCKSPEED_HZ * wakeupSeconds;
   
-    /* Configure match control register to raise an interrupt and reset on MR0 */
-    TMR_TMR32B0MCR |= (TMR_TMR32B0MCR_MR0_INT_ENABLED | TMR_TMR32B0MCR_MR0_RESET_ENABLED);
+    /* Reset on MR0.  No timer interrupt is needed since the wakeup comes
+       through the start logic, and it would end up in timer32's handler */
+    TMR_TMR32B0MCR = TMR_TMR32B0MCR_MR0_RESET_ENABLED;
   
     /* Configure external match register to set 0.1 high on match */
-    TMR_TMR32B0EMR &= ~(0xFF<<4);                   // Clear EMR config bits
-    TMR_TMR32B0EMR |= TMR_TMR32B0EMR_EMC2_HIGH;     // Set MAT2 (0.1) high on match
-
-    /* Enable wakeup interrupts (any I/O pin can be used as a wakeup source) */
-    //NVIC_EnableIRQ(WAKEUP0_IRQn);    // P0.0
-    NVIC_EnableIRQ(WAKEUP1_IRQn);      // P0.1    (CT32B0_MAT2)
-    //NVIC_EnableIRQ(WAKEUP2_IRQn);    // P0.2
-    //NVIC_EnableIRQ(WAKEUP3_IRQn);    // P0.3
-    //NVIC_EnableIRQ(WAKEUP4_IRQn);    // P0.4
-    //NVIC_EnableIRQ(WAKEUP5_IRQn);    // P0.5
-    //NVIC_EnableIRQ(WAKEUP6_IRQn);    // P0.6
-    //NVIC_EnableIRQ(WAKEUP7_IRQn);    // P0.7
-    //NVIC_EnableIRQ(WAKEUP8_IRQn);    // P0.8
-    //NVIC_EnableIRQ(WAKEUP9_IRQn);    // P0.9
-    //NVIC_EnableIRQ(WAKEUP10_IRQn);   // P0.10
-    //NVIC_EnableIRQ(WAKEUP11_IRQn);   // P0.11
-    //NVIC_EnableIRQ(WAKEUP12_IRQn);   // P1.0
-    //NVIC_EnableIRQ(WAKEUP13_IRQn);   // P1.1
-    //NVIC_EnableIRQ(WAKEUP14_IRQn);   // P1.2
-    //NVIC_EnableIRQ(WAKEUP15_IRQn);   // P1.3
-    //NVIC_EnableIRQ(WAKEUP16_IRQn);   // P1.4
-    //NVIC_EnableIRQ(WAKEUP17_IRQn);   // P1.5
-    //NVIC_EnableIRQ(WAKEUP18_IRQn);   // P1.6
-    //NVIC_EnableIRQ(WAKEUP19_IRQn);   // P1.7
-    //NVIC_EnableIRQ(WAKEUP20_IRQn);   // P1.8
-    //NVIC_EnableIRQ(WAKEUP21_IRQn);   // P1.9
-    //NVIC_EnableIRQ(WAKEUP22_IRQn);   // P1.10
-    //NVIC_EnableIRQ(WAKEUP23_IRQn);   // P1.11
-    //NVIC_EnableIRQ(WAKEUP24_IRQn);   // P2.0
-    //NVIC_EnableIRQ(WAKEUP25_IRQn);   // P2.1
-    //NVIC_EnableIRQ(WAKEUP26_IRQn);   // P2.2
-    //NVIC_EnableIRQ(WAKEUP27_IRQn);   // P2.3
-    //NVIC_EnableIRQ(WAKEUP28_IRQn);   // P2.4
-    //NVIC_EnableIRQ(WAKEUP29_IRQn);   // P2.5
-    //NVIC_EnableIRQ(WAKEUP30_IRQn);   // P2.6
-    //NVIC_EnableIRQ(WAKEUP31_IRQn);   // P2.7
-    //NVIC_EnableIRQ(WAKEUP32_IRQn);   // P2.8
-    //NVIC_EnableIRQ(WAKEUP33_IRQn);   // P2.9
-    //NVIC_EnableIRQ(WAKEUP34_IRQn);   // P2.10
-    //NVIC_EnableIRQ(WAKEUP35_IRQn);   // P2.11
-    //NVIC_EnableIRQ(WAKEUP36_IRQn);   // P3.0
-    //NVIC_EnableIRQ(WAKEUP37_IRQn);   // P3.1
-    //NVIC_EnableIRQ(WAKEUP38_IRQn);   // P3.2
-    //NVIC_EnableIRQ(WAKEUP39_IRQn);   // P3.3
-  
-    /* Use RISING EDGE for wakeup detection. */
-    SCB_STARTAPRP0 |= SCB_STARTAPRP0_APRPIO0_1;
-  
-    /* Clear all wakeup sources */ 
-    SCB_STARTRSRP0CLR = SCB_STARTRSRP0CLR_MASK;
+    TMR_TMR32B0EMR = TMR_TMR32B0EMR_EMC2_HIGH;      // Set MAT2 (0.1) high on match
 
-    /* Enable Port 0.1 as wakeup source. */
+    /* Use RISING EDGE for wakeup detection on P0.1 (CT32B0_MAT2) */
+    NVIC_EnableIRQ(WAKEUP1_IRQn);
+    SCB_STARTAPRP0 |= SCB_STARTAPRP0_APRPIO0_1;
     SCB_STARTERP0 |= SCB_STARTERP0_ERPIO0_1;
 
     // Reconfigure clock to run from WDTOSC
-    pmuWDTClockInit();
+    if (deep)
+      pmuWDTClockInit();
   
     /* Start the timer */
     TMR_TMR32B0TCR = TMR_TMR32B0TCR_COUNTERENABLE_ENABLED;
   }
 
+  pmuClockSaved = deep;
+  pmuDeepSleeping = true;
+
   __asm volatile ("WFI");
+
+  // WAKEUP_IRQHandler won't have run yet if interrupts are disabled
+  pmuRestoreClock();
+  SCB_SCR &= ~SCB_SCR_SLEEPDEEP;
+  pmuClearStartLogic();
+  pmuDeepSleeping = false;
+
+  elapsed = 0;
+  if (wakeupSeconds > 0)
+  {
+    TMR_TMR32B0TCR = TMR_TMR32B0TCR_COUNTERENABLE_DISABLED;
+
+    // MAT2 is only set if the timer expired, otherwise TC holds the time
+    if (TMR_TMR32B0EMR & TMR_TMR32B0EMR_EM2)
+      elapsed = wakeupSeconds * 1000;
+    else
+      elapsed = (uint32_t)(((uint64_t)TMR_TMR32B0TC * 1000) / PMU_WDTCLOCKSPEED_HZ);
+
+    // Hand the timer and pin back in the state they were found
+    TMR_TMR32B0TC = 0;
+    TMR_TMR32B0CTCR = ctcr;
+    TMR_TMR32B0PR = pr;
+    TMR_TMR32B0MR0 = mr0;
+    TMR_TMR32B0MCR = mcr;
+    TMR_TMR32B0EMR = emr;
+    IOCON_PIO0_1 = iocon;
+    TMR_TMR32B0TCR = tcr;
+
+    SCB_STARTERP0 = erp0;
+    SCB_STARTAPRP0 = aprp0;
+    if (!(erp0 & SCB_STARTERP0_ERPIO0_1))
+      NVIC_DisableIRQ(WAKEUP1_IRQn);
+  }
+  SCB_SYSAHBCLKCTRL = ahbClk;
+
+  // The time base stops in deep-sleep, so only the wakeup timer knows
+  // how long the device was asleep
+  pmuLastMs = pmuGetMs();
+  if (deep)
+  {
+    pmuStats.deepSleepMs += elapsed;
+    pmuStats.deepSleepCount++;
+  }
+  else
+  {
+    pmuStats.sleepMs += pmuLastMs - start;
+    pmuStats.sleepCount++;
+  }
+
+  // Perform peripheral specific and custom wakeup tasks
+  pmuRestoreHW();
+
   return;
 }
 
@@ -399,9 +678,13 @@ void pmuPowerDown( void )
 /**************************************************************************/
 void pmuSetupHW(void)
 {
-  #ifdef CFG_CHIBI
-    chb_sleep(TRUE);
-  #endif
+  uint32_t i;
+
+  for (i = 0; i < pmuHookCount; i++)
+  {
+    if (pmuSuspendHooks[i])
+      pmuSuspendHooks[i]();
+  }
 }
 
 /**************************************************************************/
@@ -412,8 +695,41 @@ void pmuSetupHW(void)
 /**************************************************************************/
 void pmuRestoreHW(void)
 {
-  #ifdef CFG_CHIBI
-    // Wakeup Chibi/Transceiver
-    chb_sleep(FALSE);
-  #endif
+  uint32_t i;
+
+  for (i = pmuHookCount; i > 0; i--)
+  {
+    if (pmuResumeHooks[i - 1])
+      pmuResumeHooks[i - 1]();
+  }
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Gets the time spent in each power state
+
+    The current active period is included up to the time of the call.
+
+    @param[out] stats
+                The structure to fill
+*/
+/**************************************************************************/
+void pmuGetStats(pmuStats_t *stats)
+{
+  uint32_t now = pmuGetMs();
+
+  pmuStats.activeMs += now - pmuLastMs;
+  pmuLastMs = now;
+  *stats = pmuStats;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Clears the power state statistics
+*/
+/**************************************************************************/
+void pmuResetStats(void)
+{
+  memset(&pmuStats, 0, sizeof(pmuStats));
+  pmuLastMs = pmuGetMs();
 }
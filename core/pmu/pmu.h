@@ -41,10 +41,55 @@
 
 #include "projectconfig.h"
 
+#define PMU_MAXHOOKS        (8)           // Number of suspend/resume hook pairs that can be registered
+
+typedef void (*pmuHook_t)(void);
+
+typedef enum
+{
+  PMU_ERROR_OK = 0,                       // Everything executed normally
+  PMU_ERROR_HOOKSFULL,                    // PMU_MAXHOOKS hook pairs are already registered
+  PMU_ERROR_INVALIDPIN,                   // The pin isn't connected to the start logic
+  PMU_ERROR_LAST
+}
+pmuError_e;
+
+typedef enum
+{
+  PMU_WAKEUPEDGE_FALLING = 0,
+  PMU_WAKEUPEDGE_RISING
+}
+pmuWakeupEdge_e;
+
+/**************************************************************************/
+/*!
+    Time spent in each power state since pmuInit or pmuResetStats.
+    Active and sleep time come from the systick (or the software timer
+    when CFG_SWTIMER is enabled).  Deep-sleep time is only known when a
+    wakeup timer was armed, since no clock is running otherwise.
+*/
+/**************************************************************************/
+typedef struct
+{
+  uint32_t activeMs;
+  uint32_t sleepMs;
+  uint32_t deepSleepMs;
+  uint32_t sleepCount;
+  uint32_t deepSleepCount;
+  uint32_t wakeupSources[2];              // SCB_STARTSRP0/1 at the last deep-sleep wakeup
+}
+pmuStats_t;
+
 void WAKEUP_IRQHandler( void );
 void pmuInit( void );
+pmuError_e pmuRegisterHooks(pmuHook_t suspend, pmuHook_t resume);
+pmuError_e pmuWakeupEnable(uint32_t portNum, uint32_t bitPos, pmuWakeupEdge_e edge);
+pmuError_e pmuWakeupDisable(uint32_t portNum, uint32_t bitPos);
+void pmuWakeupUSB(bool enable);
 void pmuSleep( void );
 void pmuDeepSleep(uint32_t sleepCtrl, uint32_t wakeupSeconds);
 void pmuPowerDown( void );
+void pmuGetStats(pmuStats_t *stats);
+void pmuResetStats( void );
 
 #endif
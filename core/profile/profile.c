@@ -0,0 +1,257 @@
+/**************************************************************************/
+/*!
+    @file     profile.c
+
+    @section DESCRIPTION
+
+    Cycle-accurate profiling using the Cortex-M3 DWT cycle counter.
+
+    Named probes (see PROFILE_DEFINE in profile.h) keep a count, the
+    min/max/total duration and a log4 histogram of the cycles spent
+    between PROFILE_START and PROFILE_STOP.  PROFILE_ISR_ENTER and
+    PROFILE_ISR_EXIT write timestamped events into a RAM ring buffer of
+    CFG_PROFILE_TRACESIZE entries, overwriting the oldest ones, so the
+    last few interrupts before a problem can be inspected.
+
+    The cycle counter wraps every 2^32 cycles (~60s at 72MHz), which is
+    fine for durations but not for absolute times.
+
+    When built for the host (as in tools/chibisim), CLOCK_MONOTONIC is
+    used instead and the 'cycles' are nanoseconds (PROFILE_CLOCK_HZ).
+
+    @section LICENSE
+
+    Software License Agreement (BSD License)
+
+    Copyright (c) 2012, microBuilder SARL
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+    1. Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holders nor the
+    names of its contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ''AS IS'' AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**************************************************************************/
+#include <string.h>
+
+#include "profile.h"
+#include "core/cpu/cpu.h"
+
+#ifndef __arm__
+  #include <time.h>
+#endif
+
+static profileProbe_t *_profileProbes = 0;
+static profileTraceEntry_t _profileTrace[CFG_PROFILE_TRACESIZE];
+static uint32_t _profileTraceHead = 0;
+static uint32_t _profileTraceCount = 0;
+
+#ifndef __arm__
+/**************************************************************************/
+/*!
+    @brief  Returns a free-running nanosecond count (host builds)
+*/
+/**************************************************************************/
+uint32_t profileGetCycles(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec);
+}
+#endif
+
+/**************************************************************************/
+/*!
+    @brief  Starts the DWT cycle counter
+*/
+/**************************************************************************/
+void profileInit(void)
+{
+  #ifdef __arm__
+    SCB_DEMCR |= SCB_DEMCR_TRCENA;
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+  #endif
+}
+
+/**************************************************************************/
+/*!
+    @brief  Adds a duration to a probe.  Normally called through
+            PROFILE_STOP.
+
+    @param[in]  probe
+                The probe to update
+    @param[in]  cycles
+                The duration in cycles
+*/
+/**************************************************************************/
+void profileRecord(profileProbe_t *probe, uint32_t cycles)
+{
+  uint32_t lock, bucket;
+
+  // Bucket n holds 4^n..4^(n+1)-1 cycles
+  bucket = (31 - __builtin_clz(cycles | 1)) >> 1;
+
+  lock = cpuLock();
+
+  if (probe->count == 0)
+  {
+    // First use: add the probe to the list (it stays listed on reset)
+    if (!probe->listed)
+    {
+      probe->next = _profileProbes;
+      _profileProbes = probe;
+      probe->listed = true;
+    }
+    probe->min = cycles;
+    probe->max = cycles;
+  }
+  else
+  {
+    if (cycles < probe->min)
+      probe->min = cycles;
+    if (cycles > probe->max)
+      probe->max = cycles;
+  }
+  probe->count++;
+  probe->total += cycles;
+  probe->histogram[bucket]++;
+
+  cpuUnlock(lock);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Writes an event into the trace buffer.  Normally called
+            through PROFILE_ISR_ENTER and PROFILE_ISR_EXIT.
+*/
+/**************************************************************************/
+void profileTrace(uint8_t id, uint8_t exit)
+{
+  uint32_t lock;
+  profileTraceEntry_t *entry;
+
+  lock = cpuLock();
+
+  entry = &_profileTrace[_profileTraceHead];
+  entry->cycles = profileGetCycles();
+  entry->id = id;
+  entry->exit = exit;
+
+  if (++_profileTraceHead == CFG_PROFILE_TRACESIZE)
+    _profileTraceHead = 0;
+  if (_profileTraceCount < CFG_PROFILE_TRACESIZE)
+    _profileTraceCount++;
+
+  cpuUnlock(lock);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Returns the first probe that has recorded a duration.  The
+            others follow through the next field.
+*/
+/**************************************************************************/
+profileProbe_t *profileGetProbes(void)
+{
+  return _profileProbes;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Copies a probe's statistics with interrupts disabled, so the
+            64-bit total, count and histogram all match even if the
+            probe is updated from an interrupt
+
+    @param[in]  probe
+                The probe to read, from profileGetProbes
+    @param[out] copy
+                The statistics at the time of the call
+*/
+/**************************************************************************/
+void profileGetProbe(const profileProbe_t *probe, profileProbe_t *copy)
+{
+  uint32_t lock;
+
+  lock = cpuLock();
+  *copy = *probe;
+  cpuUnlock(lock);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reads an event from the trace buffer
+
+    New events move the older ones down, so interrupts that are traced
+    should be quiet while the buffer is read.
+
+    @param[in]  index
+                The event to read, 0 being the oldest
+    @param[out] entry
+                The event
+
+    @returns    false if there are fewer than index + 1 events
+*/
+/**************************************************************************/
+bool profileGetTraceEntry(uint32_t index, profileTraceEntry_t *entry)
+{
+  uint32_t lock;
+  bool found = false;
+
+  lock = cpuLock();
+
+  if (index < _profileTraceCount)
+  {
+    index += _profileTraceHead + CFG_PROFILE_TRACESIZE - _profileTraceCount;
+    *entry = _profileTrace[index % CFG_PROFILE_TRACESIZE];
+    found = true;
+  }
+
+  cpuUnlock(lock);
+
+  return found;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Clears all probe statistics and the trace buffer
+*/
+/**************************************************************************/
+void profileReset(void)
+{
+  uint32_t lock;
+  profileProbe_t *probe;
+
+  lock = cpuLock();
+
+  for (probe = _profileProbes; probe; probe = probe->next)
+  {
+    probe->count = 0;
+    probe->min = 0;
+    probe->max = 0;
+    probe->total = 0;
+    memset(probe->histogram, 0, sizeof(probe->histogram));
+  }
+  _profileTraceHead = 0;
+  _profileTraceCount = 0;
+
+  cpuUnlock(lock);
+}
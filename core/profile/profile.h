@@ -0,0 +1,135 @@
+/**************************************************************************/
+/*!
+    @file     profile.h
+
+    @section LICENSE
+
+    Software License Agreement (BSD License)
+
+    Copyright (c) 2012, microBuilder SARL
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+    1. Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holders nor the
+    names of its contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ''AS IS'' AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**************************************************************************/
+
+#ifndef _PROFILE_H_
+#define _PROFILE_H_
+
+#include "projectconfig.h"
+
+#ifndef CFG_PROFILE_TRACESIZE
+  #define CFG_PROFILE_TRACESIZE (64)
+#endif
+
+#define PROFILE_BUCKETS     (16)          // Histogram bucket n counts durations of 4^n..4^(n+1)-1 cycles
+
+#ifdef __arm__
+  #define PROFILE_CLOCK_HZ  (CFG_CPU_CCLK)
+#else
+  #define PROFILE_CLOCK_HZ  (1000000000)  // clock_gettime backend counts in ns
+#endif
+
+/**************************************************************************/
+/*!
+    A named probe point, defined with PROFILE_DEFINE.  Probes add
+    themselves to the list returned by profileGetProbes the first time
+    they record a duration.
+*/
+/**************************************************************************/
+typedef struct profileProbe_s
+{
+  const char *            name;
+  struct profileProbe_s * next;
+  bool                    listed;
+  uint32_t                count;
+  uint32_t                min;              // Durations in cycles
+  uint32_t                max;
+  uint64_t                total;
+  uint32_t                histogram[PROFILE_BUCKETS];
+} profileProbe_t;
+
+typedef struct
+{
+  uint32_t cycles;                          // Cycle counter at the event
+  uint8_t  id;                              // Usually the IRQ number
+  uint8_t  exit;                            // 0 on ISR entry, 1 on exit
+} profileTraceEntry_t;
+
+/**************************************************************************/
+/*!
+    Probe macros.  These compile to nothing unless CFG_PROFILE is
+    defined, so probes can be left in drivers.
+
+    @code
+    PROFILE_DEFINE(fill, "lcdFillRGB");
+
+    void drawFill(uint16_t color)
+    {
+      PROFILE_START(fill);
+      lcdFillRGB(color);
+      PROFILE_STOP(fill);
+    }
+    @endcode
+
+    PROFILE_START declares a local variable, so a probe can only be
+    started once per block.
+*/
+/**************************************************************************/
+#ifdef CFG_PROFILE
+  #define PROFILE_DEFINE(probe, label)  static profileProbe_t profileProbe_##probe = { .name = label }
+  #define PROFILE_START(probe)          uint32_t profileStart_##probe = profileGetCycles()
+  #define PROFILE_STOP(probe)           profileRecord(&profileProbe_##probe, profileGetCycles() - profileStart_##probe)
+  #define PROFILE_ISR_ENTER(id)         profileTrace((id), 0)
+  #define PROFILE_ISR_EXIT(id)          profileTrace((id), 1)
+#else
+  #define PROFILE_DEFINE(probe, label)  extern int profileUnused_##probe
+  #define PROFILE_START(probe)          do { } while (0)
+  #define PROFILE_STOP(probe)           do { } while (0)
+  #define PROFILE_ISR_ENTER(id)         do { } while (0)
+  #define PROFILE_ISR_EXIT(id)          do { } while (0)
+#endif
+
+#ifdef __arm__
+/**************************************************************************/
+/*!
+    @brief  Returns the DWT cycle counter
+*/
+/**************************************************************************/
+static inline uint32_t profileGetCycles(void)
+{
+  return DWT_CYCCNT;
+}
+#else
+uint32_t  profileGetCycles (void);
+#endif
+
+void            profileInit (void);
+void            profileRecord (profileProbe_t *probe, uint32_t cycles);
+void            profileTrace (uint8_t id, uint8_t exit);
+profileProbe_t *profileGetProbes (void);
+void            profileGetProbe (const profileProbe_t *probe, profileProbe_t *copy);
+bool            profileGetTraceEntry (uint32_t index, profileTraceEntry_t *entry);
+void            profileReset (void);
+
+#endif
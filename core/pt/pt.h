@@ -0,0 +1,174 @@
+/**************************************************************************/
+/*!
+    @file     pt.h
+
+    @section DESCRIPTION
+
+    Stackless cooperative threads ('protothreads', after the design by
+    Adam Dunkels) for long driver sequences that would otherwise block
+    in systickDelay.
+
+    A protothread is a function declared with PT_THREAD that returns
+    whenever it has to wait, and continues after the PT_WAIT_xxx or
+    PT_DELAY_MS it stopped at the next time it is called.  Each thread
+    only needs a pt_t (8 bytes) to remember where it is, so several
+    device sequences can be run side by side from the main loop by
+    calling their threads in turn.
+
+    Since the function returns while waiting, local variables are lost
+    across PT_WAIT_xxx, PT_DELAY_MS and PT_YIELD: anything that has to
+    be kept must be static, or passed in by the caller.  A protothread
+    also can't use a switch statement around a wait, or have two waits
+    on the same line, since the waits are case labels numbered by
+    __LINE__.
+
+    PT_DELAY_MS uses the systick tick count, so the systick must be
+    running while a thread is waiting (see swtimerSuspendTick).
+
+    @section Example
+
+    @code
+    #include "core/pt/pt.h"
+
+    static PT_THREAD(blink(pt_t *pt))
+    {
+      PT_BEGIN(pt);
+      while (1)
+      {
+        gpioSetValue (CFG_LED_PORT, CFG_LED_PIN, CFG_LED_ON);
+        PT_DELAY_MS(pt, 100);
+        gpioSetValue (CFG_LED_PORT, CFG_LED_PIN, CFG_LED_OFF);
+        PT_DELAY_MS(pt, 900);
+      }
+      PT_END(pt);
+    }
+
+    pt_t blinkPT, tempPT;
+    uint8_t celsius;
+    isl12022mError_t error;
+
+    PT_INIT(&blinkPT);
+    PT_INIT(&tempPT);
+    while (1)
+    {
+      blink(&blinkPT);
+      if (!PT_SCHEDULE(isl12022mGetTempPT(&tempPT, &celsius, &error)))
+      {
+        // The temperature conversion is done, start the next one
+        printf("%u C%s", celsius, CFG_PRINTF_NEWLINE);
+      }
+    }
+    @endcode
+
+    @section LICENSE
+
+    Software License Agreement (BSD License)
+
+    Copyright (c) 2012, microBuilder SARL
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+    1. Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holders nor the
+    names of its contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ''AS IS'' AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**************************************************************************/
+
+#ifndef _PT_H_
+#define _PT_H_
+
+#include "projectconfig.h"
+#include "core/systick/systick.h"
+
+#define PT_WAITING    (0)     // Waiting on a condition or delay
+#define PT_YIELDED    (1)     // Gave up the CPU with PT_YIELD
+#define PT_EXITED     (2)     // Stopped with PT_EXIT
+#define PT_ENDED      (3)     // Reached PT_END
+
+/**************************************************************************/
+/*!
+    The state of one protothread.  Only PT_INIT should be used on it
+    outside of the thread itself.
+*/
+/**************************************************************************/
+typedef struct
+{
+  uint16_t  lc;               // Line to continue from (0 to start over)
+  uint32_t  ticks;            // Tick count when PT_DELAY_MS started
+} pt_t;
+
+// Declares a protothread: PT_THREAD(name(pt_t *pt, ...))
+#define PT_THREAD(name_args)      char name_args
+
+// Starts (or restarts) a thread from the top
+#define PT_INIT(pt)               do { (pt)->lc = 0; } while (0)
+
+// Must enclose the body of every protothread
+#define PT_BEGIN(pt)              { char PT_YIELD_FLAG = 1; (void)PT_YIELD_FLAG; switch ((pt)->lc) { case 0:
+#define PT_END(pt)                } PT_INIT(pt); return PT_ENDED; }
+
+// Returns until 'condition' is true
+#define PT_WAIT_UNTIL(pt, condition)            \
+  do {                                          \
+    (pt)->lc = __LINE__; case __LINE__:         \
+    if (!(condition)) return PT_WAITING;        \
+  } while (0)
+
+#define PT_WAIT_WHILE(pt, condition)  PT_WAIT_UNTIL((pt), !(condition))
+
+// Runs a child thread until it ends
+#define PT_WAIT_THREAD(pt, thread)    PT_WAIT_WHILE((pt), PT_SCHEDULE(thread))
+
+// Starts a child thread with its own pt_t and runs it until it ends
+#define PT_SPAWN(pt, child, thread)             \
+  do {                                          \
+    PT_INIT((child));                           \
+    PT_WAIT_THREAD((pt), (thread));             \
+  } while (0)
+
+// Returns once, to let the other threads run
+#define PT_YIELD(pt)                            \
+  do {                                          \
+    PT_YIELD_FLAG = 0;                          \
+    (pt)->lc = __LINE__; case __LINE__:         \
+    if (PT_YIELD_FLAG == 0) return PT_YIELDED;  \
+  } while (0)
+
+// Stops the thread (it starts over from PT_BEGIN on the next call)
+#define PT_EXIT(pt)               do { PT_INIT(pt); return PT_EXITED; } while (0)
+
+// Returns until at least 'ms' milliseconds have passed
+#define PT_DELAY_MS(pt, ms)                     \
+  do {                                          \
+    (pt)->ticks = systickGetTicks();            \
+    PT_WAIT_UNTIL((pt), (systickGetTicks() - (pt)->ticks) >= (uint32_t)(ms) / CFG_SYSTICK_DELAY_IN_MS); \
+  } while (0)
+
+// Runs a thread once, evaluating to true while it hasn't ended or exited
+#define PT_SCHEDULE(f)            ((f) < PT_EXITED)
+
+// Runs a thread to completion, busy-waiting like the blocking drivers do
+#define PT_RUN(pt, thread)                      \
+  do {                                          \
+    PT_INIT((pt));                              \
+    while (PT_SCHEDULE(thread));                \
+  } while (0)
+
+#endif
@@ -28,6 +28,28 @@
 
     @endcode
 
+    A sequence of (frequency, duty cycle, duration) steps can also be
+    played in the background.  The timer interrupt moves on to the next
+    step, so the main loop is free while the sequence plays:
+
+    @code
+    #include "core/pwm/pwm.h"
+    ...
+
+    // Two beeps on the buzzer (P1.9) while an LED on P1.10 fades in
+    static const pwmStep_t alert[] =
+    {
+      { 4000, { 5000,    0 }, 100 },
+      {    0, {    0,    0 },  50 },
+      { 4000, { 5000, 3000 }, 100 },
+      { 2000, { 5000, 6000 }, 300 },
+    };
+
+    pwmInit();
+    pwmEnableChannel(1);
+    pwmSequenceStart(alert, sizeof(alert) / sizeof(pwmStep_t), false, 0);
+    @endcode
+
     @section LICENSE
 
     Software License Agreement (BSD License)
@@ -63,6 +85,15 @@
 uint32_t pwmPulseWidth = CFG_PWM_DEFAULT_PULSEWIDTH;
 uint32_t pwmDutyCycle = CFG_PWM_DEFAULT_DUTYCYCLE;
 
+// State of the sequence played by pwmSequenceStart (updated by the ISR)
+static const pwmStep_t * volatile pwmSequence = 0;
+static uint16_t pwmSequenceCount = 0;
+static uint16_t pwmSequenceIndex = 0;
+static bool pwmSequenceLoop = false;
+static bool pwmSequenceEnding = false;
+static uint32_t pwmSequencePeriodsLeft = 0;
+static pwmSequenceCallback_t pwmSequenceDone = 0;
+
 // pwmMaxPulses is used by TIMER16_1_IRQHandler to turn PWM off after
 // a specified number of pulses have been sent.  This only relevant when
 // pwmStartFixed() is used.
@@ -107,6 +138,38 @@ void pwmInit(void)
   NVIC_EnableIRQ(TIMER_16_1_IRQn);
 }
 
+/**************************************************************************/
+/*! 
+    Enables the output of an additional PWM channel.  Channel 0 (MAT0,
+    P1.9) is enabled by pwmInit, and channel 1 (MAT1, P1.10) is only
+    used by pwmSequenceStart.
+
+    @returns    -1 if an invalid channel was supplied.
+*/
+/**************************************************************************/
+int pwmEnableChannel(uint8_t channel)
+{
+  switch (channel)
+  {
+    case 0:
+      IOCON_PIO1_9 &= ~IOCON_PIO1_9_FUNC_MASK;
+      IOCON_PIO1_9 |= IOCON_PIO1_9_FUNC_CT16B1_MAT0;
+      TMR_TMR16B1PWMC |= TMR_TMR16B1PWMC_PWM0_ENABLED;
+      break;
+    case 1:
+      /* Keep the output low until a sequence sets a duty cycle for it */
+      TMR_TMR16B1MR1 = 0xFFFF;
+      IOCON_PIO1_10 &= ~IOCON_PIO1_10_FUNC_MASK;
+      IOCON_PIO1_10 |= IOCON_PIO1_10_FUNC_CT16B1_MAT1;
+      TMR_TMR16B1PWMC |= TMR_TMR16B1PWMC_PWM1_ENABLED;
+      break;
+    default:
+      return -1;
+  }
+
+  return 0;
+}
+
 /**************************************************************************/
 /*! 
     Starts the PWM output
@@ -123,11 +186,14 @@ void pwmStart(void)
 
 /**************************************************************************/
 /*! 
-    Stops the PWM output
+    Stops the PWM output (and any sequence that is playing)
 */
 /**************************************************************************/
 void pwmStop(void)
 {
+  /* End any sequence started by pwmSequenceStart */
+  pwmSequenceStop();
+
   /* Disable Timer1 */
   TMR_TMR16B1TCR &= ~(TMR_TMR16B1TCR_COUNTERENABLE_MASK);
 }
@@ -251,4 +317,177 @@ int pwmSetFrequencyInMicroseconds(uint16_t us)
   return 0;  
 }
 
+/**************************************************************************/
+/*! 
+    Private - Sets up the timer for one step of the sequence.  The
+    prescaler is picked so that the period fits in 16 bits, which
+    allows anything from 1Hz (servos, slow LED fades) up to tens of
+    kHz.
+*/
+/**************************************************************************/
+static void pwmSequenceLoad(const pwmStep_t *step)
+{
+  uint32_t frequency, ticks, prescale, period, duty;
+
+  /* Pauses are timed with a 1kHz period */
+  frequency = step->frequency ? step->frequency : 1000;
+
+  ticks = (CFG_CPU_CCLK/SCB_SYSAHBCLKDIV) / frequency;
+  prescale = ticks / 0x10000 + 1;
+  period = ticks / prescale;
+
+  /* Start a fresh period with the new settings (the prescale counter
+     has to be cleared too in case it is above the new prescaler) */
+  TMR_TMR16B1PR = prescale - 1;
+  TMR_TMR16B1PC = 0;
+  TMR_TMR16B1TC = 0;
+  TMR_TMR16B1MR3 = pwmPulseWidth = period - 1;
+
+  /* The output goes high when TC reaches MRx, so a match value above
+     MR3 keeps it low and 0 keeps it high */
+  duty = step->frequency ? step->duty[0] : 0;
+  TMR_TMR16B1MR0 = duty >= PWM_DUTY_MAX ? 0 : (period * (PWM_DUTY_MAX - duty)) / PWM_DUTY_MAX;
+  duty = step->frequency ? step->duty[1] : 0;
+  TMR_TMR16B1MR1 = duty >= PWM_DUTY_MAX ? 0 : (period * (PWM_DUTY_MAX - duty)) / PWM_DUTY_MAX;
+
+  pwmSequencePeriodsLeft = ((uint32_t)step->duration * frequency + 500) / 1000;
+  if (!pwmSequencePeriodsLeft)
+  {
+    pwmSequencePeriodsLeft = 1;
+  }
+}
+
+/**************************************************************************/
+/*! 
+    Private - Stops the timer at the end of a sequence, and puts the
+    prescaler set by pwmSequenceLoad back to 1 for pwmStart and
+    pwmSetFrequencyInTicks
+*/
+/**************************************************************************/
+static void pwmSequenceHalt(void)
+{
+  pwmSequence = 0;
+  TMR_TMR16B1MCR &= ~(TMR_TMR16B1MCR_MR3_INT_MASK);
+  TMR_TMR16B1TCR &= ~(TMR_TMR16B1TCR_COUNTERENABLE_MASK);
+  TMR_TMR16B1PR = 0;
+  TMR_TMR16B1PC = 0;
+}
+
+/**************************************************************************/
+/*! 
+    Plays a sequence of steps in the background.  Each step sets the
+    frequency and the duty cycle of every channel for a number of
+    milliseconds.  The timer interrupt counts the periods and moves on
+    to the next step, so nothing needs to be done while it plays.
+
+    @param[in]  steps
+                The steps to play.  This buffer must stay valid until
+                the sequence ends (or is stopped).
+    @param[in]  count
+                The number of steps in the buffer
+    @param[in]  loop
+                Start over from the first step after the last one,
+                until pwmSequenceStop is called
+    @param[in]  done
+                Called from the timer interrupt once the sequence has
+                ended (0 if not needed)
+
+    @returns    -1 if no steps were supplied.
+
+    @note       The sequence takes over the PWM settings, so the values
+                set with pwmSetDutyCycle and pwmSetFrequencyInTicks are
+                lost.  All channels share the frequency of the step.
+*/
+/**************************************************************************/
+int pwmSequenceStart(const pwmStep_t *steps, uint16_t count, bool loop, pwmSequenceCallback_t done)
+{
+  if ((steps == 0) || (count == 0))
+  {
+    return -1;
+  }
+
+  pwmSequenceStop();
+
+  pwmMaxPulses = 0;
+  pwmSequenceCount = count;
+  pwmSequenceIndex = 0;
+  pwmSequenceLoop = loop;
+  pwmSequenceEnding = false;
+  pwmSequenceDone = done;
+  pwmSequenceLoad(&steps[0]);
+  pwmSequence = steps;
+
+  /* Interrupt at the end of each period (MR3) to count the periods */
+  TMR_TMR16B1MCR |= (TMR_TMR16B1MCR_MR3_INT_ENABLED);
+  TMR_TMR16B1TCR = TMR_TMR16B1TCR_COUNTERENABLE_ENABLED;
+
+  return 0;
+}
+
+/**************************************************************************/
+/*! 
+    Stops the sequence started by pwmSequenceStart straight away (the
+    'done' callback isn't called)
+*/
+/**************************************************************************/
+void pwmSequenceStop(void)
+{
+  NVIC_DisableIRQ(TIMER_16_1_IRQn);
+  if (pwmSequence)
+  {
+    pwmSequenceHalt();
+  }
+  NVIC_EnableIRQ(TIMER_16_1_IRQn);
+}
 
+/**************************************************************************/
+/*! 
+    Returns true while a sequence is playing
+*/
+/**************************************************************************/
+bool pwmSequenceIsPlaying(void)
+{
+  return pwmSequence != 0;
+}
+
+/**************************************************************************/
+/*! 
+    Called by TIMER16_1_IRQHandler at the end of every PWM period
+    (see "core/timer16/timer16.c") to move the sequence along
+*/
+/**************************************************************************/
+void pwmSequenceTick(void)
+{
+  if (!pwmSequence || --pwmSequencePeriodsLeft)
+  {
+    return;
+  }
+
+  if (pwmSequenceEnding)
+  {
+    /* The outputs have been low for a full period, stop the timer */
+    pwmSequenceHalt();
+    if (pwmSequenceDone)
+    {
+      pwmSequenceDone();
+    }
+    return;
+  }
+
+  if (++pwmSequenceIndex >= pwmSequenceCount)
+  {
+    if (!pwmSequenceLoop)
+    {
+      /* Run one more period with the outputs low, so that the timer
+         doesn't stop with an output left high */
+      TMR_TMR16B1MR0 = 0xFFFF;
+      TMR_TMR16B1MR1 = 0xFFFF;
+      pwmSequenceEnding = true;
+      pwmSequencePeriodsLeft = 1;
+      return;
+    }
+    pwmSequenceIndex = 0;
+  }
+
+  pwmSequenceLoad(&pwmSequence[pwmSequenceIndex]);
+}
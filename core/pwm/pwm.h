@@ -39,12 +39,35 @@
 
 #include "projectconfig.h"
 
+#define PWM_CHANNELS      (2)         // MAT0 (P1.9) and MAT1 (P1.10) on 16-bit Timer 1
+#define PWM_DUTY_MAX      (10000)     // pwmStep_t duty cycles are in 0.01% units
+
+/**************************************************************************/
+/*!
+    One step of a waveform sequence (see pwmSequenceStart).  All the
+    channels share the same frequency.
+*/
+/**************************************************************************/
+typedef struct
+{
+  uint16_t  frequency;              // Frequency in Hz (0 for a pause with all outputs low)
+  uint16_t  duty[PWM_CHANNELS];     // Duty cycle of each channel (0..PWM_DUTY_MAX)
+  uint16_t  duration;               // Duration of the step in milliseconds
+} pwmStep_t;
+
+typedef void (*pwmSequenceCallback_t)( void );
+
 void pwmInit( void );
+int  pwmEnableChannel( uint8_t channel );
 void pwmStart( void );
 void pwmStop( void );
 void pwmStartFixed( uint32_t pulses );
 int  pwmSetDutyCycle( uint32_t percentage );
 int  pwmSetFrequencyInTicks( uint16_t ticks );
 int  pwmSetFrequencyInMicroseconds(uint16_t us );
+int  pwmSequenceStart( const pwmStep_t *steps, uint16_t count, bool loop, pwmSequenceCallback_t done );
+void pwmSequenceStop( void );
+bool pwmSequenceIsPlaying( void );
+void pwmSequenceTick( void );
 
 #endif
\ No newline at end of file
@@ -0,0 +1,477 @@
+/**************************************************************************/
+/*!
+    @file     swtimer.c
+
+    @section DESCRIPTION
+
+    Software timers and a 64-bit microsecond clock, using CT32B1.
+
+    CT32B1 runs freely at 1MHz, and MR1 counts its rollovers to extend
+    it to 64 bits (swtimerGetMicroseconds), so the clock never wraps
+    and has no tick jitter.
+
+    Timers are kept in a list sorted by expiry time, and MR0 is only
+    programmed with the expiry time of the first one.  There is no
+    periodic interrupt: CT32B1 only interrupts when a timer is due (or
+    once every ~71 minutes when the counter rolls over).  The interrupt
+    handler just flags that a timer is due.  The callbacks run from
+    swtimerTask, called from the main loop, so they can use drivers
+    that wait on other interrupts (I2C, etc.).
+
+    To sleep between timers, call swtimerSuspendTick before pmuSleep
+    and swtimerResumeTick after it, so that the 1ms systick interrupt
+    doesn't wake the MCU up.  The systick tick count is corrected on
+    resume.
+
+    CT32B1 can't be used by timer32 when CFG_SWTIMER is defined.
+
+    @section Example
+
+    @code
+    #include "core/swtimer/swtimer.h"
+    #include "core/pmu/pmu.h"
+
+    static swtimer_t blinkTimer;
+    static swtimer_t timeoutTimer;
+
+    static void blink(void *arg)
+    {
+      gpioSetValue (CFG_LED_PORT, CFG_LED_PIN, gpioGetValue(CFG_LED_PORT, CFG_LED_PIN) ? 0 : 1);
+    }
+
+    static void timeout(void *arg)
+    {
+      swtimerStop(&blinkTimer);
+    }
+
+    swtimerInit();
+    // Toggle the LED every 250ms, and stop after 10s
+    swtimerStart(&blinkTimer, 250000, 250000, blink, 0);
+    swtimerStart(&timeoutTimer, 10000000, 0, timeout, 0);
+
+    while (1)
+    {
+      swtimerTask();
+      __disable_irq();
+      if (!swtimerPending())
+      {
+        swtimerSuspendTick();
+        pmuSleep();
+        swtimerResumeTick();
+      }
+      __enable_irq();
+    }
+    @endcode
+
+    @section LICENSE
+
+    Software License Agreement (BSD License)
+
+    Copyright (c) 2012, microBuilder SARL
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+    1. Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holders nor the
+    names of its contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ''AS IS'' AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**************************************************************************/
+#include "swtimer.h"
+
+#ifdef CFG_SWTIMER
+
+#include "core/cpu/cpu.h"
+#include "core/systick/systick.h"
+
+static swtimer_t * _swtimerHead = 0;
+static volatile uint32_t _swtimerRollovers = 0;
+static volatile bool _swtimerDue = false;
+static uint64_t _swtimerTickSuspended = 0;
+static uint32_t _swtimerTickRemainder = 0;
+static bool _swtimerInitialised = false;
+
+/**************************************************************************/
+/*!
+    @brief  CT32B1 interrupt handler.  MR1 marks a rollover of the
+            counter and MR0 the expiry of the first timer.
+*/
+/**************************************************************************/
+void TIMER32_1_IRQHandler(void)
+{
+  uint32_t flags = TMR_TMR32B1IR;
+
+  TMR_TMR32B1IR = flags;
+
+  if (flags & TMR_TMR32B1IR_MR1)
+  {
+    _swtimerRollovers++;
+  }
+
+  // Also set when the interrupt is pended by swtimerProgram
+  if (!(flags & TMR_TMR32B1IR_MR1) || (flags & TMR_TMR32B1IR_MR0))
+  {
+    _swtimerDue = true;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Inserts a timer in the list, keeping it sorted by expiry
+            time (timers with the same expiry time run in the order
+            they were added).  Must be called with the lock held.
+*/
+/**************************************************************************/
+static void swtimerInsert(swtimer_t *timer)
+{
+  swtimer_t **link = &_swtimerHead;
+
+  while (*link && ((*link)->expiry <= timer->expiry))
+  {
+    link = &(*link)->next;
+  }
+  timer->next = *link;
+  *link = timer;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Removes a timer from the list.  Must be called with the
+            lock held.
+*/
+/**************************************************************************/
+static void swtimerRemove(swtimer_t *timer)
+{
+  swtimer_t **link = &_swtimerHead;
+
+  while (*link && (*link != timer))
+  {
+    link = &(*link)->next;
+  }
+  if (*link)
+  {
+    *link = timer->next;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets MR0 to the expiry time of the first timer, or turns it
+            off if there are no timers.  If the first timer has already
+            expired, swtimerPending is set instead.  Must be called
+            with the lock held.
+
+    @return true if the first timer has already expired
+*/
+/**************************************************************************/
+static bool swtimerProgram(void)
+{
+  uint64_t now, delta;
+
+  if (!_swtimerHead)
+  {
+    TMR_TMR32B1MCR = TMR_TMR32B1MCR_MR1_INT_ENABLED;
+    return false;
+  }
+
+  now = swtimerGetMicroseconds();
+  if (_swtimerHead->expiry <= now)
+  {
+    _swtimerDue = true;
+    return true;
+  }
+
+  // MR0 only holds the lower 32 bits, so wake up half way to
+  // timers that are further away and reprogram then
+  delta = _swtimerHead->expiry - now;
+  if (delta > 0x80000000)
+  {
+    delta = 0x80000000;
+  }
+  TMR_TMR32B1MR0 = (uint32_t)(now + delta);
+  TMR_TMR32B1MCR = TMR_TMR32B1MCR_MR0_INT_ENABLED | TMR_TMR32B1MCR_MR1_INT_ENABLED;
+
+  // The counter may have passed MR0 while it was being set, in which
+  // case there won't be a match, so pend the interrupt instead
+  if ((int32_t)(TMR_TMR32B1MR0 - TMR_TMR32B1TC) <= 0)
+  {
+    NVIC_SetPendingIRQ(TIMER_32_1_IRQn);
+  }
+
+  return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Starts CT32B1 as a free-running 1MHz counter
+*/
+/**************************************************************************/
+void swtimerInit(void)
+{
+  if (_swtimerInitialised) return;
+
+  /* Enable the clock for CT32B1 */
+  SCB_SYSAHBCLKCTRL |= (SCB_SYSAHBCLKCTRL_CT32B1);
+
+  TMR_TMR32B1TCR = TMR_TMR32B1TCR_COUNTERRESET_ENABLED;
+  TMR_TMR32B1PR = ((CFG_CPU_CCLK/SCB_SYSAHBCLKDIV) / 1000000) - 1;
+
+  /* Count rollovers (MR1 matches on the last count before 0) */
+  TMR_TMR32B1MR1 = 0xFFFFFFFF;
+  TMR_TMR32B1MCR = TMR_TMR32B1MCR_MR1_INT_ENABLED;
+  TMR_TMR32B1IR = TMR_TMR32B1IR_MR0 | TMR_TMR32B1IR_MR1;
+
+  _swtimerHead = 0;
+  _swtimerRollovers = 0;
+  _swtimerDue = false;
+  _swtimerInitialised = true;
+
+  NVIC_EnableIRQ(TIMER_32_1_IRQn);
+  TMR_TMR32B1TCR = TMR_TMR32B1TCR_COUNTERENABLE_ENABLED;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Returns the number of microseconds since swtimerInit was
+            called.  This is safe to call from an interrupt or with
+            interrupts disabled.
+*/
+/**************************************************************************/
+uint64_t swtimerGetMicroseconds(void)
+{
+  uint32_t rollovers, count, flags;
+
+  // Make sure the rollover count and the counter belong together
+  do
+  {
+    rollovers = _swtimerRollovers;
+    count = TMR_TMR32B1TC;
+    flags = TMR_TMR32B1IR;
+  } while (rollovers != _swtimerRollovers);
+
+  // A rollover that hasn't been serviced yet leaves the counter near 0
+  if ((flags & TMR_TMR32B1IR_MR1) && (count < 0x80000000))
+  {
+    rollovers++;
+  }
+
+  return ((uint64_t)rollovers << 32) | count;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Causes a blocking delay of 'delayUs' microseconds
+*/
+/**************************************************************************/
+void swtimerDelayUs(uint32_t delayUs)
+{
+  uint32_t start = TMR_TMR32B1TC;
+
+  // Unsigned arithmetic takes care of the counter rolling over
+  while ((TMR_TMR32B1TC - start) < delayUs);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Starts (or restarts) a timer
+
+    @param[in]  timer
+                The timer.  It must stay valid until it has expired or
+                has been stopped.
+    @param[in]  delayUs
+                Microseconds until the first callback
+    @param[in]  periodUs
+                Microseconds between callbacks after the first one, or
+                0 for a one-shot timer.  Periodic timers don't drift:
+                each expiry time is the previous one + periodUs, and
+                periods that were missed completely are skipped.
+    @param[in]  callback
+                Function called from swtimerTask when the timer expires
+    @param[in]  arg
+                Passed to callback
+
+    @note       This can be called from an interrupt or a callback.
+*/
+/**************************************************************************/
+void swtimerStart(swtimer_t *timer, uint32_t delayUs, uint32_t periodUs, swtimerCallback_t callback, void *arg)
+{
+  uint32_t lock;
+
+  if (!_swtimerInitialised) swtimerInit();
+
+  lock = cpuLock();
+  if (timer->active)
+  {
+    swtimerRemove(timer);
+  }
+  timer->expiry = swtimerGetMicroseconds() + delayUs;
+  timer->period = periodUs;
+  timer->callback = callback;
+  timer->arg = arg;
+  timer->active = true;
+  swtimerInsert(timer);
+
+  // Only the first timer needs a match
+  if (_swtimerHead == timer)
+  {
+    swtimerProgram();
+  }
+  cpuUnlock(lock);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Stops a timer.  Nothing happens if it isn't running.
+
+    @note       This can be called from an interrupt or a callback.
+*/
+/**************************************************************************/
+void swtimerStop(swtimer_t *timer)
+{
+  uint32_t lock;
+
+  lock = cpuLock();
+  if (timer->active)
+  {
+    swtimerRemove(timer);
+    timer->active = false;
+    swtimerProgram();
+  }
+  cpuUnlock(lock);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Returns true if the timer is running
+*/
+/**************************************************************************/
+bool swtimerIsActive(swtimer_t *timer)
+{
+  return timer->active;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Returns true if a timer has expired and swtimerTask needs
+            to run.  Check this with interrupts disabled before going
+            to sleep, since a timer may expire in between.
+*/
+/**************************************************************************/
+bool swtimerPending(void)
+{
+  return _swtimerDue;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Runs the callbacks of all of the timers that have expired.
+            This must be called from the main loop.
+
+    @return The number of microseconds until the next timer expires,
+            or SWTIMER_NONE if no timers are running
+*/
+/**************************************************************************/
+uint32_t swtimerTask(void)
+{
+  swtimer_t *timer;
+  uint64_t now, remaining;
+  uint32_t lock, missed;
+
+  if (!_swtimerInitialised) return SWTIMER_NONE;
+
+  _swtimerDue = false;
+
+  while (1)
+  {
+    lock = cpuLock();
+    now = swtimerGetMicroseconds();
+    timer = _swtimerHead;
+    if (!timer || (timer->expiry > now))
+    {
+      // Nothing is due yet, so set the match for the next timer
+      if (!swtimerProgram())
+      {
+        break;
+      }
+      cpuUnlock(lock);
+      continue;
+    }
+
+    // Remove the timer before calling it, so the callback can restart
+    // or stop it
+    _swtimerHead = timer->next;
+    if (timer->period)
+    {
+      missed = (now - timer->expiry) / timer->period;
+      timer->expiry += (uint64_t)(missed + 1) * timer->period;
+      swtimerInsert(timer);
+    }
+    else
+    {
+      timer->active = false;
+    }
+    cpuUnlock(lock);
+
+    timer->callback(timer->arg);
+  }
+
+  if (!_swtimerHead)
+  {
+    cpuUnlock(lock);
+    return SWTIMER_NONE;
+  }
+
+  remaining = _swtimerHead->expiry - now;
+  cpuUnlock(lock);
+
+  return remaining >= SWTIMER_NONE ? SWTIMER_NONE - 1 : (uint32_t)remaining;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Stops the systick interrupt, so that only the software
+            timers and other interrupts wake the MCU up.  The systick
+            tick count doesn't advance until swtimerResumeTick is
+            called, so systickDelay can't be used in between.
+*/
+/**************************************************************************/
+void swtimerSuspendTick(void)
+{
+  if (!_swtimerInitialised) swtimerInit();
+
+  _swtimerTickSuspended = swtimerGetMicroseconds();
+  systickSuspend();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Restarts the systick interrupt after swtimerSuspendTick,
+            adding the ticks that were missed to the tick count
+*/
+/**************************************************************************/
+void swtimerResumeTick(void)
+{
+  uint64_t elapsed;
+
+  elapsed = swtimerGetMicroseconds() - _swtimerTickSuspended + _swtimerTickRemainder;
+  _swtimerTickRemainder = elapsed % (CFG_SYSTICK_DELAY_IN_MS * 1000);
+  systickResume(elapsed / (CFG_SYSTICK_DELAY_IN_MS * 1000));
+}
+
+#endif
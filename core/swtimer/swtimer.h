@@ -0,0 +1,73 @@
+/**************************************************************************/
+/*!
+    @file     swtimer.h
+
+    @section LICENSE
+
+    Software License Agreement (BSD License)
+
+    Copyright (c) 2012, microBuilder SARL
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+    1. Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holders nor the
+    names of its contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ''AS IS'' AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**************************************************************************/
+
+#ifndef _SWTIMER_H_
+#define _SWTIMER_H_
+
+#include "projectconfig.h"
+
+#define SWTIMER_NONE      (0xFFFFFFFF)    // Returned by swtimerTask when no timers are running
+
+typedef void (*swtimerCallback_t)(void *arg);
+
+/**************************************************************************/
+/*!
+    A software timer.  The memory is supplied by the caller and must
+    stay valid while the timer is running; the fields are managed by
+    swtimerStart and swtimerStop.
+*/
+/**************************************************************************/
+typedef struct swtimer_s
+{
+  struct swtimer_s *  next;
+  uint64_t            expiry;         // Time of the next callback in us
+  uint32_t            period;         // Time between callbacks in us (0 for a one-shot timer)
+  swtimerCallback_t   callback;
+  void *              arg;
+  bool                active;
+} swtimer_t;
+
+void      swtimerInit (void);
+uint64_t  swtimerGetMicroseconds (void);
+void      swtimerDelayUs (uint32_t delayUs);
+void      swtimerStart (swtimer_t *timer, uint32_t delayUs, uint32_t periodUs, swtimerCallback_t callback, void *arg);
+void      swtimerStop (swtimer_t *timer);
+bool      swtimerIsActive (swtimer_t *timer);
+bool      swtimerPending (void);
+uint32_t  swtimerTask (void);
+void      swtimerSuspendTick (void);
+void      swtimerResumeTick (void);
+
+#endif
@@ -68,6 +68,10 @@
 volatile uint32_t fatTicks = 0;
 #endif
 
+#ifdef CFG_SWTIMER
+#include "core/swtimer/swtimer.h"
+#endif
+
 volatile uint32_t systickTicks = 0;             // 1ms tick counter
 volatile uint32_t systickRollovers = 0;
 
@@ -162,7 +166,8 @@ void systickInit (uint32_t delayMs)
 
     @Note       This function takes into account the fact that the tick
                 counter may eventually roll over to 0 once it reaches
-                0xFFFFFFFF.
+                0xFFFFFFFF (the unsigned subtraction below still gives
+                the number of elapsed ticks).
 */
 /**************************************************************************/
 void systickDelay (uint32_t delayTicks) 
@@ -173,18 +178,58 @@ void systickDelay (uint32_t delayTicks)
   // Make sure delay is at least 1 tick in case of division, etc.
   if (delayTicks == 0) delayTicks = 1;
 
-  if (curTicks > 0xFFFFFFFF - delayTicks)
+  while ((systickTicks - curTicks) < delayTicks);
+}
+
+/**************************************************************************/
+/*! 
+    @brief      Stops the systick interrupt (the counter keeps running),
+                so that it doesn't wake the MCU up every tick while it
+                sleeps.  The tick count doesn't advance until
+                systickResume is called (see systickGetMicroseconds for
+                the microsecond clock).
+*/
+/**************************************************************************/
+void systickSuspend (void)
+{
+  SYSTICK_STCTRL &= ~SYSTICK_STCTRL_TICKINT;
+}
+
+/**************************************************************************/
+/*! 
+    @brief      Restarts the systick interrupt after systickSuspend
+
+    @param[in]  elapsedTicks
+                The number of ticks that passed while the interrupt was
+                stopped (measured with another timer), which are added
+                to the tick count.
+
+    @note       The FatFs timer (disk_timerproc) is caught up as well,
+                so its timeouts and the card detection debounce count
+                the time spent suspended.
+*/
+/**************************************************************************/
+void systickResume (uint32_t elapsedTicks)
+{
+  uint32_t ticks = systickTicks + elapsedTicks;
+
+  if (ticks < systickTicks) systickRollovers++;
+  systickTicks = ticks;
+
+  #ifdef CFG_SDCARD
   {
-    // Rollover will occur during delay
-    while (systickTicks >= curTicks)
+    // Its timers are 8-bit, so more than 255 calls make no difference
+    uint32_t calls = (fatTicks + elapsedTicks) / 10;
+    fatTicks = (fatTicks + elapsedTicks) % 10;
+    if (calls > 255) calls = 255;
+    while (calls--)
     {
-      while (systickTicks < (delayTicks - (0xFFFFFFFF - curTicks)));
-    }      
-  }
-  else
-  {
-    while ((systickTicks - curTicks) < delayTicks);
+      disk_timerproc();
+    }
   }
+  #endif
+
+  SYSTICK_STCTRL |= SYSTICK_STCTRL_TICKINT;
 }
 
 /**************************************************************************/
@@ -227,3 +272,46 @@ uint32_t systickGetSecondsActive(void)
   return secsActive;
 }
 
+
+/**************************************************************************/
+/*! 
+    @brief      Returns the number of microseconds since the systick timer
+                was started, interpolated from the systick counter.  The
+                value wraps around every ~71 minutes.
+
+    @note       This is safe to call from an ISR or with interrupts
+                disabled.  A tick that has elapsed but not yet been
+                serviced by SysTick_Handler is accounted for.
+
+    @note       With CFG_SWTIMER the value is taken from the software
+                timer clock (swtimerGetMicroseconds) instead, which keeps
+                counting while the tick is suspended for tickless sleep.
+                Without it the value doesn't advance (and the sub-tick
+                part wraps) between systickSuspend and systickResume.
+*/
+/**************************************************************************/
+uint32_t systickGetMicroseconds(void)
+{
+  #ifdef CFG_SWTIMER
+  return (uint32_t)swtimerGetMicroseconds();
+  #else
+  uint32_t ticks, cur, reload;
+
+  // Make sure the tick count and the counter belong together
+  do
+  {
+    ticks = systickTicks;
+    cur = SYSTICK_STCURR;
+  } while (ticks != systickTicks);
+
+  // A pending rollover leaves the counter close to the reload value
+  reload = SYSTICK_STRELOAD;
+  if ((SCB_ICSR & SCB_ICSR_PENDSTSET) && (cur > reload / 2))
+  {
+    ticks++;
+  }
+
+  return ticks * ((reload + 1) / (CFG_CPU_CCLK / 1000000)) +
+         (reload - cur) / (CFG_CPU_CCLK / 1000000);
+  #endif
+}
@@ -43,8 +43,11 @@
 
 void systickInit (uint32_t delayMs);
 void systickDelay (uint32_t delayTicks);
+void systickSuspend (void);
+void systickResume (uint32_t elapsedTicks);
 uint32_t systickGetTicks(void);
 uint32_t systickGetRollovers(void);
 uint32_t systickGetSecondsActive(void);
+uint32_t systickGetMicroseconds(void);
 
 #endif
\ No newline at end of file
@@ -77,6 +77,7 @@ volatile uint32_t timer16_0_counter = 0;
 volatile uint32_t timer16_1_counter = 0;
 
 #ifdef CFG_PWM
+  #include "core/pwm/pwm.h"
   volatile uint32_t pwmCounter = 0;
   extern volatile uint32_t pwmMaxPulses;    // See drivers/pwm/pwm.c
 #endif
@@ -319,6 +320,9 @@ void TIMER16_1_IRQHandler(void)
         pwmMaxPulses = 0;
       }
     }
+
+    /* Move on to the next step of a sequence started by pwmSequenceStart */
+    pwmSequenceTick();
   }
   #endif
 
@@ -87,38 +87,18 @@ void timer32Delay(uint8_t timerNum, uint32_t delay)
 {
   uint32_t curTicks;
 
+  // The unsigned subtraction gives the number of elapsed ticks even if
+  // the counter rolls over during the delay
   if (timerNum == 0)
   {
     curTicks = timer32_0_counter;
-    if (curTicks > 0xFFFFFFFF - delay)
-    {
-      // Rollover will occur during delay
-      while (timer32_0_counter >= curTicks)
-      {
-        while (timer32_0_counter < (delay - (0xFFFFFFFF - curTicks)));
-      }      
-    }
-    else
-    {
-      while ((timer32_0_counter - curTicks) < delay);
-    }
+    while ((timer32_0_counter - curTicks) < delay);
   }
 
   else if (timerNum == 1)
   {
     curTicks = timer32_1_counter;
-    if (curTicks > 0xFFFFFFFF - delay)
-    {
-      // Rollover will occur during delay
-      while (timer32_1_counter >= curTicks)
-      {
-        while (timer32_1_counter < (delay - (0xFFFFFFFF - curTicks)));
-      }      
-    }
-    else
-    {
-      while ((timer32_1_counter - curTicks) < delay);
-    }
+    while ((timer32_1_counter - curTicks) < delay);
   }
 
   return;
@@ -150,8 +130,12 @@ void TIMER32_0_IRQHandler(void)
 /**************************************************************************/
 /*! 
 	@brief Interrupt handler for 32-bit timer 1
+
+    @note  CT32B1 is used by the software timers (core/swtimer) when
+           CFG_SWTIMER is defined, and the handler is defined there.
 */
 /**************************************************************************/
+#ifndef CFG_SWTIMER
 void TIMER32_1_IRQHandler(void)
 {  
   /* Clear the interrupt flag */
@@ -163,6 +147,7 @@ void TIMER32_1_IRQHandler(void)
 
   return;
 }
+#endif
 
 /**************************************************************************/
 /*! 
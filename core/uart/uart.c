@@ -94,11 +94,16 @@
 #include <string.h>
 
 #include "uart.h"
+#include "core/profile/profile.h"
 
 #ifdef CFG_INTERFACE_UART
   #include "core/cmd/cmd.h"
 #endif
 
+#ifdef CFG_EVENTS
+  #include "core/events/events.h"
+#endif
+
 /**************************************************************************/
 /*!
     UART protocol control block, which is used to safely access the
@@ -118,6 +123,8 @@ void UART_IRQHandler(void)
   uint8_t IIRValue, LSRValue;
   uint8_t Dummy = Dummy;
 
+  PROFILE_ISR_ENTER(UART_IRQn);
+
   IIRValue = UART_U0IIR;
   IIRValue &= ~(UART_U0IIR_IntStatus_MASK); /* skip pending bit in IIR */
   IIRValue &= UART_U0IIR_IntId_MASK;        /* check bit 1~3, interrupt identification */
@@ -133,6 +140,7 @@ void UART_IRQHandler(void)
       /* Read LSR will clear the interrupt */
       pcb.status = LSRValue;
       Dummy = UART_U0RBR;	/* Dummy read on RX to clear interrupt, then bail out */
+      PROFILE_ISR_EXIT(UART_IRQn);
       return;
     }
     // No error and receive data is ready
@@ -141,6 +149,9 @@ void UART_IRQHandler(void)
       /* If no error on RLS, normal ready, save into the data buffer. */
       /* Note: read RBR will clear the interrupt */
       uartRxBufferWrite(UART_U0RBR);
+      #ifdef CFG_EVENTS
+      eventsPost(EVENTS_UARTRX, 0);
+      #endif
     }
   }
 
@@ -149,6 +160,9 @@ void UART_IRQHandler(void)
   {
     // Add incoming text to UART buffer
     uartRxBufferWrite(UART_U0RBR);
+    #ifdef CFG_EVENTS
+    eventsPost(EVENTS_UARTRX, 0);
+    #endif
   }
 
   // 3.) Check character timeout indicator
@@ -172,6 +186,7 @@ void UART_IRQHandler(void)
       pcb.pending_tx_data= 1;
     }
   }
+  PROFILE_ISR_EXIT(UART_IRQn);
   return;
 }
 
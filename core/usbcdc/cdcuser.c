@@ -26,6 +26,10 @@
 #include "cdcuser.h"
 #include "cdc_buf.h"
 
+#ifdef CFG_EVENTS
+  #include "core/events/events.h"
+#endif
+
 unsigned char BulkBufIn  [64];            // Buffer to store USB IN  packet
 unsigned char BulkBufOut [64];            // Buffer to store USB OUT packet
 unsigned char NotificationBuf [10];
@@ -39,7 +43,7 @@ unsigned short  CDC_DepInEmpty  = 1;                   // Data IN EP is empty
   much faster than  UART transmits
  *---------------------------------------------------------------------------*/
 /* Buffer masks */
-#define CDC_BUF_SIZE               (64)               // Output buffer in bytes (power 2)
+#define CDC_BUF_SIZE               (256)              // Output buffer in bytes (power 2)
                                                        // large enough for file transfer
 #define CDC_BUF_MASK               (CDC_BUF_SIZE-1ul)
 
@@ -50,6 +54,7 @@ unsigned short  CDC_DepInEmpty  = 1;                   // Data IN EP is empty
 #define CDC_BUF_EMPTY(cdcBuf)      (cdcBuf.rdIdx == cdcBuf.wrIdx)
 #define CDC_BUF_FULL(cdcBuf)       (cdcBuf.rdIdx == cdcBuf.wrIdx+1)
 #define CDC_BUF_COUNT(cdcBuf)      (CDC_BUF_MASK & (cdcBuf.wrIdx - cdcBuf.rdIdx))
+#define CDC_BUF_FREE(cdcBuf)       (CDC_BUF_MASK - CDC_BUF_COUNT(cdcBuf))
 
 
 // CDC output buffer
@@ -61,6 +66,12 @@ typedef struct __CDC_BUF_T {
 
 CDC_BUF_T  CDC_OutBuf;                                 // buffer for all CDC Out data
 
+// Set when an OUT packet was left in the endpoint for lack of buffer space.
+// The host is NAKed until CDC_RdOutBuf makes room and collects it.
+static volatile unsigned char CDC_OutPending;
+
+static void CDC_DrainOutEP (void);
+
 /*----------------------------------------------------------------------------
   read data from CDC_OutBuf
  *---------------------------------------------------------------------------*/
@@ -78,6 +89,13 @@ int CDC_RdOutBuf (char *buffer, const int *length) {
   while (bytesToRead--) {
     *buffer++ = CDC_BUF_RD(CDC_OutBuf);
   }
+
+  if (CDC_OutPending && CDC_BUF_FREE(CDC_OutBuf) >= sizeof(BulkBufOut)) {
+    NVIC_DisableIRQ(USB_IRQn);
+    CDC_DrainOutEP();
+    NVIC_EnableIRQ(USB_IRQn);
+  }
+
   return (bytesRead);  
 }
 
@@ -132,6 +150,7 @@ void CDC_Init (void) {
   CDC_SerialState = CDC_GetSerialState();
 
   CDC_BUF_RESET(CDC_OutBuf);
+  CDC_OutPending = 0;
 
   // Initialise the CDC buffer.   This is required to buffer outgoing
   // data (MCU to PC) since data can only be sent 64 bytes per frame
@@ -322,16 +341,34 @@ void CDC_BulkIn(void) {
   Return Value: none
  *---------------------------------------------------------------------------*/
 void CDC_BulkOut(void) {
-  int numBytesRead;
-
-  // get data from USB into intermediate buffer
-  numBytesRead = USB_ReadEP(CDC_DEP_OUT, &BulkBufOut[0]);
-
-  // ... add code to check for overwrite
+  CDC_DrainOutEP();
+}
 
-  // store data in a buffer to transmit it over serial interface
-  CDC_WrOutBuf ((char *)&BulkBufOut[0], &numBytesRead);
+/*----------------------------------------------------------------------------
+  Move OUT packets from the endpoint into CDC_OutBuf while they fit.  Any
+  packet that doesn't fit stays in the endpoint, so the host is NAKed
+  instead of the buffer being overwritten.  Must be called with the USB
+  interrupt disabled (or from it).
+ *---------------------------------------------------------------------------*/
+static void CDC_DrainOutEP (void) {
+  int numBytesRead;
 
+  CDC_OutPending = 0;
+  while (USB_EPFull(CDC_DEP_OUT)) {
+    if (CDC_BUF_FREE(CDC_OutBuf) < sizeof(BulkBufOut)) {
+      CDC_OutPending = 1;
+      break;
+    }
+
+    // get data from USB into intermediate buffer
+    numBytesRead = USB_ReadEP(CDC_DEP_OUT, &BulkBufOut[0]);
+
+    // store data in a buffer to transmit it over serial interface
+    CDC_WrOutBuf ((char *)&BulkBufOut[0], &numBytesRead);
+    #ifdef CFG_EVENTS
+    eventsPost(EVENTS_USBCDCRX, 0);
+    #endif
+  }
 }
 
 
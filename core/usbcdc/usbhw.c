@@ -401,6 +401,21 @@ void USB_ClearEPBuf (uint32_t EPNum) {
 }
 
 
+/*
+ *  Check USB Endpoint Buffer Status
+ *    Parameters:      EPNum: Endpoint Number
+ *                       EPNum.0..3: Address
+ *                       EPNum.7:    Dir
+ *    Return Value:    Non-zero if the endpoint holds a packet
+ *                     (OUT) or is still sending one (IN)
+ */
+
+uint32_t USB_EPFull (uint32_t EPNum) {
+  WrCmd(CMD_SEL_EP(EPAdr(EPNum)));
+  return (RdCmdDat(DAT_SEL_EP(EPAdr(EPNum))) & EP_SEL_F);
+}
+
+
 /*
  *  Read USB Endpoint Data
  *    Parameters:      EPNum: Endpoint Number
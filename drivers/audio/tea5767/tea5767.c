@@ -110,6 +110,25 @@ void tea5767ReadData(uint8_t * bytes)
 */
 /**************************************************************************/
 bool tea5767CheckCrystal(void)
+{
+  bool good;
+  pt_t pt;
+
+  PT_RUN(&pt, tea5767CheckCrystalPT(&pt, &good));
+
+  return good;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Same as tea5767CheckCrystal, but returns instead of blocking
+            while the tuner settles on 81.4MHz
+
+    @note   This is a protothread (see core/pt/pt.h).  'good' is set
+            once PT_SCHEDULE returns false.
+*/
+/**************************************************************************/
+PT_THREAD(tea5767CheckCrystalPT(pt_t *pt, bool *good))
 {
   /*  AN10133 (p.38) states:
   
@@ -140,9 +159,11 @@ bool tea5767CheckCrystal(void)
   uint8_t ifValue = 0;
   uint8_t buffer[5] = { 0, 0, 0, 0, 0 };
 
+  PT_BEGIN(pt);
+
   // Set the frequency to 81.4MHz
   tea5767SetFrequency(81400000);
-  systickDelay(100);
+  PT_DELAY_MS(pt, 100);
 
   // Read back the IF bits
   tea5767ReadData(&buffer[0]);
@@ -154,10 +175,9 @@ bool tea5767CheckCrystal(void)
 
   // Return true if the crystal is OK (IF = 0x37 @ 81.4MHz),
   // false if it's something else
-  if (0x37 == ifValue)
-    return true;
-  else
-    return false;
+  *good = (0x37 == ifValue);
+
+  PT_END(pt);
 }
 
 /**************************************************************************/
@@ -38,6 +38,7 @@
 #define _TEA5767_H_
 
 #include "projectconfig.h"
+#include "core/pt/pt.h"
 
 #define TEA5767_FMBANDSTART_US_EUROPE            (87500000) // 87.5 MHz to 108 MHz
 #define TEA5767_FMBANDSTART_JAPAN                (76000000) // 76 MHz to 91 MHz plus TV audio at 108 MHz
@@ -145,5 +146,7 @@ void      tea5767SetFrequency( uint32_t );
 uint32_t  tea5767GetFrequency( void );
 void      tea5767Scan( uint8_t );
 void      tea5767Mute( bool );
+bool      tea5767CheckCrystal( void );
+PT_THREAD(tea5767CheckCrystalPT( pt_t *pt, bool *good ));
 
 #endif
\ No newline at end of file
@@ -1,19 +1,38 @@
 /**************************************************************************/
 /*! 
-    @file     sum1.h
+    @file     cksum.h
     @author   Luke-Jr
     @date     15 July, 2012
-    @version  0.1
+    @version  0.2
 
-    Basic BSD checksum.
+    Basic BSD checksum, CRC-16/CCITT and CRC-32.
 
     Based on FreeBSD's cksum program.
+
+    CRC lookup table size is selected at compile time with
+    CFG_CRC_TABLESIZE (see crc16.c and crc32.c):
+
+      0     Bitwise, no tables (smallest, slowest)
+      16    16-entry nibble tables (96 bytes of flash)
+      256   256-entry byte tables (1.5KB of flash)
+      1024  As 256, with CRC-32 using slicing-by-4 (4KB for CRC-32)
 */
 /**************************************************************************/
 
 #ifndef _CKSUM_H_
 #define _CKSUM_H_
 
+#include <stdint.h>
+
+/* Initial value for CRC-16/CCITT ("CCITT-FALSE", poly 0x1021) */
+#define CRC16_CCITT_INIT  (0xFFFF)
+
+/* Initial value for CRC-32 (IEEE 802.3, as used by zlib) */
+#define CRC32_INIT        (0)
+
 extern uint16_t csum1(uint16_t sum, uint8_t c);
+extern uint16_t csum1Buffer(uint16_t sum, const void *buf, uint32_t len);
+extern uint16_t crc16Ccitt(uint16_t crc, const void *buf, uint32_t len);
+extern uint32_t crc32(uint32_t crc, const void *buf, uint32_t len);
 
 #endif
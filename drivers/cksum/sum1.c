@@ -13,7 +13,23 @@
 
 #include <stdint.h>
 
+#include "cksum.h"
+
 uint16_t csum1(uint16_t sum, uint8_t c)
 {
   return ((uint32_t)((sum >> 1) | ((sum & 1) ? 0x8000 : 0)) + (uint32_t)c) & 0xffff;
 }
+
+uint16_t csum1Buffer(uint16_t sum, const void *buf, uint32_t len)
+{
+  const uint8_t *p = (const uint8_t *)buf;
+  uint32_t s = sum;
+
+  // Rotate right by one and add, without the per-byte branch of csum1
+  while (len--)
+  {
+    s = (((s >> 1) | (s << 15)) + *p++) & 0xffff;
+  }
+
+  return (uint16_t)s;
+}
@@ -613,6 +613,16 @@ void ssd1306ShiftFrameBuffer( uint8_t height )
     return;
   }
 
+  // Shifting by whole 8-pixel pages is a straight block move since each
+  // byte in the buffer holds one column of a page
+  if ((height & 7) == 0)
+  {
+    uint16_t offset = (height / 8) * SSD1306_LCDWIDTH;
+    memmove(&_ssd1306buffer[0], &_ssd1306buffer[offset], sizeof(_ssd1306buffer) - offset);
+    memset(&_ssd1306buffer[sizeof(_ssd1306buffer) - offset], 0x00, offset);
+    return;
+  }
+
   // This is horribly inefficient, but at least easy to understand
   // In a production environment, this should be significantly optimised
 
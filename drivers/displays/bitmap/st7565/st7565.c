@@ -421,6 +421,16 @@ void st7565ShiftFrameBuffer( uint8_t height )
     return;
   }
 
+  // Shifting by whole 8-pixel pages is a straight block move since each
+  // byte in the buffer holds one column of a page
+  if ((height & 7) == 0)
+  {
+    uint16_t offset = (height / 8) * 128;
+    memmove(&_st7565buffer[0], &_st7565buffer[offset], sizeof(_st7565buffer) - offset);
+    memset(&_st7565buffer[sizeof(_st7565buffer) - offset], 0x00, offset);
+    return;
+  }
+
   // This is horribly inefficient, but at least easy to understand
   // In a production environment, this should be significantly optimised
 
@@ -0,0 +1,412 @@
+/**************************************************************************/
+/*!
+    @file     scope.c
+    @author   K. Townsend (microBuilder.eu)
+
+    @brief    Renders oscilloscope-style traces over a graticule
+
+    Each trace is drawn as one vertical span per column, running from
+    the previous sample to the current one.  The spans of the last
+    frame are kept, so a new frame only touches the pixels that
+    actually changed: the part of the old span that isn't covered by
+    the new one is erased, and the part of the new span that wasn't
+    covered by the old one is drawn.  Erasing only writes the graticule
+    pixels that fall inside the erased span, so the grid never has to
+    be redrawn and a trace can be updated at full panel width many
+    times a second without flickering.
+
+    @section Example
+
+    @code
+    #include "drivers/displays/tft/controls/scope.h"
+
+    static scope_t scope;
+    static uint8_t spans[200 * 2];
+    static uint16_t samples[200];
+    static uint16_t adcRing[256];
+    scopeTrigger_t trigger = { 512, SCOPE_EDGE_RISING, 400 };
+
+    scope.x = 10;
+    scope.y = 25;
+    scope.width = 200;
+    scope.height = 176;
+    scope.gridX = 25;
+    scope.gridY = 25;
+    scope.colorBackground = COLOR_BLACK;
+    scope.colorGrid = COLOR_GRAY_50;
+    scope.minValue = 0;
+    scope.maxValue = 1023;
+    scopeSetTrace(&scope, 0, COLOR_YELLOW, spans);
+    scopeInit(&scope);
+
+    // Sample AD5 at 20kHz
+    adcContinuousSetBuffer(5, adcRing, 256);
+    adcContinuousStart(ADC_AD0CR_SEL_AD5, ADC_TRIGGER_CT16B0, 20000, 0);
+
+    while (1)
+    {
+      if (scopeCapture(&trigger, 5, samples, 200))
+      {
+        scopeRenderTrace(&scope, 0, samples, 200);
+      }
+    }
+    @endcode
+
+    @section LICENSE
+
+    Software License Agreement (BSD License)
+
+    Copyright (c) 2012, K. Townsend
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+    1. Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holders nor the
+    names of its contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ''AS IS'' AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**************************************************************************/
+#include <string.h>
+
+#include "scope.h"
+#include "core/adc/adc.h"
+
+/**************************************************************************/
+/*!
+    @brief  Converts a sample value to a row in the plot (0 is the top)
+*/
+/**************************************************************************/
+static uint8_t scopeValueToRow(scope_t *scope, uint16_t value)
+{
+  if (value <= scope->minValue) return scope->height - 1;
+  if (value >= scope->maxValue) return 0;
+
+  return (scope->height - 1) - ((uint32_t)(value - scope->minValue) * (scope->height - 1)) / (scope->maxValue - scope->minValue);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Restores the background and graticule between rows top and
+            bottom of the specified column.  Every pixel is written
+            once, so only the graticule pixels inside the span are
+            drawn in the grid color.
+*/
+/**************************************************************************/
+static void scopeDrawBackground(scope_t *scope, uint16_t column, uint16_t top, uint16_t bottom)
+{
+  uint16_t x = scope->x + column;
+  uint16_t row, end;
+
+  // Vertical graticule line
+  if (scope->gridX && (column % scope->gridX == 0))
+  {
+    lcdDrawVLine(x, scope->y + top, scope->y + bottom, scope->colorGrid);
+    return;
+  }
+
+  if (!scope->gridY)
+  {
+    lcdDrawVLine(x, scope->y + top, scope->y + bottom, scope->colorBackground);
+    return;
+  }
+
+  // Background runs between the horizontal graticule lines
+  row = top;
+  while (row <= bottom)
+  {
+    if (row % scope->gridY == 0)
+    {
+      lcdDrawPixel(x, scope->y + row, scope->colorGrid);
+      row++;
+      continue;
+    }
+    end = row + (scope->gridY - row % scope->gridY) - 1;
+    if (end > bottom) end = bottom;
+    lcdDrawVLine(x, scope->y + row, scope->y + end, scope->colorBackground);
+    row = end + 1;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Erases rows top..bottom of a trace in the specified column,
+            redrawing any other trace that overlaps them
+*/
+/**************************************************************************/
+static void scopeEraseSpan(scope_t *scope, uint8_t trace, uint16_t column, uint16_t top, uint16_t bottom)
+{
+  uint8_t other;
+  uint16_t otherTop, otherBottom;
+
+  scopeDrawBackground(scope, column, top, bottom);
+
+  for (other = 0; other < SCOPE_MAXTRACES; other++)
+  {
+    if ((other == trace) || !scope->traces[other].spans) continue;
+    otherTop = scope->traces[other].spans[column * 2];
+    otherBottom = scope->traces[other].spans[column * 2 + 1];
+    if (otherTop == SCOPE_NOSPAN) continue;
+    if (otherTop < top) otherTop = top;
+    if (otherBottom > bottom) otherBottom = bottom;
+    if (otherTop <= otherBottom)
+    {
+      lcdDrawVLine(scope->x + column, scope->y + otherTop, scope->y + otherBottom, scope->traces[other].color);
+    }
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets the color and span buffer for one of the traces
+
+    @param[in]  scope
+                The scope (width must already be set)
+    @param[in]  trace
+                Trace number (0..SCOPE_MAXTRACES-1)
+    @param[in]  color
+                Color used when rendering the trace
+    @param[in]  spans
+                Buffer of at least 2 * width bytes, or 0 to disable
+                the trace
+*/
+/**************************************************************************/
+void scopeSetTrace(scope_t *scope, uint8_t trace, uint16_t color, uint8_t *spans)
+{
+  if (trace >= SCOPE_MAXTRACES) return;
+
+  scope->traces[trace].color = color;
+  scope->traces[trace].spans = spans;
+  if (spans)
+  {
+    memset(spans, SCOPE_NOSPAN, scope->width * 2);
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Renders the background and graticule, and forgets any
+            traces that were drawn
+
+    @param[in]  scope
+                The scope to render
+*/
+/**************************************************************************/
+void scopeInit(scope_t *scope)
+{
+  uint16_t column;
+  uint8_t trace;
+
+  for (column = 0; column < scope->width; column++)
+  {
+    scopeDrawBackground(scope, column, 0, scope->height - 1);
+  }
+
+  for (trace = 0; trace < SCOPE_MAXTRACES; trace++)
+  {
+    if (scope->traces[trace].spans)
+    {
+      memset(scope->traces[trace].spans, SCOPE_NOSPAN, scope->width * 2);
+    }
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Replaces a trace with a new set of samples, only updating
+            the pixels that changed since the last call
+
+    @param[in]  scope
+                The scope to render in
+    @param[in]  trace
+                Trace number (0..SCOPE_MAXTRACES-1)
+    @param[in]  samples
+                Samples to render, one per column starting at the left
+                edge of the plot
+    @param[in]  count
+                Number of samples.  Columns past the last sample are
+                left empty, and samples past the last column are ignored.
+*/
+/**************************************************************************/
+void scopeRenderTrace(scope_t *scope, uint8_t trace, const uint16_t *samples, uint16_t count)
+{
+  uint8_t *spans;
+  uint16_t column, x;
+  uint16_t newTop, newBottom, oldTop, oldBottom;
+  uint8_t previous = 0, current;
+
+  if ((trace >= SCOPE_MAXTRACES) || !scope->traces[trace].spans) return;
+
+  spans = scope->traces[trace].spans;
+  if (count > scope->width) count = scope->width;
+  if (count) previous = scopeValueToRow(scope, samples[0]);
+
+  for (column = 0; column < scope->width; column++)
+  {
+    // Span from the previous sample to this one
+    if (column < count)
+    {
+      current = scopeValueToRow(scope, samples[column]);
+      newTop = current < previous ? current : previous;
+      newBottom = current < previous ? previous : current;
+      previous = current;
+    }
+    else
+    {
+      newTop = newBottom = SCOPE_NOSPAN;
+    }
+
+    oldTop = spans[column * 2];
+    oldBottom = spans[column * 2 + 1];
+    if ((oldTop == newTop) && (oldBottom == newBottom)) continue;
+
+    spans[column * 2] = newTop;
+    spans[column * 2 + 1] = newBottom;
+    x = scope->x + column;
+
+    if (oldTop == SCOPE_NOSPAN)
+    {
+      lcdDrawVLine(x, scope->y + newTop, scope->y + newBottom, scope->traces[trace].color);
+    }
+    else if (newTop == SCOPE_NOSPAN)
+    {
+      scopeEraseSpan(scope, trace, column, oldTop, oldBottom);
+    }
+    else
+    {
+      // Erase the parts of the old span above and below the new one
+      if (oldTop < newTop)
+      {
+        scopeEraseSpan(scope, trace, column, oldTop, oldBottom < newTop ? oldBottom : newTop - 1);
+      }
+      if (oldBottom > newBottom)
+      {
+        scopeEraseSpan(scope, trace, column, oldTop > newBottom ? oldTop : newBottom + 1, oldBottom);
+      }
+      // Draw the parts of the new span above and below the old one
+      if (newTop < oldTop)
+      {
+        lcdDrawVLine(x, scope->y + newTop, scope->y + (newBottom < oldTop ? newBottom : oldTop - 1), scope->traces[trace].color);
+      }
+      if (newBottom > oldBottom)
+      {
+        lcdDrawVLine(x, scope->y + (newTop > oldBottom ? newTop : oldBottom + 1), scope->y + newBottom, scope->traces[trace].color);
+      }
+    }
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Erases a trace
+*/
+/**************************************************************************/
+void scopeClearTrace(scope_t *scope, uint8_t trace)
+{
+  scopeRenderTrace(scope, trace, 0, 0);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Finds the first sample where the signal crosses the
+            specified level
+
+    @param[in]  samples
+                Samples to search
+    @param[in]  count
+                Number of samples
+    @param[in]  level
+                Sample value the signal has to cross
+    @param[in]  edge
+                SCOPE_EDGE_RISING or SCOPE_EDGE_FALLING
+
+    @return     The index of the first sample at or past the level, or
+                -1 if the signal doesn't cross it
+*/
+/**************************************************************************/
+int32_t scopeFindTrigger(const uint16_t *samples, uint16_t count, uint16_t level, scopeEdge_e edge)
+{
+  uint16_t i;
+
+  for (i = 1; i < count; i++)
+  {
+    if (edge == SCOPE_EDGE_RISING ?
+        (samples[i - 1] < level) && (samples[i] >= level) :
+        (samples[i - 1] > level) && (samples[i] <= level))
+    {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Collects a triggered frame from an ADC channel's continuous
+            acquisition ring buffer (see adcContinuousStart).  Samples
+            are discarded until the trigger condition is met, then the
+            frame is filled as they arrive, so this never blocks and
+            can be called as often as required.
+
+    @param[in]  trigger
+                Trigger settings and state
+    @param[in]  adcChannel
+                The A/D channel [0..7] to take the samples from
+    @param[out] samples
+                The frame.  This must not be changed until it is full.
+    @param[in]  count
+                Number of samples in a frame
+
+    @return     true once the frame is full
+*/
+/**************************************************************************/
+bool scopeCapture(scopeTrigger_t *trigger, uint8_t adcChannel, uint16_t *samples, uint16_t count)
+{
+  uint16_t sample;
+  bool crossed;
+
+  while (!trigger->triggered)
+  {
+    if (!adcContinuousRead(adcChannel, &sample, 1)) return false;
+
+    crossed = trigger->edge == SCOPE_EDGE_RISING ?
+              (trigger->previous < trigger->level) && (sample >= trigger->level) :
+              (trigger->previous > trigger->level) && (sample <= trigger->level);
+    trigger->previous = sample;
+
+    // Start the frame on the trigger, or after autoTimeout samples without one
+    trigger->waited++;
+    if (crossed || (trigger->autoTimeout && (trigger->waited >= trigger->autoTimeout)))
+    {
+      trigger->triggered = true;
+      trigger->waited = 0;
+      samples[0] = sample;
+      trigger->captured = 1;
+    }
+  }
+
+  trigger->captured += adcContinuousRead(adcChannel, &samples[trigger->captured], count - trigger->captured);
+  if (trigger->captured < count) return false;
+
+  trigger->triggered = false;
+  trigger->captured = 0;
+  trigger->previous = samples[count - 1];
+
+  return true;
+}
@@ -0,0 +1,112 @@
+/**************************************************************************/
+/*!
+    @file     scope.h
+    @author   K. Townsend (microBuilder.eu)
+
+    @section LICENSE
+
+    Software License Agreement (BSD License)
+
+    Copyright (c) 2012, K. Townsend
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+    1. Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holders nor the
+    names of its contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ''AS IS'' AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**************************************************************************/
+#ifndef __SCOPE_H__
+#define __SCOPE_H__
+
+#include "projectconfig.h"
+#include "drivers/displays/tft/drawing.h"
+
+#define SCOPE_MAXTRACES   (2)       // Traces per scope
+#define SCOPE_NOSPAN      (0xFF)    // Marks a column the trace hasn't been drawn in
+
+/**************************************************************************/
+/*!
+    One trace in a scope.  'spans' holds 2 * width bytes (the top and
+    bottom row of the trace in each column, relative to the top of the
+    plot) and is what allows the previous trace to be erased without
+    redrawing the whole plot.
+*/
+/**************************************************************************/
+typedef struct
+{
+  uint16_t  color;
+  uint8_t * spans;
+} scopeTrace_t;
+
+/**************************************************************************/
+/*!
+    A plot area with a graticule.  Fill in the fields (height must be
+    less than 255 pixels) and set the traces with scopeSetTrace, then
+    call scopeInit.
+*/
+/**************************************************************************/
+typedef struct
+{
+  uint16_t      x;                // Left edge of the plot area
+  uint16_t      y;                // Top edge of the plot area
+  uint16_t      width;            // Width in pixels (one sample per column)
+  uint16_t      height;           // Height in pixels
+  uint16_t      gridX;            // Pixels between vertical graticule lines (0 for none)
+  uint16_t      gridY;            // Pixels between horizontal graticule lines (0 for none)
+  uint16_t      colorBackground;
+  uint16_t      colorGrid;
+  uint16_t      minValue;         // Sample value at the bottom of the plot
+  uint16_t      maxValue;         // Sample value at the top of the plot
+  scopeTrace_t  traces[SCOPE_MAXTRACES];
+} scope_t;
+
+typedef enum
+{
+  SCOPE_EDGE_RISING = 0,
+  SCOPE_EDGE_FALLING
+}
+scopeEdge_e;
+
+/**************************************************************************/
+/*!
+    Trigger state for scopeCapture.  Set level, edge and autoTimeout
+    and clear the rest before the first capture.
+*/
+/**************************************************************************/
+typedef struct
+{
+  uint16_t      level;            // Sample value the signal has to cross
+  scopeEdge_e   edge;
+  uint16_t      autoTimeout;      // Samples to wait before capturing anyway (0 to wait forever)
+  uint16_t      previous;         // Last sample checked for the trigger
+  uint16_t      waited;           // Samples checked since the last frame
+  uint16_t      captured;         // Samples in the current frame
+  bool          triggered;
+} scopeTrigger_t;
+
+void scopeSetTrace (scope_t *scope, uint8_t trace, uint16_t color, uint8_t *spans);
+void scopeInit (scope_t *scope);
+void scopeRenderTrace (scope_t *scope, uint8_t trace, const uint16_t *samples, uint16_t count);
+void scopeClearTrace (scope_t *scope, uint8_t trace);
+int32_t scopeFindTrigger (const uint16_t *samples, uint16_t count, uint16_t level, scopeEdge_e edge);
+bool scopeCapture (scopeTrigger_t *trigger, uint8_t adcChannel, uint16_t *samples, uint16_t count);
+
+#endif
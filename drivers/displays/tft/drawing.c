@@ -39,6 +39,7 @@
 #include <string.h>
 
 #include "drawing.h"
+#include "core/profile/profile.h"
 
 /**************************************************************************/
 /*                                                                        */
@@ -131,6 +132,8 @@ void drawPixel(uint16_t x, uint16_t y, uint16_t color)
   }
 }
 
+PROFILE_DEFINE(fill, "lcdFillRGB");
+
 /**************************************************************************/
 /*!
     @brief  Fills the screen with the specified color
@@ -141,7 +144,9 @@ void drawPixel(uint16_t x, uint16_t y, uint16_t color)
 /**************************************************************************/
 void drawFill(uint16_t color)
 {
+  PROFILE_START(fill);
   lcdFillRGB(color);
+  PROFILE_STOP(fill);
 }
 
 /**************************************************************************/
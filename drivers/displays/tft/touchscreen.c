@@ -265,6 +265,7 @@ int setCalibrationMatrix( tsPoint_t * displayPtr, tsPoint_t * screenPtr, tsMatri
     eepromWriteS32(CFG_EEPROM_TOUCHSCREEN_CAL_FN, matrixPtr->Fn);
     eepromWriteS32(CFG_EEPROM_TOUCHSCREEN_CAL_DIVIDER, matrixPtr->Divider);
     eepromWriteU8(CFG_EEPROM_TOUCHSCREEN_CALIBRATED, 1);
+    eepromFlush();
   }
 
   return( retValue ) ;
@@ -592,6 +593,7 @@ int tsSetThreshhold(uint8_t value)
 
   // Persist to EEPROM
   eepromWriteU8(CFG_EEPROM_TOUCHSCREEN_THRESHHOLD, value);
+  eepromFlush();
 
   return 0;
 }
@@ -8,6 +8,7 @@
 #define _USE_IOCTL	1
 
 #include "integer.h"
+#include "core/pt/pt.h"
 
 
 /* Status of Disk Functions */
@@ -27,6 +28,7 @@ typedef enum {
 /* Prototypes for disk control functions */
 
 DSTATUS disk_initialize (BYTE);
+PT_THREAD(disk_initializePT (pt_t*, BYTE, DSTATUS*));
 DSTATUS disk_status (BYTE);
 DRESULT disk_read (BYTE, BYTE*, DWORD, BYTE);
 #if	_READONLY == 0
@@ -76,6 +76,7 @@
 /                   case on non-LFN cfg.
 /---------------------------------------------------------------------------*/
 
+#include <string.h>
 #include "projectconfig.h"
 #include "ff.h"			/* FatFs configurations and declarations */
 #include "diskio.h"		/* Declarations of low level disk I/O functions */
@@ -175,16 +176,13 @@ WCHAR LfnBuf[_MAX_LFN + 1];
 /* Copy memory to memory */
 static
 void mem_cpy (void* dst, const void* src, int cnt) {
-	char *d = (char*)dst;
-	const char *s = (const char *)src;
-	while (cnt--) *d++ = *s++;
+	memcpy(dst, src, cnt);	/* Word-optimised core/libc version */
 }
 
 /* Fill memory */
 static
 void mem_set (void* dst, int val, int cnt) {
-	char *d = (char*)dst;
-	while (cnt--) *d++ = (char)val;
+	memset(dst, val, cnt);
 }
 
 /* Compare memory to memory */
@@ -11,6 +11,8 @@
 #include "core/gpio/gpio.h"
 #include "core/ssp/ssp.h"
 #include "core/systick/systick.h"
+#include "core/profile/profile.h"
+#include "core/pt/pt.h"
 
 
 /* Definitions for MMC/SDC command */
@@ -40,8 +42,6 @@
 // #define	FCLK_SLOW()					/* Set slow clock (100k-400k) */
 // #define	FCLK_FAST()					/* Set fast clock (depends on the CSD) */
 
-#define FDELAY(ms) systickDelay(ms)     // Assumes delay = 1ms, ugly
-
 /*--------------------------------------------------------------------------
 
    Module Private Functions
@@ -357,7 +357,35 @@ DSTATUS disk_initialize (
 	BYTE drv		/* Physical drive nmuber (0) */
 )
 {
-	BYTE n, cmd, ty, ocr[4];
+	DSTATUS stat;
+	pt_t pt;
+
+	PT_RUN(&pt, disk_initializePT(&pt, drv, &stat));
+
+	return stat;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Initialize Disk Drive without blocking                                */
+/*                                                                       */
+/* Protothread version of disk_initialize (see core/pt/pt.h), returning  */
+/* during the card detect delay and while the card leaves idle state.    */
+/* 'stat' is set once PT_SCHEDULE returns false.  The card is deselected */
+/* whenever the thread returns, so other threads may use SSP0 meanwhile  */
+/* as long as they leave it in the SD card's SPI mode.                   */
+/*-----------------------------------------------------------------------*/
+
+PT_THREAD(disk_initializePT (
+	pt_t *pt,
+	BYTE drv,		/* Physical drive nmuber (0) */
+	DSTATUS *stat	/* Returned disk status */
+))
+{
+	BYTE n;
+	static BYTE cmd, ty, ocr[4];		/* Kept across the waits below */
+
+	PT_BEGIN(pt);
 
         // Init SSP (clock low between frames, transition on leading edge)      
         sspInit(0, sspClockPolarity_Low, sspClockPhase_RisingEdge); 
@@ -367,10 +395,12 @@ DSTATUS disk_initialize (
         gpioSetPullup (&IOCON_PIO3_0, gpioPullupMode_Inactive);
 
         // Wait 20ms for card detect to stabilise
-        systickDelay(20);        
+        PT_DELAY_MS(pt, 20);
 
-	if (drv) return STA_NOINIT;			/* Supports only single drive */
-	if (Stat & STA_NODISK) return Stat;	/* No card in the socket */
+	*stat = STA_NOINIT;
+	if (drv) PT_EXIT(pt);				/* Supports only single drive */
+	*stat = Stat;
+	if (Stat & STA_NODISK) PT_EXIT(pt);	/* No card in the socket */
 
 	power_on();							/* Force socket power on */
 	FCLK_SLOW();
@@ -382,7 +412,12 @@ DSTATUS disk_initialize (
 		if (send_cmd(CMD8, 0x1AA) == 1) {	/* SDHC */
 			for (n = 0; n < 4; n++) ocr[n] = rcvr_spi();		/* Get trailing return value of R7 resp */
 			if (ocr[2] == 0x01 && ocr[3] == 0xAA) {				/* The card can work at vdd range of 2.7-3.6V */
-				while (Timer1 && send_cmd(ACMD41, 1UL << 30));	/* Wait for leaving idle state (ACMD41 with HCS bit) */
+				while (Timer1) {							/* Wait for leaving idle state (ACMD41 with HCS bit) */
+					n = send_cmd(ACMD41, 1UL << 30);
+					deselect();							/* Release the bus before yielding */
+					if (!n) break;
+					PT_YIELD(pt);
+				}
 				if (Timer1 && send_cmd(CMD58, 0) == 0) {		/* Check CCS bit in the OCR */
 					for (n = 0; n < 4; n++) ocr[n] = rcvr_spi();
 					ty = (ocr[0] & 0x40) ? CT_SD2 | CT_BLOCK : CT_SD2;	/* SDv2 */
@@ -394,7 +429,12 @@ DSTATUS disk_initialize (
 			} else {
 				ty = CT_MMC; cmd = CMD1;	/* MMCv3 */
 			}
-			while (Timer1 && send_cmd(cmd, 0));			/* Wait for leaving idle state */
+			while (Timer1) {						/* Wait for leaving idle state */
+				n = send_cmd(cmd, 0);
+				deselect();							/* Release the bus before yielding */
+				if (!n) break;
+				PT_YIELD(pt);
+			}
 			if (!Timer1 || send_cmd(CMD16, 512) != 0)	/* Set R/W block length to 512 */
 				ty = 0;
 		}
@@ -409,7 +449,8 @@ DSTATUS disk_initialize (
 		power_off();
 	}
 
-	return Stat;
+	*stat = Stat;
+	PT_END(pt);
 }
 
 
@@ -428,6 +469,8 @@ DSTATUS disk_status (
 
 
 
+PROFILE_DEFINE(read, "disk_read");
+
 /*-----------------------------------------------------------------------*/
 /* Read Sector(s)                                                        */
 /*-----------------------------------------------------------------------*/
@@ -442,6 +485,8 @@ DRESULT disk_read (
 	if (drv || !count) return RES_PARERR;
 	if (Stat & STA_NOINIT) return RES_NOTRDY;
 
+	PROFILE_START(read);
+
 	if (!(CardType & CT_BLOCK)) sector *= 512;	/* Convert to byte address if needed */
 
 	if (count == 1) {	/* Single block read */
@@ -460,6 +505,8 @@ DRESULT disk_read (
 	}
 	deselect();
 
+	PROFILE_STOP(read);
+
 	return count ? RES_ERROR : RES_OK;
 }
 
@@ -3,9 +3,15 @@
     @file     jtag.c
     @author   Luke-Jr
     @date     1 July, 2012
-    @version  0.1
+    @version  0.2
 
     JTAG via GPIO
+
+    Pin masks and GPIO data register addresses are precomputed for each
+    port, so a clock cycle is a handful of masked register writes.  Using
+    JTAG_BROADCAST as the port clocks every active port (see jtagDetect
+    and jtagSetActive) at once, which lets identical chains be shifted
+    in parallel.
 */
 /**************************************************************************/
 
@@ -28,6 +34,72 @@ static struct _jtagport _jtagports[] = CFG_JTAG_PORTS;
 #define _jtagportCount  (sizeof(_jtagports)/sizeof(_jtagports[0]))
 static uint8_t _jtagactive[_jtagportCount];
 
+// Masked GPIO data register: only the bits set in mask are read/written
+#define _jtagGPIOReg(port, mask)  (pREG32 (GPIO_GPIO0_BASE + ((port) << 16) + ((mask) << 2)))
+
+// Precomputed register addresses and masks for clocking one JTAG port, or
+// all active ports at once.  Lines on the same GPIO port are driven with a
+// single masked write, and ports sharing TCK are clocked together.
+struct _jtagplan {
+  uint8_t count;           // Number of GPIO ports used for TCK/TMS/TDI
+  struct {
+    REG32   *data;         // Masked data register covering TCK, TMS and TDI
+    REG32   *tck;          // Masked data register covering TCK only
+    uint32_t tms;
+    uint32_t tdi;
+  } gpio[4];
+  REG32   *tdo;            // Masked data register covering TDO
+};
+
+// One plan per port, followed by the broadcast plan for JTAG_BROADCAST
+static struct _jtagplan _jtagplans[_jtagportCount + 1];
+
+static void _jtagPlanBuild(struct _jtagplan *pl, uint8_t first, uint8_t last, uint8_t activeOnly)
+{
+  uint32_t tck[4] = {0}, tms[4] = {0}, tdi[4] = {0};
+  uint8_t i, port;
+
+  pl->tdo = _jtagGPIOReg(0, 0);
+  for (i = first; i <= last; ++i)
+  {
+    struct _jtagport *pi = &_jtagports[i];
+    if (activeOnly && !_jtagactive[i])
+      continue;
+    tck[pi->tck[0]] |= 1 << pi->tck[1];
+    tms[pi->tms[0]] |= 1 << pi->tms[1];
+    tdi[pi->tdi[0]] |= 1 << pi->tdi[1];
+    pl->tdo = _jtagGPIOReg(pi->tdo[0], 1 << pi->tdo[1]);
+  }
+
+  pl->count = 0;
+  for (port = 0; port < 4; ++port)
+  {
+    if (!(tck[port] | tms[port] | tdi[port]))
+      continue;
+    pl->gpio[pl->count].data = _jtagGPIOReg(port, tck[port] | tms[port] | tdi[port]);
+    pl->gpio[pl->count].tck  = _jtagGPIOReg(port, tck[port]);
+    pl->gpio[pl->count].tms  = tms[port];
+    pl->gpio[pl->count].tdi  = tdi[port];
+    ++pl->count;
+  }
+}
+
+static inline const struct _jtagplan *_jtagPlan(uint8_t jtagPort)
+{
+  return &_jtagplans[(jtagPort == JTAG_BROADCAST) ? _jtagportCount : jtagPort];
+}
+
+// Sets TMS/TDI with TCK low, then raises TCK and samples TDO
+static inline uint8_t _jtagPlanClock(const struct _jtagplan *pl, uint32_t tdi, uint32_t tms)
+{
+  uint8_t i;
+  for (i = 0; i < pl->count; ++i)
+    *pl->gpio[i].data = (tdi ? pl->gpio[i].tdi : 0) | (tms ? pl->gpio[i].tms : 0);
+  for (i = 0; i < pl->count; ++i)
+    *pl->gpio[i].tck = 0xFFF;
+  return *pl->tdo ? 1 : 0;
+}
+
 void jtagInit()
 {
   uint8_t i;
@@ -41,8 +113,10 @@ void jtagInit()
     gpioSetDir(pi->tms[0], pi->tms[1], gpioDirection_Output);
     gpioSetDir(pi->tdo[0], pi->tdo[1], gpioDirection_Input );
     gpioSetDir(pi->tdi[0], pi->tdi[1], gpioDirection_Output);
+    _jtagPlanBuild(&_jtagplans[i], i, i, 0);
     jtagReset(i);
   }
+  _jtagPlanBuild(&_jtagplans[_jtagportCount], 0, _jtagportCount - 1, 1);
 }
 
 uint8_t jtagDetectPorts()
@@ -50,76 +124,91 @@ uint8_t jtagDetectPorts()
   return _jtagportCount;
 }
 
+void jtagSetActive(uint8_t jtagPort, uint8_t active)
+{
+  _jtagactive[jtagPort] = active;
+  _jtagPlanBuild(&_jtagplans[_jtagportCount], 0, _jtagportCount - 1, 1);
+}
+
+uint8_t jtagIsActive(uint8_t jtagPort)
+{
+  return _jtagactive[jtagPort];
+}
+
 uint8_t jtagClock(uint8_t jtagPort, uint8_t tdi, uint8_t tms)
 {
-  if (jtagPort == 0xff)
-  {
-    uint8_t i, rv;
-    rv = 0xff;
-    for (i=0; i<_jtagportCount; ++i)
-      if (_jtagactive[i])
-        rv = jtagClock(i, tdi, tms);
-    return rv;
-  }
-  struct _jtagport *pi = &_jtagports[jtagPort];
-  gpioSetValue(pi->tms[0], pi->tms[1], tms);
-  gpioSetValue(pi->tdi[0], pi->tdi[1], tdi);
-  gpioSetValue(pi->tck[0], pi->tck[1], 0);
-  gpioSetValue(pi->tck[0], pi->tck[1], 1);
-  return gpioGetValue(pi->tdo[0], pi->tdo[1]);
+  const struct _jtagplan *pl = _jtagPlan(jtagPort);
+  if (!pl->count)
+    return 0xff;
+  return _jtagPlanClock(pl, tdi, tms);
 }
 
-static void _jtagRWBit(uint8_t jtagPort, uint8_t*byte, uint8_t mask, uint8_t tms, uint8_t read)
+// Shifts 'bitlength' bits MSB first with TMS low
+static void _jtagShift(const struct _jtagplan *pl, uint8_t data[], uint32_t bitlength, uint8_t read)
 {
-  uint8_t rv = jtagClock(jtagPort, byte[0] & mask, tms);
+  uint32_t w, i;
+  uint8_t b, m, rv;
+
   if (!read)
+  {
+    // Write-only (e.g. bitstreams): a word per iteration
+    for ( ; bitlength >= 32; bitlength -= 32, data += 4)
+    {
+      w = ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+      for (i = 0; i < 32; ++i, w <<= 1)
+        _jtagPlanClock(pl, w & 0x80000000, 0);
+    }
+    for ( ; bitlength >= 8; bitlength -= 8, ++data)
+      for (m = 0x80; m; m >>= 1)
+        _jtagPlanClock(pl, data[0] & m, 0);
+    for (m = 0x80; bitlength; --bitlength, m >>= 1)
+      _jtagPlanClock(pl, data[0] & m, 0);
     return;
-  if (rv)
-    byte[0] |= mask;
-  else
-    byte[0] &= ~mask;
+  }
+
+  for ( ; bitlength >= 8; bitlength -= 8, ++data)
+  {
+    b = data[0];
+    for (m = 0x80; m; m >>= 1)
+    {
+      rv = _jtagPlanClock(pl, b & m, 0);
+      b = rv ? (b | m) : (b & ~m);
+    }
+    data[0] = b;
+  }
+  for (m = 0x80; bitlength; --bitlength, m >>= 1)
+  {
+    rv = _jtagPlanClock(pl, data[0] & m, 0);
+    data[0] = rv ? (data[0] | m) : (data[0] & ~m);
+  }
 }
 
 // Expects to start at the Capture step, to handle 0-length gracefully
 void _jtagLLReadWrite(uint8_t jtagPort, uint8_t data[], uint32_t bitlength, uint8_t read, uint8_t stage)
 {
-  uint8_t i, j;
-  div_t d;
+  const struct _jtagplan *pl = _jtagPlan(jtagPort);
+  uint8_t *last, mask, rv;
   
   if (!bitlength)
   {
-    jtagClock(jtagPort, 0, 1);
+    _jtagPlanClock(pl, 0, 1);
     return;
   }
   
   if (stage & 1)
-    jtagClock(jtagPort, 0, 0);
+    _jtagPlanClock(pl, 0, 0);
   
-  // d = div(bitlength - 1, 8);  // NOTE: This hangs for some reason
   --bitlength;
-  d.quot = bitlength / 8;
-  d.rem  = bitlength % 8;
-  
-  for (i=0; i<d.quot; ++i)
-  {
-    _jtagRWBit(jtagPort, &data[i], 0x80, 0, read);
-    _jtagRWBit(jtagPort, &data[i], 0x40, 0, read);
-    _jtagRWBit(jtagPort, &data[i], 0x20, 0, read);
-    _jtagRWBit(jtagPort, &data[i], 0x10, 0, read);
-    _jtagRWBit(jtagPort, &data[i], 0x08, 0, read);
-    _jtagRWBit(jtagPort, &data[i], 0x04, 0, read);
-    _jtagRWBit(jtagPort, &data[i], 0x02, 0, read);
-    _jtagRWBit(jtagPort, &data[i], 0x01, 0, read);
-  }
-  for (j=0; j<d.rem; ++j)
-    _jtagRWBit(jtagPort, &data[i], 0x80>>j, 0, read);
+  _jtagShift(pl, data, bitlength, read);
+
+  // The final bit leaves Shift (Exit1) if finishing
+  last = &data[bitlength / 8];
+  mask = 0x80 >> (bitlength % 8);
+  rv = _jtagPlanClock(pl, *last & mask, stage & 2);
+  if (read)
+    *last = rv ? (*last | mask) : (*last & ~mask);
   if (stage & 2)
-  {
-    _jtagRWBit(jtagPort, &data[i], 0x80>>j, 1, read);
-    jtagClock(jtagPort, 0, 1);  // Update
-  }
-  else
-    _jtagRWBit(jtagPort, &data[i], 0x80>>j, 0, read);
+    _jtagPlanClock(pl, 0, 1);  // Update
 }
 
 void jtagReset(uint8_t jtagPort)
@@ -147,7 +236,7 @@ int8_t jtagDetect(uint8_t jtagPort)
     if (jtagClock(jtagPort, 1, 0))
       break;
   jtagReset(jtagPort);
-  _jtagactive[jtagPort] = (i == 1);
+  jtagSetActive(jtagPort, i == 1);
   return i < 2 ? i : -2;
 }
 
@@ -14,8 +14,13 @@
 
 #include "sysdefs.h"
 
+// Port number addressing all active ports at once
+#define JTAG_BROADCAST  (0xff)
+
 extern void jtagInit();
 extern uint8_t jtagDetectPorts();
+extern void jtagSetActive(uint8_t jtagPort, uint8_t active);
+extern uint8_t jtagIsActive(uint8_t jtagPort);
 extern uint8_t jtagClock(uint8_t jtagPort, uint8_t tdo, uint8_t tms);
 extern void _jtagLLReadWrite(uint8_t jtagPort, uint8_t data[], uint32_t bitlength, uint8_t read, uint8_t stage);
 extern void jtagReset(uint8_t jtagPort);
@@ -9,6 +9,24 @@
               position handling methods to keep track of the motor's
               relative position and the spindle's current rotation.
 
+    Steps are emitted from the 32-bit Timer 0 match interrupt, so the
+    CPU is free while the motor moves.  Moves are queued (up to
+    STEPPER_QUEUESIZE of them) and each one follows a trapezoidal
+    speed profile: it accelerates from standstill at a constant rate
+    up to its top speed, cruises, and decelerates back to standstill
+    at its last step.  Starting slowly and ramping up is what allows
+    a motor to reach speeds it would stall at if it were started at
+    them directly.
+
+    The step intervals are computed with the recurrence described in
+    "Generate stepper-motor speed profiles in real time" (D. Austin):
+    c(n) = c(n-1) - 2*c(n-1)/(4n+1), which needs a single division
+    per step.  The square root needed for the first interval and the
+    length of each phase are worked out when the move is queued.
+
+    The four control pins have to be on the same port, since they are
+    updated together with a single masked write to the port.
+
     @section Example
 
     @code 
@@ -38,6 +56,21 @@
       }
     }
 
+    @endcode
+
+    @code
+
+    // Queue a few moves with acceleration and carry on with other work
+    // while the motor runs (speeds in steps/s, accelerations in steps/s)
+    stepperMove(4000, 2000, 4000);
+    stepperMove(-4000, 1000, 1000);
+
+    while (stepperIsMoving())
+    {
+      printf("%d\r\n", (int32_t)stepperGetPosition());
+      systickDelay(100);
+    }
+
     @endcode    
 
     @section LICENSE
@@ -76,45 +109,200 @@
 #include "core/gpio/gpio.h"
 #include "core/timer32/timer32.h"
 
-static int64_t  stepperPosition = 0;          // The current position (in steps) relative to 'Home'
-static uint32_t stepperStepNumber = 0;        // The current position (in steps) relative to 0
-static uint32_t stepperStepsPerRotation = 0;  // Number of steps in a full 360 rotation
-static uint32_t stepperStepDelay = 0;         // Delay in CPU ticks between individual steps
+#if (STEPPER_IN2_PORT != STEPPER_IN1_PORT) || (STEPPER_IN3_PORT != STEPPER_IN1_PORT) || (STEPPER_IN4_PORT != STEPPER_IN1_PORT)
+  #error "STEPPER_IN1..4 must all be on the same port"
+#endif
+
+// Writes to this address only change the four control pins (see UM10375 9.4.1)
+#define STEPPER_PINMASK     ((1 << STEPPER_IN1_PIN) | (1 << STEPPER_IN2_PIN) | (1 << STEPPER_IN3_PIN) | (1 << STEPPER_IN4_PIN))
+#define STEPPER_PINS        (*(pREG32 (GPIO_GPIO0_BASE + (STEPPER_IN1_PORT << 16) + (STEPPER_PINMASK << 2))))
+
+#define STEPPER_PATTERN(in1, in2, in3, in4) \
+  (((in1) << STEPPER_IN1_PIN) | ((in2) << STEPPER_IN2_PIN) | ((in3) << STEPPER_IN3_PIN) | ((in4) << STEPPER_IN4_PIN))
+
+// Pin states for each of the four phases
+static const uint32_t stepperPatterns[4] =
+{
+  STEPPER_PATTERN(1, 0, 1, 0),
+  STEPPER_PATTERN(0, 1, 1, 0),
+  STEPPER_PATTERN(0, 1, 0, 1),
+  STEPPER_PATTERN(1, 0, 0, 1)
+};
 
 /**************************************************************************/
 /*! 
-    Private - Cause the motor to step forward or backward one step
+    A queued move, with its speed profile worked out in timer ticks
 */
 /**************************************************************************/
-void stepMotor(uint32_t thisStep)
+typedef struct
 {
-  switch (thisStep)
+  uint32_t steps;       // Number of steps in the move
+  bool     forward;     // Direction
+  uint32_t c0;          // Interval before the first step
+  uint32_t cmin;        // Interval at top speed
+  uint32_t accelSteps;  // Steps spent accelerating (and decelerating)
+} stepperMove_t;
+
+static volatile int64_t  stepperPosition = 0;          // The current position (in steps) relative to 'Home'
+static volatile uint32_t stepperStepNumber = 0;        // The current position (in steps) relative to 0
+static uint32_t stepperStepsPerRotation = 0;           // Number of steps in a full 360 rotation
+static uint32_t stepperSpeed = 0;                      // Speed used by stepperStep (steps/s)
+static uint32_t stepperAccel = 0;                      // Acceleration used by stepperStep (steps/s, 0 for none)
+static volatile uint8_t  stepperPhase = 0;             // Current pin pattern
+
+static stepperMove_t stepperQueue[STEPPER_QUEUESIZE];
+static volatile uint32_t stepperQueueHead = 0;         // Next move to run (changed by the ISR)
+static volatile uint32_t stepperQueueTail = 0;         // Next free slot
+
+// The move in progress (only used by the ISR, and by stepperStop with the ISR masked)
+static stepperMove_t stepperCurrent;
+static volatile bool stepperRunning = false;
+static uint32_t stepperStepsDone;                      // Steps taken in the current move
+static uint32_t stepperDecelStart;                     // First step of the deceleration
+static uint32_t stepperInterval;                       // Current interval in timer ticks
+static int32_t  stepperRest;                           // Remainder carried between intervals
+
+/**************************************************************************/
+/*!
+    Private - Integer square root (rounded down)
+*/
+/**************************************************************************/
+static uint32_t stepperSqrt(uint64_t value)
+{
+  uint64_t result = 0;
+  uint64_t bit = (uint64_t)1 << 62;
+
+  while (bit > value)
   {
-    case 0: // 1010
-      gpioSetValue(STEPPER_IN1_PORT, STEPPER_IN1_PIN, 1);
-      gpioSetValue(STEPPER_IN2_PORT, STEPPER_IN2_PIN, 0);
-      gpioSetValue(STEPPER_IN3_PORT, STEPPER_IN3_PIN, 1);
-      gpioSetValue(STEPPER_IN4_PORT, STEPPER_IN4_PIN, 0);
-      break;
-    case 1: // 0110
-      gpioSetValue(STEPPER_IN1_PORT, STEPPER_IN1_PIN, 0);
-      gpioSetValue(STEPPER_IN2_PORT, STEPPER_IN2_PIN, 1);
-      gpioSetValue(STEPPER_IN3_PORT, STEPPER_IN3_PIN, 1);
-      gpioSetValue(STEPPER_IN4_PORT, STEPPER_IN4_PIN, 0);
-      break;
-    case 2: // 0101
-      gpioSetValue(STEPPER_IN1_PORT, STEPPER_IN1_PIN, 0);
-      gpioSetValue(STEPPER_IN2_PORT, STEPPER_IN2_PIN, 1);
-      gpioSetValue(STEPPER_IN3_PORT, STEPPER_IN3_PIN, 0);
-      gpioSetValue(STEPPER_IN4_PORT, STEPPER_IN4_PIN, 1);
-      break;
-    case 3: // 1001
-      gpioSetValue(STEPPER_IN1_PORT, STEPPER_IN1_PIN, 1);
-      gpioSetValue(STEPPER_IN2_PORT, STEPPER_IN2_PIN, 0);
-      gpioSetValue(STEPPER_IN3_PORT, STEPPER_IN3_PIN, 0);
-      gpioSetValue(STEPPER_IN4_PORT, STEPPER_IN4_PIN, 1);
-      break;     
+    bit >>= 2;
   }
+
+  while (bit)
+  {
+    if (value >= result + bit)
+    {
+      value -= result + bit;
+      result = (result >> 1) + bit;
+    }
+    else
+    {
+      result >>= 1;
+    }
+    bit >>= 2;
+  }
+
+  return (uint32_t)result;
+}
+
+/**************************************************************************/
+/*!
+    Private - Starts the move at the head of the queue, or stops the
+    timer if the queue is empty.  Called with the timer interrupt
+    masked (or from it).
+*/
+/**************************************************************************/
+static void stepperStartNext(void)
+{
+  if (stepperQueueHead == stepperQueueTail)
+  {
+    stepperRunning = false;
+    timer32Disable(0);
+    return;
+  }
+
+  stepperCurrent = stepperQueue[stepperQueueHead];
+  stepperQueueHead = (stepperQueueHead + 1) % STEPPER_QUEUESIZE;
+
+  stepperStepsDone = 0;
+  stepperDecelStart = stepperCurrent.steps - stepperCurrent.accelSteps;
+  stepperInterval = stepperCurrent.c0;
+  stepperRest = 0;
+  stepperRunning = true;
+
+  // The timer resets on MR0, so the first step happens c0 ticks from now
+  TMR_TMR32B0MR0 = stepperInterval - 1;
+  TMR_TMR32B0TC = 0;
+  timer32Enable(0);
+}
+
+/**************************************************************************/
+/*!
+    Private - Called on each MR0 match of 32-bit Timer 0: emits one
+    step and works out the interval until the next one
+*/
+/**************************************************************************/
+static void stepperTimerHandler(void)
+{
+  int32_t n, interval, delta;
+
+  if (!stepperRunning)
+  {
+    // The timer was started by someone else (pmu wakeup, etc.)
+    timer32Disable(0);
+    return;
+  }
+
+  // Step the motor one step
+  if (stepperCurrent.forward)
+  {
+    stepperPhase = (stepperPhase + 1) & 3;
+    stepperPosition++;          // Increment global position counter
+    stepperStepNumber++;        // Increment single rotation counter
+    if (stepperStepNumber == stepperStepsPerRotation)
+    {
+      stepperStepNumber = 0;
+    }
+  }
+  else
+  {
+    stepperPhase = (stepperPhase - 1) & 3;
+    stepperPosition--;          // Decrement global position counter
+    if (stepperStepNumber == 0)
+    {
+      stepperStepNumber = stepperStepsPerRotation;
+    }
+    stepperStepNumber--;        // Decrement single rotation counter
+  }
+  STEPPER_PINS = stepperPatterns[stepperPhase];
+
+  stepperStepsDone++;
+  if (stepperStepsDone >= stepperCurrent.steps)
+  {
+    stepperStartNext();
+    return;
+  }
+
+  // Work out the interval until the next step
+  if (stepperStepsDone < stepperCurrent.accelSteps)
+  {
+    // Speeding up: n counts up from 1
+    n = stepperStepsDone;
+  }
+  else if (stepperStepsDone >= stepperDecelStart)
+  {
+    // Slowing down: n counts up from -accelSteps to -1
+    if (stepperStepsDone == stepperDecelStart)
+    {
+      stepperRest = 0;
+    }
+    n = (int32_t)stepperStepsDone - (int32_t)stepperCurrent.steps;
+  }
+  else
+  {
+    // Cruising
+    n = 0;
+  }
+
+  if (n)
+  {
+    interval = stepperInterval;
+    delta = 2 * interval + stepperRest;
+    interval -= delta / (4 * n + 1);
+    stepperRest = delta % (4 * n + 1);
+    stepperInterval = interval < (int32_t)stepperCurrent.cmin ? stepperCurrent.cmin : (uint32_t)interval;
+  }
+
+  TMR_TMR32B0MR0 = stepperInterval - 1;
 }
 
 /**************************************************************************/
@@ -134,16 +322,18 @@ void stepperInit(uint32_t steps)
   gpioSetDir(STEPPER_IN3_PORT, STEPPER_IN3_PIN, 1);
   gpioSetDir(STEPPER_IN4_PORT, STEPPER_IN4_PIN, 1);
 
-  gpioSetValue(STEPPER_IN1_PORT, STEPPER_IN1_PIN, 0);
-  gpioSetValue(STEPPER_IN2_PORT, STEPPER_IN2_PIN, 0);
-  gpioSetValue(STEPPER_IN3_PORT, STEPPER_IN3_PIN, 0);
-  gpioSetValue(STEPPER_IN4_PORT, STEPPER_IN4_PIN, 0);
+  STEPPER_PINS = 0;
 
   // Set the number of steps per rotation
   stepperStepsPerRotation = steps;
 
-  // Set the default speed (2 rotations per second)
+  // Steps are emitted from the timer interrupt
+  timer32Init(0, TIMER32_DEFAULTINTERVAL);
+  timer32SetIntHandler(stepperTimerHandler);
+
+  // Set the default speed (2 rotations per second) without acceleration
   stepperSetSpeed(120);
+  stepperSetAcceleration(0);
 }
 
 /**************************************************************************/
@@ -153,11 +343,18 @@ void stepperInit(uint32_t steps)
     @return   The difference (in steps) of the motor's current position
               from the original 'Home' position. Value can be negative or 
               positive depending on the direction of previous movements.
+              This is updated while the motor moves.
 */
 /**************************************************************************/
 int64_t stepperGetPosition()
 {
-  return stepperPosition;
+  int64_t position;
+
+  NVIC_DisableIRQ(TIMER_32_0_IRQn);
+  position = stepperPosition;
+  NVIC_EnableIRQ(TIMER_32_0_IRQn);
+
+  return position;
 }
 
 /**************************************************************************/
@@ -183,7 +380,9 @@ uint32_t stepperGetRotation()
 /**************************************************************************/
 void stepperSetHome()
 {
+  NVIC_DisableIRQ(TIMER_32_0_IRQn);
   stepperPosition = 0;
+  NVIC_EnableIRQ(TIMER_32_0_IRQn);
 }
 
 /**************************************************************************/
@@ -193,7 +392,8 @@ void stepperSetHome()
 /**************************************************************************/
 void stepperMoveHome()
 {
-  stepperStep(stepperPosition * -1);
+  stepperWait();
+  stepperStep(stepperGetPosition() * -1);
 }
 
 /**************************************************************************/
@@ -217,7 +417,8 @@ void stepperSetZero()
 /**************************************************************************/
 void stepperMoveZero()
 {
-  if (!stepperStepNumber)
+  stepperWait();
+  if (stepperStepNumber)
   {
     stepperStep(stepperStepsPerRotation - stepperStepNumber);
   }
@@ -226,75 +427,186 @@ void stepperMoveZero()
 /**************************************************************************/
 /*! 
     @brief    Sets the motor speed in rpm, meaning the number of times the
-              motor will fully rotate in a one minute period.
+              motor will fully rotate in a one minute period.  This is
+              the top speed used by stepperStep.
 
     @param[in]  rpm
                 Motor speed in revolutions per minute (RPM)
 
     @warning  Not all motors will function at all speeds, and some trial
               and error may be required to find an appropriate speed for
-              the motor.
+              the motor.  Higher speeds can usually be reached with
+              stepperSetAcceleration.
 */
 /**************************************************************************/
 void stepperSetSpeed(uint32_t rpm)
 {
-  uint32_t ticksOneRPM = ((CFG_CPU_CCLK/SCB_SYSAHBCLKDIV) / stepperStepsPerRotation) * 60;
+  stepperSpeed = (rpm * stepperStepsPerRotation) / 60;
+  if (!stepperSpeed)
+  {
+    stepperSpeed = 1;
+  }
+}
 
-  // Set stepper RPM
-  stepperStepDelay = ticksOneRPM / rpm;
+/**************************************************************************/
+/*!
+    @brief    Sets the acceleration used by stepperStep
 
-  // Initialise 32-bit timer 0 with the appropriate delay
-  timer32Init(0, stepperStepDelay);
-  timer32Enable(0);
+    @param[in]  accel
+                Acceleration (and deceleration) in steps/s, or 0 to
+                start and stop at full speed
+*/
+/**************************************************************************/
+void stepperSetAcceleration(uint32_t accel)
+{
+  stepperAccel = accel;
 }
 
 /**************************************************************************/
-/*! 
-    @brief      Moves the motor forward or backward the specified number
-                of steps.  A positive number moves the motor forward,
-                while a negative number moves the motor backwards.
+/*!
+    @brief      Queues a move and returns straight away.  The move starts
+                once the moves queued before it have finished.
 
     @param[in]  steps
-                The number of steps to move foreward (positive) or
+                The number of steps to move forward (positive) or
                 backward (negative)
+    @param[in]  speed
+                The top speed in steps per second
+    @param[in]  accel
+                The acceleration and deceleration in steps/s, or 0 to
+                move at the top speed from the first step to the last.
+                If the move is too short to reach the top speed, the
+                motor decelerates as soon as it is half way.
+
+    @note   Possible error messages are:
+
+            - STEPPER_ERROR_INVALIDSPEED  // 'speed' is 0 or too fast for the timer
+            - STEPPER_ERROR_QUEUEFULL     // STEPPER_QUEUESIZE moves are already queued
 */
 /**************************************************************************/
-void stepperStep(int32_t steps)
+stepperError_e stepperMove(int32_t steps, uint32_t speed, uint32_t accel)
 {
-  uint32_t stepsLeft = abs(steps);          // Force number to be positive
+  stepperMove_t *move;
+  uint32_t next;
+  uint64_t c0;
 
-  while (stepsLeft > 0)
+  if (!steps)
   {
-    // Wait 1 tick between individual steps
-    timer32Delay(0, 1);
+    return STEPPER_ERROR_OK;
+  }
+  if (!speed || (TIMER32_CCLK_1S / speed < STEPPER_MININTERVAL))
+  {
+    return STEPPER_ERROR_INVALIDSPEED;
+  }
+
+  next = (stepperQueueTail + 1) % STEPPER_QUEUESIZE;
+  if (next == stepperQueueHead)
+  {
+    return STEPPER_ERROR_QUEUEFULL;
+  }
+
+  move = &stepperQueue[stepperQueueTail];
+  move->steps = abs(steps);
+  move->forward = steps > 0;
+  move->cmin = TIMER32_CCLK_1S / speed;
+  move->c0 = move->cmin;
+  move->accelSteps = 0;
 
-    // Increment or decrement step counters (depending on direction)
-    if (steps > 0)
+  if (accel)
+  {
+    // c0 = 0.676 * f * sqrt(2 / accel), with sqrt(2) * 0.676 = 0.956
+    c0 = ((uint64_t)TIMER32_CCLK_1S * 956 / 1000 << 12) / stepperSqrt((uint64_t)accel << 24);
+    if (c0 > STEPPER_MAXINTERVAL)
     {
-      stepperPosition++;          // Increment global position counter
-      stepperStepNumber++;        // Increment single rotation counter
-      if (stepperStepNumber == stepperStepsPerRotation)
-      {
-        stepperStepNumber = 0;
-      }
+      c0 = STEPPER_MAXINTERVAL;
     }
-    else
+
+    if (c0 > move->cmin)
     {
-      stepperPosition--;          // Decrement global position counter
-      if (stepperStepNumber == 0)
+      move->c0 = (uint32_t)c0;
+      // Steps needed to reach the top speed: v / 2a
+      move->accelSteps = (uint32_t)(((uint64_t)speed * speed) / (2 * (uint64_t)accel));
+      if (!move->accelSteps)
+      {
+        move->accelSteps = 1;
+      }
+      if (move->accelSteps > move->steps / 2)
       {
-        stepperStepNumber = stepperStepsPerRotation;
+        move->accelSteps = move->steps / 2;
       }
-      stepperStepNumber--;        // Decrement single rotation counter
     }
+  }
 
-    // Decrement number of remaining steps
-    stepsLeft--;
-
-    // Step the motor one step
-    stepMotor(stepperStepNumber % 4);
+  // Hand the move over to the ISR
+  NVIC_DisableIRQ(TIMER_32_0_IRQn);
+  stepperQueueTail = next;
+  if (!stepperRunning)
+  {
+    stepperStartNext();
   }
+  NVIC_EnableIRQ(TIMER_32_0_IRQn);
+
+  return STEPPER_ERROR_OK;
+}
+
+/**************************************************************************/
+/*!
+    @brief    Returns true while a move is running or queued
+*/
+/**************************************************************************/
+bool stepperIsMoving()
+{
+  return stepperRunning;
 }
 
+/**************************************************************************/
+/*!
+    @brief    Waits until all queued moves have finished
+*/
+/**************************************************************************/
+void stepperWait()
+{
+  while (stepperRunning);
+}
+
+/**************************************************************************/
+/*!
+    @brief    Drops any queued moves and brings the motor to a stop,
+              decelerating at the rate of the current move so that no
+              steps are lost.  The position is still tracked while the
+              motor slows down (see stepperIsMoving).
+*/
+/**************************************************************************/
+void stepperStop()
+{
+  NVIC_DisableIRQ(TIMER_32_0_IRQn);
+  stepperQueueTail = stepperQueueHead;
+  if (stepperRunning && (stepperStepsDone < stepperDecelStart))
+  {
+    // Decelerate from the current speed: as many steps as it took to reach it
+    uint32_t rampSteps = stepperStepsDone < stepperCurrent.accelSteps ? stepperStepsDone : stepperCurrent.accelSteps;
+    stepperCurrent.steps = stepperStepsDone + rampSteps + 1;
+    stepperCurrent.accelSteps = rampSteps;
+    stepperDecelStart = stepperStepsDone + 1;
+  }
+  NVIC_EnableIRQ(TIMER_32_0_IRQn);
+}
 
+/**************************************************************************/
+/*! 
+    @brief      Moves the motor forward or backward the specified number
+                of steps.  A positive number moves the motor forward,
+                while a negative number moves the motor backwards.  This
+                waits until the move (and any queued before it) has
+                finished.
 
+    @param[in]  steps
+                The number of steps to move foreward (positive) or
+                backward (negative)
+*/
+/**************************************************************************/
+void stepperStep(int32_t steps)
+{
+  while (stepperMove(steps, stepperSpeed, stepperAccel) == STEPPER_ERROR_QUEUEFULL);
+  stepperWait();
+}
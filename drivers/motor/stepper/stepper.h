@@ -48,14 +48,32 @@
 #define STEPPER_IN4_PORT   (3)
 #define STEPPER_IN4_PIN    (3)
 
-void     stepperInit( uint32_t steps );
-void     stepperSetSpeed( uint32_t rpm );
-int64_t  stepperGetPosition();
-uint32_t stepperGetRotation();
-void     stepperMoveHome();
-void     stepperSetHome();
-void     stepperMoveZero();
-void     stepperSetZero();
-void     stepperStep( int32_t steps );
+#define STEPPER_QUEUESIZE    (8)            // Moves that can be queued (one slot is kept free)
+#define STEPPER_MININTERVAL  (500)          // Shortest step interval in CPU ticks (limits the ISR load)
+#define STEPPER_MAXINTERVAL  (0x3FFFFFFF)   // Longest step interval in CPU ticks
+
+typedef enum
+{
+  STEPPER_ERROR_OK = 0,               // Everything executed normally
+  STEPPER_ERROR_INVALIDSPEED,         // Speed is 0 or above CPU ticks / STEPPER_MININTERVAL
+  STEPPER_ERROR_QUEUEFULL,            // No room left in the move queue
+  STEPPER_ERROR_LAST
+}
+stepperError_e;
+
+void           stepperInit( uint32_t steps );
+void           stepperSetSpeed( uint32_t rpm );
+void           stepperSetAcceleration( uint32_t accel );
+int64_t        stepperGetPosition();
+uint32_t       stepperGetRotation();
+void           stepperMoveHome();
+void           stepperSetHome();
+void           stepperMoveZero();
+void           stepperSetZero();
+void           stepperStep( int32_t steps );
+stepperError_e stepperMove( int32_t steps, uint32_t speed, uint32_t accel );
+bool           stepperIsMoving();
+void           stepperWait();
+void           stepperStop();
 
 #endif
\ No newline at end of file
@@ -51,6 +51,7 @@ void chb_init()
 {
     memset(&pcb, 0, sizeof(chb_pcb_t));
     pcb.src_addr = chb_get_short_addr();
+    chb_buf_init();
     chb_drvr_init();
 }
 
@@ -152,80 +153,108 @@ U8 chb_write(U16 addr, U8 *data, U8 len)
 
 /**************************************************************************/
 /*!
-    Read data from the buffer. Need to pass in a buffer of at leasts max frame
-    size and two 16-bit containers for the src and dest addresses.
- 
-    The read function will automatically populate the addresses and the data with
-    the frm payload. It will then return the len of the payload.
+    Hands the descriptor of the frame returned by chb_read_frame() back to
+    the receive queue.
 */
 /**************************************************************************/
-U8 chb_read(chb_rx_data_t *rx)
+void chb_read_done()
 {
-    U8 i, len, seq, *data_ptr;
-
-    data_ptr = rx->data;
+    chb_buf_free();
 
-    // first byte is always len. check it to make sure 
-    // we have a valid len byte.
-    if ((len = chb_buf_read()) > CHB_MAX_FRAME_LENGTH)
+    // lower the rx flag first so that a frame queued by the ISR in the
+    // meantime can't be missed
+    pcb.data_rcv = false;
+    if (chb_buf_get_len())
     {
-        return 0;
+        pcb.data_rcv = true;
     }
-    *data_ptr++ = len;
-
-    // load the rest of the data into buffer
-    for (i=0; i<len; i++)
-    {
-        *data_ptr++ = chb_buf_read();
-    }
-
-    // we're using the buffer that's fed in as an argument as a temp
-    // buffer as well to save resources.
-    // we'll use it as temp storage to parse the frame. then move the frame
-    // down so that only the payload will be in the buffer.
+}
 
-    // extract the sequence number
-    data_ptr = rx->data + 3;    // location of sequence number
-    seq = *data_ptr;
+/**************************************************************************/
+/*!
+    Zero-copy read.  Fills in the addresses and link metadata, points
+    rx->data at the payload inside the receive queue, then returns the len
+    of the payload (or 0 if no frame is available).  The payload stays valid until
+    chb_read_done() is called, which must happen before the next read.
 
-    // parse the buffer and extract the dest and src addresses
-    data_ptr = rx->data + 6;                // location of dest addr
-    rx->dest_addr = *(U16 *)data_ptr;
-    data_ptr += sizeof(U16);
-    rx->src_addr = *(U16 *)data_ptr;
-    data_ptr += sizeof(U16);
+    In promiscuous mode rx->data points at the complete frame, starting
+    with the length byte, and the frame length is returned.
+*/
+/**************************************************************************/
+U8 chb_read_frame(chb_rx_frame_t *rx)
+{
+    chb_frame_t *frm;
+    U8 len, seq;
 
-    // if the data in the rx buf is 0, then clear the rx_flag. otherwise, keep it raised
-    if (!chb_buf_get_len())
+    rx->len = 0;
+    while ((frm = chb_buf_peek()) != NULL)
     {
-        pcb.data_rcv = false;
-    }
+        // first byte is always len. the rest of the frame is the header
+        // followed by the payload and the fcs.
+        len = frm->data[0];
+        seq = frm->data[3];                     // location of sequence number
+        rx->dest_addr = *(U16 *)(frm->data + 6);  // location of dest addr
+        rx->src_addr = *(U16 *)(frm->data + 8);   // location of src addr
+        rx->ed = frm->ed;
+        rx->lqi = frm->lqi;
+        rx->crc = frm->crc;
+        rx->timestamp = frm->timestamp;
 
 #if (CFG_CHIBI_PROMISCUOUS == 1)
-    // if we're in promiscuous mode, we don't want to do any duplicate rejection and we don't want to move the payload
-    // to the front of the buffer. We want to capture the full frame so just keep the frame intact and return the length.
-    return len;
+        // if we're in promiscuous mode, we don't want to do any duplicate rejection and we don't want to strip
+        // the header. We want to capture the full frame so just hand it over intact and return the length.
+        rx->data = frm->data;
+        rx->len = len;
+        return len;
 #else
-    // duplicate frame check (dupe check). we want to remove frames that have been already been received since they 
-    // are just retries. 
-    // note: this dupe check only removes duplicate frames from the previous transfer. if another frame from a different
-    // node comes in between the dupes, then the dupe will show up as a received frame.
-    if ((seq == prev_seq) && (rx->src_addr == prev_src_addr))
-    {
-        // this is a duplicate frame from a retry. the remote node thinks we didn't receive 
-        // it properly. discard.
-        return 0;
-    }
-    else
-    {
+        // duplicate frame check (dupe check). we want to remove frames that have been already been received since they 
+        // are just retries. frames without a payload are tossed as well.
+        // note: this dupe check only removes duplicate frames from the previous transfer. if another frame from a different
+        // node comes in between the dupes, then the dupe will show up as a received frame.
+        if ((len <= (CHB_HDR_SZ + CHB_FCS_LEN)) || ((seq == prev_seq) && (rx->src_addr == prev_src_addr)))
+        {
+            chb_read_done();
+            continue;
+        }
         prev_seq = seq;
         prev_src_addr = rx->src_addr;
-    }
 
-    // move the payload down to the beginning of the data buffer
-    memmove(rx->data, data_ptr, len - CHB_HDR_SZ);
-    // finally, return the len of the payload
-    return len - CHB_HDR_SZ - CHB_FCS_LEN;
+        // point at the payload, which follows the len byte and the header
+        rx->data = frm->data + 1 + CHB_HDR_SZ;
+        rx->len = len - CHB_HDR_SZ - CHB_FCS_LEN;
+        return rx->len;
 #endif
+    }
+    return 0;
 }
 
+/**************************************************************************/
+/*!
+    Read data from the buffer. Need to pass in a buffer of at leasts max frame
+    size and two 16-bit containers for the src and dest addresses.
+ 
+    The read function will automatically populate the addresses and the data with
+    the frm payload. It will then return the len of the payload.  This copies
+    the payload out of the receive queue; use chb_read_frame() to avoid that.
+*/
+/**************************************************************************/
+U8 chb_read(chb_rx_data_t *rx)
+{
+    chb_rx_frame_t frm;
+    U8 len;
+
+    if ((len = chb_read_frame(&frm)) == 0)
+    {
+        return 0;
+    }
+
+    rx->src_addr = frm.src_addr;
+    rx->dest_addr = frm.dest_addr;
+    rx->ed = frm.ed;
+    rx->lqi = frm.lqi;
+    rx->crc = frm.crc;
+    rx->timestamp = frm.timestamp;
+    memcpy(rx->data, frm.data, len);
+    chb_read_done();
+    return len;
+}
@@ -35,6 +35,7 @@
 #define CHIBI_H
 
 #include "types.h"
+#include "projectconfig.h"
 
 #define CHB_HDR_SZ        9    // FCF + seq + pan_id + dest_addr + src_addr (2 + 1 + 2 + 2 + 2)
 #define CHB_FCS_LEN       2
@@ -89,12 +90,35 @@ typedef struct
     U8 len;
     U16 src_addr;
     U16 dest_addr;
+    U8 ed;              // energy detect level
+    U8 lqi;             // link quality indicator
+    U8 crc;             // 1 if the FCS was valid
+    U32 timestamp;      // systickGetMicroseconds() on entry to the TRX_END ISR
+#if (CFG_CHIBI_PROMISCUOUS == 1)
+    U8 data[1 + 127];   // complete frame including the len byte
+#else
     U8 data[CHB_MAX_PAYLOAD];
+#endif
 } chb_rx_data_t;
 
+// Zero-copy receive descriptor, data points into the receive queue
+typedef struct
+{
+    U8 len;
+    U16 src_addr;
+    U16 dest_addr;
+    U8 ed;
+    U8 lqi;
+    U8 crc;
+    U32 timestamp;
+    U8 *data;
+} chb_rx_frame_t;
+
 void chb_init();
 chb_pcb_t *chb_get_pcb();
 U8 chb_write(U16 addr, U8 *data, U8 len);
 U8 chb_read(chb_rx_data_t *rx);
+U8 chb_read_frame(chb_rx_frame_t *rx);
+void chb_read_done();
 
 #endif
@@ -32,12 +32,27 @@
 
 *******************************************************************/
 #include <stdio.h>
+#include <string.h>
 #include "chb_buf.h"
-#include "projectconfig.h"
 
-static U8 chb_buf[CFG_CHIBI_BUFFERSIZE];
-static volatile U32 rd_ptr, wr_ptr;
-static volatile U32 len;
+/*
+    The receive buffer is a fixed-count queue of frame descriptors with a
+    single producer and a single consumer.  The radio ISR bursts a frame
+    straight into the descriptor returned by chb_buf_alloc(), fills in the
+    metadata and publishes it with chb_buf_commit().  The application gets
+    a pointer to the oldest frame with chb_buf_peek() and hands the
+    descriptor back with chb_buf_free(), so payloads are never copied
+    through an intermediate byte FIFO.
+
+    rd_cnt and wr_cnt count modulo twice the queue size so that a full
+    queue can be told apart from an empty one.  Each side only ever writes its
+    own counter, so no locking is required.
+*/
+static chb_frame_t chb_buf[CHB_BUF_FRAMES];
+static volatile U32 rd_cnt, wr_cnt;
+static chb_buf_stats_t stats;
+
+#define CHB_BUF_NEXT(cnt)   (((cnt) + 1) % (2 * CHB_BUF_FRAMES))
 
 /**************************************************************************/
 /*!
@@ -46,44 +61,90 @@ static volatile U32 len;
 /**************************************************************************/
 void chb_buf_init()
 {
-    rd_ptr = 0;
-    wr_ptr = 0;
-    len = 0;
+    rd_cnt = 0;
+    wr_cnt = 0;
+    memset(&stats, 0, sizeof(stats));
 }
 
 /**************************************************************************/
 /*!
-
+    Returns the next free descriptor, or NULL (and counts an overflow) if
+    every descriptor is in use.  The descriptor is not visible to the
+    reader until chb_buf_commit() is called.
 */
 /**************************************************************************/
-void chb_buf_write(U8 data)
+chb_frame_t *chb_buf_alloc()
 {
-    chb_buf[wr_ptr] = data;
-    wr_ptr = (wr_ptr + 1) % CFG_CHIBI_BUFFERSIZE;
-    len++;
+    if (chb_buf_get_len() >= CHB_BUF_FRAMES)
+    {
+        stats.overflow++;
+        return NULL;
+    }
+    return &chb_buf[wr_cnt % CHB_BUF_FRAMES];
 }
 
 /**************************************************************************/
 /*!
-
+    Queues the descriptor previously returned by chb_buf_alloc()
 */
 /**************************************************************************/
-U8 chb_buf_read()
+void chb_buf_commit()
 {
-    U8 data;
+    U32 len;
+
+    wr_cnt = CHB_BUF_NEXT(wr_cnt);
 
-    data = chb_buf[rd_ptr];
-    rd_ptr = (rd_ptr + 1) % CFG_CHIBI_BUFFERSIZE;
-    len--;
-    return data;
+    stats.rcvd++;
+    if ((len = chb_buf_get_len()) > stats.peak)
+    {
+        stats.peak = len;
+    }
+}
+
+/**************************************************************************/
+/*!
+    Returns the oldest queued frame without removing it, or NULL if the
+    queue is empty
+*/
+/**************************************************************************/
+chb_frame_t *chb_buf_peek()
+{
+    if (wr_cnt == rd_cnt)
+    {
+        return NULL;
+    }
+    return &chb_buf[rd_cnt % CHB_BUF_FRAMES];
 }
 
 /**************************************************************************/
 /*!
+    Releases the oldest queued frame
+*/
+/**************************************************************************/
+void chb_buf_free()
+{
+    if (wr_cnt != rd_cnt)
+    {
+        rd_cnt = CHB_BUF_NEXT(rd_cnt);
+    }
+}
 
+/**************************************************************************/
+/*!
+    Returns the number of queued frames
 */
 /**************************************************************************/
 U32 chb_buf_get_len()
 {
-    return len;
+    return (wr_cnt + 2 * CHB_BUF_FRAMES - rd_cnt) % (2 * CHB_BUF_FRAMES);
+}
+
+/**************************************************************************/
+/*!
+    Returns the receive queue statistics
+*/
+/**************************************************************************/
+chb_buf_stats_t *chb_buf_get_stats()
+{
+    return &stats;
 }
@@ -35,10 +35,47 @@
 #define CHB_BUF_H
 
 #include "types.h"
+#include "projectconfig.h"
+
+// Receive frame descriptor, large enough for the biggest 802.15.4 frame.
+// data is laid out like the radio's frame buffer: data[0] is the frame
+// length (PSDU including FCS) and the PSDU follows.  The metadata is
+// captured by the ISR when the frame arrives, so it stays with the frame.
+typedef struct
+{
+    U8 data[1 + 127];
+    U32 timestamp;      // systickGetMicroseconds() on entry to chb_ISR_Handler,
+                        // i.e. just after the TRX_END interrupt ending the frame
+    U8 ed;              // energy detect level (PHY_ED_LEVEL)
+    U8 lqi;             // link quality indicator
+    U8 crc;             // 1 if the FCS was valid
+} chb_frame_t;
+
+// Receive queue statistics
+typedef struct
+{
+    U32 rcvd;           // frames queued since chb_buf_init()
+    U16 overflow;       // frames dropped because every descriptor was in use
+    U8 peak;            // highest number of frames queued at once
+} chb_buf_stats_t;
+
+// Number of frame descriptors in the receive queue
+#define CHB_BUF_FRAMES      (CFG_CHIBI_RXFRAMES)
+
+#if (CFG_CHIBI_RXFRAMES < 1)
+  #error "CFG_CHIBI_RXFRAMES must be at least 1"
+#endif
 
 void chb_buf_init();
-void chb_buf_write(U8 data);
-U8 chb_buf_read();
+
+// producer side (radio ISR)
+chb_frame_t *chb_buf_alloc();
+void chb_buf_commit();
+
+// consumer side (application)
+chb_frame_t *chb_buf_peek();
+void chb_buf_free();
 U32 chb_buf_get_len();
+chb_buf_stats_t *chb_buf_get_stats();
 
 #endif
@@ -40,9 +40,16 @@
 
 #include "core/systick/systick.h"
 #include "core/timer16/timer16.h"
+#include "core/pmu/pmu.h"
+#include "core/profile/profile.h"
+
+#ifdef CFG_EVENTS
+  #include "core/events/events.h"
+#endif
+
+PROFILE_DEFINE(chb_isr, "chb_ISR_Handler");
 
 // store string messages in flash rather than RAM
-const char chb_err_overflow[] = "BUFFER FULL. TOSSING INCOMING DATA\r\n";
 const char chb_err_init[] = "RADIO NOT INITIALIZED PROPERLY\r\n";
 /**************************************************************************/
 /*!
@@ -249,9 +256,6 @@ void chb_reg_read_mod_write(U8 addr, U8 val, U8 mask)
 /**************************************************************************/
 void chb_frame_write(U8 *hdr, U8 hdr_len, U8 *data, U8 data_len)
 {
-    //U8 i, dummy;
-    U8 i;
-
     // dont allow transmission longer than max frame size
     if ((hdr_len + data_len) > 127)
     {
@@ -263,22 +267,11 @@ void chb_frame_write(U8 *hdr, U8 hdr_len, U8 *data, U8 data_len)
     CHB_SPI_ENABLE(); 
 
     // send fifo write command
-    // dummy = chb_xfer_byte(CHB_SPI_CMD_FW);
     chb_xfer_byte(CHB_SPI_CMD_FW);
 
-    // write hdr contents to fifo
-    for (i=0; i<hdr_len; i++)
-    {
-        // dummy = chb_xfer_byte(*hdr++);
-        chb_xfer_byte(*hdr++);
-    }
-
-    // write data contents to fifo
-    for (i=0; i<data_len; i++)
-    {
-        // dummy = chb_xfer_byte(*data++);
-        chb_xfer_byte(*data++);
-    }
+    // write hdr and data contents to fifo
+    chb_xfer_block(hdr, NULL, hdr_len);
+    chb_xfer_block(data, NULL, data_len);
 
     // terminate spi transaction
     CHB_SPI_DISABLE(); 
@@ -287,12 +280,15 @@ void chb_frame_write(U8 *hdr, U8 hdr_len, U8 *data, U8 data_len)
 
 /**************************************************************************/
 /*!
-
+    Called from the ISR.  The frame is burst straight into a descriptor
+    from the receive queue along with its link metadata, or clocked out and
+    dropped if the queue is full.
 */
 /**************************************************************************/
-static void chb_frame_read()
+static void chb_frame_read(U8 ed, U8 crc, U32 timestamp)
 {
-    U8 i, len, data;
+    U8 len;
+    chb_frame_t *frm;
 
     // CHB_ENTER_CRIT();
     CHB_SPI_ENABLE();
@@ -304,33 +300,24 @@ static void chb_frame_read()
     /*Check for correct frame length.*/
     if ((len >= CHB_MIN_FRAME_LENGTH) && (len <= CHB_MAX_FRAME_LENGTH))
     {
-        // check to see if there is room to write the frame in the buffer. if not, then drop it
-        if (len < (CFG_CHIBI_BUFFERSIZE - chb_buf_get_len()))
+        if ((frm = chb_buf_alloc()) != NULL)
         {
-            chb_buf_write(len);
-            
-            for (i=0; i<len; i++)
-            {
-                data = chb_xfer_byte(0);
-                chb_buf_write(data);
-            }
+            frm->data[0] = len;
+            chb_xfer_block(NULL, &frm->data[1], len);
+
+            // the radio appends the lqi to the frame
+            frm->lqi = chb_xfer_byte(0);
+            frm->ed = ed;
+            frm->crc = crc;
+            frm->timestamp = timestamp;
+            chb_buf_commit();
         }
         else
         {
-            // we've overflowed the buffer. toss the data and do some housekeeping
-            chb_pcb_t *pcb = chb_get_pcb();
-
-            // read out the data and throw it away
-            for (i=0; i<len; i++)
-            {
-                data = chb_xfer_byte(0);
-            }
-
-            // Increment the overflow stat
-            pcb->overflow++;
-
-            // print the error message
-            printf(chb_err_overflow);
+            // we've overflowed the buffer. toss the data and bump the
+            // overflow stat. no printing here, we're in the ISR.
+            chb_xfer_block(NULL, NULL, len);
+            chb_get_pcb()->overflow++;
         }
     }
 
@@ -347,7 +334,7 @@ static void chb_frame_read()
 #ifdef CHB_DEBUG
 void chb_sram_read(U8 addr, U8 len, U8 *data)
 {
-    U8 i, dummy;
+    U8 dummy;
 
     CHB_ENTER_CRIT();
     CHB_SPI_ENABLE();
@@ -358,10 +345,7 @@ void chb_sram_read(U8 addr, U8 len, U8 *data)
     /*Send address where to start reading.*/
     dummy = chb_xfer_byte(addr);
 
-    for (i=0; i<len; i++)
-    {
-        *data++ = chb_xfer_byte(0);
-    }
+    chb_xfer_block(NULL, data, len);
 
     CHB_SPI_DISABLE();
     CHB_LEAVE_CRIT();
@@ -374,7 +358,7 @@ void chb_sram_read(U8 addr, U8 len, U8 *data)
 /**************************************************************************/
 void chb_sram_write(U8 addr, U8 len, U8 *data)
 {    
-    U8 i, dummy;
+    U8 dummy;
 
     CHB_ENTER_CRIT();
     CHB_SPI_ENABLE();
@@ -385,10 +369,7 @@ void chb_sram_write(U8 addr, U8 len, U8 *data)
     /*Send address where to start writing to.*/
     dummy = chb_xfer_byte(addr);
 
-    for (i=0; i<len; i++)
-    {
-        dummy = chb_xfer_byte(*data++);
-    }
+    chb_xfer_block(data, NULL, len);
 
     CHB_SPI_DISABLE();
     CHB_LEAVE_CRIT();
@@ -779,6 +760,22 @@ static void chb_radio_init()
     }
 }
 
+/**************************************************************************/
+/*!
+    Put the radio to sleep before the MCU enters deep-sleep, and wake
+    it up again afterwards.
+*/
+/**************************************************************************/
+static void chb_suspend()
+{
+    chb_sleep(true);
+}
+
+static void chb_resume()
+{
+    chb_sleep(false);
+}
+
 /**************************************************************************/
 /*!
 
@@ -810,6 +807,8 @@ void chb_drvr_init()
 
     // config radio
     chb_radio_init();
+
+    pmuRegisterHooks(chb_suspend, chb_resume);
 }
 
 /**************************************************************************/
@@ -851,6 +850,8 @@ void chb_ISR_Handler (void)
     // U8 dummy, state, intp_src = 0;
     U8 state, intp_src = 0;
     chb_pcb_t *pcb = chb_get_pcb();
+    U32 timestamp = systickGetMicroseconds();
+    PROFILE_START(chb_isr);
 
     CHB_ENTER_CRIT();
 
@@ -883,13 +884,17 @@ void chb_ISR_Handler (void)
                 // get the crc
                 pcb->crc = (chb_reg_read(PHY_RSSI) & (1<<7)) ? 1 : 0;
 
-                // if the crc is not valid, then do not read the frame and set the rx flag
-                if (pcb->crc)
+                // if the crc is not valid, then do not read the frame and set the rx flag.
+                // in promiscuous mode the frame is kept and flagged through its crc field.
+                if (pcb->crc || CFG_CHIBI_PROMISCUOUS)
                 {
                     // get the data
-                    chb_frame_read();
+                    chb_frame_read(pcb->ed, pcb->crc, timestamp);
                     pcb->rcvd_xfers++;
                     pcb->data_rcv = true;
+                    #ifdef CFG_EVENTS
+                    eventsPost(EVENTS_CHIBIRX, 0);
+                    #endif
                 }
             }
             else
@@ -922,4 +927,6 @@ void chb_ISR_Handler (void)
         }
     }
     CHB_LEAVE_CRIT();
+
+    PROFILE_STOP(chb_isr);
 }
@@ -48,13 +48,8 @@
 /**************************************************************************/
 void chb_eeprom_write(uint16_t addr, uint8_t *buf, uint16_t size)
 {
-  // Write the address one byte at a time
-  uint16_t a = 0;
-  while (a < size)
-  {
-    eepromWriteU8(addr + a, buf[a]);
-    a++;
-  }
+  // Write the buffer one EEPROM page at a time
+  eepromWriteBuffer(addr, buf, size);
 }
 
 /**************************************************************************/
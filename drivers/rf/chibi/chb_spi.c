@@ -75,3 +75,36 @@ U8 chb_xfer_byte(U8 data)
     // Read the queue
     return SSP_SSP0DR;
 }
+
+/**************************************************************************/
+/*!
+    Transfers a block of bytes in a single burst.  The SSP FIFOs are kept
+    topped up so the bus runs back to back instead of stalling on every
+    byte.  If tx is NULL zeroes are sent, and if rx is NULL the received
+    bytes are discarded.  The caller is responsible for the slave select.
+*/
+/**************************************************************************/
+void chb_xfer_block(const U8 *tx, U8 *rx, U8 len)
+{
+    U8 sent = 0, rcvd = 0, data;
+
+    while (rcvd < len)
+    {
+        // never have more bytes in flight than the RX FIFO can hold
+        while ((sent < len) && ((U8)(sent - rcvd) < SSP_FIFOSIZE) && (SSP_SSP0SR & SSP_SSP0SR_TNF_MASK))
+        {
+            SSP_SSP0DR = tx ? tx[sent] : 0;
+            sent++;
+        }
+
+        if (SSP_SSP0SR & SSP_SSP0SR_RNE_MASK)
+        {
+            data = SSP_SSP0DR;
+            if (rx)
+            {
+                rx[rcvd] = data;
+            }
+            rcvd++;
+        }
+    }
+}
@@ -58,5 +58,6 @@
 
 void chb_spi_init();
 U8 chb_xfer_byte(U8 data);
+void chb_xfer_block(const U8 *tx, U8 *rx, U8 len);
 
 #endif
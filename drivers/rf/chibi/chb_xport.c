@@ -0,0 +1,513 @@
+/**************************************************************************/
+/*!
+    @file     chb_xport.c
+    @date     19 October, 2026
+    @version  1.0
+
+    Message transport on top of the Chibi MAC.
+
+    Messages that fit in a frame are appended to an aggregate for their
+    destination and go out as one frame when it is full, when a message for
+    another node is sent, after CHB_XPORT_AGG_TIMEOUT ms, or on
+    chb_xport_flush().  This saves a MAC header and an ACK per message.
+
+    Larger messages are split into numbered fragments.  The last fragment
+    of each burst asks the receiver for a bitmap of what it has, and only
+    the missing fragments are sent again.  The receiver reassembles into a
+    small pool of buffers and reports completion with the same bitmap.
+
+    chb_xport_poll() must be called regularly from the main loop; it reads
+    all frames from the Chibi receive queue, so chb_read() should not be
+    used alongside it.  chb_xport_send() polls while waiting for a status
+    report, so it must not be called from the receive callback.
+
+    Fragmented messages are limited to CHB_XPORT_MAX_MSG bytes, the size
+    of the receiver's reassembly buffers, so both ends must be built with
+    the same CHB_XPORT_REASM_SIZE.
+*/
+/**************************************************************************/
+#include <string.h>
+
+#include "chb_xport.h"
+#include "core/systick/systick.h"
+
+// The transport relies on the filtered, addressed frames of normal mode,
+// so promiscuous builds (e.g. the sniffer) leave it out
+#if (CFG_CHIBI_PROMISCUOUS == 0)
+
+#define CHB_XPORT_MASK(cnt)     (((cnt) >= 32) ? 0xFFFFFFFF : ((1UL << (cnt)) - 1))
+
+typedef struct
+{
+    U16 src_addr;
+    U8 msg_id;
+    U8 count;               // number of fragments, 0 if the buffer is free
+    U32 rcvd;               // bitmap of received fragments
+    U16 len;                // known once the last fragment has arrived
+    U32 last;               // time of the last fragment (ms)
+    U8 data[CHB_XPORT_REASM_SIZE];
+} chb_xport_reasm_t;
+
+static chb_xport_reasm_t reasm[CHB_XPORT_REASM_BUFS];
+static chb_xport_rx_cb_t rx_cb;
+static chb_xport_stats_t stats;
+
+// pending aggregate
+static U8 agg_buf[CHB_MAX_PAYLOAD];
+static U8 agg_len;
+static U16 agg_addr;
+static U32 agg_time;
+
+// fragmented message being sent
+static U8 tx_buf[CHB_MAX_PAYLOAD];
+static U8 tx_msg_id;
+static U16 tx_addr;
+static U32 tx_status;
+static bool tx_waiting, tx_reported;
+
+// recently completed messages, one per sender, so that a lost final
+// status can be repeated without delivering the message again.  A sender
+// that restarts begins again at the same message ids, so an entry only
+// holds until the sender's retries are over or it moves on to another
+// message.
+typedef struct
+{
+    U16 src_addr;           // 0xFFFE if unused
+    U8 msg_id;
+    U8 count;
+    U32 time;               // completion time (ms)
+} chb_xport_done_t;
+
+static chb_xport_done_t done[CHB_XPORT_DONE_ENTRIES];
+
+/**************************************************************************/
+/*!
+
+*/
+/**************************************************************************/
+static U32 chb_xport_ms()
+{
+    return systickGetTicks() * CFG_SYSTICK_DELAY_IN_MS;
+}
+
+/**************************************************************************/
+/*!
+
+*/
+/**************************************************************************/
+static void chb_xport_send_status(U16 addr, U8 msg_id, U32 rcvd)
+{
+    U8 status[6];
+
+    status[0] = CHB_XPORT_STATUS;
+    status[1] = msg_id;
+    status[2] = rcvd;
+    status[3] = rcvd >> 8;
+    status[4] = rcvd >> 16;
+    status[5] = rcvd >> 24;
+    chb_write(addr, status, sizeof(status));
+}
+
+/**************************************************************************/
+/*!
+    Finds the reassembly buffer for a message, or claims a free (or timed
+    out) one for it.
+*/
+/**************************************************************************/
+static chb_xport_reasm_t *chb_xport_reasm_get(U16 src_addr, U8 msg_id, U32 now)
+{
+    chb_xport_reasm_t *avail = NULL;
+    U8 i;
+
+    for (i=0; i<CHB_XPORT_REASM_BUFS; i++)
+    {
+        if (reasm[i].count == 0)
+        {
+            if (!avail)
+            {
+                avail = &reasm[i];
+            }
+        }
+        else if ((reasm[i].src_addr == src_addr) && (reasm[i].msg_id == msg_id))
+        {
+            return &reasm[i];
+        }
+        else if ((now - reasm[i].last) >= CHB_XPORT_REASM_TIMEOUT)
+        {
+            reasm[i].count = 0;
+            stats.rx_timeouts++;
+            if (!avail)
+            {
+                avail = &reasm[i];
+            }
+        }
+    }
+    return avail;
+}
+
+/**************************************************************************/
+/*!
+    Returns the completed-message entry for a sender, or the entry to
+    reuse for it (an unused or the oldest one)
+*/
+/**************************************************************************/
+static chb_xport_done_t *chb_xport_done_get(U16 src_addr, U32 now)
+{
+    chb_xport_done_t *oldest = &done[0];
+    U8 i;
+
+    for (i=0; i<CHB_XPORT_DONE_ENTRIES; i++)
+    {
+        if (done[i].src_addr == src_addr)
+        {
+            return &done[i];
+        }
+        if ((oldest->src_addr != 0xFFFE) &&
+            ((done[i].src_addr == 0xFFFE) ||
+             ((now - done[i].time) > (now - oldest->time))))
+        {
+            oldest = &done[i];
+        }
+    }
+    return oldest;
+}
+
+/**************************************************************************/
+/*!
+
+*/
+/**************************************************************************/
+static void chb_xport_rx_frag(chb_rx_frame_t *rx, U32 now)
+{
+    chb_xport_reasm_t *r;
+    chb_xport_done_t *d;
+    U8 msg_id, idx, req, cnt, flen;
+    bool unicast = (rx->dest_addr != 0xFFFF);
+    U16 offset;
+
+    if (rx->len < CHB_XPORT_FRAG_HDR_SZ)
+    {
+        return;
+    }
+    msg_id = rx->data[1];
+    idx = rx->data[2] & ~CHB_XPORT_FRAG_REQ;
+    req = (rx->data[2] & CHB_XPORT_FRAG_REQ) && unicast;
+    cnt = rx->data[3];
+    flen = rx->len - CHB_XPORT_FRAG_HDR_SZ;
+
+    // every fragment but the last one is full
+    if ((cnt == 0) || (cnt > CHB_XPORT_MAX_FRAGS) || (idx >= cnt) ||
+        ((idx < cnt - 1) && (flen != CHB_XPORT_FRAG_DATA)))
+    {
+        return;
+    }
+
+    // a retransmission of a message we've already delivered
+    d = chb_xport_done_get(rx->src_addr, now);
+    if (d->src_addr == rx->src_addr)
+    {
+        if ((msg_id == d->msg_id) && (cnt == d->count) &&
+            ((now - d->time) < CHB_XPORT_DONE_TIMEOUT))
+        {
+            if (req)
+            {
+                chb_xport_send_status(rx->src_addr, msg_id, CHB_XPORT_MASK(cnt));
+            }
+            return;
+        }
+        d->src_addr = 0xFFFE;
+    }
+
+    offset = idx * CHB_XPORT_FRAG_DATA;
+    if (((offset + flen) > CHB_XPORT_REASM_SIZE) ||
+        ((r = chb_xport_reasm_get(rx->src_addr, msg_id, now)) == NULL))
+    {
+        stats.rx_dropped++;
+        return;
+    }
+
+    if (r->count == 0)
+    {
+        r->src_addr = rx->src_addr;
+        r->msg_id = msg_id;
+        r->count = cnt;
+        r->rcvd = 0;
+        r->len = 0;
+    }
+
+    memcpy(&r->data[offset], &rx->data[CHB_XPORT_FRAG_HDR_SZ], flen);
+    r->rcvd |= 1UL << idx;
+    r->last = now;
+    if (idx == cnt - 1)
+    {
+        r->len = offset + flen;
+    }
+
+    if (r->rcvd == CHB_XPORT_MASK(cnt))
+    {
+        // report first so the sender isn't held up by the callback
+        if (unicast)
+        {
+            chb_xport_send_status(r->src_addr, msg_id, r->rcvd);
+        }
+        d->src_addr = r->src_addr;
+        d->msg_id = msg_id;
+        d->count = cnt;
+        d->time = now;
+
+        stats.rx_msgs++;
+        if (rx_cb)
+        {
+            rx_cb(r->src_addr, r->data, r->len);
+        }
+        r->count = 0;
+    }
+    else if (req)
+    {
+        chb_xport_send_status(r->src_addr, msg_id, r->rcvd);
+    }
+}
+
+/**************************************************************************/
+/*!
+
+*/
+/**************************************************************************/
+static void chb_xport_rx_agg(chb_rx_frame_t *rx)
+{
+    U8 i = 1, len;
+
+    while (i < rx->len)
+    {
+        len = rx->data[i++];
+        if ((i + len) > rx->len)
+        {
+            break;
+        }
+
+        stats.rx_msgs++;
+        if (rx_cb)
+        {
+            rx_cb(rx->src_addr, &rx->data[i], len);
+        }
+        i += len;
+    }
+}
+
+/**************************************************************************/
+/*!
+    Records the fragments that the receiver reports as received, if
+    the status frame is for the message being sent
+*/
+/**************************************************************************/
+static void chb_xport_rx_status(chb_rx_frame_t *rx)
+{
+    if ((rx->len < 6) || !tx_waiting || (rx->src_addr != tx_addr) ||
+        (rx->data[1] != tx_msg_id))
+    {
+        return;
+    }
+
+    tx_status |= rx->data[2] | ((U32)rx->data[3] << 8) |
+                 ((U32)rx->data[4] << 16) | ((U32)rx->data[5] << 24);
+    tx_reported = true;
+}
+
+/**************************************************************************/
+/*!
+    Sets the function that receives complete messages
+*/
+/**************************************************************************/
+void chb_xport_init(chb_xport_rx_cb_t cb)
+{
+    U8 i;
+
+    memset(reasm, 0, sizeof(reasm));
+    memset(&stats, 0, sizeof(stats));
+    agg_len = 0;
+    for (i=0; i<CHB_XPORT_DONE_ENTRIES; i++)
+    {
+        done[i].src_addr = 0xFFFE;
+    }
+    rx_cb = cb;
+}
+
+/**************************************************************************/
+/*!
+    Sends the pending aggregate, if any
+*/
+/**************************************************************************/
+void chb_xport_flush()
+{
+    if (agg_len)
+    {
+        chb_write(agg_addr, agg_buf, agg_len);
+        stats.tx_frames++;
+        agg_len = 0;
+    }
+}
+
+/**************************************************************************/
+/*!
+    Sends a message of up to CHB_XPORT_MAX_MSG bytes.  Messages that
+    fit in a frame are queued for aggregation and the call returns
+    immediately.  Larger messages are sent before the call returns.
+    The return value is CHB_NO_ACK if fragments were still missing
+    after CHB_XPORT_RETRIES bursts.  Fragmented broadcasts are sent
+    once, without retransmission.
+*/
+/**************************************************************************/
+U8 chb_xport_send(U16 addr, U8 *data, U16 len)
+{
+    U8 cnt, i, last, flen, round;
+    U32 missing, start;
+
+    stats.tx_msgs++;
+
+    // small messages are aggregated, two bytes for the type and len
+    if (len <= (CHB_MAX_PAYLOAD - 2))
+    {
+        if (agg_len &&
+            ((agg_addr != addr) || ((agg_len + 1 + len) > CHB_MAX_PAYLOAD)))
+        {
+            chb_xport_flush();
+        }
+        if (!agg_len)
+        {
+            agg_buf[agg_len++] = CHB_XPORT_AGG;
+            agg_addr = addr;
+            agg_time = chb_xport_ms();
+        }
+        agg_buf[agg_len++] = len;
+        memcpy(&agg_buf[agg_len], data, len);
+        agg_len += len;
+        return CHB_SUCCESS;
+    }
+
+    // the receiver could never reassemble it
+    if (len > CHB_XPORT_MAX_MSG)
+    {
+        stats.tx_failed++;
+        return CHB_INVALID;
+    }
+
+    // keep messages in order
+    chb_xport_flush();
+
+    cnt = (len + CHB_XPORT_FRAG_DATA - 1) / CHB_XPORT_FRAG_DATA;
+    missing = CHB_XPORT_MASK(cnt);
+    tx_msg_id++;
+    tx_addr = addr;
+
+    for (round=0; missing && (round < CHB_XPORT_RETRIES); round++)
+    {
+        // the last fragment of the burst requests a status report
+        for (last=cnt-1; !(missing & (1UL << last)); last--);
+
+        tx_status = 0;
+        tx_reported = false;
+        for (i=0; i<=last; i++)
+        {
+            if (!(missing & (1UL << i)))
+            {
+                continue;
+            }
+
+            flen = (i == cnt - 1) ? len - i * CHB_XPORT_FRAG_DATA
+                                  : CHB_XPORT_FRAG_DATA;
+            tx_buf[0] = CHB_XPORT_FRAG;
+            tx_buf[1] = tx_msg_id;
+            tx_buf[2] = i | ((i == last) ? CHB_XPORT_FRAG_REQ : 0);
+            tx_buf[3] = cnt;
+            memcpy(&tx_buf[CHB_XPORT_FRAG_HDR_SZ],
+                   &data[i * CHB_XPORT_FRAG_DATA], flen);
+            chb_write(addr, tx_buf, CHB_XPORT_FRAG_HDR_SZ + flen);
+
+            stats.tx_frames++;
+            if (round)
+            {
+                stats.tx_retransmits++;
+            }
+        }
+
+        if (addr == 0xFFFF)
+        {
+            return CHB_SUCCESS;
+        }
+
+        // wait for the status report, handling other traffic meanwhile
+        tx_waiting = true;
+        start = chb_xport_ms();
+        while (!tx_reported && ((chb_xport_ms() - start) < CHB_XPORT_STATUS_TIMEOUT))
+        {
+            chb_xport_poll();
+        }
+        tx_waiting = false;
+
+        missing &= ~tx_status;
+    }
+
+    if (missing)
+    {
+        stats.tx_failed++;
+        return CHB_NO_ACK;
+    }
+    return CHB_SUCCESS;
+}
+
+/**************************************************************************/
+/*!
+    Processes received frames and the aggregation and reassembly timeouts
+*/
+/**************************************************************************/
+void chb_xport_poll()
+{
+    chb_rx_frame_t rx;
+    U32 now = chb_xport_ms();
+    U8 i;
+
+    while (chb_read_frame(&rx))
+    {
+        switch (rx.data[0])
+        {
+        case CHB_XPORT_AGG:
+            chb_xport_rx_agg(&rx);
+            break;
+        case CHB_XPORT_FRAG:
+            chb_xport_rx_frag(&rx, now);
+            break;
+        case CHB_XPORT_STATUS:
+            chb_xport_rx_status(&rx);
+            break;
+        default:
+            break;
+        }
+        chb_read_done();
+    }
+
+    if (agg_len && ((now - agg_time) >= CHB_XPORT_AGG_TIMEOUT))
+    {
+        chb_xport_flush();
+    }
+
+    for (i=0; i<CHB_XPORT_REASM_BUFS; i++)
+    {
+        if (reasm[i].count && ((now - reasm[i].last) >= CHB_XPORT_REASM_TIMEOUT))
+        {
+            reasm[i].count = 0;
+            stats.rx_timeouts++;
+        }
+    }
+}
+
+/**************************************************************************/
+/*!
+
+*/
+/**************************************************************************/
+chb_xport_stats_t *chb_xport_get_stats()
+{
+    return &stats;
+}
+
+#endif
@@ -0,0 +1,80 @@
+/**************************************************************************/
+/*!
+    @file     chb_xport.h
+    @date     19 October, 2026
+    @version  1.0
+
+    Message transport on top of the Chibi MAC.  Small messages to the
+    same node are aggregated into one frame, and messages larger than a
+    frame are fragmented and reassembled with selective retransmission.
+*/
+/**************************************************************************/
+#ifndef CHB_XPORT_H
+#define CHB_XPORT_H
+
+#include "types.h"
+#include "chb.h"
+
+// transport header types (first payload byte of every frame)
+#define CHB_XPORT_AGG           0x01    // [type] { [len] [data...] }*
+#define CHB_XPORT_FRAG          0x02    // [type] [msg id] [index | REQ] [count] [data...]
+#define CHB_XPORT_STATUS        0x03    // [type] [msg id] [32-bit bitmap of received fragments]
+
+#define CHB_XPORT_FRAG_HDR_SZ   4
+#define CHB_XPORT_FRAG_DATA     (CHB_MAX_PAYLOAD - CHB_XPORT_FRAG_HDR_SZ)
+#define CHB_XPORT_FRAG_REQ      0x80    // set in the index of the last fragment of a burst
+#define CHB_XPORT_MAX_FRAGS     32      // limited by the status bitmap
+
+// number and size of the reassembly buffers
+#ifndef CHB_XPORT_REASM_BUFS
+#define CHB_XPORT_REASM_BUFS    2
+#endif
+#ifndef CHB_XPORT_REASM_SIZE
+#define CHB_XPORT_REASM_SIZE    (4 * CHB_XPORT_FRAG_DATA)
+#endif
+#if (CHB_XPORT_REASM_SIZE > (CHB_XPORT_MAX_FRAGS * CHB_XPORT_FRAG_DATA))
+  #error "CHB_XPORT_REASM_SIZE is larger than CHB_XPORT_MAX_FRAGS fragments"
+#endif
+
+// largest message chb_xport_send() accepts, it must fit the receiver's
+// reassembly buffer
+#define CHB_XPORT_MAX_MSG       CHB_XPORT_REASM_SIZE
+
+// give up on partial messages after this long without a fragment (ms)
+#define CHB_XPORT_REASM_TIMEOUT 500
+
+// how long retransmissions of a delivered message are recognised (ms),
+// longer than a sender spends on its retries, and for how many senders
+#define CHB_XPORT_DONE_TIMEOUT  500
+#ifndef CHB_XPORT_DONE_ENTRIES
+#define CHB_XPORT_DONE_ENTRIES  4
+#endif
+
+// flush a partially filled aggregate after this long (ms)
+#define CHB_XPORT_AGG_TIMEOUT   10
+
+// how long to wait for a status report and how many bursts to send
+#define CHB_XPORT_STATUS_TIMEOUT 50
+#define CHB_XPORT_RETRIES       4
+
+// delivers a complete message, data is only valid during the call
+typedef void (*chb_xport_rx_cb_t)(U16 src_addr, U8 *data, U16 len);
+
+typedef struct
+{
+    U16 tx_msgs;
+    U16 tx_frames;
+    U16 tx_retransmits;
+    U16 tx_failed;
+    U16 rx_msgs;
+    U16 rx_dropped;         // no free reassembly buffer or message too big
+    U16 rx_timeouts;        // partial messages discarded
+} chb_xport_stats_t;
+
+void chb_xport_init(chb_xport_rx_cb_t cb);
+U8 chb_xport_send(U16 addr, U8 *data, U16 len);
+void chb_xport_flush();
+void chb_xport_poll();
+chb_xport_stats_t *chb_xport_get_stats();
+
+#endif
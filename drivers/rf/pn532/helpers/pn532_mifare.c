@@ -0,0 +1,111 @@
+/**************************************************************************/
+/*! 
+    @file     pn532_mifare.c
+*/
+/**************************************************************************/
+
+/*  The MIFARE READ command (0x30) returns 16 bytes on both Classic and
+    Ultralight cards: one block on Classic cards, or four consecutive
+    pages on Ultralight cards.  pn532_mifare_ReadChained queues several
+    READ commands at once, so the PN532 receives each command as soon
+    as the previous response has been read, instead of waiting for the
+    caller to process every response in turn.
+*/
+
+#include <string.h>
+
+#include "../pn532.h"
+#include "../pn532_bus.h"
+#include "pn532_mifare.h"
+
+/* State of the chained read in progress */
+static struct
+{
+  pn532_error_t error;
+  uint8_t       pending;
+} _mifareRead;
+
+/**************************************************************************/
+/*! 
+    Completion callback for each queued READ command.  pvContext points
+    to the 16 bytes in the caller's buffer for this command.
+*/
+/**************************************************************************/
+static void pn532_mifare_ReadDone(pn532_error_t error, const byte_t * pbtResponse, size_t szLen, void * pvContext)
+{
+  /* Valid response: 00 00 FF LEN LCS D5 41 [Status] [16 bytes] DCS 00 */
+  if (!error && ((szLen != 26) || (pbtResponse[7] != 0x00)))
+  {
+    error = PN532_ERROR_BLOCKREADFAILED;
+  }
+
+  if (!error)
+  {
+    memcpy(pvContext, pbtResponse + 8, 16);
+  }
+  else if (!_mifareRead.error)
+  {
+    _mifareRead.error = error;
+  }
+
+  _mifareRead.pending--;
+}
+
+/**************************************************************************/
+/*! 
+    Reads uiCount 16-byte chunks with back-to-back READ commands
+
+    @param  uiAddress   Block (Classic) or page (Ultralight) of the first
+                        READ command
+    @param  uiStep      Address increment between READ commands (1 for
+                        Classic blocks, 4 for Ultralight pages)
+    @param  uiCount     Number of READ commands
+    @param  pbtData     Buffer for uiCount * 16 bytes
+
+    @note   The reads still queued are cancelled after the first
+            failure, since the card drops its authentication state after
+            an error.  Can't be called from a pn532Submit callback.
+
+            Possible error messages are:
+
+            - PN532_ERROR_BLOCKREADFAILED
+*/
+/**************************************************************************/
+pn532_error_t pn532_mifare_ReadChained (uint8_t uiAddress, uint8_t uiStep, uint8_t uiCount, byte_t * pbtData)
+{
+  byte_t abtCommand[4];
+  uint8_t uiSent = 0;
+
+  _mifareRead.error = PN532_ERROR_NONE;
+  _mifareRead.pending = 0;
+
+  abtCommand[0] = PN532_COMMAND_INDATAEXCHANGE;
+  abtCommand[1] = 1;                            /* Card number */
+  abtCommand[2] = PN532_MIFARE_CMD_READ;        /* Mifare Read command = 0x30 */
+
+  while ((uiSent < uiCount && !_mifareRead.error) || _mifareRead.pending)
+  {
+    /* Keep the command queue topped up */
+    while (uiSent < uiCount && !_mifareRead.error)
+    {
+      abtCommand[3] = uiAddress + uiSent * uiStep;
+      if (pn532Submit(abtCommand, sizeof(abtCommand), PN532_TIMEOUT_DEFAULT,
+                      pn532_mifare_ReadDone, pbtData + uiSent * 16))
+      {
+        break;
+      }
+      _mifareRead.pending++;
+      uiSent++;
+    }
+    pn532Task();
+
+    /* Drop the reads that are still queued after a failure */
+    if (_mifareRead.error && _mifareRead.pending)
+    {
+      pn532Cancel(pn532_mifare_ReadDone);
+      _mifareRead.pending = 0;
+    }
+  }
+
+  return _mifareRead.error;
+}
@@ -8,6 +8,7 @@
 #define __PN532_MIFARE_H__
 
 #include "projectconfig.h"
+#include "../pn532.h"
 
 // These may need to be enlarged for multi card support
 #define PN532_RESPONSELEN_INLISTPASSIVETARGET (64)
@@ -26,4 +27,6 @@ typedef enum pn532_mifare_cmd_e
 } 
 pn532_mifare_cmd_t;
 
+pn532_error_t pn532_mifare_ReadChained (uint8_t uiAddress, uint8_t uiStep, uint8_t uiCount, byte_t * pbtData);
+
 #endif
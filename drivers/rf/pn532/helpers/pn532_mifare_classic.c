@@ -153,6 +153,21 @@
 
 #include "core/systick/systick.h"
 
+/* Sector authentication cache.  A MIFARE Classic card stays
+   authenticated for one sector until another sector is authenticated,
+   an operation fails or the card is selected again, so a block in the
+   sector that was authenticated last can be accessed without repeating
+   the three-pass authentication. */
+static struct
+{
+  bool    valid;
+  byte_t  abtUID[7];
+  size_t  szUIDLen;
+  uint8_t uiSector;
+  uint8_t uiKeyType;
+  byte_t  abtKey[6];
+} _mifareclassicAuth;
+
 /**************************************************************************/
 /*! 
       Indicates whether the specified block number is the first block
@@ -182,6 +197,57 @@ bool is_trailer_block (uint32_t uiBlock)
     return ((uiBlock + 1) % 16 == 0);
 }
 
+/**************************************************************************/
+/*! 
+      Returns the sector containing the specified block (0..31 are the
+      4 block sectors, 32..39 the 16 block sectors of 4K cards)
+*/
+/**************************************************************************/
+uint8_t pn532_mifareclassic_BlockSector (uint32_t uiBlock)
+{
+  if (uiBlock < 128)
+    return uiBlock / 4;
+  else
+    return 32 + (uiBlock - 128) / 16;
+}
+
+/**************************************************************************/
+/*! 
+      Returns the first block of the specified sector
+*/
+/**************************************************************************/
+uint32_t pn532_mifareclassic_SectorFirstBlock (uint8_t uiSector)
+{
+  if (uiSector < 32)
+    return uiSector * 4;
+  else
+    return 128 + (uiSector - 32) * 16;
+}
+
+/**************************************************************************/
+/*! 
+      Returns the number of blocks (including the trailer) in the
+      specified sector
+*/
+/**************************************************************************/
+uint8_t pn532_mifareclassic_SectorBlockCount (uint8_t uiSector)
+{
+  return (uiSector < 32) ? 4 : 16;
+}
+
+/**************************************************************************/
+/*! 
+    Forgets the authenticated sector.  Must be called whenever the card
+    may have been selected again behind the helpers' back, e.g. by an
+    InAutoPoll or InListPassiveTarget issued elsewhere, since the card
+    then drops its authentication.
+*/
+/**************************************************************************/
+void pn532_mifareclassic_InvalidateAuth (void)
+{
+  _mifareclassicAuth.valid = false;
+}
+
 /**************************************************************************/
 /*! 
     Tries to detect MIFARE targets in passive mode.  This needs to be done
@@ -230,16 +296,12 @@ pn532_error_t pn532_mifareclassic_WaitForPassiveTarget (byte_t * pbtCUID, size_t
   /* Note:  To wait for a card with a known UID, append the four byte     */
   /*        UID to the end of the command.                                */ 
   byte_t abtCommand[] = { PN532_COMMAND_INLISTPASSIVETARGET, 0x01, PN532_MODULATION_ISO14443A_106KBPS};
-  error = pn532Write(abtCommand, sizeof(abtCommand));
-  if (error) 
-    return error;
 
-  /* Wait until we get a valid response or a timeout                      */
-  do
-  {
-    systickDelay(25);
-    error = pn532Read(abtResponse, &szLen);
-  } while (error == PN532_ERROR_RESPONSEBUFFEREMPTY);
+  /* Selecting a card resets its authentication state                     */
+  _mifareclassicAuth.valid = false;
+
+  /* The PN532 only answers once a card enters the field, so no timeout  */
+  error = pn532Execute(abtCommand, sizeof(abtCommand), abtResponse, &szLen, 0);
   if (error) 
     return error;
 
@@ -309,6 +371,15 @@ pn532_error_t pn532_mifareclassic_WaitForPassiveTarget (byte_t * pbtCUID, size_t
                           (PN532_MIFARE_CMD_AUTH_A or PN532_MIFARE_CMD_AUTH_B)
     @param  pbtKeys       Pointer to a byte array containing the 6 byte
                           key value
+
+    @note   Nothing is sent to the card if the block's sector is still
+            authenticated with the same key.  Possible error messages
+            are:
+
+            - PN532_ERROR_INVALIDKEYTYPE (uiKeyType is neither
+              PN532_MIFARE_CMD_AUTH_A nor PN532_MIFARE_CMD_AUTH_B)
+            - PN532_ERROR_APPLEVELERROR (authentication failed, see
+              pn532GetPCB()->appError)
 */
 /**************************************************************************/
 pn532_error_t pn532_mifareclassic_AuthenticateBlock (byte_t * pbtCUID, size_t szCUIDLen, uint32_t uiBlockNumber, uint8_t uiKeyType, byte_t * pbtKeys)
@@ -318,6 +389,23 @@ pn532_error_t pn532_mifareclassic_AuthenticateBlock (byte_t * pbtCUID, size_t sz
   byte_t abtResponse[PN532_RESPONSELEN_INDATAEXCHANGE];
   size_t szLen;
 
+  if ((uiKeyType != PN532_MIFARE_CMD_AUTH_A) && (uiKeyType != PN532_MIFARE_CMD_AUTH_B))
+  {
+    return PN532_ERROR_INVALIDKEYTYPE;
+  }
+
+  /* Skip the authentication if the sector is already authenticated */
+  if (_mifareclassicAuth.valid &&
+      (_mifareclassicAuth.uiSector == pn532_mifareclassic_BlockSector(uiBlockNumber)) &&
+      (_mifareclassicAuth.uiKeyType == uiKeyType) &&
+      (_mifareclassicAuth.szUIDLen == szCUIDLen) &&
+      (0 == memcmp(_mifareclassicAuth.abtUID, pbtCUID, szCUIDLen)) &&
+      (0 == memcmp(_mifareclassicAuth.abtKey, pbtKeys, 6)))
+  {
+    return PN532_ERROR_NONE;
+  }
+  _mifareclassicAuth.valid = false;
+
   #ifdef PN532_DEBUGMODE
   PN532_DEBUG("Trying to authenticate card ");
   pn532PrintHex(pbtCUID, szCUIDLen);
@@ -326,7 +414,7 @@ pn532_error_t pn532_mifareclassic_AuthenticateBlock (byte_t * pbtCUID, size_t sz
   /* Prepare the authentication command */
   abtCommand[0] = PN532_COMMAND_INDATAEXCHANGE;   /* Data Exchange Header */
   abtCommand[1] = 1;                              /* Max card numbers */
-  abtCommand[2] = (uiKeyType) ? PN532_MIFARE_CMD_AUTH_A : PN532_MIFARE_CMD_AUTH_B;
+  abtCommand[2] = uiKeyType;
   abtCommand[3] = uiBlockNumber;                  /* Block Number (1K = 0..63, 4K = 0..255 */
   memcpy (abtCommand+4, pbtKeys, 6);
   uint8_t i;
@@ -335,34 +423,37 @@ pn532_error_t pn532_mifareclassic_AuthenticateBlock (byte_t * pbtCUID, size_t sz
     abtCommand[10+i] = pbtCUID[i];                /* 4 byte card ID */
   }
   
-  /* Send the command */
-  error = pn532Write(abtCommand, 10+szCUIDLen);
+  /* Send the command and wait for the response */
+  memset(abtResponse, 0, PN532_RESPONSELEN_INDATAEXCHANGE);
+  error = pn532Execute(abtCommand, 10+szCUIDLen, abtResponse, &szLen, PN532_TIMEOUT_DEFAULT);
   if (error)
   {
-    /* Problem with the serial bus, etc. */
     #ifdef PN532_DEBUGMODE
       PN532_DEBUG("Authentification failed%s", CFG_PRINTF_NEWLINE);
     #endif
     return error;
   }
 
-  /* Read the authentication response */
-  memset(abtResponse, 0, PN532_RESPONSELEN_INDATAEXCHANGE);
-  do
-  {
-    systickDelay(25);
-    error = pn532Read(abtResponse, &szLen);
-  }
-  while (error == PN532_ERROR_RESPONSEBUFFEREMPTY);
-  if (error)
+  /* The status byte following D5 41 is 0x00 if the card accepted the key */
+  if (abtResponse[7] != 0x00)
   {
+    pn532GetPCB()->appError = abtResponse[7] & 0x3F;
     #ifdef PN532_DEBUGMODE
-      PN532_DEBUG("Authentification failed%s", CFG_PRINTF_NEWLINE);
+      PN532_DEBUG("Authentification failed (0x%02x)%s", abtResponse[7], CFG_PRINTF_NEWLINE);
     #endif
-    return error;
+    return PN532_ERROR_APPLEVELERROR;
   }
 
-  // ToDo: How to check if authentification really worked (bad key, etc.)?
+  /* Remember the authenticated sector */
+  if (szCUIDLen <= sizeof(_mifareclassicAuth.abtUID))
+  {
+    memcpy(_mifareclassicAuth.abtUID, pbtCUID, szCUIDLen);
+    memcpy(_mifareclassicAuth.abtKey, pbtKeys, 6);
+    _mifareclassicAuth.szUIDLen = szCUIDLen;
+    _mifareclassicAuth.uiSector = pn532_mifareclassic_BlockSector(uiBlockNumber);
+    _mifareclassicAuth.uiKeyType = uiKeyType;
+    _mifareclassicAuth.valid = true;
+  }
 
   /* Output the authentification data */
   #ifdef PN532_DEBUGMODE
@@ -405,30 +496,15 @@ pn532_error_t pn532_mifareclassic_ReadDataBlock (uint8_t uiBlockNumber, byte_t *
   abtCommand[2] = PN532_MIFARE_CMD_READ;        /* Mifare Read command = 0x30 */
   abtCommand[3] = uiBlockNumber;                /* Block Number (0..63 for 1K, 0..255 for 4K) */
   
-  /* Send the commands */
-  error = pn532Write(abtCommand, sizeof(abtCommand));
-  if (error)
-  {
-    /* Bus error, etc. */
-    #ifdef PN532_DEBUGMODE
-      PN532_DEBUG("Read failed%s", CFG_PRINTF_NEWLINE);
-    #endif
-    return error;
-  }
-
-  /* Read the response */
+  /* Send the command and wait for the response */
   memset(abtResponse, 0, PN532_RESPONSELEN_INDATAEXCHANGE);
-  do
-  {
-    systickDelay(50);
-    error = pn532Read(abtResponse, &szLen);
-  }
-  while (error == PN532_ERROR_RESPONSEBUFFEREMPTY);
+  error = pn532Execute(abtCommand, sizeof(abtCommand), abtResponse, &szLen, PN532_TIMEOUT_DEFAULT);
   if (error)
   {
     #ifdef PN532_DEBUGMODE
       PN532_DEBUG("Read failed%s", CFG_PRINTF_NEWLINE);
     #endif
+    _mifareclassicAuth.valid = false;
     return error;
   }
 
@@ -441,6 +517,7 @@ pn532_error_t pn532_mifareclassic_ReadDataBlock (uint8_t uiBlockNumber, byte_t *
   }
   else
   {
+    _mifareclassicAuth.valid = false;
     #ifdef PN532_DEBUGMODE
       PN532_DEBUG("Unexpected response reading block %d.  Bad key?%s", uiBlockNumber, CFG_PRINTF_NEWLINE);
     #endif
@@ -456,3 +533,58 @@ pn532_error_t pn532_mifareclassic_ReadDataBlock (uint8_t uiBlockNumber, byte_t *
   // Return OK signal
   return PN532_ERROR_NONE;
 }
+
+/**************************************************************************/
+/*! 
+    Reads every block of a sector (trailer included), authenticating
+    the sector once and then queueing the block reads back to back.
+
+    @param  pbtCUID       Pointer to a byte array containing the card UID
+    @param  szCUIDLen     The length (in bytes) of the card's UID
+    @param  uiSector      The sector to read (0..15 for 1KB cards, and
+                          0..39 for 4KB cards)
+    @param  uiKeyType     Which key type to use during authentication
+                          (PN532_MIFARE_CMD_AUTH_A or PN532_MIFARE_CMD_AUTH_B)
+    @param  pbtKeys       Pointer to a byte array containing the 6 byte
+                          key value
+    @param  pbtData       Pointer to the byte array that will hold the
+                          sector data (16 bytes per block, see
+                          pn532_mifareclassic_SectorBlockCount)
+
+    @note   Possible error messages are:
+
+            - PN532_ERROR_ADDRESSOUTOFRANGE
+            - PN532_ERROR_INVALIDKEYTYPE
+            - PN532_ERROR_APPLEVELERROR (authentication failed)
+            - PN532_ERROR_BLOCKREADFAILED
+*/
+/**************************************************************************/
+pn532_error_t pn532_mifareclassic_ReadSector (byte_t * pbtCUID, size_t szCUIDLen, uint8_t uiSector, uint8_t uiKeyType, byte_t * pbtKeys, byte_t * pbtData)
+{
+  pn532_error_t error;
+  uint32_t uiFirstBlock;
+
+  if (uiSector >= 40)
+  {
+    return PN532_ERROR_ADDRESSOUTOFRANGE;
+  }
+
+  uiFirstBlock = pn532_mifareclassic_SectorFirstBlock(uiSector);
+  error = pn532_mifareclassic_AuthenticateBlock(pbtCUID, szCUIDLen, uiFirstBlock, uiKeyType, pbtKeys);
+  if (error)
+  {
+    return error;
+  }
+
+  error = pn532_mifare_ReadChained(uiFirstBlock, 1, pn532_mifareclassic_SectorBlockCount(uiSector), pbtData);
+  if (error)
+  {
+    #ifdef PN532_DEBUGMODE
+      PN532_DEBUG("Unable to read sector %d%s", uiSector, CFG_PRINTF_NEWLINE);
+    #endif
+    _mifareclassicAuth.valid = false;
+    return error;
+  }
+
+  return PN532_ERROR_NONE;
+}
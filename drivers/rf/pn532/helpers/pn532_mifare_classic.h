@@ -13,5 +13,10 @@
 pn532_error_t pn532_mifareclassic_WaitForPassiveTarget (byte_t * pbtCUID, size_t * szCUIDLen);
 pn532_error_t pn532_mifareclassic_AuthenticateBlock (byte_t * pbtCUID, size_t szCUIDLen, uint32_t uiBlockNumber, uint8_t uiKeyType, byte_t * pbtKeys);
 pn532_error_t pn532_mifareclassic_ReadDataBlock (uint8_t uiBlockNumber, byte_t * pbtData);
+pn532_error_t pn532_mifareclassic_ReadSector (byte_t * pbtCUID, size_t szCUIDLen, uint8_t uiSector, uint8_t uiKeyType, byte_t * pbtKeys, byte_t * pbtData);
+void          pn532_mifareclassic_InvalidateAuth (void);
+uint8_t       pn532_mifareclassic_BlockSector (uint32_t uiBlock);
+uint32_t      pn532_mifareclassic_SectorFirstBlock (uint8_t uiSector);
+uint8_t       pn532_mifareclassic_SectorBlockCount (uint8_t uiSector);
 
 #endif
@@ -134,16 +134,8 @@ pn532_error_t pn532_mifareultralight_WaitForPassiveTarget (byte_t * pbtCUID, siz
   /* Note:  To wait for a card with a known UID, append the four byte     */
   /*        UID to the end of the command.                                */ 
   byte_t abtCommand[] = { PN532_COMMAND_INLISTPASSIVETARGET, 0x01, PN532_MODULATION_ISO14443A_106KBPS};
-  error = pn532Write(abtCommand, sizeof(abtCommand));
-  if (error) 
-    return error;
-
-  /* Wait until we get a valid response or a timeout                      */
-  do
-  {
-    systickDelay(25);
-    error = pn532Read(abtResponse, &szLen);
-  } while (error == PN532_ERROR_RESPONSEBUFFEREMPTY);
+  /* The PN532 only answers once a card enters the field, so no timeout  */
+  error = pn532Execute(abtCommand, sizeof(abtCommand), abtResponse, &szLen, 0);
   if (error) 
     return error;
 
@@ -229,25 +221,9 @@ pn532_error_t pn532_mifareultralight_ReadPage (uint8_t page, byte_t * pbtBuffer)
   abtCommand[2] = PN532_MIFARE_CMD_READ;        /* Mifare Read command = 0x30 */
   abtCommand[3] = page;                         /* Page Number (0..63 in most cases) */
   
-  /* Send the commands */
-  error = pn532Write(abtCommand, sizeof(abtCommand));
-  if (error)
-  {
-    /* Bus error, etc. */
-    #ifdef PN532_DEBUGMODE
-      PN532_DEBUG("Read failed%s", CFG_PRINTF_NEWLINE);
-    #endif
-    return error;
-  }
-
-  /* Read the response */
+  /* Send the command and wait for the response */
   memset(abtResponse, 0, PN532_RESPONSELEN_INDATAEXCHANGE);
-  do
-  {
-    systickDelay(50);
-    error = pn532Read(abtResponse, &szLen);
-  }
-  while (error == PN532_ERROR_RESPONSEBUFFEREMPTY);
+  error = pn532Execute(abtCommand, sizeof(abtCommand), abtResponse, &szLen, PN532_TIMEOUT_DEFAULT);
   if (error)
   {
     #ifdef PN532_DEBUGMODE
@@ -284,3 +260,50 @@ pn532_error_t pn532_mifareultralight_ReadPage (uint8_t page, byte_t * pbtBuffer)
   return PN532_ERROR_NONE;
 }
 
+/**************************************************************************/
+/*! 
+    Reads several consecutive pages.  Each READ command returns four
+    pages, so the pages are read four at a time (with back-to-back
+    commands) rather than one page per command.
+
+    @param  page        The first page number (0..63 in most cases)
+    @param  count       The number of pages to read
+    @param  pbtBuffer   Pointer to the byte array that will hold the
+                        retrieved data (4 bytes per page, rounded up to
+                        a multiple of 16 bytes)
+
+    @note   Possible error messages are:
+
+            - PN532_ERROR_ADDRESSOUTOFRANGE
+            - PN532_ERROR_BLOCKREADFAILED
+*/
+/**************************************************************************/
+pn532_error_t pn532_mifareultralight_ReadPages (uint8_t page, uint8_t count, byte_t * pbtBuffer)
+{
+  pn532_error_t error;
+
+  if ((count == 0) || (page + count > 64))
+  {
+    return PN532_ERROR_ADDRESSOUTOFRANGE;
+  }
+
+  #ifdef PN532_DEBUGMODE
+    PN532_DEBUG("Reading pages %03d..%03d%s", page, page + count - 1, CFG_PRINTF_NEWLINE);
+  #endif
+
+  error = pn532_mifare_ReadChained(page, 4, (count + 3) / 4, pbtBuffer);
+  if (error)
+  {
+    #ifdef PN532_DEBUGMODE
+      PN532_DEBUG("Read failed%s", CFG_PRINTF_NEWLINE);
+    #endif
+    return error;
+  }
+
+  /* Display data for debug if requested */
+  #ifdef PN532_DEBUGMODE
+    pn532PrintHexChar(pbtBuffer, count * 4);
+  #endif
+
+  return PN532_ERROR_NONE;
+}
@@ -12,5 +12,6 @@
 
 pn532_error_t pn532_mifareultralight_WaitForPassiveTarget (byte_t * pbtCUID, size_t * szCUIDLen);
 pn532_error_t pn532_mifareultralight_ReadPage (uint8_t page, byte_t * pbtBuffer);
+pn532_error_t pn532_mifareultralight_ReadPages (uint8_t page, uint8_t count, byte_t * pbtBuffer);
 
 #endif
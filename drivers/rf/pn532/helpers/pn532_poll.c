@@ -0,0 +1,308 @@
+/**************************************************************************/
+/*! 
+    @file     pn532_poll.c
+*/
+/**************************************************************************/
+
+/*  CONTINUOUS POLLING
+    ==================
+
+    The poller keeps an InAutoPoll command in the PN532 command queue at
+    all times, so up to two targets of several types can be detected
+    without the host polling for every modulation in turn.  Every target
+    that is found is compared with the targets already in the field:
+
+    - A target that wasn't in the field before is reported with
+      PN532_POLL_EVENT_ARRIVE.
+    - A target that is still in the field isn't reported again, and its
+      logical target number (ucTg) is kept up to date, so the
+      application can keep talking to it (InDataExchange, etc.) without
+      selecting it again with InListPassiveTarget.
+    - A target that hasn't been seen for PN532_POLL_MISSES consecutive
+      polls is reported with PN532_POLL_EVENT_LEAVE.
+
+    While the field is empty, InAutoPoll is sent with PollNr =
+    PN532_POLL_IDLEROUNDS, so the PN532 does several rounds on its own
+    before it answers.  While targets are present a single polling round
+    is requested instead, so that departures (and a second card, when a
+    badge follows another one closely) are noticed quickly.  The poll is
+    never endless: the next one is queued behind whatever the
+    application has queued meanwhile, so pn532Execute/pn532Submit wait
+    at most for the poll in progress (PollNr x number of types x Period
+    x 150 ms).
+
+    Every InAutoPoll selects the targets again, which drops a MIFARE
+    Classic authentication, so the sector cache of the MIFARE Classic
+    helpers is invalidated whenever a poll completes.
+
+    pn532Task() must be called regularly to keep the poller running,
+    since it relies on the PN532 command engine.
+*/
+
+#include <string.h>
+
+#include "../pn532.h"
+#include "../pn532_bus.h"
+#include "pn532_poll.h"
+#include "pn532_mifare_classic.h"
+
+/* Default target types: ISO14443A (Mifare, etc.), FeliCa and ISO14443B */
+static const byte_t _pollDefaultTypes[] = { PN532_POLL_TYPE_MIFARE, PN532_POLL_TYPE_FELICA_212, PN532_POLL_TYPE_ISO14443_4B };
+
+static struct
+{
+  BOOL                    active;
+  byte_t                  abtCommand[3 + 15];   // InAutoPoll, PollNr, Period, Type1..Type15
+  size_t                  szCommand;
+  pn532_poll_callback_t   callback;
+  pn532_poll_target_t     targets[PN532_POLL_MAXTARGETS];
+} _poll;
+
+static void pn532_poll_Done(pn532_error_t error, const byte_t * pbtResponse, size_t szLen, void * pvContext);
+
+/**************************************************************************/
+/*! 
+    Extracts the UID from the target data returned by InAutoPoll
+
+    @returns  The UID length, or 0 if the target data is too short
+*/
+/**************************************************************************/
+static size_t pn532_poll_GetUID (uint8_t ucType, const byte_t * pbtData, size_t szData, byte_t * pbtUID)
+{
+  size_t szUID;
+
+  switch (ucType)
+  {
+    case PN532_POLL_TYPE_GENERIC_106A:
+    case PN532_POLL_TYPE_MIFARE:
+    case PN532_POLL_TYPE_ISO14443_4A:
+      /* Tg, SENS_RES (2), SEL_RES, NFCIDLength, NFCID1 [, ATS] */
+      if (szData < 5)
+        return 0;
+      szUID = pbtData[4];
+      if ((szUID > PN532_POLL_MAXUIDLEN) || (5 + szUID > szData))
+        return 0;
+      memcpy(pbtUID, pbtData + 5, szUID);
+      return szUID;
+    case PN532_POLL_TYPE_GENERIC_212:
+    case PN532_POLL_TYPE_GENERIC_424:
+    case PN532_POLL_TYPE_FELICA_212:
+    case PN532_POLL_TYPE_FELICA_424:
+      /* Tg, POL_RES length, 0x01, NFCID2 (8), Pad (8) [, SYST_CODE] */
+      if (szData < 11)
+        return 0;
+      memcpy(pbtUID, pbtData + 3, 8);
+      return 8;
+    case PN532_POLL_TYPE_ISO14443B:
+    case PN532_POLL_TYPE_ISO14443_4B:
+      /* Tg, ATQB (0x50, PUPI (4), ...), ATTRIB_RES length, ATTRIB_RES */
+      if (szData < 6)
+        return 0;
+      memcpy(pbtUID, pbtData + 2, 4);
+      return 4;
+    case PN532_POLL_TYPE_JEWEL:
+      /* Tg, SENS_RES (2), JEWELID (4) */
+      if (szData < 7)
+        return 0;
+      memcpy(pbtUID, pbtData + 3, 4);
+      return 4;
+    default:
+      return 0;
+  }
+}
+
+/**************************************************************************/
+/*! 
+    Queues the next InAutoPoll command
+*/
+/**************************************************************************/
+static void pn532_poll_Submit (void)
+{
+  uint8_t i;
+  BOOL occupied = FALSE;
+
+  for (i = 0; i < PN532_POLL_MAXTARGETS; i++)
+  {
+    if (_poll.targets[i].present)
+      occupied = TRUE;
+  }
+
+  /* Poll a few rounds when the field is empty, or once to check the
+     targets that are present */
+  _poll.abtCommand[1] = occupied ? 0x01 : PN532_POLL_IDLEROUNDS;
+  if (pn532Submit(_poll.abtCommand, _poll.szCommand, 0, pn532_poll_Done, 0))
+  {
+    #ifdef PN532_DEBUGMODE
+      PN532_DEBUG("Unable to queue InAutoPoll, polling stopped%s", CFG_PRINTF_NEWLINE);
+    #endif
+    _poll.active = FALSE;
+  }
+}
+
+/**************************************************************************/
+/*! 
+    Completion callback for InAutoPoll.  Updates the targets in the
+    field, reports arrivals and departures, and queues the next poll.
+*/
+/**************************************************************************/
+static void pn532_poll_Done (pn532_error_t error, const byte_t * pbtResponse, size_t szLen, void * pvContext)
+{
+  pn532_poll_target_t found[PN532_POLL_MAXTARGETS];
+  uint8_t nFound = 0;
+  uint8_t i, j;
+  size_t pos;
+
+  /* The targets have been selected again */
+  pn532_mifareclassic_InvalidateAuth();
+
+  if (!_poll.active)
+    return;
+
+  /* 00 00 FF LEN LCS D5 61 NbTg [Type Len TargetData]... DCS 00 */
+  if (szLen > PN532_RESPONSE_MAXLEN)
+    szLen = PN532_RESPONSE_MAXLEN;
+  if (!error && (szLen > 10))
+  {
+    pos = 8;
+    for (i = 0; (i < pbtResponse[7]) && (nFound < PN532_POLL_MAXTARGETS); i++)
+    {
+      if (pos + 2 + pbtResponse[pos + 1] > szLen - 2)
+        break;
+      found[nFound].ucType = pbtResponse[pos];
+      found[nFound].ucTg = pbtResponse[pos + 2];
+      found[nFound].szUIDLen = pn532_poll_GetUID(pbtResponse[pos], pbtResponse + pos + 2, pbtResponse[pos + 1], found[nFound].abtUID);
+      if (found[nFound].szUIDLen)
+        nFound++;
+      pos += 2 + pbtResponse[pos + 1];
+    }
+  }
+
+  /* Match the targets that were already in the field */
+  for (i = 0; i < PN532_POLL_MAXTARGETS; i++)
+  {
+    pn532_poll_target_t *target = &_poll.targets[i];
+    if (!target->present)
+      continue;
+
+    for (j = 0; j < nFound; j++)
+    {
+      if ((found[j].ucType == target->ucType) &&
+          (found[j].szUIDLen == target->szUIDLen) &&
+          (0 == memcmp(found[j].abtUID, target->abtUID, target->szUIDLen)))
+        break;
+    }
+
+    if (j < nFound)
+    {
+      /* Still there ... remove it from the list of new targets */
+      target->ucTg = found[j].ucTg;
+      target->ucMisses = 0;
+      found[j] = found[--nFound];
+    }
+    else if (++target->ucMisses >= PN532_POLL_MISSES)
+    {
+      target->present = FALSE;
+      if (_poll.callback)
+        _poll.callback(PN532_POLL_EVENT_LEAVE, target);
+    }
+  }
+
+  /* Anything left is a new arrival */
+  for (j = 0; j < nFound; j++)
+  {
+    for (i = 0; i < PN532_POLL_MAXTARGETS; i++)
+    {
+      if (!_poll.targets[i].present)
+        break;
+    }
+    if (i == PN532_POLL_MAXTARGETS)
+      break;
+
+    _poll.targets[i] = found[j];
+    _poll.targets[i].present = TRUE;
+    _poll.targets[i].ucMisses = 0;
+    if (_poll.callback)
+      _poll.callback(PN532_POLL_EVENT_ARRIVE, &_poll.targets[i]);
+  }
+
+  /* The callbacks may have stopped the poller */
+  if (_poll.active)
+    pn532_poll_Submit();
+}
+
+/**************************************************************************/
+/*! 
+    Starts polling for targets in the background
+
+    @param  abtTypes    Target types to poll for, in order of preference
+                        (see pn532_poll_type_t), or 0 for ISO14443A,
+                        FeliCa 212 kbps and ISO14443-4B
+    @param  szTypes     Number of target types (1..15)
+    @param  ucPeriod    Polling period in units of 150 ms (1..15)
+    @param  callback    Called from pn532Task() when a target arrives or
+                        leaves.  It can queue commands for the target
+                        with pn532Submit (ucTg is the target number for
+                        InDataExchange), leaving at least one queue slot
+                        free for the next poll.
+
+    @note   Possible error messages are:
+
+            - PN532_ERROR_ADDRESSOUTOFRANGE (invalid types or period)
+            - PN532_ERROR_QUEUEFULL
+*/
+/**************************************************************************/
+pn532_error_t pn532_poll_Start (const byte_t * abtTypes, size_t szTypes, uint8_t ucPeriod, pn532_poll_callback_t callback)
+{
+  if (!abtTypes)
+  {
+    abtTypes = _pollDefaultTypes;
+    szTypes = sizeof(_pollDefaultTypes);
+  }
+  if ((szTypes == 0) || (szTypes > 15) || (ucPeriod == 0) || (ucPeriod > 15))
+  {
+    return PN532_ERROR_ADDRESSOUTOFRANGE;
+  }
+
+  pn532_poll_Stop();
+  memset(_poll.targets, 0, sizeof(_poll.targets));
+
+  _poll.abtCommand[0] = PN532_COMMAND_INAUTOPOLL;
+  _poll.abtCommand[2] = ucPeriod;
+  memcpy(_poll.abtCommand + 3, abtTypes, szTypes);
+  _poll.szCommand = 3 + szTypes;
+  _poll.callback = callback;
+  _poll.active = TRUE;
+
+  pn532_poll_Submit();
+  return _poll.active ? PN532_ERROR_NONE : PN532_ERROR_QUEUEFULL;
+}
+
+/**************************************************************************/
+/*! 
+    Stops polling.  The queued poll is removed (or aborted if the PN532
+    is already processing it), and the targets are forgotten without
+    LEAVE events.
+*/
+/**************************************************************************/
+void pn532_poll_Stop (void)
+{
+  _poll.active = FALSE;
+  pn532Cancel(pn532_poll_Done);
+
+  /* An aborted poll may have selected the targets already */
+  pn532_mifareclassic_InvalidateAuth();
+}
+
+/**************************************************************************/
+/*! 
+    Returns one of the target slots (0..PN532_POLL_MAXTARGETS-1), or 0
+    for an invalid index.  Check 'present' to see if the slot is in use.
+*/
+/**************************************************************************/
+const pn532_poll_target_t * pn532_poll_GetTarget (uint8_t index)
+{
+  if (index >= PN532_POLL_MAXTARGETS)
+    return 0;
+
+  return &_poll.targets[index];
+}
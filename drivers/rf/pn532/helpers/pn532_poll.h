@@ -0,0 +1,56 @@
+/**************************************************************************/
+/*! 
+    @file     pn532_poll.h
+*/
+/**************************************************************************/
+
+#ifndef __PN532_POLL_H__
+#define __PN532_POLL_H__
+
+#include "projectconfig.h"
+#include "../pn532.h"
+
+#define PN532_POLL_MAXTARGETS     (2)     // InAutoPoll reports at most two targets
+#define PN532_POLL_MAXUIDLEN      (10)    // Longest ISO14443A UID (triple size)
+#define PN532_POLL_MISSES         (2)     // Polls a target can miss before it is reported as gone
+#define PN532_POLL_IDLEROUNDS     (2)     // InAutoPoll rounds (PollNr) while the field is empty
+
+/* Target types for InAutoPoll (see UM0701-02 section 7.3.13) */
+typedef enum pn532_poll_type_e
+{
+  PN532_POLL_TYPE_GENERIC_106A  = 0x00,   // Generic passive 106 kbps (ISO14443-4A, Mifare and DEP)
+  PN532_POLL_TYPE_GENERIC_212   = 0x01,   // Generic passive 212 kbps (FeliCa and DEP)
+  PN532_POLL_TYPE_GENERIC_424   = 0x02,   // Generic passive 424 kbps (FeliCa and DEP)
+  PN532_POLL_TYPE_ISO14443B     = 0x03,   // Passive 106 kbps ISO14443B
+  PN532_POLL_TYPE_JEWEL         = 0x04,   // Innovision Jewel tag
+  PN532_POLL_TYPE_MIFARE        = 0x10,   // Mifare card
+  PN532_POLL_TYPE_FELICA_212    = 0x11,   // FeliCa 212 kbps card
+  PN532_POLL_TYPE_FELICA_424    = 0x12,   // FeliCa 424 kbps card
+  PN532_POLL_TYPE_ISO14443_4A   = 0x20,   // Passive 106 kbps ISO14443-4A
+  PN532_POLL_TYPE_ISO14443_4B   = 0x23    // Passive 106 kbps ISO14443-4B
+} pn532_poll_type_t;
+
+typedef enum pn532_poll_event_e
+{
+  PN532_POLL_EVENT_ARRIVE,                // A new target entered the field
+  PN532_POLL_EVENT_LEAVE                  // A target hasn't been seen for PN532_POLL_MISSES polls
+} pn532_poll_event_t;
+
+/* A target tracked by the poller */
+typedef struct
+{
+  BOOL      present;
+  uint8_t   ucType;                       // pn532_poll_type_t reported by InAutoPoll
+  uint8_t   ucTg;                         // Logical target number for InDataExchange, etc.
+  byte_t    abtUID[PN532_POLL_MAXUIDLEN]; // NFCID1 (type A), PUPI (type B), NFCID2 (FeliCa) or Jewel ID
+  size_t    szUIDLen;
+  uint8_t   ucMisses;
+} pn532_poll_target_t;
+
+typedef void (*pn532_poll_callback_t)(pn532_poll_event_t event, const pn532_poll_target_t * pTarget);
+
+pn532_error_t pn532_poll_Start (const byte_t * abtTypes, size_t szTypes, uint8_t ucPeriod, pn532_poll_callback_t callback);
+void          pn532_poll_Stop (void);
+const pn532_poll_target_t * pn532_poll_GetTarget (uint8_t index);
+
+#endif
@@ -12,6 +12,46 @@
 
 static pn532_pcb_t pcb;
 
+/* Command engine states */
+typedef enum pn532_engine_state_e
+{
+  PN532_ENGINE_IDLE,
+  PN532_ENGINE_WAITACK,
+  PN532_ENGINE_WAITRESPONSE
+}
+pn532_engine_state_t;
+
+/* A queued command */
+typedef struct
+{
+  byte_t              abtCommand[PN532_QUEUE_CMDLEN];
+  size_t              szCommand;
+  uint32_t            uiTimeout;
+  pn532_callback_t    callback;
+  void *              pvContext;
+} pn532_cmd_t;
+
+/* Command queue and the state of the command at its head */
+static struct
+{
+  pn532_cmd_t           queue[PN532_QUEUE_SIZE];
+  uint8_t               head;
+  uint8_t               count;
+  pn532_engine_state_t  state;
+  uint32_t              started;
+  BOOL                  running;
+  byte_t                abtResponse[PN532_RESPONSE_MAXLEN];
+} engine;
+
+/* Completion record used by pn532Execute */
+typedef struct
+{
+  volatile BOOL       done;
+  pn532_error_t       error;
+  byte_t *            pbtResponse;
+  size_t *            pszLen;
+} pn532_result_t;
+
 /**************************************************************************/
 /*! 
     @brief  Prints a hexadecimal value in plain characters
@@ -76,14 +116,37 @@ pn532_pcb_t * pn532GetPCB()
 /**************************************************************************/
 void pn532Init(void)
 {
+  pt_t pt;
+
+  PT_RUN(&pt, pn532InitPT(&pt));
+}
+
+/**************************************************************************/
+/*! 
+    @brief      Same as pn532Init, but returns instead of blocking while
+                the PN532 resets, so other devices can be serviced in
+                the meantime.  pn532Submit and pn532Execute can be used
+                once PT_SCHEDULE returns false.
+
+    @note       This is a protothread (see core/pt/pt.h)
+*/
+/**************************************************************************/
+PT_THREAD(pn532InitPT(pt_t *pt))
+{
+  static pt_t hwInitPT;
+
+  PT_BEGIN(pt);
+
   // Clear protocol control blocks
   memset(&pcb, 0, sizeof(pn532_pcb_t));
 
   // Initialise the underlying HW
-  pn532_bus_HWInit();
+  PT_SPAWN(pt, &hwInitPT, pn532_bus_HWInitPT(&hwInitPT));
 
   // Set the PCB flags to an appropriate state
   pcb.initialised = TRUE;
+
+  PT_END(pt);
 }
 
 /**************************************************************************/
@@ -100,6 +163,10 @@ pn532_error_t pn532Read(byte_t * pbtResponse, size_t * pszLen)
 {
   if (!pcb.initialised) pn532Init();  
 
+  // The command engine owns the bus while it has queued commands
+  if (engine.count)
+    return PN532_ERROR_BUSY;
+
   // Try to wake the device up if it's in sleep mode
   if (pcb.state == PN532_STATE_SLEEP)
   {
@@ -140,6 +207,10 @@ pn532_error_t pn532Write(byte_t * abtCommand, size_t szLen)
 {
   if (!pcb.initialised) pn532Init();
 
+  // The command engine owns the bus while it has queued commands
+  if (engine.count)
+    return PN532_ERROR_BUSY;
+
   // Try to wake the device up if it's in sleep mode
   if (pcb.state == PN532_STATE_SLEEP)
   {
@@ -161,3 +232,296 @@ pn532_error_t pn532Write(byte_t * abtCommand, size_t szLen)
     return PN532_ERROR_UNABLETOINIT;
   }
 }
+
+/**************************************************************************/
+/*! 
+    @brief      Removes the command at the head of the queue and reports
+                the result to its callback
+
+    The slot is released before the callback runs, so the callback is
+    free to queue a follow-up command.
+*/
+/**************************************************************************/
+static void pn532Complete(pn532_error_t error, const byte_t * pbtResponse, size_t szLen)
+{
+  pn532_cmd_t *cmd = &engine.queue[engine.head];
+  pn532_callback_t callback = cmd->callback;
+  void *pvContext = cmd->pvContext;
+
+  engine.head = (engine.head + 1) % PN532_QUEUE_SIZE;
+  engine.count--;
+  engine.state = PN532_ENGINE_IDLE;
+
+  if (callback)
+  {
+    callback(error, pbtResponse, szLen, pvContext);
+  }
+}
+
+/**************************************************************************/
+/*! 
+    @brief      Queues a command for the PN532 and returns immediately
+
+    The command is sent once every command queued before it has
+    completed.  pn532Task() must be called regularly (from the main loop,
+    for example) to move the queue forward, and the callback is invoked
+    from pn532Task() with the response frame or an error.
+
+    @param      abtCommand
+                The command byte followed by any parameters.  The data
+                is copied, so the array can be reused straight away.
+    @param      szLen
+                The number of bytes in abtCommand
+    @param      uiTimeout
+                Ticks to wait for the response after the PN532 has
+                acknowledged the command, or 0 to wait forever (useful
+                with PN532_COMMAND_INLISTPASSIVETARGET, which only
+                answers once a card enters the field)
+    @param      callback
+                Function called when the command completes (can be 0)
+    @param      pvContext
+                Passed unchanged to the callback
+
+    @note   Possible error messages are:
+
+            - PN532_ERROR_QUEUEFULL
+            - PN532_ERROR_COMMANDTOOLONG
+*/
+/**************************************************************************/
+pn532_error_t pn532Submit(const byte_t * abtCommand, size_t szLen, uint32_t uiTimeout, pn532_callback_t callback, void * pvContext)
+{
+  pn532_cmd_t *cmd;
+
+  if (szLen > PN532_QUEUE_CMDLEN)
+    return PN532_ERROR_COMMANDTOOLONG;
+  if (engine.count == PN532_QUEUE_SIZE)
+    return PN532_ERROR_QUEUEFULL;
+
+  cmd = &engine.queue[(engine.head + engine.count) % PN532_QUEUE_SIZE];
+  memcpy(cmd->abtCommand, abtCommand, szLen);
+  cmd->szCommand = szLen;
+  cmd->uiTimeout = uiTimeout;
+  cmd->callback = callback;
+  cmd->pvContext = pvContext;
+  engine.count++;
+
+  return PN532_ERROR_NONE;
+}
+
+/**************************************************************************/
+/*! 
+    @brief      Moves the command queue forward
+
+    Sends the next queued command when the bus is idle, and otherwise
+    checks whether the PN532 has signalled that its ACK or response
+    frame is ready (via the IRQ line on I2C, or the RX FIFO on UART).
+    Nothing blocks while the PN532 is processing a command, so this can
+    be called as often as needed.
+*/
+/**************************************************************************/
+void pn532Task(void)
+{
+  pn532_cmd_t *cmd;
+  pn532_error_t error;
+  size_t szLen;
+
+  // Don't re-enter from a completion callback
+  if (engine.running)
+    return;
+  engine.running = TRUE;
+
+  cmd = &engine.queue[engine.head];
+  switch (engine.state)
+  {
+    case PN532_ENGINE_IDLE:
+      if (!engine.count)
+        break;
+
+      if (!pcb.initialised) pn532Init();
+      if (pcb.state == PN532_STATE_SLEEP)
+      {
+        error = pn532_bus_Wakeup();
+        if (error)
+        {
+          pn532Complete(error, 0, 0);
+          break;
+        }
+      }
+
+      pcb.lastCommand = cmd->abtCommand[0];
+      error = pn532_bus_WriteCommand(cmd->abtCommand, cmd->szCommand);
+      if (error)
+      {
+        pn532Complete(error, 0, 0);
+        break;
+      }
+      engine.started = systickGetTicks();
+      engine.state = PN532_ENGINE_WAITACK;
+      break;
+
+    case PN532_ENGINE_WAITACK:
+      if (pn532_bus_IsReady())
+      {
+        error = pn532_bus_ReadAck();
+        if (error)
+        {
+          pn532Complete(error, 0, 0);
+          break;
+        }
+        engine.started = systickGetTicks();
+        engine.state = PN532_ENGINE_WAITRESPONSE;
+      }
+      else if (systickGetTicks() - engine.started > PN532_ACK_TIMEOUT)
+      {
+        #ifdef PN532_DEBUGMODE
+        PN532_DEBUG("Timed out waiting for ACK%s", CFG_PRINTF_NEWLINE);
+        #endif
+        pn532Complete(PN532_ERROR_NOACK, 0, 0);
+      }
+      break;
+
+    case PN532_ENGINE_WAITRESPONSE:
+      if (pn532_bus_IsReady())
+      {
+        error = pn532_bus_ReadResponse(engine.abtResponse, &szLen);
+        // szLen comes from the frame's LEN byte and can be larger than
+        // what was actually read, so callbacks only see the buffer
+        if (szLen > PN532_RESPONSE_MAXLEN)
+          szLen = PN532_RESPONSE_MAXLEN;
+        pn532Complete(error, engine.abtResponse, szLen);
+      }
+      else if (cmd->uiTimeout && (systickGetTicks() - engine.started > cmd->uiTimeout))
+      {
+        // Sending an ACK frame makes the PN532 drop the current command
+        pn532_bus_Abort();
+        #ifdef PN532_DEBUGMODE
+        PN532_DEBUG("Timed out waiting for response%s", CFG_PRINTF_NEWLINE);
+        #endif
+        if ((cmd->abtCommand[0] == PN532_COMMAND_INLISTPASSIVETARGET) ||
+            (cmd->abtCommand[0] == PN532_COMMAND_INAUTOPOLL))
+        {
+          pn532Complete(PN532_ERROR_TIMEOUTWAITINGFORCARD, 0, 0);
+        }
+        else
+        {
+          pn532Complete(PN532_ERROR_READYSTATUSTIMEOUT, 0, 0);
+        }
+      }
+      break;
+  }
+
+  engine.running = FALSE;
+}
+
+/**************************************************************************/
+/*! 
+    @brief      Indicates whether the command queue is empty and no
+                command is in flight
+*/
+/**************************************************************************/
+BOOL pn532IsIdle(void)
+{
+  return (engine.count == 0) ? TRUE : FALSE;
+}
+
+/**************************************************************************/
+/*! 
+    @brief      Removes every queued command that uses the specified
+                callback.  If one of them is already being processed by
+                the PN532 it is aborted.  The callback isn't called for
+                the removed commands.
+*/
+/**************************************************************************/
+void pn532Cancel(pn532_callback_t callback)
+{
+  uint8_t i, n = engine.count;
+  pn532_cmd_t *cmd;
+
+  engine.count = 0;
+  for (i = 0; i < n; i++)
+  {
+    cmd = &engine.queue[(engine.head + i) % PN532_QUEUE_SIZE];
+    if (cmd->callback == callback)
+    {
+      // The command at the head may already be with the PN532
+      if ((i == 0) && (engine.state != PN532_ENGINE_IDLE))
+      {
+        pn532_bus_Abort();
+        engine.state = PN532_ENGINE_IDLE;
+      }
+      continue;
+    }
+
+    // Close the gap left by the removed commands
+    if (engine.count != i)
+    {
+      engine.queue[(engine.head + engine.count) % PN532_QUEUE_SIZE] = *cmd;
+    }
+    engine.count++;
+  }
+}
+
+/**************************************************************************/
+/*! 
+    @brief      Completion callback for pn532Execute
+*/
+/**************************************************************************/
+static void pn532ExecuteDone(pn532_error_t error, const byte_t * pbtResponse, size_t szLen, void * pvContext)
+{
+  pn532_result_t *result = (pn532_result_t *)pvContext;
+
+  if (pbtResponse)
+  {
+    memcpy(result->pbtResponse, pbtResponse, szLen);
+  }
+  *result->pszLen = pbtResponse ? szLen : 0;
+  result->error = error;
+  result->done = TRUE;
+}
+
+/**************************************************************************/
+/*! 
+    @brief      Queues a command and waits for its response
+
+    This is the blocking counterpart of pn532Submit, used by the MIFARE
+    helpers.  The queue is serviced continuously while waiting, so the
+    response is picked up as soon as the PN532 signals that it is ready.
+
+    @param      abtCommand
+                The command byte followed by any parameters
+    @param      szLen
+                The number of bytes in abtCommand
+    @param      pbtResponse
+                Buffer for the response frame (PN532_RESPONSE_MAXLEN
+                bytes, same layout as pn532Read)
+    @param      pszLen
+                Pointer to the number of bytes in the response
+    @param      uiTimeout
+                Ticks to wait for the response, or 0 to wait forever
+
+    @note   Can't be called from a pn532Submit callback (returns
+            PN532_ERROR_BUSY)
+*/
+/**************************************************************************/
+pn532_error_t pn532Execute(const byte_t * abtCommand, size_t szLen, byte_t * pbtResponse, size_t * pszLen, uint32_t uiTimeout)
+{
+  pn532_result_t result;
+  pn532_error_t error;
+
+  if (engine.running)
+    return PN532_ERROR_BUSY;
+
+  result.done = FALSE;
+  result.pbtResponse = pbtResponse;
+  result.pszLen = pszLen;
+  error = pn532Submit(abtCommand, szLen, uiTimeout, pn532ExecuteDone, &result);
+  if (error)
+    return error;
+
+  while (!result.done)
+  {
+    pn532Task();
+  }
+
+  return result.error;
+}
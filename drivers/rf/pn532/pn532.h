@@ -8,11 +8,19 @@
 #define __PN532_H__
 
 #include "projectconfig.h"
+#include "core/pt/pt.h"
 
 // Comment out this line to disable debug output
 // #define PN532_DEBUGMODE
 #define PN532_DEBUG(fmt, args...)             printf(fmt, ##args) 
 
+/* Command engine settings */
+#define PN532_QUEUE_SIZE                      (4)     // Number of commands that can be queued
+#define PN532_QUEUE_CMDLEN                    (32)    // Max command length (incl. command byte) that can be queued
+#define PN532_RESPONSE_MAXLEN                 (64)    // Response buffer size, must be >= I2C_BUFSIZE-1
+#define PN532_ACK_TIMEOUT                     (50)    // Max ticks between sending a command and its ACK frame
+#define PN532_TIMEOUT_DEFAULT                 (1000)  // Response timeout in ticks used by the helpers
+
 /* Error messages generated by the stack */
 /* Not to be confused with app level errors from the PN532 */
 /* These are the errors that are returned by the PN532 driver */
@@ -33,7 +41,10 @@ typedef enum pn532_error_e
   PN532_ERROR_BLOCKREADFAILED         = 0x0C,   // Unexpected response to block read request
   PN532_ERROR_WRONGCARDTYPE           = 0x0D,   // Card is not the expected format (based on SENS_RES/ATQA value)
   PN532_ERROR_ADDRESSOUTOFRANGE       = 0x0E,   // Specified block and page is out of range
-  PN532_ERROR_I2C_NACK                = 0x0F    // I2C Bus - No ACK was received for master to slave data transfer
+  PN532_ERROR_I2C_NACK                = 0x0F,   // I2C Bus - No ACK was received for master to slave data transfer
+  PN532_ERROR_QUEUEFULL               = 0x10,   // No free slot in the command queue
+  PN532_ERROR_COMMANDTOOLONG          = 0x11,   // Command doesn't fit in a command queue slot
+  PN532_ERROR_INVALIDKEYTYPE          = 0x12    // MIFARE key type is not PN532_MIFARE_CMD_AUTH_A or _B
 } pn532_error_t;
 
 typedef enum pn532_modulation_e
@@ -134,11 +145,23 @@ typedef struct
   uint32_t            appError;
 } pn532_pcb_t;
 
+/* Completion callback for queued commands.  pbtResponse holds the raw
+   response frame (same layout as pn532Read), at most
+   PN532_RESPONSE_MAXLEN bytes, and is only valid until the callback
+   returns. */
+typedef void (*pn532_callback_t)(pn532_error_t error, const byte_t * pbtResponse, size_t szLen, void * pvContext);
+
 void          pn532PrintHex(const byte_t * pbtData, const size_t szBytes);
 void          pn532PrintHexChar(const byte_t * pbtData, const size_t szBytes);
 pn532_pcb_t * pn532GetPCB();
 void          pn532Init();
+PT_THREAD(    pn532InitPT(pt_t *pt));
 pn532_error_t pn532Read(byte_t *pbtResponse, size_t * pszLen);
 pn532_error_t pn532Write(byte_t *abtCommand, size_t szLen);
+pn532_error_t pn532Submit(const byte_t * abtCommand, size_t szLen, uint32_t uiTimeout, pn532_callback_t callback, void * pvContext);
+pn532_error_t pn532Execute(const byte_t * abtCommand, size_t szLen, byte_t * pbtResponse, size_t * pszLen, uint32_t uiTimeout);
+void          pn532Task(void);
+BOOL          pn532IsIdle(void);
+void          pn532Cancel(pn532_callback_t callback);
 
 #endif
@@ -9,6 +9,7 @@
 
 #include "projectconfig.h"
 #include "pn532.h"
+#include "core/pt/pt.h"
 
 // #define PN532_BUS_UART
 #define PN532_BUS_I2C
@@ -32,8 +33,16 @@
 
 // Generic interface for the different serial buses available on the PN532
 void          pn532_bus_HWInit(void);
+PT_THREAD(    pn532_bus_HWInitPT(pt_t *pt));
 pn532_error_t pn532_bus_SendCommand(const byte_t * pbtData, const size_t szData);
 pn532_error_t pn532_bus_ReadResponse(byte_t * pbtResponse, size_t * pszRxLen);
 pn532_error_t pn532_bus_Wakeup(void);
 
+// Non-blocking steps used by the command engine in pn532.c
+pn532_error_t pn532_bus_WriteCommand(const byte_t * pbtData, const size_t szData);
+BOOL          pn532_bus_IsReady(void);
+pn532_error_t pn532_bus_ReadAck(void);
+void          pn532_bus_Abort(void);
+void          pn532_bus_IRQHandler(void);
+
 #endif
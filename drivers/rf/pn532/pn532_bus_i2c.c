@@ -48,6 +48,11 @@ extern volatile uint8_t   I2CMasterBuffer[I2C_BUFSIZE];
 extern volatile uint8_t   I2CSlaveBuffer[I2C_BUFSIZE];
 extern volatile uint32_t  I2CReadLength, I2CWriteLength;
 
+#ifdef GPIO_ENABLE_IRQ3
+// Set by pn532_bus_IRQHandler on the falling edge of the IRQ line
+static volatile bool _pn532_bus_i2c_irqPending = false;
+#endif
+
 /* ======================================================================
    PRIVATE FUNCTIONS                                                      
    ====================================================================== */
@@ -186,11 +191,17 @@ pn532_error_t pn532_bus_i2c_BuildFrame(byte_t * pbtFrame, size_t * pszFrame, con
 
 /**************************************************************************/
 /*! 
-    @brief  Initialises I2C and configures the PN532 HW
+    @brief  Initialises I2C and configures the PN532 HW, without blocking
+            while the PN532 is held in reset and boots (500ms)
+
+    @note   This is a protothread (see core/pt/pt.h): call it until
+            PT_SCHEDULE returns false.
 */
 /**************************************************************************/
-void pn532_bus_HWInit(void)
+PT_THREAD(pn532_bus_HWInitPT(pt_t *pt))
 {
+  PT_BEGIN(pt);
+
   #ifdef PN532_DEBUGMODE
   PN532_DEBUG("Initialising I2C %s", CFG_PRINTF_NEWLINE);
   #endif
@@ -199,17 +210,41 @@ void pn532_bus_HWInit(void)
   // Set IRQ pin to input
   gpioSetDir(PN532_I2C_IRQPORT, PN532_I2C_IRQPIN, gpioDirection_Input);
 
+  // Interrupt on the falling edge of IRQ (frame ready)
+  #ifdef GPIO_ENABLE_IRQ3
+  gpioSetInterrupt(PN532_I2C_IRQPORT,
+                   PN532_I2C_IRQPIN,
+                   gpioInterruptSense_Edge,
+                   gpioInterruptEdge_Single,
+                   gpioInterruptEvent_ActiveLow);
+  gpioIntEnable(PN532_I2C_IRQPORT, PN532_I2C_IRQPIN);
+  #endif
+
   // Set reset pin as output and reset device
   gpioSetDir(PN532_RSTPD_PORT, PN532_RSTPD_PIN, gpioDirection_Output);
   #ifdef PN532_DEBUGMODE
   PN532_DEBUG("Resetting the PN532...\r\n");
   #endif
   gpioSetValue(PN532_RSTPD_PORT, PN532_RSTPD_PIN, 0);
-  systickDelay(400);
+  PT_DELAY_MS(pt, 400);
   gpioSetValue(PN532_RSTPD_PORT, PN532_RSTPD_PIN, 1);
 
   // Wait for the PN532 to finish booting
-  systickDelay(100);
+  PT_DELAY_MS(pt, 100);
+
+  PT_END(pt);
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Initialises I2C and configures the PN532 HW
+*/
+/**************************************************************************/
+void pn532_bus_HWInit(void)
+{
+  pt_t pt;
+
+  PT_RUN(&pt, pn532_bus_HWInitPT(&pt));
 }
 
 /**************************************************************************/
@@ -230,6 +265,68 @@ void pn532_bus_HWInit(void)
 */
 /**************************************************************************/
 pn532_error_t pn532_bus_SendCommand(const byte_t * pbtData, const size_t szData)
+{
+  pn532_error_t error = PN532_ERROR_NONE;
+  pn532_pcb_t *pn532 = pn532GetPCB();
+
+  // Keep track of the last command that was sent
+  pn532->lastCommand = pbtData[0];
+
+  // Send the command frame
+  error = pn532_bus_WriteCommand(pbtData, szData);
+  if (error)
+  {
+    return error;
+  }
+
+  // --------------------------------------------------------------------
+  // Wait for the IRQ/Ready flag
+  // --------------------------------------------------------------------
+  if (!(pn532_bus_i2c_WaitForReady()))
+  {
+    #ifdef PN532_DEBUGMODE
+    PN532_DEBUG ("Timed out waiting for IRQ/Ready%s", CFG_PRINTF_NEWLINE);
+    #endif
+    return PN532_ERROR_READYSTATUSTIMEOUT;
+  }
+
+  // Read the ACK frame
+  error = pn532_bus_ReadAck();
+  if (error)
+  {
+    return error;
+  }
+
+  // --------------------------------------------------------------------
+  // Wait for the post-ACK IRQ/Ready flag
+  // --------------------------------------------------------------------
+  if (!(pn532_bus_i2c_WaitForReady()))
+  {
+    #ifdef PN532_DEBUGMODE
+    PN532_DEBUG ("Timed out waiting for IRQ/Ready%s", CFG_PRINTF_NEWLINE);
+    #endif
+    return PN532_ERROR_READYSTATUSTIMEOUT;
+  }
+
+  return PN532_ERROR_NONE;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Builds a frame for the specified command and writes it to
+            the PN532 without waiting for the ACK frame
+
+    @param  pdbData   Pointer to the byte data to send
+    @param  szData    Length in bytes of the data to send
+
+    @note   Possible error messages are:
+
+            - PN532_ERROR_EXTENDEDFRAME       // Extended frames not supported
+            - PN532_ERROR_BUSY                // Already busy with a command
+            - PN532_ERROR_I2C_NACK            // No ACK on I2C
+*/
+/**************************************************************************/
+pn532_error_t pn532_bus_WriteCommand(const byte_t * pbtData, const size_t szData)
 {
   pn532_error_t error = PN532_ERROR_NONE;
   pn532_pcb_t *pn532 = pn532GetPCB();
@@ -243,17 +340,16 @@ pn532_error_t pn532_bus_SendCommand(const byte_t * pbtData, const size_t szData)
   // Flag the stack as busy
   pn532->state = PN532_STATE_BUSY;
 
-  // --------------------------------------------------------------------
-  // Send the command frame
-  // --------------------------------------------------------------------
   byte_t abtFrame[PN532_BUFFER_LEN] = { 0x00, 0x00, 0xff };
   size_t szFrame = 0;
 
   // Build the frame
-  pn532_bus_i2c_BuildFrame (abtFrame, &szFrame, pbtData, szData);
-
-  // Keep track of the last command that was sent
-  pn532->lastCommand = pbtData[0];
+  error = pn532_bus_i2c_BuildFrame (abtFrame, &szFrame, pbtData, szData);
+  if (error)
+  {
+    pn532->state = PN532_STATE_READY;
+    return error;
+  }
 
   // Output the frame data for debugging if requested
   #ifdef PN532_DEBUGMODE
@@ -261,6 +357,11 @@ pn532_error_t pn532_bus_SendCommand(const byte_t * pbtData, const size_t szData)
   pn532PrintHex(abtFrame, szFrame);
   #endif
 
+  // The next falling edge on IRQ will signal the ACK frame
+  #ifdef GPIO_ENABLE_IRQ3
+  _pn532_bus_i2c_irqPending = false;
+  #endif
+
   // Send data to the PN532
   error = pn532_bus_i2c_WriteData(abtFrame, szFrame);
 
@@ -271,26 +372,43 @@ pn532_error_t pn532_bus_SendCommand(const byte_t * pbtData, const size_t szData)
     #ifdef PN532_DEBUGMODE
     PN532_DEBUG ("No ACK received on I2C bus%s", CFG_PRINTF_NEWLINE);
     #endif
-    pn532->state = PN532_STATE_READY;
-    return error;
   }
 
-  // --------------------------------------------------------------------
-  // Wait for the IRQ/Ready flag
-  // --------------------------------------------------------------------
-  if (!(pn532_bus_i2c_WaitForReady()))
+  pn532->state = PN532_STATE_READY;
+  return error;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Reads and checks the ACK frame that the PN532 sends after
+            receiving a command.  Only call this once pn532_bus_IsReady
+            returns TRUE.
+
+    @note   Possible error messages are:
+
+            - PN532_ERROR_BUSY
+            - PN532_ERROR_INVALIDACK          // No ACK frame received
+*/
+/**************************************************************************/
+pn532_error_t pn532_bus_ReadAck(void)
+{
+  pn532_pcb_t *pn532 = pn532GetPCB();
+  uint32_t i;
+
+  // Check if we're busy
+  if (pn532->state == PN532_STATE_BUSY)
   {
-    pn532->state = PN532_STATE_READY;
-    #ifdef PN532_DEBUGMODE
-    PN532_DEBUG ("Timed out waiting for IRQ/Ready%s", CFG_PRINTF_NEWLINE);
-    #endif
-    return PN532_ERROR_READYSTATUSTIMEOUT;
+    return PN532_ERROR_BUSY;
   }
 
-  // --------------------------------------------------------------------
-  // Read the ACK frame
-  // --------------------------------------------------------------------
-  uint32_t i;
+  // Flag the stack as busy
+  pn532->state = PN532_STATE_BUSY;
+
+  // The next falling edge on IRQ will signal the response frame
+  #ifdef GPIO_ENABLE_IRQ3
+  _pn532_bus_i2c_irqPending = false;
+  #endif
+
   // Clear buffer
   for ( i = 0; i < I2C_BUFSIZE; i++ )
   {
@@ -320,22 +438,55 @@ pn532_error_t pn532_bus_SendCommand(const byte_t * pbtData, const size_t szData)
     return PN532_ERROR_INVALIDACK;
   }
 
-  // --------------------------------------------------------------------
-  // Wait for the post-ACK IRQ/Ready flag
-  // --------------------------------------------------------------------
-  if (!(pn532_bus_i2c_WaitForReady()))
-  {
-    pn532->state = PN532_STATE_READY;
-    #ifdef PN532_DEBUGMODE
-    PN532_DEBUG ("Timed out waiting for IRQ/Ready%s", CFG_PRINTF_NEWLINE);
-    #endif
-    return PN532_ERROR_READYSTATUSTIMEOUT;
-  }
-
   pn532->state = PN532_STATE_READY;
   return PN532_ERROR_NONE;
 }
 
+/**************************************************************************/
+/*! 
+    @brief  Indicates whether the PN532 has a frame (ACK or response)
+            ready to be read, without blocking
+
+    With GPIO_ENABLE_IRQ3 the falling edge of the IRQ line is latched by
+    pn532_bus_IRQHandler, which also wakes the MCU if it is sleeping
+    while waiting for the PN532.  Otherwise the IRQ line is polled.
+*/
+/**************************************************************************/
+BOOL pn532_bus_IsReady(void)
+{
+  #ifdef GPIO_ENABLE_IRQ3
+  return _pn532_bus_i2c_irqPending ? TRUE : FALSE;
+  #else
+  return gpioGetValue(PN532_I2C_IRQPORT, PN532_I2C_IRQPIN) ? FALSE : TRUE;
+  #endif
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Aborts the command the PN532 is currently processing by
+            sending it an ACK frame (see UM0701-02 section 6.2.1.3)
+*/
+/**************************************************************************/
+void pn532_bus_Abort(void)
+{
+  const byte_t abtAck[6] = { 0x00, 0x00, 0xff, 0x00, 0xff, 0x00 };
+
+  pn532_bus_i2c_WriteData(abtAck, sizeof(abtAck));
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Called by the GPIO 3 IRQ handler when the PN532 pulls its
+            IRQ line low to signal that a frame is ready
+*/
+/**************************************************************************/
+void pn532_bus_IRQHandler(void)
+{
+  #ifdef GPIO_ENABLE_IRQ3
+  _pn532_bus_i2c_irqPending = true;
+  #endif
+}
+
 /**************************************************************************/
 /*! 
     @brief  Reads a response from the PN532
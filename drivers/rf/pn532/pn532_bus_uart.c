@@ -64,11 +64,17 @@ pn532_error_t pn532_bus_BuildFrame(byte_t * pbtFrame, size_t * pszFrame, const b
 
 /**************************************************************************/
 /*! 
-    @brief  Initialises UART and configures the PN532
+    @brief  Initialises UART and configures the PN532, without blocking
+            while the PN532 is held in reset and boots (500ms)
+
+    @note   This is a protothread (see core/pt/pt.h): call it until
+            PT_SCHEDULE returns false.
 */
 /**************************************************************************/
-void pn532_bus_HWInit(void)
+PT_THREAD(pn532_bus_HWInitPT(pt_t *pt))
 {
+  PT_BEGIN(pt);
+
   #ifdef PN532_DEBUGMODE
   PN532_DEBUG("Initialising UART (%d)%s", PN532_UART_BAUDRATE, CFG_PRINTF_NEWLINE);
   #endif
@@ -80,11 +86,25 @@ void pn532_bus_HWInit(void)
   PN532_DEBUG("Resetting the PN532...\r\n");
   #endif
   gpioSetValue(PN532_RSTPD_PORT, PN532_RSTPD_PIN, 0);
-  systickDelay(400);
+  PT_DELAY_MS(pt, 400);
   gpioSetValue(PN532_RSTPD_PORT, PN532_RSTPD_PIN, 1);
 
   // Wait for the PN532 to finish booting
-  systickDelay(100);
+  PT_DELAY_MS(pt, 100);
+
+  PT_END(pt);
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Initialises UART and configures the PN532
+*/
+/**************************************************************************/
+void pn532_bus_HWInit(void)
+{
+  pt_t pt;
+
+  PT_RUN(&pt, pn532_bus_HWInitPT(&pt));
 }
 
 /**************************************************************************/
@@ -104,6 +124,49 @@ void pn532_bus_HWInit(void)
 /**************************************************************************/
 pn532_error_t pn532_bus_SendCommand(const byte_t * pbtData, const size_t szData)
 {
+  pn532_error_t error;
+  pn532_pcb_t *pn532 = pn532GetPCB();
+
+  // Keep track of the last command that was sent
+  pn532->lastCommand = pbtData[0];
+
+  error = pn532_bus_WriteCommand(pbtData, szData);
+  if (error)
+  {
+    return error;
+  }
+
+  // Wait for ACK
+  systickDelay(10);   // FIXME: How long should we wait for ACK?
+  if (!pn532_bus_IsReady()) 
+  {
+    // Unable to read ACK
+    #ifdef PN532_DEBUGMODE
+    PN532_DEBUG ("Unable to read ACK%s", CFG_PRINTF_NEWLINE);
+    #endif
+    return PN532_ERROR_NOACK;
+  }
+
+  return pn532_bus_ReadAck();
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Builds a frame for the specified command and sends it to
+            the PN532 without waiting for the ACK frame
+
+    @param  pdbData   Pointer to the byte data to send
+    @param  szData    Length in bytes of the data to send
+
+    @note   Possible error messages are:
+
+            - PN532_ERROR_BUSY
+            - PN532_ERROR_EXTENDEDFRAME
+*/
+/**************************************************************************/
+pn532_error_t pn532_bus_WriteCommand(const byte_t * pbtData, const size_t szData)
+{
+  pn532_error_t error;
   pn532_pcb_t *pn532 = pn532GetPCB();
     
   // Check if we're busy
@@ -120,10 +183,12 @@ pn532_error_t pn532_bus_SendCommand(const byte_t * pbtData, const size_t szData)
   size_t szFrame = 0;
 
   // Build the frame
-  pn532_bus_BuildFrame (abtFrame, &szFrame, pbtData, szData);
-
-  // Keep track of the last command that was sent
-  pn532->lastCommand = pbtData[0];
+  error = pn532_bus_BuildFrame (abtFrame, &szFrame, pbtData, szData);
+  if (error)
+  {
+    pn532->state = PN532_STATE_READY;
+    return error;
+  }
 
   // Output the frame data for debugging if requested
   #ifdef PN532_DEBUGMODE
@@ -134,28 +199,40 @@ pn532_error_t pn532_bus_SendCommand(const byte_t * pbtData, const size_t szData)
   // Send data to the PN532
   uartSend (abtFrame, szFrame);
 
-  // Wait for ACK
+  pn532->state = PN532_STATE_READY;
+  return PN532_ERROR_NONE;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Reads and checks the ACK frame that the PN532 sends after
+            receiving a command.  Only call this once pn532_bus_IsReady
+            returns TRUE.
+
+    @note   Possible error messages are:
+
+            - PN532_ERROR_BUSY
+            - PN532_ERROR_INVALIDACK
+*/
+/**************************************************************************/
+pn532_error_t pn532_bus_ReadAck(void)
+{
+  pn532_pcb_t *pn532 = pn532GetPCB();
   byte_t abtRxBuf[6];
-  uart_pcb_t *uart = uartGetPCB();
-  systickDelay(10);   // FIXME: How long should we wait for ACK?
-  if (uart->rxfifo.len < 6) 
+  uint32_t i;
+
+  // Check if we're busy
+  if (pn532->state == PN532_STATE_BUSY)
   {
-    // Unable to read ACK
-    #ifdef PN532_DEBUGMODE
-    PN532_DEBUG ("Unable to read ACK%s", CFG_PRINTF_NEWLINE);
-    #endif
-    pn532->state = PN532_STATE_READY;
-    return PN532_ERROR_NOACK;
+    return PN532_ERROR_BUSY;
   }
 
   // Read ACK ... this will also remove it from the buffer
   const byte_t abtAck[6] = { 0x00, 0x00, 0xff, 0x00, 0xff, 0x00 };
-  abtRxBuf[0] = uartRxBufferRead();
-  abtRxBuf[1] = uartRxBufferRead();
-  abtRxBuf[2] = uartRxBufferRead();
-  abtRxBuf[3] = uartRxBufferRead();
-  abtRxBuf[4] = uartRxBufferRead();
-  abtRxBuf[5] = uartRxBufferRead();
+  for (i = 0; i < 6; i++)
+  {
+    abtRxBuf[i] = uartRxBufferRead();
+  }
 
   // Make sure the received ACK matches the prototype
   if (0 != (memcmp (abtRxBuf, abtAck, 6))) 
@@ -165,14 +242,58 @@ pn532_error_t pn532_bus_SendCommand(const byte_t * pbtData, const size_t szData)
     pn532PrintHex(abtRxBuf, 6);
     PN532_DEBUG("%s", CFG_PRINTF_NEWLINE);
     #endif
-    pn532->state = PN532_STATE_READY;
     return PN532_ERROR_INVALIDACK;
   }
 
-  pn532->state = PN532_STATE_READY;
   return PN532_ERROR_NONE;
 }
 
+/**************************************************************************/
+/*! 
+    @brief  Indicates whether a complete frame (ACK or response) has
+            been received, without blocking or consuming any data
+
+    The frame length is taken from the LEN byte in the RX FIFO, so a
+    frame that is still arriving isn't handed over half-finished.
+*/
+/**************************************************************************/
+BOOL pn532_bus_IsReady(void)
+{
+  uart_pcb_t *uart = uartGetPCB();
+  uint32_t len = uart->rxfifo.len;
+  uint8_t lenByte, lcsByte;
+
+  // ACK frames (00 00 FF 00 FF 00) are the shortest frames
+  if (len < 6)
+  {
+    return FALSE;
+  }
+
+  lenByte = uart->rxfifo.buf[(uart->rxfifo.rd_ptr + 3) % CFG_UART_BUFSIZE];
+  lcsByte = uart->rxfifo.buf[(uart->rxfifo.rd_ptr + 4) % CFG_UART_BUFSIZE];
+  if ((lenByte == 0x00) || (lenByte == 0xff && lcsByte == 0xff))
+  {
+    // ACK frame or extended frame (rejected by pn532_bus_ReadResponse)
+    return TRUE;
+  }
+
+  // 00 00 FF LEN LCS [TFI DATA] DCS 00
+  return (len >= (uint32_t)lenByte + 7) ? TRUE : FALSE;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Aborts the command the PN532 is currently processing by
+            sending it an ACK frame (see UM0701-02 section 6.2.1.3)
+*/
+/**************************************************************************/
+void pn532_bus_Abort(void)
+{
+  byte_t abtAck[6] = { 0x00, 0x00, 0xff, 0x00, 0xff, 0x00 };
+
+  uartSend(abtAck, sizeof(abtAck));
+}
+
 /**************************************************************************/
 /*! 
     @brief  Reads a response from the PN532
@@ -0,0 +1,362 @@
+/**************************************************************************/
+/*!
+    @file     bignum.c
+    @date     19 October, 2026
+    @version  1.0
+
+    Multi-precision unsigned integer arithmetic with Montgomery modular
+    multiplication and sliding-window exponentiation.
+
+    All 32x32->64-bit products compile to UMULL/UMLAL on the Cortex-M3.
+    The intermediate product and the window table live in static RAM
+    (see BN_MAXLIMBS and BN_TABLE_LIMBS) to keep stack usage bounded, so
+    the functions in this file are not re-entrant.
+
+    @warning  The code is not constant-time.  It is intended for public
+              key operations (signature verification) and for private
+              key operations on devices where timing side channels are
+              not a concern.
+*/
+/**************************************************************************/
+
+#include <string.h>
+
+#include "bignum.h"
+
+/* Double-width product plus one carry limb */
+static uint32_t _bnProduct[2 * BN_MAXLIMBS + 1];
+
+/* Odd powers a^1, a^3, a^5 ... in Montgomery form */
+static uint32_t _bnTable[BN_TABLE_LIMBS];
+
+/**************************************************************************/
+/*!
+    @brief  Loads a big-endian byte string into a limb array, zero
+            extending or truncating to 'limbs' limbs
+*/
+/**************************************************************************/
+void bnFromBytes(uint32_t *r, uint32_t limbs, const uint8_t *buf, uint32_t len)
+{
+  uint32_t i;
+
+  memset(r, 0, limbs * sizeof(uint32_t));
+  for (i = 0; i < len && i < limbs * 4; i++)
+  {
+    r[i / 4] |= (uint32_t)buf[len - 1 - i] << (8 * (i % 4));
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Stores a limb array as a big-endian byte string of 'len' bytes
+*/
+/**************************************************************************/
+void bnToBytes(uint8_t *buf, uint32_t len, const uint32_t *a, uint32_t limbs)
+{
+  uint32_t i;
+
+  for (i = 0; i < len; i++)
+  {
+    buf[len - 1 - i] = i < limbs * 4 ? a[i / 4] >> (8 * (i % 4)) : 0;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Compares two numbers, returning -1, 0 or 1
+*/
+/**************************************************************************/
+int bnCmp(const uint32_t *a, const uint32_t *b, uint32_t limbs)
+{
+  while (limbs--)
+  {
+    if (a[limbs] != b[limbs])
+    {
+      return a[limbs] > b[limbs] ? 1 : -1;
+    }
+  }
+  return 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  r = a + b, returns the carry out
+*/
+/**************************************************************************/
+uint32_t bnAdd(uint32_t *r, const uint32_t *a, const uint32_t *b, uint32_t limbs)
+{
+  uint64_t s = 0;
+  uint32_t i;
+
+  for (i = 0; i < limbs; i++)
+  {
+    s += (uint64_t)a[i] + b[i];
+    r[i] = (uint32_t)s;
+    s >>= 32;
+  }
+  return (uint32_t)s;
+}
+
+/**************************************************************************/
+/*!
+    @brief  r = a - b, returns the borrow out
+*/
+/**************************************************************************/
+uint32_t bnSub(uint32_t *r, const uint32_t *a, const uint32_t *b, uint32_t limbs)
+{
+  uint32_t borrow = 0;
+  uint32_t i;
+
+  for (i = 0; i < limbs; i++)
+  {
+    uint64_t d = (uint64_t)a[i] - b[i] - borrow;
+    r[i] = (uint32_t)d;
+    borrow = (uint32_t)(d >> 32) & 1;
+  }
+  return borrow;
+}
+
+/**************************************************************************/
+/*!
+    @brief  r = a * b, where r has room for 2 * limbs limbs and does not
+            overlap a or b
+*/
+/**************************************************************************/
+void bnMul(uint32_t *r, const uint32_t *a, const uint32_t *b, uint32_t limbs)
+{
+  uint32_t i, j;
+
+  memset(r, 0, 2 * limbs * sizeof(uint32_t));
+  for (i = 0; i < limbs; i++)
+  {
+    uint64_t t = 0;
+    uint32_t ai = a[i];
+
+    if (ai == 0) continue;
+    for (j = 0; j < limbs; j++)
+    {
+      t += (uint64_t)ai * b[j] + r[i + j];
+      r[i + j] = (uint32_t)t;
+      t >>= 32;
+    }
+    r[i + limbs] = (uint32_t)t;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Montgomery reduction of _bnProduct (2 * limbs + 1 limbs, must
+            be less than n * R), r = _bnProduct * R^-1 mod n
+*/
+/**************************************************************************/
+static void bnMontRedc(uint32_t *r, const bnMont_t *ctx)
+{
+  const uint32_t *n = ctx->n;
+  uint32_t k = ctx->limbs;
+  uint32_t *t = _bnProduct;
+  uint32_t i, j;
+
+  for (i = 0; i < k; i++)
+  {
+    uint32_t m = t[i] * ctx->n0;
+    uint64_t c = 0;
+
+    for (j = 0; j < k; j++)
+    {
+      c += (uint64_t)m * n[j] + t[i + j];
+      t[i + j] = (uint32_t)c;
+      c >>= 32;
+    }
+    for (j = i + k; c && j <= 2 * k; j++)
+    {
+      c += t[j];
+      t[j] = (uint32_t)c;
+      c >>= 32;
+    }
+  }
+
+  // Result is t[k..2k] < 2n, subtract n once if required
+  if (t[2 * k] || bnCmp(&t[k], n, k) >= 0)
+  {
+    bnSub(r, &t[k], n, k);
+  }
+  else
+  {
+    memcpy(r, &t[k], k * sizeof(uint32_t));
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets up a Montgomery context for the odd modulus n.  The
+            caller must point ctx->rr at R^2 mod n afterwards, either
+            precomputed or via bnMontComputeRR.
+*/
+/**************************************************************************/
+void bnMontInit(bnMont_t *ctx, const uint32_t *n, uint32_t limbs)
+{
+  uint32_t x = n[0];
+  uint32_t i;
+
+  // Newton iteration for n^-1 mod 2^32, each step doubles the number of
+  // correct low bits (n * n = 1 mod 8 for any odd n)
+  for (i = 0; i < 4; i++)
+  {
+    x *= 2 - n[0] * x;
+  }
+
+  ctx->n = n;
+  ctx->rr = NULL;
+  ctx->n0 = -x;
+  ctx->limbs = limbs;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Computes R^2 mod n into rr (ctx->limbs limbs)
+
+    2^(33 * limbs) mod n is built by modular doubling, which is 2^limbs in
+    Montgomery form.  Five Montgomery squarings then raise it to
+    2^(32 * limbs) = R, whose Montgomery form is R^2 mod n.  This takes
+    about half the doublings of the naive approach.
+*/
+/**************************************************************************/
+void bnMontComputeRR(uint32_t *rr, const bnMont_t *ctx)
+{
+  uint32_t k = ctx->limbs;
+  uint32_t i, j;
+
+  memset(rr, 0, k * sizeof(uint32_t));
+  rr[0] = 1;
+
+  for (i = 0; i < 33 * k; i++)
+  {
+    uint32_t top = rr[k - 1] >> 31;
+
+    for (j = k - 1; j > 0; j--)
+    {
+      rr[j] = (rr[j] << 1) | (rr[j - 1] >> 31);
+    }
+    rr[0] <<= 1;
+
+    if (top || bnCmp(rr, ctx->n, k) >= 0)
+    {
+      bnSub(rr, rr, ctx->n, k);
+    }
+  }
+
+  for (i = 0; i < 5; i++)
+  {
+    bnMontMul(rr, rr, rr, ctx);
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  r = a * b * R^-1 mod n.  a and b must be less than n, r may
+            alias either operand.
+*/
+/**************************************************************************/
+void bnMontMul(uint32_t *r, const uint32_t *a, const uint32_t *b, const bnMont_t *ctx)
+{
+  bnMul(_bnProduct, a, b, ctx->limbs);
+  _bnProduct[2 * ctx->limbs] = 0;
+  bnMontRedc(r, ctx);
+}
+
+/**************************************************************************/
+/*!
+    @brief  r = a mod n, where a has up to 2 * ctx->limbs limbs and is
+            less than n * R (e.g. a CRT input c < p * q with q < R)
+*/
+/**************************************************************************/
+void bnMod(uint32_t *r, const uint32_t *a, uint32_t alimbs, const bnMont_t *ctx)
+{
+  memset(_bnProduct, 0, sizeof(_bnProduct));
+  memcpy(_bnProduct, a, alimbs * sizeof(uint32_t));
+
+  // REDC gives a * R^-1, multiplying by R^2 restores a
+  bnMontRedc(r, ctx);
+  bnMontMul(r, r, ctx->rr, ctx);
+}
+
+/**************************************************************************/
+/*!
+    @brief  r = a^e mod n using left-to-right sliding window
+            exponentiation.  a must be less than n, r may alias a but
+            not e.
+*/
+/**************************************************************************/
+void bnModExp(uint32_t *r, const uint32_t *a, const uint32_t *e, uint32_t elimbs, const bnMont_t *ctx)
+{
+  uint32_t k = ctx->limbs;
+  int32_t  bits, i, j;
+  uint32_t w, v;
+  bool     started = false;
+
+  // Find the top set bit of the exponent
+  while (elimbs && e[elimbs - 1] == 0) elimbs--;
+  if (elimbs == 0)
+  {
+    memset(r, 0, k * sizeof(uint32_t));
+    r[0] = 1;
+    return;
+  }
+  bits = 32 * elimbs;
+  while (!(e[(bits - 1) / 32] & (1UL << ((bits - 1) % 32)))) bits--;
+
+  // Wider windows cost more precomputation, and must fit the table
+  w = bits > 671 ? 6 : bits > 239 ? 5 : bits > 79 ? 4 : bits > 23 ? 3 : 1;
+  while ((1UL << (w - 1)) * k > BN_TABLE_LIMBS) w--;
+
+  // _bnTable[i] = a^(2i+1) in Montgomery form
+  bnMontMul(&_bnTable[0], a, ctx->rr, ctx);
+  if (w > 1)
+  {
+    bnMontMul(r, &_bnTable[0], &_bnTable[0], ctx);
+    for (i = 1; i < (1 << (w - 1)); i++)
+    {
+      bnMontMul(&_bnTable[i * k], &_bnTable[(i - 1) * k], r, ctx);
+    }
+  }
+
+  #define BN_BIT(x) ((e[(x) / 32] >> ((x) % 32)) & 1)
+
+  for (i = bits - 1; i >= 0; )
+  {
+    if (!BN_BIT(i))
+    {
+      bnMontMul(r, r, r, ctx);
+      i--;
+      continue;
+    }
+
+    // Longest window of at most w bits ending in a set bit
+    j = i - (int32_t)w + 1;
+    if (j < 0) j = 0;
+    while (!BN_BIT(j)) j++;
+
+    for (v = 0; i >= j; i--)
+    {
+      v = (v << 1) | BN_BIT(i);
+      if (started) bnMontMul(r, r, r, ctx);
+    }
+
+    if (started)
+    {
+      bnMontMul(r, r, &_bnTable[(v >> 1) * k], ctx);
+    }
+    else
+    {
+      memcpy(r, &_bnTable[(v >> 1) * k], k * sizeof(uint32_t));
+      started = true;
+    }
+  }
+
+  #undef BN_BIT
+
+  // Leave the Montgomery domain
+  memset(_bnProduct, 0, sizeof(_bnProduct));
+  memcpy(_bnProduct, r, k * sizeof(uint32_t));
+  bnMontRedc(r, ctx);
+}
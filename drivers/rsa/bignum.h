@@ -0,0 +1,49 @@
+/**************************************************************************/
+/*!
+    @file     bignum.h
+    @date     19 October, 2026
+    @version  1.0
+
+    Multi-precision unsigned integer arithmetic with Montgomery modular
+    multiplication, used by the RSA driver for 1024/2048-bit keys.
+
+    Numbers are arrays of 32-bit limbs, least significant limb first.
+*/
+/**************************************************************************/
+
+#ifndef _BIGNUM_H_
+#define _BIGNUM_H_
+
+#include "projectconfig.h"
+
+/* Largest supported modulus in limbs */
+#define BN_MAXLIMBS       (CFG_RSA_MAXBITS / 32)
+
+/* Storage for the sliding window table of odd powers.  This holds eight  *
+ * half-size (CRT) entries or four full-size ones; bnModExp picks the     *
+ * widest window that fits.                                               */
+#define BN_TABLE_LIMBS    (8 * BN_MAXLIMBS / 2)
+
+/* Montgomery context for an odd modulus n with R = 2^(32 * limbs) */
+typedef struct bnMont_s
+{
+  const uint32_t *n;      // Modulus
+  const uint32_t *rr;     // R^2 mod n
+  uint32_t        n0;     // -n^-1 mod 2^32
+  uint32_t        limbs;  // Size of n in limbs
+}
+bnMont_t;
+
+void     bnFromBytes(uint32_t *r, uint32_t limbs, const uint8_t *buf, uint32_t len);
+void     bnToBytes(uint8_t *buf, uint32_t len, const uint32_t *a, uint32_t limbs);
+int      bnCmp(const uint32_t *a, const uint32_t *b, uint32_t limbs);
+uint32_t bnAdd(uint32_t *r, const uint32_t *a, const uint32_t *b, uint32_t limbs);
+uint32_t bnSub(uint32_t *r, const uint32_t *a, const uint32_t *b, uint32_t limbs);
+void     bnMul(uint32_t *r, const uint32_t *a, const uint32_t *b, uint32_t limbs);
+void     bnMontInit(bnMont_t *ctx, const uint32_t *n, uint32_t limbs);
+void     bnMontComputeRR(uint32_t *rr, const bnMont_t *ctx);
+void     bnMontMul(uint32_t *r, const uint32_t *a, const uint32_t *b, const bnMont_t *ctx);
+void     bnMod(uint32_t *r, const uint32_t *a, uint32_t alimbs, const bnMont_t *ctx);
+void     bnModExp(uint32_t *r, const uint32_t *a, const uint32_t *e, uint32_t elimbs, const bnMont_t *ctx);
+
+#endif
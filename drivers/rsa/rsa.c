@@ -8,6 +8,11 @@
 
     Basic RSA-encryption using 64-bit math (32-bit keys).
 
+    Multi-precision RSA (rsaBig*) handles 1024/2048-bit keys using
+    Montgomery multiplication and sliding-window exponentiation (see
+    bignum.c), with CRT for private key operations.  The largest
+    supported key is set with CFG_RSA_MAXBITS.
+
     Based on the examples from "Mastering Algorithms with C" by
     Kyle Loudon (O'Reilly, 1999).
 
@@ -26,6 +31,40 @@
 /**************************************************************************/
 
 #include "rsa.h"
+#include "bignum.h"
+#include "core/systick/systick.h"
+
+/* R^2 mod n for public keys without a precomputed value, or R^2 mod p  *
+ * followed by R^2 mod q for CRT private keys                           */
+static uint32_t _rsaRR[BN_MAXLIMBS];
+
+/* Signature/message buffer, or m1, m2 and h for CRT private keys */
+static uint32_t _rsaWork[BN_MAXLIMBS + BN_MAXLIMBS / 2];
+
+static huge_t mulmod(huge_t a, huge_t b, huge_t n)
+{
+  #if CFG_RSA_BITS == 32
+  /* The 64-bit product can't overflow */
+  return (huge_t)(((uint64_t)a * b) % n);
+  #endif
+  #if CFG_RSA_BITS == 64
+  /* a * b may need 128 bits, so accumulate with modular double-and-add */
+  huge_t y = 0;
+
+  a %= n;
+  while (b != 0)
+  {
+    if (b & 1)
+    {
+      y = (y >= n - a) ? y - (n - a) : y + a;
+    }
+    a = (a >= n - a) ? a - (n - a) : a + a;
+    b = b >> 1;
+  }
+
+  return y;
+  #endif
+}
 
 huge_t modexp(huge_t a, huge_t b, huge_t n) 
 {
@@ -38,11 +77,11 @@ huge_t modexp(huge_t a, huge_t b, huge_t n)
     /*  For each 1 in b, accumulate y. */
     if (b & 1)
     {
-      y = (y * a) % n;
+      y = mulmod(y, a, n);
     }
     
     /* Square a for each bit in b. */
-    a = (a * a) % n;
+    a = mulmod(a, a, n);
     
     /*  Prepare for the next bit in b. */
     b = b >> 1;
@@ -126,3 +165,233 @@ void rsaDecrypt(huge_t ciphertext, huge_t *plaintext, rsaPriKey_t prikey)
 
   return;
 }
+
+/**************************************************************************/
+/*! 
+    @brief  Raises 'in' to the public exponent, out = in^e mod n
+
+    @param[out] out   Result, key->limbs limbs (may alias 'in')
+    @param[in]  in    Input, key->limbs limbs, must be less than n
+    @param[in]  key   Public key
+*/
+/**************************************************************************/
+rsaError_e rsaBigPublic(uint32_t *out, const uint32_t *in, const rsaBigPubKey_t *key)
+{
+  bnMont_t ctx;
+
+  if (key->limbs == 0 || key->limbs > BN_MAXLIMBS || !(key->n[0] & 1))
+    return RSA_ERROR_KEYSIZE;
+  if (bnCmp(in, key->n, key->limbs) >= 0)
+    return RSA_ERROR_RANGE;
+
+  bnMontInit(&ctx, key->n, key->limbs);
+  if (key->rr)
+  {
+    ctx.rr = key->rr;
+  }
+  else
+  {
+    bnMontComputeRR(_rsaRR, &ctx);
+    ctx.rr = _rsaRR;
+  }
+
+  bnModExp(out, in, &key->e, 1, &ctx);
+
+  return RSA_ERROR_OK;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Raises 'in' to the private exponent using the Chinese
+            Remainder Theorem, which works on half-size numbers and is
+            roughly four times faster than a plain modular exponentiation
+
+    @param[out] out   Result, key->limbs limbs (may alias 'in')
+    @param[in]  in    Input, key->limbs limbs, must be less than p * q
+    @param[in]  key   CRT private key
+*/
+/**************************************************************************/
+rsaError_e rsaBigPrivate(uint32_t *out, const uint32_t *in, const rsaBigPriKey_t *key)
+{
+  uint32_t half = key->limbs / 2;
+  uint32_t *m1 = &_rsaWork[0];
+  uint32_t *m2 = &_rsaWork[BN_MAXLIMBS / 2];
+  uint32_t *h  = &_rsaWork[BN_MAXLIMBS];
+  bnMont_t ctxP, ctxQ;
+  uint32_t carry, i;
+
+  if (half == 0 || key->limbs > BN_MAXLIMBS || (key->limbs & 1) ||
+      !(key->p[0] & 1) || !(key->q[0] & 1))
+    return RSA_ERROR_KEYSIZE;
+
+  bnMontInit(&ctxP, key->p, half);
+  bnMontComputeRR(&_rsaRR[0], &ctxP);
+  ctxP.rr = &_rsaRR[0];
+  bnMontInit(&ctxQ, key->q, half);
+  bnMontComputeRR(&_rsaRR[half], &ctxQ);
+  ctxQ.rr = &_rsaRR[half];
+
+  /* m1 = in^dp mod p, m2 = in^dq mod q */
+  bnMod(m1, in, key->limbs, &ctxP);
+  bnModExp(m1, m1, key->dp, half, &ctxP);
+  bnMod(m2, in, key->limbs, &ctxQ);
+  bnModExp(m2, m2, key->dq, half, &ctxQ);
+
+  /* h = qinv * (m1 - m2) mod p */
+  bnMod(h, m2, half, &ctxP);
+  if (bnSub(h, m1, h, half))
+  {
+    bnAdd(h, h, key->p, half);
+  }
+  bnMontMul(h, h, key->qinv, &ctxP);
+  bnMontMul(h, h, ctxP.rr, &ctxP);
+
+  /* out = m2 + h * q */
+  bnMul(out, h, key->q, half);
+  carry = bnAdd(out, out, m2, half);
+  for (i = half; carry && i < key->limbs; i++)
+  {
+    carry = ++out[i] == 0;
+  }
+
+  return RSA_ERROR_OK;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Checks a signature against the expected encoded message
+            (e.g. a PKCS #1 v1.5 padded digest)
+
+    @param[in]  sig       Signature, big-endian, 'len' bytes
+    @param[in]  expected  Expected value of sig^e mod n, big-endian,
+                          'len' bytes
+    @param[in]  len       Length of the modulus in bytes (key->limbs * 4)
+    @param[in]  key       Public key
+*/
+/**************************************************************************/
+rsaError_e rsaBigVerify(const uint8_t *sig, const uint8_t *expected, uint32_t len, const rsaBigPubKey_t *key)
+{
+  rsaError_e error;
+  uint32_t i;
+
+  if (len != key->limbs * 4 || key->limbs > BN_MAXLIMBS)
+    return RSA_ERROR_KEYSIZE;
+
+  bnFromBytes(_rsaWork, key->limbs, sig, len);
+  error = rsaBigPublic(_rsaWork, _rsaWork, key);
+  if (error != RSA_ERROR_OK)
+    return error;
+
+  for (i = 0; i < len; i++)
+  {
+    if ((uint8_t)(_rsaWork[i / 4] >> (8 * (i % 4))) != expected[len - 1 - i])
+      return RSA_ERROR_MISMATCH;
+  }
+
+  return RSA_ERROR_OK;
+}
+
+/* 1024-bit test key (e = 65537) with a known message/ciphertext pair */
+static const uint32_t _rsaTestN[32] =
+{
+  0x0D6FC6AF, 0xF19A3AB7, 0xB8EEB7AD, 0xFD749EAA,
+  0x900FBE61, 0x236F94BC, 0x987BE02F, 0x8C63B639,
+  0x6295EA69, 0x9AA8F911, 0x3FFA7A73, 0xC14657FE,
+  0x3DBF9F46, 0x5B1E7831, 0xA2F9AF4C, 0xC67F65A9,
+  0x6139CE82, 0x8EA60A5F, 0x2C736BAE, 0xE743063A,
+  0x68E57957, 0x721F1829, 0x5CFED303, 0xD3E40BDC,
+  0xC834C33F, 0x681CA05B, 0xBEEF1E78, 0x145D2926,
+  0xD3FD3C2E, 0x66663238, 0x29A32F0D, 0xBA927CBF
+};
+
+static const uint32_t _rsaTestP[16] =
+{
+  0xCAC92EE1, 0x053427A5, 0x2367C244, 0xD58EC343,
+  0xB597E574, 0x0DC1BCC0, 0x631A5CA0, 0x0DABBEA4,
+  0x50E05024, 0x7F311C60, 0xAEE6A358, 0x8E8325E9,
+  0x7D5025F4, 0x80AFA059, 0x5730E82E, 0xE3A26693
+};
+
+static const uint32_t _rsaTestQ[16] =
+{
+  0x1EC4778F, 0x1E7A1D71, 0x1A1B146A, 0xEE34C52A,
+  0x8A859342, 0x0E363C3A, 0xB224488C, 0xDA65B024,
+  0x5259761C, 0x12133B53, 0x39EBBFDE, 0x10C392AF,
+  0xA7FA44DF, 0xBAE65E0E, 0x74200D45, 0xD1D2313D
+};
+
+static const uint32_t _rsaTestDP[16] =
+{
+  0x71AE3E81, 0xE7134CAA, 0x9DA5684A, 0x21A914CD,
+  0x344F753E, 0xF54B5755, 0x7CBB8AA5, 0xF0FF4175,
+  0xBCC6739A, 0x023E2DD7, 0x4D5315F5, 0xBC8E05B4,
+  0xC49A1967, 0x15B2A1A9, 0x7076CEC4, 0x4982AC75
+};
+
+static const uint32_t _rsaTestDQ[16] =
+{
+  0x5DD540A3, 0xF01C5AC2, 0xA8C6A32C, 0xB4641427,
+  0x4D95E523, 0xBE661F81, 0x4CABBEA6, 0x4DECC7BF,
+  0xCF80787A, 0xB3C2E710, 0x92168FF7, 0x8C593358,
+  0x1170CC73, 0x0160573E, 0x9E877D4B, 0xAD0F888B
+};
+
+static const uint32_t _rsaTestQInv[16] =
+{
+  0x37CEB261, 0xCD4CC14B, 0x00AB0E1A, 0x639FE200,
+  0xD9A262C7, 0x25292728, 0x7D374D2E, 0x6443EC02,
+  0x67A33834, 0xD4C5C94D, 0x0DA843E3, 0x6E57E5B1,
+  0xC2823E2F, 0xEDD3B6C2, 0x82E79064, 0xA3A69ED6
+};
+
+static const uint32_t _rsaTestMsg[32] =
+{
+  0x6FA6E29E, 0xDE0FC5A2, 0x6EFD39F9, 0x5D46672E,
+  0x36EBCEE8, 0x0F2D04C0, 0x40BCEEAD, 0x8781118F,
+  0x4B2AFC61, 0x0527E397, 0x24D2D713, 0x303A5ECB,
+  0xBA83E4F8, 0xA772BB87, 0xA2AC96DD, 0xDE6D4C12,
+  0xC82CB06D, 0xDF0BCF88, 0x3B5D14FC, 0x270998BC,
+  0x4A1CE9D4, 0x4546C7DB, 0xA896870F, 0xE27FF33F,
+  0xE55BEA87, 0xA43D44B5, 0x1F4D16CD, 0x5F934255,
+  0xA9758AF2, 0xD12476B5, 0x4937FFB4, 0x0081A5CC
+};
+
+static const uint32_t _rsaTestCipher[32] =
+{
+  0x3DE0207D, 0x2527CE0D, 0x4CD4F54A, 0xB6D21560,
+  0x94E730B4, 0xC32B3EAD, 0xBF7F2013, 0x56441ED0,
+  0x52AC20EF, 0x276B3CA3, 0x51AF07FC, 0x736362C2,
+  0xB6D9D6F2, 0x693E6A23, 0xAD9F60C7, 0x33CF8DB2,
+  0x741C9AB4, 0x2706D7D5, 0x7B4090EC, 0x9471F76D,
+  0xDE80C25A, 0x3A3EF48A, 0xE5978F87, 0xEA826C05,
+  0xBEA49468, 0x4ACD48BD, 0xE6C43075, 0xD0560306,
+  0x85FB19A6, 0x47192E66, 0x10E03734, 0x52314135
+};
+
+void rsaBigTest()
+{
+  static uint32_t result[32];
+  rsaBigPubKey_t publicKey = { _rsaTestN, NULL, 65537, 32 };
+  rsaBigPriKey_t privateKey = { _rsaTestP, _rsaTestQ, _rsaTestDP, _rsaTestDQ, _rsaTestQInv, 32 };
+  uint32_t ticks;
+
+  if (BN_MAXLIMBS < 32)
+  {
+    printf("CFG_RSA_MAXBITS must be at least 1024 %s", CFG_PRINTF_NEWLINE);
+    return;
+  }
+
+  printf("Starting 1024-bit RSA test %s", CFG_PRINTF_NEWLINE);
+
+  ticks = systickGetTicks();
+  rsaBigPublic(result, _rsaTestMsg, &publicKey);
+  ticks = systickGetTicks() - ticks;
+  printf("Public key operation:  %u ticks (%s) %s", (unsigned int)ticks,
+         bnCmp(result, _rsaTestCipher, 32) ? "ERROR" : "OK", CFG_PRINTF_NEWLINE);
+
+  ticks = systickGetTicks();
+  rsaBigPrivate(result, _rsaTestCipher, &privateKey);
+  ticks = systickGetTicks() - ticks;
+  printf("Private key operation: %u ticks (%s) %s", (unsigned int)ticks,
+         bnCmp(result, _rsaTestMsg, 32) ? "ERROR" : "OK", CFG_PRINTF_NEWLINE);
+}
@@ -6,7 +6,8 @@
     @date     4 January, 2010
     @version  1.0
 
-    Basic RSA-encryption using 64-bit math (32-bit keys).
+    Basic RSA-encryption using 64-bit math (32-bit keys), plus
+    multi-precision RSA for 1024/2048-bit keys (see bignum.h).
 
     Based on the examples from "Mastering Algorithms with C" by
     Kyle Loudon (O'Reilly, 1999).
@@ -44,8 +45,48 @@ typedef struct rsaPriKey_s
 } 
 rsaPriKey_t;
 
+/* Multi-precision RSA public key.  All numbers are little-endian arrays *
+ * of 32-bit limbs (see bignum.h).                                       */
+typedef struct rsaBigPubKey_s
+{
+  const uint32_t *n;      // Modulus
+  const uint32_t *rr;     // R^2 mod n, or NULL to compute it on each use
+  uint32_t        e;      // Public exponent (typically 65537)
+  uint32_t        limbs;  // Size of n in 32-bit limbs
+}
+rsaBigPubKey_t;
+
+/* Multi-precision RSA private key in CRT form.  p, q, dp, dq and qinv  *
+ * are each limbs / 2 limbs long, p and q must be odd and qinv is        *
+ * q^-1 mod p.                                                           */
+typedef struct rsaBigPriKey_s
+{
+  const uint32_t *p;
+  const uint32_t *q;
+  const uint32_t *dp;     // d mod (p - 1)
+  const uint32_t *dq;     // d mod (q - 1)
+  const uint32_t *qinv;   // q^-1 mod p
+  uint32_t        limbs;  // Size of the modulus n = p * q in 32-bit limbs
+}
+rsaBigPriKey_t;
+
+typedef enum
+{
+  RSA_ERROR_OK = 0,                 // Everything executed normally
+  RSA_ERROR_KEYSIZE,                // Key larger than CFG_RSA_MAXBITS or malformed
+  RSA_ERROR_RANGE,                  // Input not less than the modulus
+  RSA_ERROR_MISMATCH,               // Signature does not match
+  RSA_ERROR_LAST
+}
+rsaError_e;
+
 void rsaTest();
 void rsaEncrypt(huge_t plaintext, huge_t *ciphertext, rsaPubKey_t pubkey);
 void rsaDecrypt(huge_t ciphertext, huge_t *plaintext, rsaPriKey_t prikey);
 
+void rsaBigTest();
+rsaError_e rsaBigPublic(uint32_t *out, const uint32_t *in, const rsaBigPubKey_t *key);
+rsaError_e rsaBigPrivate(uint32_t *out, const uint32_t *in, const rsaBigPriKey_t *key);
+rsaError_e rsaBigVerify(const uint8_t *sig, const uint8_t *expected, uint32_t len, const rsaBigPubKey_t *key);
+
 #endif
@@ -306,38 +306,60 @@ isl12022mError_t isl12022mSetTime(uint8_t dayofweek, uint8_t year, uint8_t month
 /**************************************************************************/
 isl12022mError_t isl12022mGetTemp(uint8_t *celsius)
 {
-  isl12022mError_t error = ISL12022M_ERROR_OK;
+  isl12022mError_t error;
+  pt_t pt;
+
+  PT_RUN(&pt, isl12022mGetTempPT(&pt, celsius, &error));
+
+  return error;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Same as isl12022mGetTemp, but returns instead of blocking
+            during the 100ms temperature conversion
+
+    @note   This is a protothread (see core/pt/pt.h).  'celsius' and
+            'error' are set once PT_SCHEDULE returns false.
+*/
+/**************************************************************************/
+PT_THREAD(isl12022mGetTempPT(pt_t *pt, uint8_t *celsius, isl12022mError_t *error))
+{
   uint8_t buffer[2];
   uint32_t temp;
 
+  PT_BEGIN(pt);
+
+  *error = ISL12022M_ERROR_OK;
+
   if (!_isl12022mInitialised)
   {
-    error = isl12022mInit();
-    if (error) return error;
+    *error = isl12022mInit();
+    if (*error) PT_EXIT(pt);
   }
 
   // Enable temperature sensing if required
-  error = isl12022mReadBuffer(ISL12022M_RTC_ADDRESS, ISL12022M_REG_CSR_BETA, buffer, 1);
-  if (!error)
+  *error = isl12022mReadBuffer(ISL12022M_RTC_ADDRESS, ISL12022M_REG_CSR_BETA, buffer, 1);
+  if (!*error)
   {
     if (!(buffer[0] & ISL12022M_BETA_TEMPENABLE))
     {
       // Temp sensor is not enabled ... enable it now
-      error = isl12022mWrite8(ISL12022M_RTC_ADDRESS, ISL12022M_REG_CSR_BETA, buffer[0] | ISL12022M_BETA_TEMPENABLE);
-      if (error)
-        return error;
+      *error = isl12022mWrite8(ISL12022M_RTC_ADDRESS, ISL12022M_REG_CSR_BETA, buffer[0] | ISL12022M_BETA_TEMPENABLE);
+      if (*error)
+        PT_EXIT(pt);
     }
   }
 
   // Wait 100ms for conversion to complete
-  systickDelay(100);
+  PT_DELAY_MS(pt, 100);
   // Read low and high temp bytes (0x28 and 0x29)
-  error = isl12022mReadBuffer(ISL12022M_RTC_ADDRESS, ISL12022M_REG_TEMP_TKOL, buffer, 2);
-  if (error)
-    return error;
+  *error = isl12022mReadBuffer(ISL12022M_RTC_ADDRESS, ISL12022M_REG_TEMP_TKOL, buffer, 2);
+  if (*error)
+    PT_EXIT(pt);
   // Convert value to degrees celsius (value/2 - 273 = degrees C)
   temp = ((buffer[0]) | (buffer[1] << 8)) / 2 - 273;
   *celsius = (uint8_t)temp & 0xFF;
 
-  return error;
+  PT_END(pt);
 }
@@ -39,6 +39,7 @@
 
 #include "projectconfig.h"
 #include "core/i2c/i2c.h"
+#include "core/pt/pt.h"
 
 #define ISL12022M_RTC_ADDRESS       (0xDE)    // 1101111 shifted left 1 bit = 0xDE
 #define ISL12022M_SRAM_ADDRESS      (0xAE)    // 1010111 shifted left 1 bit = 0xAE
@@ -155,5 +156,6 @@ isl12022mError_t isl12022mInit(void);
 isl12022mError_t isl12022mGetTime(isl12022mTime_t *time);
 isl12022mError_t isl12022mSetTime(uint8_t dayofweek, uint8_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second);
 isl12022mError_t isl12022mGetTemp(uint8_t *celsius);
+PT_THREAD(isl12022mGetTempPT(pt_t *pt, uint8_t *celsius, isl12022mError_t *error));
 
 #endif
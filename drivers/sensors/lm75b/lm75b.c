@@ -195,6 +195,39 @@ lm75bError_e lm75bGetTemperature (int32_t *temp)
   return error;
 }
 
+/**************************************************************************/
+/*! 
+    @brief  Takes the LM75B out of shutdown to start converting.  A
+            valid temperature can be read with lm75bReadConversion once
+            LM75B_CONVERSIONTIME ms have elapsed.
+*/
+/**************************************************************************/
+lm75bError_e lm75bStartConversion (void)
+{
+  if (!_lm75bInitialised) lm75bInit();
+
+  return lm75bConfigWrite (LM75B_CONFIG_SHUTDOWN_POWERON);
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Reads the temperature converted since lm75bStartConversion
+            and puts the device back in shutdown mode
+            
+    @note   See lm75bGetTemperature for the units used for 'temp'
+*/
+/**************************************************************************/
+lm75bError_e lm75bReadConversion (int32_t *temp)
+{
+  lm75bError_e error = LM75B_ERROR_OK;
+  error = lm75bRead16 (LM75B_REGISTER_TEMPERATURE, temp);
+
+  // Shut device back down
+  lm75bConfigWrite (LM75B_CONFIG_SHUTDOWN_SHUTDOWN);
+
+  return error;
+}
+
 /**************************************************************************/
 /*! 
     @brief  Writes the supplied 8-bit value to the LM75B config register
@@ -44,6 +44,7 @@
 
 #define LM75B_ADDRESS (0x90) // 100 1000 shifted left 1 bit = 0x90
 #define LM75B_READBIT (0x01)
+#define LM75B_CONVERSIONTIME (100)  // ms for a conversion after leaving shutdown
 
 #define LM75B_REGISTER_TEMPERATURE      (0x00)
 #define LM75B_REGISTER_CONFIGURATION    (0x01)
@@ -64,6 +65,8 @@ lm75bError_e;
 lm75bError_e lm75bInit(void);
 lm75bError_e lm75bGetTemperature (int32_t *temp);
 lm75bError_e lm75bConfigWrite (uint8_t configValue);
+lm75bError_e lm75bStartConversion (void);
+lm75bError_e lm75bReadConversion (int32_t *temp);
 
 #endif
 
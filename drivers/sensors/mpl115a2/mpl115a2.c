@@ -57,10 +57,10 @@ static bool _mpl115a2Initialised = false;
 
 /**************************************************************************/
 /*! 
-    @brief  Reads an 8 bit value over I2C
+    @brief  Starts a pressure and temperature conversion
 */
 /**************************************************************************/
-mpl115a2Error_t mpl115a2ReadPressureTemp(uint16_t *pressure, uint16_t *temp)
+static mpl115a2Error_t mpl115a2StartPressureTemp(void)
 {
   // Clear write buffers
   uint32_t i;
@@ -77,9 +77,16 @@ mpl115a2Error_t mpl115a2ReadPressureTemp(uint16_t *pressure, uint16_t *temp)
   I2CMasterBuffer[2] = 0x00;  // Why is this necessary to get results?
   i2cEngine();
 
-  // Wait a bit for the conversion to complete (3ms max)
-  systickDelay(5);
+  return MPL115A2_ERROR_OK;
+}
 
+/**************************************************************************/
+/*! 
+    @brief  Reads the raw results of the last conversion
+*/
+/**************************************************************************/
+static mpl115a2Error_t mpl115a2ReadPressureTemp(uint16_t *pressure, uint16_t *temp)
+{
   I2CWriteLength = 2;
   I2CReadLength = 4;
   I2CMasterBuffer[0] = MPL115A2_ADDRESS;
@@ -158,19 +165,31 @@ mpl115a2Error_t mpl115a2Init(void)
 
 /**************************************************************************/
 /*! 
-    @brief  Gets the compensated pressure level in kPa
+    @brief  Starts a conversion.  The pressure can be read with
+            mpl115a2ReadConversion once MPL115A2_CONVERSIONTIME ms
+            have elapsed.
 */
 /**************************************************************************/
-mpl115a2Error_t mpl115a2GetPressure(float *pressure)
+mpl115a2Error_t mpl115a2StartConversion(void)
+{
+  // Make sure the coefficients have been read, etc.
+  if (!_mpl115a2Initialised) mpl115a2Init();
+
+  return mpl115a2StartPressureTemp();
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Reads the results of a conversion started with
+            mpl115a2StartConversion as a compensated pressure in kPa
+*/
+/**************************************************************************/
+mpl115a2Error_t mpl115a2ReadConversion(float *pressure)
 {
   uint16_t  Padc, Tadc;
   float     Pcomp;
-
   mpl115a2Error_t error = MPL115A2_ERROR_OK;
 
-  // Make sure the coefficients have been read, etc.
-  if (!_mpl115a2Initialised) mpl115a2Init();
-
   // Get raw pressure and temperature settings
   error = mpl115a2ReadPressureTemp(&Padc, &Tadc);
   if (error) return error;
@@ -183,3 +202,21 @@ mpl115a2Error_t mpl115a2GetPressure(float *pressure)
 
   return error;
 }
+
+/**************************************************************************/
+/*! 
+    @brief  Gets the compensated pressure level in kPa
+*/
+/**************************************************************************/
+mpl115a2Error_t mpl115a2GetPressure(float *pressure)
+{
+  mpl115a2Error_t error = MPL115A2_ERROR_OK;
+
+  error = mpl115a2StartConversion();
+  if (error) return error;
+
+  // Wait a bit for the conversion to complete (3ms max)
+  systickDelay(MPL115A2_CONVERSIONTIME);
+
+  return mpl115a2ReadConversion(pressure);
+}
@@ -42,6 +42,7 @@
 
 #define MPL115A2_ADDRESS              (0xC0)    // 1100 000 shifted left 1 bit = 0xC0
 #define MPL115A2_READBIT              (0x01)
+#define MPL115A2_CONVERSIONTIME       (5)       // ms, 3ms max in the datasheet
 
 enum
 {
@@ -71,6 +72,8 @@ mpl115a2Error_t;
 
 mpl115a2Error_t mpl115a2Init(void);
 mpl115a2Error_t mpl115a2GetPressure(float *pressure);
+mpl115a2Error_t mpl115a2StartConversion(void);
+mpl115a2Error_t mpl115a2ReadConversion(float *pressure);
 
 #endif
 
@@ -0,0 +1,436 @@
+/**************************************************************************/
+/*!
+    @file     sensorsched.c
+
+    @section DESCRIPTION
+
+    Background sampling scheduler for slow sensors.
+
+    The blocking getters in the sensor drivers (tsl2561GetLuminosity,
+    tcs3414GetRGBL, etc.) wait for the full conversion time inside the
+    call.  The scheduler splits every measurement into a 'start' and a
+    'read' step instead: conversions are started when a sensor's period
+    has elapsed, and the results are collected once the sensor's
+    conversion time has passed, so several sensors can convert at the
+    same time and the MCU is free in between.
+
+    Every sensor has its own sampling period and its own ring buffer of
+    timestamped samples, supplied by the caller.  When the ring buffer
+    is full the oldest sample is overwritten (see
+    sensorschedGetOverruns).
+
+    sensorschedTask() must be called from the main loop.  It returns the
+    number of ms until it next needs to run, so the caller can sleep
+    until then (the systick or a timer32 match interrupt will wake the
+    MCU up from __WFI).  The I2C transfers wait on the I2C interrupt, so
+    the task can't be run from inside an interrupt handler.
+
+    @section Example
+
+    @code
+    #include "drivers/sensors/sensorsched/sensorsched.h"
+
+    sensorschedSample_t luxBuffer[16];
+    sensorschedSample_t pressureBuffer[4];
+    uint8_t luxId, pressureId;
+    sensorschedSample_t sample;
+
+    // Light every 500ms, pressure every 5s
+    sensorschedAdd(&sensorschedTSL2561, 500, luxBuffer, 16, &luxId);
+    sensorschedAdd(&sensorschedMPL115A2, 5000, pressureBuffer, 4, &pressureId);
+
+    while (1)
+    {
+      sensorschedTask();
+      while (sensorschedGetSample(luxId, &sample) == SENSORSCHED_ERROR_OK)
+      {
+        printf("%u: %d lux%s", (unsigned int)sample.timestamp,
+          (int)sample.values[0], CFG_PRINTF_NEWLINE);
+      }
+    }
+    @endcode
+
+    @section LICENSE
+
+    Software License Agreement (BSD License)
+
+    Copyright (c) 2012, microBuilder SARL
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+    1. Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holders nor the
+    names of its contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ''AS IS'' AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**************************************************************************/
+#include <string.h>
+
+#include "sensorsched.h"
+#include "core/systick/systick.h"
+
+typedef struct
+{
+  const sensorschedDriver_t * driver;
+  sensorschedSample_t *       buffer;
+  uint16_t                    bufferLength;
+  uint16_t                    head;           // Next sample to write
+  uint16_t                    count;          // Samples waiting to be read
+  bool                        converting;
+  uint32_t                    period;         // In ticks
+  uint32_t                    conversion;     // In ticks
+  uint32_t                    due;            // Tick when the next conversion starts
+  uint32_t                    started;        // Tick when the current conversion started
+  uint32_t                    overruns;
+  uint32_t                    errors;
+} sensorschedSlot_t;
+
+static sensorschedSlot_t _sensorschedSlots[SENSORSCHED_MAXSENSORS];
+
+/**************************************************************************/
+/*!
+    @brief  Converts ms to systick ticks, rounding up
+*/
+/**************************************************************************/
+static uint32_t sensorschedTicks(uint32_t ms)
+{
+  return (ms + CFG_SYSTICK_DELAY_IN_MS - 1) / CFG_SYSTICK_DELAY_IN_MS;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Returns the driver's current conversion time in ticks
+*/
+/**************************************************************************/
+static uint32_t sensorschedConversionTicks(const sensorschedDriver_t *driver)
+{
+  uint32_t ms = driver->getConversionTime ? driver->getConversionTime() : driver->conversionTime;
+
+  // Allow for the first tick after the start being a partial one
+  return ms ? sensorschedTicks(ms) + 1 : 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Returns the slot for the supplied ID, or 0 if it isn't in use
+*/
+/**************************************************************************/
+static sensorschedSlot_t * sensorschedGetSlot(uint8_t id)
+{
+  if ((id >= SENSORSCHED_MAXSENSORS) || (!_sensorschedSlots[id].driver))
+  {
+    return 0;
+  }
+  return &_sensorschedSlots[id];
+}
+
+/**************************************************************************/
+/*!
+    @brief  Collects the results of a conversion and stores them in the
+            ring buffer
+*/
+/**************************************************************************/
+static void sensorschedCollect(sensorschedSlot_t *slot)
+{
+  sensorschedSample_t *sample;
+  int32_t values[SENSORSCHED_MAXVALUES];
+
+  slot->converting = false;
+
+  // Read into a local copy, so a failed read doesn't clobber the oldest
+  // sample when the buffer is full
+  memset(values, 0, sizeof(values));
+  if (slot->driver->read(values))
+  {
+    slot->errors++;
+    return;
+  }
+  sample = &slot->buffer[slot->head];
+  memcpy(sample->values, values, sizeof(sample->values));
+  sample->timestamp = slot->started;
+
+  slot->head = (slot->head + 1) % slot->bufferLength;
+  if (slot->count < slot->bufferLength)
+  {
+    slot->count++;
+  }
+  else
+  {
+    // The oldest sample was overwritten
+    slot->overruns++;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Adds a sensor to the scheduler
+
+    @param[in]  driver
+                The sensor driver (sensorschedTSL2561, etc.)
+    @param[in]  period
+                Time between two samples in ms
+    @param[in]  buffer
+                Ring buffer for the samples
+    @param[in]  bufferLength
+                Number of samples in the buffer
+    @param[out] id
+                The ID used to read the samples
+
+    The first conversion is started the next time sensorschedTask is
+    called.
+*/
+/**************************************************************************/
+sensorschedError_e sensorschedAdd (const sensorschedDriver_t *driver, uint32_t period, sensorschedSample_t *buffer, uint16_t bufferLength, uint8_t *id)
+{
+  uint8_t i;
+
+  if ((!driver) || (!driver->read) || (!buffer) || (!bufferLength) || (!period))
+  {
+    return SENSORSCHED_ERROR_INVALIDPARAM;
+  }
+
+  for (i = 0; i < SENSORSCHED_MAXSENSORS; i++)
+  {
+    if (!_sensorschedSlots[i].driver)
+    {
+      break;
+    }
+  }
+  if (i == SENSORSCHED_MAXSENSORS)
+  {
+    return SENSORSCHED_ERROR_FULL;
+  }
+
+  memset(&_sensorschedSlots[i], 0, sizeof(sensorschedSlot_t));
+  _sensorschedSlots[i].buffer = buffer;
+  _sensorschedSlots[i].bufferLength = bufferLength;
+  _sensorschedSlots[i].period = sensorschedTicks(period);
+  _sensorschedSlots[i].conversion = sensorschedConversionTicks(driver);
+  _sensorschedSlots[i].due = systickGetTicks();
+  _sensorschedSlots[i].driver = driver;
+
+  *id = i;
+  return SENSORSCHED_ERROR_OK;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Stops sampling a sensor.  A conversion in progress is
+            abandoned, and the sensor may be left powered up.
+*/
+/**************************************************************************/
+sensorschedError_e sensorschedRemove (uint8_t id)
+{
+  sensorschedSlot_t *slot = sensorschedGetSlot(id);
+
+  if (!slot)
+  {
+    return SENSORSCHED_ERROR_INVALIDID;
+  }
+
+  slot->driver = 0;
+  return SENSORSCHED_ERROR_OK;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Changes the sampling period (in ms) of a sensor, starting
+            with the next conversion
+*/
+/**************************************************************************/
+sensorschedError_e sensorschedSetPeriod (uint8_t id, uint32_t period)
+{
+  sensorschedSlot_t *slot = sensorschedGetSlot(id);
+
+  if (!slot)
+  {
+    return SENSORSCHED_ERROR_INVALIDID;
+  }
+  if (!period)
+  {
+    return SENSORSCHED_ERROR_INVALIDPARAM;
+  }
+
+  // Reschedule relative to the last conversion
+  slot->due = slot->due - slot->period + sensorschedTicks(period);
+  slot->period = sensorschedTicks(period);
+  return SENSORSCHED_ERROR_OK;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Starts and collects conversions that are due
+
+    @return The number of ms until the task needs to run again (0 if it
+            should be called again right away)
+*/
+/**************************************************************************/
+uint32_t sensorschedTask (void)
+{
+  sensorschedSlot_t *slot;
+  uint32_t now, wait, next = 0xFFFFFFFF;
+  uint8_t i;
+
+  for (i = 0; i < SENSORSCHED_MAXSENSORS; i++)
+  {
+    slot = &_sensorschedSlots[i];
+    if (!slot->driver)
+    {
+      continue;
+    }
+
+    now = systickGetTicks();
+
+    // Collect finished conversions
+    if ((slot->converting) && (now - slot->started >= slot->conversion))
+    {
+      sensorschedCollect(slot);
+    }
+
+    // Start new conversions
+    if ((!slot->converting) && ((int32_t)(now - slot->due) >= 0))
+    {
+      slot->started = now;
+      slot->due += slot->period;
+      if ((int32_t)(now - slot->due) >= 0)
+      {
+        // Fell behind by more than a period, so skip the missed samples
+        slot->due = now + slot->period;
+      }
+
+      if ((slot->driver->start) && (slot->driver->start()))
+      {
+        slot->errors++;
+      }
+      else if (slot->conversion)
+      {
+        // The sensor's settings may have changed since the last start
+        if (slot->driver->getConversionTime)
+        {
+          slot->conversion = sensorschedConversionTicks(slot->driver);
+        }
+        slot->converting = true;
+      }
+      else
+      {
+        sensorschedCollect(slot);
+      }
+    }
+
+    // Work out when this slot needs attention again
+    now = systickGetTicks();
+    if (slot->converting)
+    {
+      wait = now - slot->started >= slot->conversion ? 0 : slot->conversion - (now - slot->started);
+    }
+    else
+    {
+      wait = (int32_t)(now - slot->due) >= 0 ? 0 : slot->due - now;
+    }
+    if (wait < next)
+    {
+      next = wait;
+    }
+  }
+
+  return next == 0xFFFFFFFF ? next : next * CFG_SYSTICK_DELAY_IN_MS;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Returns the number of samples waiting to be read
+*/
+/**************************************************************************/
+uint16_t sensorschedAvailable (uint8_t id)
+{
+  sensorschedSlot_t *slot = sensorschedGetSlot(id);
+
+  return slot ? slot->count : 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Removes the oldest sample from the ring buffer
+*/
+/**************************************************************************/
+sensorschedError_e sensorschedGetSample (uint8_t id, sensorschedSample_t *sample)
+{
+  sensorschedSlot_t *slot = sensorschedGetSlot(id);
+
+  if (!slot)
+  {
+    return SENSORSCHED_ERROR_INVALIDID;
+  }
+  if (!slot->count)
+  {
+    return SENSORSCHED_ERROR_NODATA;
+  }
+
+  *sample = slot->buffer[(slot->head + slot->bufferLength - slot->count) % slot->bufferLength];
+  slot->count--;
+  return SENSORSCHED_ERROR_OK;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the most recent sample without removing anything from
+            the ring buffer
+*/
+/**************************************************************************/
+sensorschedError_e sensorschedGetLatest (uint8_t id, sensorschedSample_t *sample)
+{
+  sensorschedSlot_t *slot = sensorschedGetSlot(id);
+
+  if (!slot)
+  {
+    return SENSORSCHED_ERROR_INVALIDID;
+  }
+  if (!slot->count)
+  {
+    return SENSORSCHED_ERROR_NODATA;
+  }
+
+  *sample = slot->buffer[(slot->head + slot->bufferLength - 1) % slot->bufferLength];
+  return SENSORSCHED_ERROR_OK;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Returns the number of samples that were overwritten before
+            they were read
+*/
+/**************************************************************************/
+uint32_t sensorschedGetOverruns (uint8_t id)
+{
+  sensorschedSlot_t *slot = sensorschedGetSlot(id);
+
+  return slot ? slot->overruns : 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Returns the number of conversions that failed
+*/
+/**************************************************************************/
+uint32_t sensorschedGetErrors (uint8_t id)
+{
+  sensorschedSlot_t *slot = sensorschedGetSlot(id);
+
+  return slot ? slot->errors : 0;
+}
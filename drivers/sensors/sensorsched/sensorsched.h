@@ -0,0 +1,108 @@
+/**************************************************************************/
+/*!
+    @file     sensorsched.h
+
+    @section LICENSE
+
+    Software License Agreement (BSD License)
+
+    Copyright (c) 2012, microBuilder SARL
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+    1. Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holders nor the
+    names of its contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ''AS IS'' AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**************************************************************************/
+
+#ifndef _SENSORSCHED_H_
+#define _SENSORSCHED_H_
+
+#include "projectconfig.h"
+
+#define SENSORSCHED_MAXSENSORS    (8)     // Number of sensors that can be scheduled
+#define SENSORSCHED_MAXVALUES     (4)     // Number of values in one sample (R, G, B and clear for the TCS3414)
+
+typedef enum
+{
+  SENSORSCHED_ERROR_OK = 0,               // Everything executed normally
+  SENSORSCHED_ERROR_FULL,                 // No free sensor slots
+  SENSORSCHED_ERROR_INVALIDID,            // Unknown sensor ID
+  SENSORSCHED_ERROR_INVALIDPARAM,         // Missing driver or buffer, or a period of 0
+  SENSORSCHED_ERROR_NODATA,               // No samples available
+  SENSORSCHED_ERROR_LAST
+}
+sensorschedError_e;
+
+/**************************************************************************/
+/*!
+    A timestamped sample.  The timestamp is the systick tick count when
+    the conversion was started, and the meaning of the values depends
+    on the driver (see sensorsched_sensors.c).
+*/
+/**************************************************************************/
+typedef struct
+{
+  uint32_t  timestamp;
+  int32_t   values[SENSORSCHED_MAXVALUES];
+} sensorschedSample_t;
+
+/**************************************************************************/
+/*!
+    Describes how to take a measurement with a sensor.  'start' begins
+    a conversion (or is 0 if the sensor doesn't need one), and 'read'
+    collects the results conversionTime ms later.  Both return 0 on
+    success or one of the driver's error codes.  Sensors whose
+    conversion time depends on their settings provide
+    'getConversionTime' instead, which is asked at every start.
+*/
+/**************************************************************************/
+typedef struct
+{
+  const char *  name;
+  uint32_t      conversionTime;                 // Time between start and read in ms
+  uint8_t       valueCount;                     // Number of values filled in by read
+  uint32_t      (*start)(void);
+  uint32_t      (*read)(int32_t *values);
+  uint32_t      (*getConversionTime)(void);     // Overrides conversionTime if not 0
+} sensorschedDriver_t;
+
+/* Drivers for the sensors in drivers/sensors (see sensorsched_sensors.c) */
+extern const sensorschedDriver_t sensorschedINA219;
+extern const sensorschedDriver_t sensorschedJoystick;
+#ifdef CFG_LM75B
+extern const sensorschedDriver_t sensorschedLM75B;
+#endif
+extern const sensorschedDriver_t sensorschedMPL115A2;
+extern const sensorschedDriver_t sensorschedTCS3414;
+extern const sensorschedDriver_t sensorschedTSL2561;
+
+sensorschedError_e  sensorschedAdd (const sensorschedDriver_t *driver, uint32_t period, sensorschedSample_t *buffer, uint16_t bufferLength, uint8_t *id);
+sensorschedError_e  sensorschedRemove (uint8_t id);
+sensorschedError_e  sensorschedSetPeriod (uint8_t id, uint32_t period);
+uint32_t            sensorschedTask (void);
+uint16_t            sensorschedAvailable (uint8_t id);
+sensorschedError_e  sensorschedGetSample (uint8_t id, sensorschedSample_t *sample);
+sensorschedError_e  sensorschedGetLatest (uint8_t id, sensorschedSample_t *sample);
+uint32_t            sensorschedGetOverruns (uint8_t id);
+uint32_t            sensorschedGetErrors (uint8_t id);
+
+#endif
@@ -0,0 +1,169 @@
+/**************************************************************************/
+/*!
+    @file     sensorsched_sensors.c
+
+    @section DESCRIPTION
+
+    Scheduler drivers for the sensors in drivers/sensors.  The sensors
+    must be initialised (ina219Init, etc.) before they are added to the
+    scheduler, and the values stored in each sample are:
+
+    sensorschedINA219     Bus voltage (mV), current (mA), power (mW)
+    sensorschedJoystick   Horizontal and vertical ADC values, select
+    sensorschedLM75B      Temperature (0.125 C per unit)
+    sensorschedMPL115A2   Pressure (Pa)
+    sensorschedTCS3414    Red, green, blue and clear
+    sensorschedTSL2561    Broadband, IR and lux
+
+    The INA219 and the joystick convert continuously, so they are read
+    straight away.  The TSL2561 driver allows for the longest (402ms)
+    integration time; use a copy with a shorter conversionTime if
+    tsl2561SetTiming is used to shorten it.
+
+    @section LICENSE
+
+    Software License Agreement (BSD License)
+
+    Copyright (c) 2012, microBuilder SARL
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+    1. Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holders nor the
+    names of its contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ''AS IS'' AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**************************************************************************/
+#include "sensorsched.h"
+
+#include "drivers/sensors/analogjoystick/analogjoystick.h"
+#include "drivers/sensors/ina219/ina219.h"
+#include "drivers/sensors/mpl115a2/mpl115a2.h"
+#include "drivers/sensors/tcs3414/tcs3414.h"
+#include "drivers/sensors/tsl2561/tsl2561.h"
+#ifdef CFG_LM75B
+#include "drivers/sensors/lm75b/lm75b.h"
+#endif
+
+/* INA219 */
+
+static uint32_t sensorschedINA219Read(int32_t *values)
+{
+  values[0] = ina219GetBusVoltage();
+  values[1] = ina219GetCurrent_mA();
+  values[2] = ina219GetPower_mW();
+  return 0;
+}
+
+const sensorschedDriver_t sensorschedINA219 = { "INA219", 0, 3, 0, sensorschedINA219Read };
+
+/* Analog joystick */
+
+static uint32_t sensorschedJoystickRead(int32_t *values)
+{
+  uint32_t horizontal, vertical;
+  bool select;
+
+  joystickGetValues(&horizontal, &vertical, &select);
+  values[0] = horizontal;
+  values[1] = vertical;
+  values[2] = select;
+  return 0;
+}
+
+const sensorschedDriver_t sensorschedJoystick = { "Joystick", 0, 3, 0, sensorschedJoystickRead };
+
+/* LM75B */
+
+#ifdef CFG_LM75B
+static uint32_t sensorschedLM75BStart(void)
+{
+  return lm75bStartConversion();
+}
+
+static uint32_t sensorschedLM75BRead(int32_t *values)
+{
+  return lm75bReadConversion(&values[0]);
+}
+
+const sensorschedDriver_t sensorschedLM75B = { "LM75B", LM75B_CONVERSIONTIME, 1, sensorschedLM75BStart, sensorschedLM75BRead };
+#endif
+
+/* MPL115A2 */
+
+static uint32_t sensorschedMPL115A2Start(void)
+{
+  return mpl115a2StartConversion();
+}
+
+static uint32_t sensorschedMPL115A2Read(int32_t *values)
+{
+  mpl115a2Error_t error;
+  float pressure;
+
+  error = mpl115a2ReadConversion(&pressure);
+  values[0] = (int32_t)(pressure * 1000.0F);
+  return error;
+}
+
+const sensorschedDriver_t sensorschedMPL115A2 = { "MPL115A2", MPL115A2_CONVERSIONTIME, 1, sensorschedMPL115A2Start, sensorschedMPL115A2Read };
+
+/* TCS3414 */
+
+static uint32_t sensorschedTCS3414Start(void)
+{
+  return tcs3414StartConversion();
+}
+
+static uint32_t sensorschedTCS3414Read(int32_t *values)
+{
+  tcs3414Error_e error;
+  uint16_t red, green, blue, clear;
+
+  error = tcs3414ReadConversion(&red, &green, &blue, &clear);
+  values[0] = red;
+  values[1] = green;
+  values[2] = blue;
+  values[3] = clear;
+  return error;
+}
+
+const sensorschedDriver_t sensorschedTCS3414 = { "TCS3414", TCS3414_CONVERSIONTIME, 4, sensorschedTCS3414Start, sensorschedTCS3414Read };
+
+/* TSL2561 */
+
+static uint32_t sensorschedTSL2561Start(void)
+{
+  return tsl2561StartConversion();
+}
+
+static uint32_t sensorschedTSL2561Read(int32_t *values)
+{
+  tsl2561Error_t error;
+  uint16_t broadband, ir;
+
+  error = tsl2561ReadConversion(&broadband, &ir);
+  values[0] = broadband;
+  values[1] = ir;
+  values[2] = tsl2561CalculateLux(broadband, ir);
+  return error;
+}
+
+// The conversion time follows the integration time set with tsl2561SetTiming
+const sensorschedDriver_t sensorschedTSL2561 = { "TSL2561", 0, 3, sensorschedTSL2561Start, sensorschedTSL2561Read, tsl2561GetConversionTime };
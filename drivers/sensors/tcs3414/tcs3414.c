@@ -176,21 +176,28 @@ tcs3414Error_e tcs3414SetSensitivity(tcs3414Gain_t gain, tcs3414Prescalar_t pres
 
 /**************************************************************************/
 /*! 
-    @brief  Reads the RGB and clear luminosity from the TCS3414
+    @brief  Powers the device and ADC up to start a conversion.  The
+            results can be read with tcs3414ReadConversion once
+            TCS3414_CONVERSIONTIME ms have elapsed.
 */
 /**************************************************************************/
-tcs3414Error_e tcs3414GetRGBL(uint16_t *red, uint16_t *green, uint16_t *blue, uint16_t *clear)
+tcs3414Error_e tcs3414StartConversion(void)
 {
   if (!_tcs3414Initialised) tcs3414Init();
 
-  tcs3414Error_e error = TCS3414_ERROR_OK;
-
   // Enable the device by setting the control bit to 0x03 (power + ADC on)
-  error = tcs3414Write8(TCS3414_COMMAND_BIT | TCS3414_REGISTER_CONTROL, TCS3414_CONTROL_POWERON);
-  if (error) return error;  
+  return tcs3414Write8(TCS3414_COMMAND_BIT | TCS3414_REGISTER_CONTROL, TCS3414_CONTROL_POWERON);
+}
 
-  // Wait >12ms for ADC to complete
-  systickDelay(13);
+/**************************************************************************/
+/*! 
+    @brief  Reads the results of a conversion started with
+            tcs3414StartConversion and powers the device back down
+*/
+/**************************************************************************/
+tcs3414Error_e tcs3414ReadConversion(uint16_t *red, uint16_t *green, uint16_t *blue, uint16_t *clear)
+{
+  tcs3414Error_e error = TCS3414_ERROR_OK;
 
   // Reads two byte red value
   error = tcs3414Read16(TCS3414_COMMAND_BIT | TCS3414_WORD_BIT | TCS3414_REGISTER_REDLOW, red);
@@ -215,6 +222,24 @@ tcs3414Error_e tcs3414GetRGBL(uint16_t *red, uint16_t *green, uint16_t *blue, ui
   return error;
 }
 
+/**************************************************************************/
+/*! 
+    @brief  Reads the RGB and clear luminosity from the TCS3414
+*/
+/**************************************************************************/
+tcs3414Error_e tcs3414GetRGBL(uint16_t *red, uint16_t *green, uint16_t *blue, uint16_t *clear)
+{
+  tcs3414Error_e error = TCS3414_ERROR_OK;
+
+  error = tcs3414StartConversion();
+  if (error) return error;  
+
+  // Wait >12ms for ADC to complete
+  systickDelay(TCS3414_CONVERSIONTIME);
+
+  return tcs3414ReadConversion(red, green, blue, clear);
+}
+
 /**************************************************************************/
 /*! 
     @brief    Reads the RGB values from the TCS3414 color sensor and
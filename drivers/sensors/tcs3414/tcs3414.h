@@ -42,6 +42,7 @@
 
 #define TCS3414_ADDRESS                           (0x72)    // 0111001 shifted left 1 bit = 0x72 (ADDR = GND or floating)
 #define TCS3414_READBIT                           (0x01)
+#define TCS3414_CONVERSIONTIME                    (13)      // ms, >12ms with the default integration time
 
 #define TCS3414_COMMAND_BIT                       (0x80)    // Must be 1
 #define TCS3414_WORD_BIT                          (0x20)    // 1 = read/write word (rather than byte)
@@ -123,6 +124,8 @@ tcs3414Error_e;
 tcs3414Error_e tcs3414Init(void);
 tcs3414Error_e tcs3414SetSensitivity(tcs3414Gain_t gain, tcs3414Prescalar_t prescalar);
 tcs3414Error_e tcs3414GetRGBL (uint16_t *red, uint16_t *green, uint16_t *blue, uint16_t *clear);
+tcs3414Error_e tcs3414StartConversion (void);
+tcs3414Error_e tcs3414ReadConversion (uint16_t *red, uint16_t *green, uint16_t *blue, uint16_t *clear);
 uint32_t       tcs3414CalculateCCT (uint16_t red, uint16_t green, uint16_t blue);
 
 #endif
@@ -229,32 +229,47 @@ tsl2561Error_t tsl2561SetTiming(tsl2561IntegrationTime_t integration, tsl2561Gai
 
 /**************************************************************************/
 /*! 
-    @brief  Reads the luminosity on both channels from the TSL2561
+    @brief  Returns the time in ms that a conversion takes with the
+            current integration time
 */
 /**************************************************************************/
-tsl2561Error_t tsl2561GetLuminosity (uint16_t *broadband, uint16_t *ir)
+uint32_t tsl2561GetConversionTime(void)
 {
-  if (!_tsl2561Initialised) tsl2561Init();
-
-  tsl2561Error_t error = TSL2561_ERROR_OK;
-
-  // Enable the device by setting the control bit to 0x03
-  error = tsl2561Enable();
-  if (error) return error;  
-
-  // Wait x ms for ADC to complete
   switch (_tsl2561IntegrationTime)
   {
     case TSL2561_INTEGRATIONTIME_13MS:
-      systickDelay(14);
-      break;
+      return 14;
     case TSL2561_INTEGRATIONTIME_101MS:
-      systickDelay(102);
-      break;
+      return 102;
     default:
-      systickDelay(400);
-      break;
+      return 400;
   }
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Powers the device up to start a conversion.  The results
+            can be read with tsl2561ReadConversion once
+            tsl2561GetConversionTime() ms have elapsed.
+*/
+/**************************************************************************/
+tsl2561Error_t tsl2561StartConversion (void)
+{
+  if (!_tsl2561Initialised) tsl2561Init();
+
+  // Enable the device by setting the control bit to 0x03
+  return tsl2561Enable();
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Reads the results of a conversion started with
+            tsl2561StartConversion and powers the device back down
+*/
+/**************************************************************************/
+tsl2561Error_t tsl2561ReadConversion (uint16_t *broadband, uint16_t *ir)
+{
+  tsl2561Error_t error = TSL2561_ERROR_OK;
 
   // Reads two byte value from channel 0 (visible + infrared)
   error = tsl2561Read16(TSL2561_COMMAND_BIT | TSL2561_WORD_BIT | TSL2561_REGISTER_CHAN0_LOW, broadband);
@@ -271,6 +286,45 @@ tsl2561Error_t tsl2561GetLuminosity (uint16_t *broadband, uint16_t *ir)
   return error;
 }
 
+/**************************************************************************/
+/*! 
+    @brief  Reads the luminosity on both channels from the TSL2561
+*/
+/**************************************************************************/
+tsl2561Error_t tsl2561GetLuminosity (uint16_t *broadband, uint16_t *ir)
+{
+  tsl2561Error_t error;
+  pt_t pt;
+
+  PT_RUN(&pt, tsl2561GetLuminosityPT(&pt, broadband, ir, &error));
+
+  return error;
+}
+
+/**************************************************************************/
+/*! 
+    @brief  Same as tsl2561GetLuminosity, but returns instead of blocking
+            for the integration time (up to 402ms)
+
+    @note   This is a protothread (see core/pt/pt.h).  The readings and
+            'error' are set once PT_SCHEDULE returns false.
+*/
+/**************************************************************************/
+PT_THREAD(tsl2561GetLuminosityPT (pt_t *pt, uint16_t *broadband, uint16_t *ir, tsl2561Error_t *error))
+{
+  PT_BEGIN(pt);
+
+  *error = tsl2561StartConversion();
+  if (*error) PT_EXIT(pt);
+
+  // Wait x ms for ADC to complete
+  PT_DELAY_MS(pt, tsl2561GetConversionTime());
+
+  *error = tsl2561ReadConversion(broadband, ir);
+
+  PT_END(pt);
+}
+
 /**************************************************************************/
 /*! 
     @brief  Calculates LUX from the supplied ch0 (broadband) and ch1 
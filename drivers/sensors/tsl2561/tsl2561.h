@@ -39,6 +39,7 @@
 
 #include "projectconfig.h"
 #include "core/i2c/i2c.h"
+#include "core/pt/pt.h"
 
 #define TSL2561_PACKAGE_CS                  // Lux calculations differ slightly for CS package
 // #define TSL2561_PACKAGE_T_FN_CL
@@ -156,6 +157,10 @@ tsl2561Error_t;
 tsl2561Error_t tsl2561Init(void);
 tsl2561Error_t tsl2561SetTiming(tsl2561IntegrationTime_t integration, tsl2561Gain_t gain);
 tsl2561Error_t tsl2561GetLuminosity (uint16_t *broadband, uint16_t *ir);
+PT_THREAD(tsl2561GetLuminosityPT (pt_t *pt, uint16_t *broadband, uint16_t *ir, tsl2561Error_t *error));
+tsl2561Error_t tsl2561StartConversion (void);
+tsl2561Error_t tsl2561ReadConversion (uint16_t *broadband, uint16_t *ir);
+uint32_t tsl2561GetConversionTime(void);
 uint32_t tsl2561CalculateLux(uint16_t ch0, uint16_t ch1);
 
 #endif
@@ -94,6 +94,7 @@
 #include "at25040.h"
 #include "core/ssp/ssp.h"
 #include "core/gpio/gpio.h"
+#include "core/systick/systick.h"
 
 #define AT25_SELECT()       gpioSetValue(0, 2, 0)
 #define AT25_DESELECT()     gpioSetValue(0, 2, 1)
@@ -146,12 +147,37 @@ void at25Init (void)
   sspInit(0, sspClockPolarity_Low, sspClockPhase_RisingEdge);
 }
 
+/**************************************************************************/
+/*! 
+    @brief Waits until the device isn't busy with a write cycle, for up
+           to AT25_WRITETIMEOUT ms
+
+    @return     TRUE if the device is ready, FALSE if it timed out
+*/
+/**************************************************************************/
+static bool at25WaitReady()
+{
+  uint32_t start = systickGetTicks();
+
+  do
+  {
+    // Check status to see if write cycle is done or not
+    if ((at25GetRSR() & AT25_RDSR_RDY) == 0)
+    {
+      return TRUE;
+    }
+  } while ((systickGetTicks() - start) < AT25_WRITETIMEOUT / CFG_SYSTICK_DELAY_IN_MS + 1);
+
+  return FALSE;
+}
+
 /**************************************************************************/
 /*! 
     @brief Reads the specified number of bytes from the supplied address.
 
     This function will read one or more bytes starting at the supplied
-    address.
+    address.  Any number of bytes can be read in one operation, since
+    the EEPROM keeps sending sequential bytes until CS is released.
 
     @param[in]  address
                 The 16-bit address where the read will start.  The maximum
@@ -164,28 +190,13 @@ void at25Init (void)
 /**************************************************************************/
 at25Error_e at25Read (uint16_t address, uint8_t *buffer, uint32_t bufferLength)
 {
-  if (address >= AT25_MAXADDRESS)
+  if ((address >= AT25_MAXADDRESS) || (bufferLength > AT25_MAXADDRESS - address))
   {
     return AT25_ERROR_ADDRERR;
   }
 
-  if (bufferLength > 6)
-  {
-    return AT25_ERROR_BUFFEROVERFLOW;
-  }
-
-  timeout = 0;
-  while ( timeout < SSP_MAX_TIMEOUT )
-  {
-    // Wait until the device is ready
-    uint8_t status = at25GetRSR() & AT25_RDSR_RDY;
-    if (status == 0)
-    {
-      break;
-    }
-    timeout++;
-  }
-  if ( timeout == SSP_MAX_TIMEOUT )
+  // Wait until the device is ready
+  if (!at25WaitReady())
   {
     return AT25_ERROR_TIMEOUT_WE;
   }
@@ -195,15 +206,9 @@ at25Error_e at25Read (uint16_t address, uint8_t *buffer, uint32_t bufferLength)
   src_addr[0] = address > 0xFF ? AT25_READ | AT25_A8 : AT25_READ;
   src_addr[1] = (address);
   sspSend(0, (uint8_t *)src_addr, 2); 
-  sspReceive(0, (uint8_t *)&dest_addr[2], bufferLength);
+  sspReceive(0, buffer, bufferLength);
   AT25_DESELECT();
 
-  // Fill response buffer
-  for (i = 0; i < bufferLength; i++)
-  {
-    buffer[i] = dest_addr[i + 2];
-  }
-
   return AT25_ERROR_OK;
 }
 
@@ -212,7 +217,9 @@ at25Error_e at25Read (uint16_t address, uint8_t *buffer, uint32_t bufferLength)
     @brief Writes the supplied bytes at a specified address.
 
     This function will write one or more bytes starting at the supplied
-    address.
+    address.  The data is split at page boundaries (AT25_PAGESIZE), and
+    the status register is polled to see when each page has been
+    written.
 
     @param[in]  address
                 The 16-bit address where the write will start.  The
@@ -226,69 +233,57 @@ at25Error_e at25Read (uint16_t address, uint8_t *buffer, uint32_t bufferLength)
 /**************************************************************************/
 at25Error_e at25Write (uint16_t address, uint8_t *buffer, uint32_t bufferLength)
 {
-  if (address >= AT25_MAXADDRESS)
-  {
-    return AT25_ERROR_ADDRERR;
-  }
+  uint32_t len;
 
-  if (bufferLength > 6)
+  if ((address >= AT25_MAXADDRESS) || (bufferLength > AT25_MAXADDRESS - address))
   {
-    return AT25_ERROR_BUFFEROVERFLOW;
+    return AT25_ERROR_ADDRERR;
   }
 
-  // Set write enable latch
-  at25WriteEnable();
-
-  timeout = 0;
-  while ( timeout < SSP_MAX_TIMEOUT )
+  while (bufferLength)
   {
-    // Wait until the device is write enabled
-    if (at25GetRSR() == AT25_RDSR_WEN)
+    // Don't write past the end of the current page
+    len = AT25_PAGESIZE - (address & (AT25_PAGESIZE - 1));
+    if (len > bufferLength)
     {
-      break;
+      len = bufferLength;
     }
-    timeout++;
-  }
-  if ( timeout == SSP_MAX_TIMEOUT )
-  {
-    return AT25_ERROR_TIMEOUT_WE;
-  }
 
-  for (i = 0; i < bufferLength; i++)        // Init RD and WR buffer
-  {
-    src_addr[i+2] = buffer[i];              // leave two bytes for cmd and offset(8 bits)
-    dest_addr[i] = 0;
-  }
+    // Set write enable latch
+    at25WriteEnable();
 
-  AT25_SELECT();
-  // Write command (0x02), append A8 if addr > 256 bytes
-  src_addr[0] = address > 0xFF ? AT25_WRITE | AT25_A8 : AT25_WRITE;
-  src_addr[1] = (address);
-  sspSend(0, (uint8_t *)src_addr, bufferLength + 2);
-  AT25_DESELECT();
+    timeout = 0;
+    while ( timeout < SSP_MAX_TIMEOUT )
+    {
+      // Wait until the device is write enabled
+      if (at25GetRSR() == AT25_RDSR_WEN)
+      {
+        break;
+      }
+      timeout++;
+    }
+    if ( timeout == SSP_MAX_TIMEOUT )
+    {
+      return AT25_ERROR_TIMEOUT_WE;
+    }
 
-  // Wait at least 3ms
-  for (i = 0; i < ((CFG_CPU_CCLK / 1000) * 3); i++);
-  
-  timeout = 0;
-  while ( timeout < SSP_MAX_TIMEOUT )
-  {
-    // Check status to see if write cycle is done or not
     AT25_SELECT();
-    src_addr[0] = AT25_RDSR;
-    sspSend(0, (uint8_t *)src_addr, 1);
-    sspReceive(0, (uint8_t *)dest_addr, 1);
+    // Write command (0x02), append A8 if addr > 256 bytes
+    src_addr[0] = address > 0xFF ? AT25_WRITE | AT25_A8 : AT25_WRITE;
+    src_addr[1] = (address);
+    sspSend(0, (uint8_t *)src_addr, 2);
+    sspSend(0, buffer, len);
     AT25_DESELECT();
-    // Wait until device is ready
-    if ((dest_addr[0] & AT25_RDSR_RDY) == 0x00)
+
+    // Poll the status register until the write cycle is done
+    if (!at25WaitReady())
     {
-      break;
+      return AT25_ERROR_TIMEOUT_WFINISH;
     }
-    timeout++;
-  }
-  if ( timeout == SSP_MAX_TIMEOUT )
-  {
-    return AT25_ERROR_TIMEOUT_WFINISH;
+
+    address += len;
+    buffer += len;
+    bufferLength -= len;
   }
 
   for (i = 0; i < 300; i++);                // Wait at least 250ns
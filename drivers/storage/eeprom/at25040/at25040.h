@@ -46,6 +46,8 @@
 #define AT25_RDSR_WEN       0x02
 #define AT25_A8             0x08        // For addresses > 0xFF (AT25040 only) A8 must be added to R/W commands
 #define AT25_MAXADDRESS     0x0200      // AT25040 = 0X0200, AT25020 = 0x100, AT25010 = 0x80
+#define AT25_PAGESIZE       8           // Bytes per write cycle (must be a power of 2)
+#define AT25_WRITETIMEOUT   10          // Max write cycle time in ms (tWC is 5ms max)
 
 /**************************************************************************/
 /*! 
@@ -73,7 +75,7 @@ typedef enum
   AT25_ERROR_TIMEOUT_WE,        // Timed out waiting for write enable status
   AT25_ERROR_TIMEOUT_WFINISH,   // Timed out waiting for write to finish
   AT25_ERROR_ADDRERR,           // Address out of range
-  AT25_ERROR_BUFFEROVERFLOW,    // Max 6 bytes can be read/written in one operation
+  AT25_ERROR_BUFFEROVERFLOW,    // Buffer too large for the operation
   AT2_ERROR_LAST
 }
 at25Error_e;
@@ -43,6 +43,89 @@
 
 static uint8_t buf[32];
 
+/*  WRITE CACHE
+    ===========
+
+    Every EEPROM write cycle takes several ms no matter how many bytes
+    of the page are written, so the typed write functions (eepromWriteU8,
+    eepromWriteS32, etc.) don't write to the EEPROM immediately.  The
+    bytes are collected in a one-page cache instead, and the page is
+    only written when a byte in another page is written, or when
+    eepromFlush or eepromWriteBuffer are called.  Consecutive settings
+    (a calibration table, etc.) are written with one write cycle per
+    page instead of one per value.
+
+    Reads always see the latest values, but the cache MUST be flushed
+    with eepromFlush() before the data is expected to survive a reset
+    or a power-down.
+*/
+static struct
+{
+  uint16_t page;                        // Address of the cached page
+  uint32_t dirty;                       // One bit per modified byte in data
+  uint8_t  data[MCP24AA_PAGESIZE];
+} _eepromCache;
+
+/**************************************************************************/
+/*! 
+    @brief Reads from EEPROM, including any bytes still in the cache
+*/
+/**************************************************************************/
+static mcp24aaError_e eepromCacheRead(uint16_t addr, uint8_t *buffer, uint32_t bufferLength)
+{
+  mcp24aaError_e error;
+  uint32_t i;
+
+  error = mcp24aaReadBuffer(addr, buffer, bufferLength);
+  if (error || !_eepromCache.dirty)
+  {
+    return error;
+  }
+
+  // Replace anything that hasn't been written yet
+  for (i = 0; i < MCP24AA_PAGESIZE; i++)
+  {
+    if ((_eepromCache.dirty & (1UL << i)) &&
+        (_eepromCache.page + i >= addr) && (_eepromCache.page + i < addr + bufferLength))
+    {
+      buffer[_eepromCache.page + i - addr] = _eepromCache.data[i];
+    }
+  }
+
+  return MCP24AA_ERROR_OK;
+}
+
+/**************************************************************************/
+/*! 
+    @brief Writes to the cache, flushing the cached page first if
+           another page is being written
+*/
+/**************************************************************************/
+static mcp24aaError_e eepromCacheWrite(uint16_t addr, uint8_t *buffer, uint32_t bufferLength)
+{
+  uint16_t page;
+
+  if ((addr > MCP24AA_MAXADDR) || (bufferLength > MCP24AA_MAXADDR + 1 - addr))
+  {
+    return MCP24AA_ERROR_ADDRERR;
+  }
+
+  while (bufferLength--)
+  {
+    page = addr & ~(MCP24AA_PAGESIZE - 1);
+    if ((_eepromCache.dirty) && (_eepromCache.page != page))
+    {
+      eepromFlush();
+    }
+    _eepromCache.page = page;
+    _eepromCache.data[addr - page] = *buffer++;
+    _eepromCache.dirty |= 1UL << (addr - page);
+    addr++;
+  }
+
+  return MCP24AA_ERROR_OK;
+}
+
 /**************************************************************************/
 /*! 
     @brief Checks whether the supplied address is within the valid range
@@ -72,7 +155,7 @@ bool eepromCheckAddress(uint16_t addr)
 uint8_t eepromReadU8(uint16_t addr)
 {
   mcp24aaError_e error = MCP24AA_ERROR_OK;
-  error = mcp24aaReadBuffer(addr, buf, sizeof(uint8_t));
+  error = eepromCacheRead(addr, buf, sizeof(uint8_t));
 
   // ToDo: Handle any errors
   if (error) { };
@@ -95,7 +178,7 @@ int8_t eepromReadS8(uint16_t addr)
   int8_t results;
 
   mcp24aaError_e error = MCP24AA_ERROR_OK;
-  error = mcp24aaReadBuffer(addr, buf, sizeof(int8_t));
+  error = eepromCacheRead(addr, buf, sizeof(int8_t));
   
   // ToDo: Handle any errors
   if (error) { };
@@ -119,7 +202,7 @@ uint16_t eepromReadU16(uint16_t addr)
   uint16_t results;
 
   mcp24aaError_e error = MCP24AA_ERROR_OK;
-  error = mcp24aaReadBuffer(addr, buf, sizeof(uint16_t));
+  error = eepromCacheRead(addr, buf, sizeof(uint16_t));
   
   // ToDo: Handle any errors
   if (error) { };
@@ -144,7 +227,7 @@ int16_t eepromReadS16(uint16_t addr)
   int16_t results;
 
   mcp24aaError_e error = MCP24AA_ERROR_OK;
-  error = mcp24aaReadBuffer(addr, buf, sizeof(int16_t));
+  error = eepromCacheRead(addr, buf, sizeof(int16_t));
   
   // ToDo: Handle any errors
   if (error) { };
@@ -168,7 +251,7 @@ uint32_t eepromReadU32(uint16_t addr)
   uint32_t results;
 
   mcp24aaError_e error = MCP24AA_ERROR_OK;
-  error = mcp24aaReadBuffer(addr, buf, sizeof(uint32_t));
+  error = eepromCacheRead(addr, buf, sizeof(uint32_t));
   
   // ToDo: Handle any errors
   if (error) { };
@@ -192,7 +275,7 @@ int32_t eepromReadS32(uint16_t addr)
   int32_t results;
 
   mcp24aaError_e error = MCP24AA_ERROR_OK;
-  error = mcp24aaReadBuffer(addr, buf, sizeof(int32_t));
+  error = eepromCacheRead(addr, buf, sizeof(int32_t));
   
   // ToDo: Handle any errors
   if (error) { };
@@ -216,7 +299,7 @@ uint64_t eepromReadU64(uint16_t addr)
   uint64_t results;
 
   mcp24aaError_e error = MCP24AA_ERROR_OK;
-  error = mcp24aaReadBuffer(addr, buf, sizeof(uint64_t));
+  error = eepromCacheRead(addr, buf, sizeof(uint64_t));
   
   // ToDo: Handle any errors
   if (error) { };
@@ -240,7 +323,7 @@ int64_t eepromReadS64(uint16_t addr)
   int64_t results;
 
   mcp24aaError_e error = MCP24AA_ERROR_OK;
-  error = mcp24aaReadBuffer(addr, buf, sizeof(int64_t));
+  error = eepromCacheRead(addr, buf, sizeof(int64_t));
   
   // ToDo: Handle any errors
   if (error) { };
@@ -251,10 +334,10 @@ int64_t eepromReadS64(uint16_t addr)
 
 /**************************************************************************/
 /*! 
-    @brief Reads a variabls length buffer from EEPROM
+    @brief Reads a variable length buffer from EEPROM
 
     @param[in]  addr
-                The 16-bit address to write to in EEPROM
+                The 16-bit address to read from in EEPROM
     @param[out] buffer
                 Pointer to the buffer that will store any retrieved bytes
     @param[in]  bufferLength
@@ -267,7 +350,67 @@ void eepromReadBuffer(uint16_t addr, uint8_t *buffer, uint32_t bufferLength)
   mcp24aaError_e error = MCP24AA_ERROR_OK;
   
   // Read the contents of address
-  error = mcp24aaReadBuffer(addr, buffer, bufferLength);
+  error = eepromCacheRead(addr, buffer, bufferLength);
+
+  // ToDo: Handle any errors
+  if (error) { };
+}
+
+/**************************************************************************/
+/*! 
+    @brief Writes a variable length buffer to EEPROM
+
+    The data is written immediately, one write cycle per EEPROM page,
+    after flushing the write cache.
+
+    @param[in]  addr
+                The 16-bit address to write to in EEPROM
+    @param[in]  buffer
+                Pointer to the bytes to write
+    @param[in]  bufferLength
+                The number of bytes to write
+*/
+/**************************************************************************/
+void eepromWriteBuffer(uint16_t addr, uint8_t *buffer, uint32_t bufferLength)
+{
+  mcp24aaError_e error = MCP24AA_ERROR_OK;
+
+  // Cached bytes go first so that they can't overwrite the new data
+  eepromFlush();
+  error = mcp24aaWriteBuffer(addr, buffer, bufferLength);
+
+  // ToDo: Handle any errors
+  if (error) { };
+}
+
+/**************************************************************************/
+/*! 
+    @brief Writes any values that are still in the write cache to EEPROM
+
+    Each run of modified bytes in the cached page is written with a
+    single write cycle.
+*/
+/**************************************************************************/
+void eepromFlush(void)
+{
+  mcp24aaError_e error = MCP24AA_ERROR_OK;
+  uint32_t start, end;
+
+  for (start = 0; start < MCP24AA_PAGESIZE; start = end)
+  {
+    // Find the next run of modified bytes
+    while ((start < MCP24AA_PAGESIZE) && !(_eepromCache.dirty & (1UL << start)))
+    {
+      start++;
+    }
+    for (end = start; (end < MCP24AA_PAGESIZE) && (_eepromCache.dirty & (1UL << end)); end++);
+
+    if (end > start)
+    {
+      error = mcp24aaWriteBuffer(_eepromCache.page + start, &_eepromCache.data[start], end - start);
+    }
+  }
+  _eepromCache.dirty = 0;
 
   // ToDo: Handle any errors
   if (error) { };
@@ -284,7 +427,7 @@ void eepromReadBuffer(uint16_t addr, uint8_t *buffer, uint32_t bufferLength)
 void eepromWriteU8(uint16_t addr, uint8_t value)
 {
   mcp24aaError_e error = MCP24AA_ERROR_OK;
-  error = mcp24aaWriteBuffer(addr, (uint8_t *)&value, sizeof(value));
+  error = eepromCacheWrite(addr, (uint8_t *)&value, sizeof(value));
 
   // ToDo: Handle any errors
   if (error) { };
@@ -301,7 +444,7 @@ void eepromWriteU8(uint16_t addr, uint8_t value)
 void eepromWriteS8(uint16_t addr, int8_t value)
 {
   mcp24aaError_e error = MCP24AA_ERROR_OK;
-  error = mcp24aaWriteBuffer(addr, (uint8_t *)&value, sizeof(value));
+  error = eepromCacheWrite(addr, (uint8_t *)&value, sizeof(value));
 
   // ToDo: Handle any errors
   if (error) { };
@@ -318,7 +461,7 @@ void eepromWriteS8(uint16_t addr, int8_t value)
 void eepromWriteU16(uint16_t addr, uint16_t value)
 {
   mcp24aaError_e error = MCP24AA_ERROR_OK;
-  error = mcp24aaWriteBuffer(addr, (uint8_t *)&value, sizeof(value));
+  error = eepromCacheWrite(addr, (uint8_t *)&value, sizeof(value));
 
   // ToDo: Handle any errors
   if (error) { };
@@ -335,7 +478,7 @@ void eepromWriteU16(uint16_t addr, uint16_t value)
 void eepromWriteS16(uint16_t addr, int16_t value)
 {
   mcp24aaError_e error = MCP24AA_ERROR_OK;
-  error = mcp24aaWriteBuffer(addr, (uint8_t *)&value, sizeof(value));
+  error = eepromCacheWrite(addr, (uint8_t *)&value, sizeof(value));
 
   // ToDo: Handle any errors
   if (error) { };
@@ -352,7 +495,7 @@ void eepromWriteS16(uint16_t addr, int16_t value)
 void eepromWriteU32(uint16_t addr, uint32_t value)
 {
   mcp24aaError_e error = MCP24AA_ERROR_OK;
-  error = mcp24aaWriteBuffer(addr, (uint8_t *)&value, sizeof(value));
+  error = eepromCacheWrite(addr, (uint8_t *)&value, sizeof(value));
 
   // ToDo: Handle any errors
   if (error) { };
@@ -369,7 +512,7 @@ void eepromWriteU32(uint16_t addr, uint32_t value)
 void eepromWriteS32(uint16_t addr, int32_t value)
 {
   mcp24aaError_e error = MCP24AA_ERROR_OK;
-  error = mcp24aaWriteBuffer(addr, (uint8_t *)&value, sizeof(value));
+  error = eepromCacheWrite(addr, (uint8_t *)&value, sizeof(value));
 
   // ToDo: Handle any errors
   if (error) { };
@@ -386,7 +529,7 @@ void eepromWriteS32(uint16_t addr, int32_t value)
 void eepromWriteU64(uint16_t addr, uint64_t value)
 {
   mcp24aaError_e error = MCP24AA_ERROR_OK;
-  error = mcp24aaWriteBuffer(addr, (uint8_t *)&value, sizeof(value));
+  error = eepromCacheWrite(addr, (uint8_t *)&value, sizeof(value));
 
   // ToDo: Handle any errors
   if (error) { };
@@ -403,7 +546,7 @@ void eepromWriteU64(uint16_t addr, uint64_t value)
 void eepromWriteS64(uint16_t addr, int64_t value)
 {
   mcp24aaError_e error = MCP24AA_ERROR_OK;
-  error = mcp24aaWriteBuffer(addr, (uint8_t *)&value, sizeof(value));
+  error = eepromCacheWrite(addr, (uint8_t *)&value, sizeof(value));
 
   // ToDo: Handle any errors
   if (error) { };
@@ -49,6 +49,8 @@ int32_t   eepromReadS32 ( uint16_t addr );
 uint64_t  eepromReadU64 ( uint16_t addr );
 int64_t   eepromReadS64 ( uint16_t addr );
 void      eepromReadBuffer ( uint16_t addr, uint8_t *buffer, uint32_t bufferLength);
+void      eepromWriteBuffer ( uint16_t addr, uint8_t *buffer, uint32_t bufferLength);
+void      eepromFlush ( void );
 void      eepromWriteU8 ( uint16_t addr, uint8_t value );
 void      eepromWriteS8 ( uint16_t addr, int8_t value );
 void      eepromWriteU16 ( uint16_t addr, uint16_t value );
@@ -129,12 +129,44 @@ mcp24aaError_e mcp24aaInit()
   return MCP24AA_ERROR_OK;
 }
 
+/**************************************************************************/
+/*! 
+    @brief Waits for an internal write cycle to finish.
+
+    The EEPROM doesn't acknowledge its address while it is busy writing
+    a page, so the address is sent until it is acknowledged (ACK
+    polling).  This typically takes much less than the maximum write
+    time in the datasheet.
+*/
+/**************************************************************************/
+static mcp24aaError_e mcp24aaWaitReady (uint16_t address)
+{
+  uint32_t start = systickGetTicks();
+
+  do
+  {
+    // Dummy write that only sets the address pointer
+    I2CWriteLength = 3;
+    I2CReadLength = 0;
+    I2CMasterBuffer[0] = MCP24AA_ADDR;
+    I2CMasterBuffer[1] = (address >> 8);
+    I2CMasterBuffer[2] = (address & 0xFF);
+    if (i2cEngine() == I2CSTATE_ACK)
+    {
+      return MCP24AA_ERROR_OK;
+    }
+  } while ((systickGetTicks() - start) < MCP24AA_WRITETIMEOUT / CFG_SYSTICK_DELAY_IN_MS + 1);
+
+  return MCP24AA_ERROR_TIMEOUT;
+}
+
 /**************************************************************************/
 /*! 
     @brief Reads the specified number of bytes from the supplied address.
 
     This function will read one or more bytes starting at the supplied
-    address.  A maximum of 8 bytes can be read in one operation.
+    address.  Reads longer than the I2C buffer are split into several
+    sequential reads.
 
     @param[in]  address
                 The 16-bit address where the read will start.  The maximum
@@ -147,46 +179,45 @@ mcp24aaError_e mcp24aaInit()
 /**************************************************************************/
 mcp24aaError_e mcp24aaReadBuffer (uint16_t address, uint8_t *buffer, uint32_t bufferLength)
 {
+  uint32_t i, len;
+
   if (!_mcp24aaInitialised) mcp24aaInit();
 
-  if (address >= MCP24AA_MAXADDR)
+  if ((address > MCP24AA_MAXADDR) || (bufferLength > MCP24AA_MAXADDR + 1 - address))
   {
     return MCP24AA_ERROR_ADDRERR;
   }
 
-  if (bufferLength > 8)
+  while (bufferLength)
   {
-    return MCP24AA_ERROR_BUFFEROVERFLOW;
-  }
-
-  // ToDo: Check if I2C is ready
+    len = bufferLength > I2C_BUFSIZE ? I2C_BUFSIZE : bufferLength;
+
+    // Write address bits to enable random read
+    I2CWriteLength = 3;
+    I2CReadLength = len;
+    I2CMasterBuffer[0] = MCP24AA_ADDR;                    // I2C device address
+    I2CMasterBuffer[1] = (address >> 8);                  // Address (high byte)
+    I2CMasterBuffer[2] = (address & 0xFF);                // Address (low byte)
+    // If you wish to read, you need to append the address w/read bit, though this
+    // needs to be placed one bit higher than the size of I2CWriteLength which 
+    // may be unexpected
+    I2CMasterBuffer[3] = MCP24AA_ADDR | MCP24AA_READBIT;  
+
+    // Transmit command
+    if (i2cEngine() != I2CSTATE_ACK)
+    {
+      return MCP24AA_ERROR_I2CBUSY;
+    }
 
-  // Clear buffers
-  uint32_t i;
-  for ( i = 0; i < I2C_BUFSIZE; i++ )
-  {
-    I2CMasterBuffer[i] = 0x00;
-    I2CSlaveBuffer[i] = 0x00;
-  }
+    // Fill response buffer
+    for (i = 0; i < len; i++)
+    {
+      buffer[i] = I2CSlaveBuffer[i];
+    }
 
-  // Write address bits to enable random read
-  I2CWriteLength = 3;
-  I2CReadLength = bufferLength;
-  I2CMasterBuffer[0] = MCP24AA_ADDR;                    // I2C device address
-  I2CMasterBuffer[1] = (address >> 8);                  // Address (high byte)
-  I2CMasterBuffer[2] = (address & 0xFF);                // Address (low byte)
-  // If you wish to read, you need to append the address w/read bit, though this
-  // needs to be placed one bit higher than the size of I2CWriteLength which 
-  // may be unexpected
-  I2CMasterBuffer[3] = MCP24AA_ADDR | MCP24AA_READBIT;  
-
-  // Transmit command
-  i2cEngine();
-
-  // Fill response buffer
-  for (i = 0; i < bufferLength; i++)
-  {
-    buffer[i] = I2CSlaveBuffer[i];
+    address += len;
+    buffer += len;
+    bufferLength -= len;
   }
 
   return MCP24AA_ERROR_OK;
@@ -197,7 +228,9 @@ mcp24aaError_e mcp24aaReadBuffer (uint16_t address, uint8_t *buffer, uint32_t bu
     @brief Writes the supplied bytes at a specified address.
 
     This function will write one or more bytes starting at the supplied
-    address.  A maximum of 8 bytes can be written in one operation.
+    address.  The data is split at page boundaries (MCP24AA_PAGESIZE),
+    and every page is written in a single write cycle.  The function
+    returns once the last write cycle has finished.
 
     @param[in]  address
                 The 16-bit address where the write will start.  The
@@ -211,44 +244,54 @@ mcp24aaError_e mcp24aaReadBuffer (uint16_t address, uint8_t *buffer, uint32_t bu
 /**************************************************************************/
 mcp24aaError_e mcp24aaWriteBuffer (uint16_t address, uint8_t *buffer, uint32_t bufferLength)
 {
+  mcp24aaError_e error;
+  uint32_t i, len;
+
   if (!_mcp24aaInitialised) mcp24aaInit();
 
-  if (address >= MCP24AA_MAXADDR)
+  if ((address > MCP24AA_MAXADDR) || (bufferLength > MCP24AA_MAXADDR + 1 - address))
   {
     return MCP24AA_ERROR_ADDRERR;
   }
 
-  if (bufferLength > 8)
+  while (bufferLength)
   {
-    return MCP24AA_ERROR_BUFFEROVERFLOW;
-  }
+    // Don't write past the end of the current page
+    len = MCP24AA_PAGESIZE - (address & (MCP24AA_PAGESIZE - 1));
+    if (len > bufferLength)
+    {
+      len = bufferLength;
+    }
 
-  // ToDo: Check if I2C is ready
+    // Write address bits and data to the master buffer
+    I2CWriteLength = 3 + len;
+    I2CReadLength = 0;
+    I2CMasterBuffer[0] = MCP24AA_ADDR;                // I2C device address
+    I2CMasterBuffer[1] = (address >> 8);              // Address (high byte)
+    I2CMasterBuffer[2] = (address & 0xFF);            // Address (low byte)
+    for (i = 0; i < len; i++)
+    {
+      I2CMasterBuffer[i+3] = buffer[i];
+    }
 
-  // Clear write buffer
-  uint32_t i;
-  for ( i = 0; i < I2C_BUFSIZE; i++ )
-  {
-    I2CMasterBuffer[i] = 0x00;
-  }
+    // Transmit command
+    if (i2cEngine() != I2CSTATE_ACK)
+    {
+      return MCP24AA_ERROR_I2CBUSY;
+    }
 
-  // Write address bits and data to the master buffer
-  I2CWriteLength = 3 + bufferLength;
-  I2CReadLength = 0;
-  I2CMasterBuffer[0] = MCP24AA_ADDR;                // I2C device address
-  I2CMasterBuffer[1] = (address >> 8);              // Address (high byte)
-  I2CMasterBuffer[2] = (address & 0xFF);            // Address (low byte)
-  for (i = 0; i < bufferLength; i++)
-  {
-    I2CMasterBuffer[i+3] = buffer[i];
-  }
+    // Wait for the write cycle to finish
+    error = mcp24aaWaitReady(address);
+    if (error)
+    {
+      return error;
+    }
 
-  // Transmit command
-  i2cEngine();
+    address += len;
+    buffer += len;
+    bufferLength -= len;
+  }
 
-  // Wait at least 10ms
-  systickDelay(10);
-  
   return MCP24AA_ERROR_OK;
 }
 
@@ -45,6 +45,8 @@
 #define MCP24AA_RW      0x01
 #define MCP24AA_READBIT 0x01
 #define MCP24AA_MAXADDR 0xFFF         // 4K = 4096
+#define MCP24AA_PAGESIZE 32           // Bytes per write cycle (must be a power of 2)
+#define MCP24AA_WRITETIMEOUT 10       // Max write cycle time in ms (5ms typical)
 
 typedef enum
 {
@@ -52,7 +54,8 @@ typedef enum
   MCP24AA_ERROR_I2CINIT,              // Unable to initialise I2C
   MCP24AA_ERROR_I2CBUSY,              // I2C already in use
   MCP24AA_ERROR_ADDRERR,              // Address out of range
-  MCP24AA_ERROR_BUFFEROVERFLOW,       // Max 8 bytes can be read/written in one operation
+  MCP24AA_ERROR_BUFFEROVERFLOW,       // Buffer too large for the operation
+  MCP24AA_ERROR_TIMEOUT,              // Timed out waiting for a write cycle to finish
   MCP24AA_ERROR_LAST
 }
 mcp24aaError_e;
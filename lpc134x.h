@@ -110,6 +110,12 @@
 #define SCB_CPUID_VARIANT_MASK                    ((unsigned int) 0x00F00000) // Variant
 #define SCB_CPUID_IMPLEMENTER_MASK                ((unsigned int) 0xFF000000) // Implementer
 
+/*  Interrupt Control and State Register */
+
+#define SCB_ICSR                                  (*(pREG32 (0xE000ED04)))
+#define SCB_ICSR_PENDSTSET_MASK                   ((unsigned int) 0x04000000) // SysTick exception is pending
+#define SCB_ICSR_PENDSTSET                        ((unsigned int) 0x04000000)
+
 /*  System Control Register */
 
 #define SCB_SCR                                   (*(pREG32 (0xE000ED10)))
@@ -206,6 +212,11 @@
 #define SCB_DFSR_EXTERNAL_MASK                    ((unsigned int) 0x00000010) // EDBGRQ signal asserted
 #define SCB_DFSR_EXTERNAL                         ((unsigned int) 0x00000010)
 
+/*  Debug Exception and Monitor Control Register */
+
+#define SCB_DEMCR_TRCENA_MASK                     ((unsigned int) 0x01000000) // Enable the DWT and ITM units
+#define SCB_DEMCR_TRCENA                          ((unsigned int) 0x01000000)
+
 /*  SCB_MEMREMAP (System memory remap register)
     The system memory remap register selects whether the ARM interrupt vectors are read
     from the boot ROM, the flash, or the SRAM.  */
@@ -1276,6 +1287,9 @@
 #define DWT_MASK3                                 (*(pREG32 (0xE0001054)))    // Mask register 3
 #define DWT_FUNCTION3                             (*(pREG32 (0xE0001058)))    // Function register 3
 
+#define DWT_CTRL_CYCCNTENA_MASK                   ((unsigned int) 0x00000001) // Enable the cycle counter
+#define DWT_CTRL_CYCCNTENA                        ((unsigned int) 0x00000001)
+
 /*##############################################################################
 ## Power Management Unit (PMU)
 ##############################################################################*/
@@ -2019,6 +2033,11 @@ static inline void NVIC_DisableIRQ(IRQn_t IRQn)
   NVIC->ICER[((uint32_t)(IRQn) >> 5)] = (1 << ((uint32_t)(IRQn) & 0x1F));
 }
 
+static inline void NVIC_SetPendingIRQ(IRQn_t IRQn)
+{
+  NVIC->ISPR[((uint32_t)(IRQn) >> 5)] = (1 << ((uint32_t)(IRQn) & 0x1F));
+}
+
 /*##############################################################################
 ## GPIO - General Purpose I/O
 ##############################################################################*/
@@ -3360,6 +3379,12 @@ static inline void NVIC_DisableIRQ(IRQn_t IRQn)
 #define ADC_AD0CR_START_MASK                      (0x07000000)
 #define ADC_AD0CR_START_NOSTART                   (0x00000000)
 #define ADC_AD0CR_START_STARTNOW                  (0x01000000)
+#define ADC_AD0CR_START_CT16B0_CAP0               (0x02000000)    // Start on an edge of PIO0_2/CT16B0_CAP0
+#define ADC_AD0CR_START_CT32B0_CAP0               (0x03000000)    // Start on an edge of PIO1_5/CT32B0_CAP0
+#define ADC_AD0CR_START_CT32B0_MAT0               (0x04000000)    // Start on an edge of CT32B0_MAT0
+#define ADC_AD0CR_START_CT32B0_MAT1               (0x05000000)    // Start on an edge of CT32B0_MAT1
+#define ADC_AD0CR_START_CT16B0_MAT0               (0x06000000)    // Start on an edge of CT16B0_MAT0
+#define ADC_AD0CR_START_CT16B0_MAT1               (0x07000000)    // Start on an edge of CT16B0_MAT1
 #define ADC_AD0CR_EDGE_MASK                       (0x08000000)
 #define ADC_AD0CR_EDGE_FALLING                    (0x08000000)
 #define ADC_AD0CR_EDGE_RISING                     (0x00000000)
@@ -50,6 +50,10 @@ void cmd_help(uint8_t argc, char **argv);         // handled by core/cmd/cmd.c
 void cmd_sysinfo(uint8_t argc, char **argv);
 void cmd_reset(uint8_t argc, char **argv);
 
+#ifdef CFG_INTERFACE_STATS
+void cmd_stats(uint8_t argc, char **argv);        // handled by core/cmd/cmd.c
+#endif
+
 #ifdef CFG_TFTLCD
 void cmd_backlight(uint8_t argc, char **argv);
 void cmd_button(uint8_t argc, char **argv);
@@ -97,6 +101,10 @@ void cmd_sd_dir(uint8_t argc, char **argv);
 void cmd_pwm(uint8_t argc, char **argv);
 #endif
 
+#ifdef CFG_PROFILE
+void cmd_profile(uint8_t argc, char **argv);
+#endif
+
 #ifdef CFG_JTAG
 void cmd_jtagread(uint8_t argc, char **argv);
 void cmd_jtagwrite(uint8_t argc, char **argv);
@@ -122,6 +130,10 @@ cmd_t cmd_tbl[] =
   { "V",    0,  0,  0, cmd_sysinfo           , "System Info"                    , CMD_NOPARAMS },
   { "Z",    0,  0,  0, cmd_reset             , "Reset"                          , CMD_NOPARAMS },
 
+  #ifdef CFG_INTERFACE_STATS
+  { "stats",0,  1,  0, cmd_stats             , "Command Statistics"             , "'stats [<r>]'" },
+  #endif
+
   #ifdef CFG_I2CEEPROM
   { "e",    1,  1,  0, cmd_i2ceeprom_read    , "EEPROM Read"                    , "'e <addr>'" },
   { "w",    2,  2,  0, cmd_i2ceeprom_write   , "EEPROM Write"                   , "'w <addr> <val>'" },
@@ -169,6 +181,10 @@ cmd_t cmd_tbl[] =
   { "M",    2,  2,  0,  cmd_pwm              , "PWM Control"                    , "'M [<dutycycle(%)>] [<frequency(ticks)>]'" },
   #endif
 
+  #ifdef CFG_PROFILE
+  { "pr",   0,  1,  0,  cmd_profile          , "Profiling"                      , "'pr [<h|t|r>]'" },
+  #endif
+
   #ifdef CFG_JTAG
   { "jr",   3,  3,  0,  cmd_jtagread         , "JTAG Read"                      , "'jr <port> <I|D> <bits>'" },
   { "jw",   3,  4,  0,  cmd_jtagwrite        , "JTAG Write"                     , "'jw <port> <I|D> <hexdata> [<padbits>]'" },
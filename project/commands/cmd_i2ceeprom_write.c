@@ -92,6 +92,7 @@ void cmd_i2ceeprom_write(uint8_t argc, char **argv)
 
   // Write data at supplied address
   eepromWriteU8(addr, val);
+  eepromFlush();
 
   // Write successful
   printf("0x%02X written at 0x%04X%s", val, addr, CFG_PRINTF_NEWLINE);
@@ -0,0 +1,159 @@
+/**************************************************************************/
+/*! 
+    @file     cmd_profile.c
+
+    @brief    Code to execute for cmd_profile in the 'core/cmd'
+              command-line interpretter.
+
+    @section LICENSE
+
+    Software License Agreement (BSD License)
+
+    Copyright (c) 2012, microBuilder SARL
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+    1. Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holders nor the
+    names of its contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ''AS IS'' AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**************************************************************************/
+#include <stdio.h>
+
+#include "projectconfig.h"
+#include "core/cmd/cmd.h"
+#include "project/commands.h"       // Generic helper functions
+
+#ifdef CFG_PROFILE
+  #include "core/profile/profile.h"
+
+#define CMD_PROFILE_CYCLES_PER_US   (PROFILE_CLOCK_HZ / 1000000)
+
+/**************************************************************************/
+/*! 
+    Prints the count, min/mean/max time and total time of every probe
+*/
+/**************************************************************************/
+static void cmd_profile_summary(void)
+{
+  profileProbe_t *probe;
+  profileProbe_t copy;
+
+  printf("%-16s %8s %10s %10s %10s %10s%s", "Probe", "Count", "Min (us)", "Mean (us)", "Max (us)", "Total (ms)", CFG_PRINTF_NEWLINE);
+  for (probe = profileGetProbes(); probe; probe = probe->next)
+  {
+    // Probes can be updated from interrupts while printing
+    profileGetProbe(probe, &copy);
+    if (copy.count == 0)
+      continue;
+    printf("%-16s %8u %10u %10u %10u %10u%s",
+           copy.name,
+           (unsigned int)copy.count,
+           (unsigned int)(copy.min / CMD_PROFILE_CYCLES_PER_US),
+           (unsigned int)(copy.total / copy.count / CMD_PROFILE_CYCLES_PER_US),
+           (unsigned int)(copy.max / CMD_PROFILE_CYCLES_PER_US),
+           (unsigned int)(copy.total / CMD_PROFILE_CYCLES_PER_US / 1000),
+           CFG_PRINTF_NEWLINE);
+  }
+}
+
+/**************************************************************************/
+/*! 
+    Prints the non-empty histogram buckets of every probe
+*/
+/**************************************************************************/
+static void cmd_profile_histogram(void)
+{
+  profileProbe_t *probe;
+  profileProbe_t copy;
+  uint32_t i;
+
+  for (probe = profileGetProbes(); probe; probe = probe->next)
+  {
+    profileGetProbe(probe, &copy);
+    if (copy.count == 0)
+      continue;
+    printf("%s%s", copy.name, CFG_PRINTF_NEWLINE);
+    for (i = 0; i < PROFILE_BUCKETS; i++)
+    {
+      if (copy.histogram[i])
+      {
+        printf("  >= %10u cycles : %u%s", (unsigned int)(1u << (i * 2)), (unsigned int)copy.histogram[i], CFG_PRINTF_NEWLINE);
+      }
+    }
+  }
+}
+
+/**************************************************************************/
+/*! 
+    Prints the ISR trace, with times relative to the oldest event
+*/
+/**************************************************************************/
+static void cmd_profile_trace(void)
+{
+  profileTraceEntry_t entry;
+  uint32_t start = 0, i;
+
+  for (i = 0; profileGetTraceEntry(i, &entry); i++)
+  {
+    if (i == 0)
+      start = entry.cycles;
+    printf("%10u us  IRQ %2u %s%s", 
+           (unsigned int)((entry.cycles - start) / CMD_PROFILE_CYCLES_PER_US),
+           entry.id, 
+           entry.exit ? "exit" : "enter", 
+           CFG_PRINTF_NEWLINE);
+  }
+}
+
+/**************************************************************************/
+/*! 
+    Profiling command handler.  With no argument, the probe summary is
+    printed.  'h' prints the histograms, 't' the ISR trace and 'r'
+    clears everything.
+*/
+/**************************************************************************/
+void cmd_profile(uint8_t argc, char **argv)
+{
+  if (argc == 0)
+  {
+    cmd_profile_summary();
+    return;
+  }
+
+  switch (argv[0][0])
+  {
+    case 'h':
+      cmd_profile_histogram();
+      break;
+    case 't':
+      cmd_profile_trace();
+      break;
+    case 'r':
+      profileReset();
+      printf("Profile cleared%s", CFG_PRINTF_NEWLINE);
+      break;
+    default:
+      printf("Invalid option [h|t|r]%s", CFG_PRINTF_NEWLINE);
+      break;
+  }
+}
+
+#endif
@@ -96,6 +96,14 @@
   #include "core/pwm/pwm.h"
 #endif
 
+#ifdef CFG_PROFILE
+  #include "core/profile/profile.h"
+#endif
+
+#ifdef CFG_SWTIMER
+  #include "core/swtimer/swtimer.h"
+#endif
+
 #ifdef CFG_SDCARD
   #include "core/ssp/ssp.h"
   #include "drivers/fatfs/diskio.h"
@@ -133,7 +141,13 @@
 void systemInit()
 {
   cpuInit();                                // Configure the CPU
+  #ifdef CFG_PROFILE
+    profileInit();                          // Start the DWT cycle counter
+  #endif
   systickInit(CFG_SYSTICK_DELAY_IN_MS);     // Start systick timer
+  #ifdef CFG_SWTIMER
+    swtimerInit();                          // Start the microsecond clock
+  #endif
   gpioInit();                               // Enable GPIO
   pmuInit();                                // Configure power management
 
@@ -300,6 +314,9 @@ int pf_getchar()
 static inline
 void __putchar(const char c) 
 {
+  #ifdef CFG_INTERFACE_STATS
+    cmdOutputBytes++;
+  #endif
   #ifdef CFG_PRINTF_USBCDC
     cdcBufferWrite(c);
   #elif defined(CFG_PRINTF_UART)
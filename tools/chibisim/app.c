@@ -0,0 +1,210 @@
+/*
+ * Chibi radio simulator - the application run by every node.
+ *
+ * Node 0 is the sink.  Every other node sends the scenario's messages to
+ * it, either one frame per message with chb_write() or through the
+ * chb_xport transport, and then keeps receiving until the host ends the
+ * scenario.  Messages carry the sender and a sequence number followed by
+ * a pattern derived from both, so the sink can detect corruption, loss
+ * and duplicates.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "sim.h"
+#include "core/systick/systick.h"
+#include "core/timer16/timer16.h"
+#include "drivers/rf/chibi/chb.h"
+#include "drivers/rf/chibi/chb_buf.h"
+#include "drivers/rf/chibi/chb_xport.h"
+#include "core/profile/profile.h"
+
+#define SIM_EXPORT          __attribute__((visibility("default")))
+#define SIM_SINK_ADDR       0x0001      // short address of node 0
+#define SIM_MSG_HDR         5           // [node] [seq, 32-bit LE]
+
+extern const simHost_t *simHost;
+extern int simNode;
+uint64_t simTime(void);
+
+static uint8_t appMsg[CHB_XPORT_REASM_SIZE];
+static uint32_t appNextSeq[SIM_MAX_NODES];
+static simResult_t appResult;
+
+static uint8_t appPattern(int node, uint32_t seq, int i)
+{
+  return (uint8_t)(seq * 7 + node * 31 + i);
+}
+
+static void appBuild(uint32_t seq)
+{
+  int i;
+
+  appMsg[0] = simNode;
+  appMsg[1] = seq;
+  appMsg[2] = seq >> 8;
+  appMsg[3] = seq >> 16;
+  appMsg[4] = seq >> 24;
+  for (i = SIM_MSG_HDR; i < simHost->scenario->size; i++)
+  {
+    appMsg[i] = appPattern(simNode, seq, i);
+  }
+}
+
+static void appCheck(U16 src, U8 *data, U16 len)
+{
+  uint32_t seq;
+  int node, i;
+
+  node = src - 1;
+  if (len != simHost->scenario->size || node <= 0 || node >= SIM_MAX_NODES || data[0] != node)
+  {
+    appResult.corrupt++;
+    return;
+  }
+
+  seq = data[1] | (data[2] << 8) | (data[3] << 16) | ((uint32_t)data[4] << 24);
+  for (i = SIM_MSG_HDR; i < len; i++)
+  {
+    if (data[i] != appPattern(node, seq, i))
+    {
+      appResult.corrupt++;
+      return;
+    }
+  }
+
+  if (seq < appNextSeq[node])
+  {
+    appResult.duplicates++;
+    return;
+  }
+  appNextSeq[node] = seq + 1;
+  appResult.received++;
+}
+
+static void appPoll(void)
+{
+  chb_rx_data_t rx;
+  U8 len;
+
+  if (simHost->scenario->xport)
+  {
+    chb_xport_poll();
+  }
+  else
+  {
+    while (chb_get_pcb()->data_rcv)
+    {
+      len = chb_read(&rx);
+      if (len)
+      {
+        appCheck(rx.src_addr, rx.data, len);
+      }
+    }
+  }
+
+  // the main loop costs time even when there is nothing to do
+  systickGetTicks();
+}
+
+static void appSend(void)
+{
+  const simScenario_t *sc = simHost->scenario;
+  uint32_t seq, start;
+  U8 status;
+
+  for (seq = 0; seq < (uint32_t)sc->messages; seq++)
+  {
+    appBuild(seq);
+    if (sc->xport)
+    {
+      status = chb_xport_send(SIM_SINK_ADDR, appMsg, sc->size);
+    }
+    else
+    {
+      status = chb_write(SIM_SINK_ADDR, appMsg, sc->size);
+    }
+
+    appResult.sent++;
+    switch (status)
+    {
+    case CHB_SUCCESS:
+      appResult.txdSuccess++;
+      break;
+    case CHB_NO_ACK:
+      appResult.txdNoAck++;
+      appResult.sendErrors++;
+      break;
+    case CHB_CHANNEL_ACCESS_FAILURE:
+      appResult.txdChannelFail++;
+      appResult.sendErrors++;
+      break;
+    default:
+      appResult.sendErrors++;
+      break;
+    }
+
+    // keep servicing the stack while waiting for the next message
+    start = systickGetMicroseconds();
+    do
+    {
+      appPoll();
+    } while (systickGetMicroseconds() - start < sc->interval);
+  }
+
+  if (sc->xport)
+  {
+    chb_xport_flush();
+  }
+}
+
+SIM_EXPORT void simNodeMain(void)
+{
+  chb_buf_stats_t *buf;
+  chb_xport_stats_t *xport;
+
+  chb_init();
+  if (simHost->scenario->xport)
+  {
+    chb_xport_init(appCheck);
+  }
+
+  if (simNode != 0)
+  {
+    // let every node finish its radio initialisation first
+    systickDelay(5);
+    appSend();
+  }
+  simHost->sendDone(simNode);
+
+  while (!simHost->stopping(simNode))
+  {
+    appPoll();
+  }
+
+  buf = chb_buf_get_stats();
+  appResult.rxFrames = buf->rcvd;
+  appResult.rxOverflow = buf->overflow;
+  appResult.rxPeak = buf->peak;
+  if (simHost->scenario->xport)
+  {
+    xport = chb_xport_get_stats();
+    appResult.xportRetransmits = xport->tx_retransmits;
+    appResult.xportDropped = xport->rx_dropped;
+    appResult.xportTimeouts = xport->rx_timeouts;
+    appResult.sendErrors = xport->tx_failed;
+  }
+  appResult.finished = simTime();
+
+#ifdef CFG_PROFILE
+  profileProbe_t *probe;
+  for (probe = profileGetProbes(); probe; probe = probe->next)
+  {
+    printf("node %d %-16s %8u calls  min %u  mean %u  max %u ns\n", simNode,
+           probe->name, probe->count, probe->min,
+           (uint32_t)(probe->total / probe->count), probe->max);
+  }
+#endif
+
+  simHost->finished(simNode, &appResult);
+}
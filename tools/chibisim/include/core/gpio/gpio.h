@@ -0,0 +1,62 @@
+/*
+ * Host stand-in for core/gpio/gpio.h, implemented by the simulated node.
+ */
+#ifndef _GPIO_H_
+#define _GPIO_H_
+
+#include "projectconfig.h"
+
+typedef enum gpioInterruptSense_e
+{
+  gpioInterruptSense_Edge = 0,
+  gpioInterruptSense_Level
+}
+gpioInterruptSense_t;
+
+typedef enum gpioInterruptEdge_e
+{
+  gpioInterruptEdge_Single = 0,
+  gpioInterruptEdge_Double
+}
+gpioInterruptEdge_t;
+
+typedef enum gpioInterruptEvent_e
+{
+  gpioInterruptEvent_ActiveHigh = 0,
+  gpioInterruptEvent_ActiveLow
+}
+gpioInterruptEvent_t;
+
+typedef enum gpioDirection_e
+{
+  gpioDirection_Input = 0,
+  gpioDirection_Output
+}
+gpioDirection_t;
+
+typedef enum gpioPullupMode_e
+{
+  gpioPullupMode_Inactive = 0,
+  gpioPullupMode_PullDown,
+  gpioPullupMode_PullUp,
+  gpioPullupMode_Repeater
+}
+gpioPullupMode_t;
+
+// IOCON registers used by the Chibi driver
+extern volatile uint32_t simIocon[4];
+#define IOCON_PIO1_8    (simIocon[0])
+#define IOCON_PIO1_9    (simIocon[1])
+#define IOCON_PIO1_10   (simIocon[2])
+#define IOCON_PIO1_11   (simIocon[3])
+
+void        gpioInit          ( void );
+void        gpioSetDir        ( uint32_t portNum, uint32_t bitPos, gpioDirection_t dir );
+uint32_t    gpioGetValue      ( uint32_t portNum, uint32_t bitPos );
+void        gpioSetValue      ( uint32_t portNum, uint32_t bitPos, uint32_t bitVal );
+void        gpioSetInterrupt  ( uint32_t portNum, uint32_t bitPos, gpioInterruptSense_t sense, gpioInterruptEdge_t edge, gpioInterruptEvent_t event );
+void        gpioIntEnable     ( uint32_t portNum, uint32_t bitPos );
+void        gpioIntDisable    ( uint32_t portNum, uint32_t bitPos );
+void        gpioSetPullup     ( volatile uint32_t *ioconRegister, gpioPullupMode_t mode );
+
+#endif
@@ -0,0 +1,23 @@
+/*
+ * Host stand-in for core/pmu/pmu.h.  The simulated node never sleeps, so
+ * suspend/resume hooks are accepted and ignored.
+ */
+#ifndef __PMU_H__
+#define __PMU_H__
+
+#include "projectconfig.h"
+
+typedef void (*pmuHook_t)(void);
+
+typedef enum
+{
+  PMU_ERROR_OK = 0,
+  PMU_ERROR_HOOKSFULL,
+  PMU_ERROR_INVALIDPIN,
+  PMU_ERROR_LAST
+}
+pmuError_e;
+
+pmuError_e pmuRegisterHooks(pmuHook_t suspend, pmuHook_t resume);
+
+#endif
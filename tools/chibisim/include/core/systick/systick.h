@@ -0,0 +1,13 @@
+/*
+ * Host stand-in for core/systick/systick.h, driven by the simulated clock.
+ */
+#ifndef _SYSTICK_H_
+#define _SYSTICK_H_
+
+#include "projectconfig.h"
+
+void systickDelay (uint32_t delayTicks);
+uint32_t systickGetTicks(void);
+uint32_t systickGetMicroseconds(void);
+
+#endif
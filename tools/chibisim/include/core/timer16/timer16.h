@@ -0,0 +1,13 @@
+/*
+ * Host stand-in for core/timer16/timer16.h, driven by the simulated clock.
+ */
+#ifndef __TIMER16_H__
+#define __TIMER16_H__
+
+#include "projectconfig.h"
+
+void timer16DelayUS(uint8_t timerNum, uint16_t delayInUS);
+void timer16Enable(uint8_t timerNum);
+void timer16Init(uint8_t timerNum, uint16_t timerInterval);
+
+#endif
@@ -0,0 +1,12 @@
+/*
+ * Host stand-in for drivers/storage/eeprom/eeprom.h, backed by RAM.
+ */
+#ifndef _EEPROM_H_
+#define _EEPROM_H_
+
+#include "projectconfig.h"
+
+void      eepromReadBuffer ( uint16_t addr, uint8_t *buffer, uint32_t bufferLength);
+void      eepromWriteBuffer ( uint16_t addr, uint8_t *buffer, uint32_t bufferLength);
+
+#endif
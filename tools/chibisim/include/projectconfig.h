@@ -0,0 +1,36 @@
+/*
+ * Host build configuration for the Chibi radio simulator.  This stands in
+ * for the firmware's projectconfig.h when the Chibi sources are compiled
+ * for Linux (see ../Makefile).
+ */
+#ifndef _PROJECTCONFIG_H_
+#define _PROJECTCONFIG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define CFG_CPU_CCLK                  (72000000)
+#define CFG_SYSTICK_DELAY_IN_MS       (1)
+#define CFG_PRINTF_NEWLINE            "\n"
+
+#define CFG_CHIBI
+#define CFG_CHIBI_MODE                (0)
+#define CFG_CHIBI_POWER               (0xE9)
+#define CFG_CHIBI_CHANNEL             (0)
+#define CFG_CHIBI_PANID               (0x1234)
+#ifndef CFG_CHIBI_PROMISCUOUS
+#define CFG_CHIBI_PROMISCUOUS         (0)
+#endif
+#ifndef CFG_CHIBI_RXFRAMES
+#define CFG_CHIBI_RXFRAMES            (2)
+#endif
+
+#define CFG_EEPROM_CHIBI_IEEEADDR     (0x0000)
+#define CFG_EEPROM_CHIBI_SHORTADDR    (0x0009)
+
+// interrupt masking, provided by the simulated node
+void __disable_irq(void);
+void __enable_irq(void);
+
+#endif
@@ -0,0 +1,641 @@
+/*
+ * Chibi radio simulator - one simulated node.
+ *
+ * This file replaces chb_spi.c and the LPC1343 peripherals the Chibi stack
+ * uses (GPIO, systick, timer16, EEPROM and interrupt masking).  The radio
+ * is modelled at the SPI level: the unmodified driver in chb_drvr.c talks
+ * to a register file, frame buffer and TRX state machine that behave like
+ * the AT86RF212's, and the host (sim.c) moves frames between the radios.
+ *
+ * Every access to the simulated hardware advances the node's clock and
+ * gives the host a chance to run the other nodes, so time only passes
+ * while the firmware is doing something.  The radio interrupt is taken at
+ * those same points whenever interrupts are enabled.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "sim.h"
+#include "projectconfig.h"
+#include "core/gpio/gpio.h"
+#include "core/systick/systick.h"
+#include "core/timer16/timer16.h"
+#include "core/pmu/pmu.h"
+#include "drivers/storage/eeprom/eeprom.h"
+#include "drivers/rf/chibi/chb.h"
+#include "drivers/rf/chibi/chb_drvr.h"
+#include "drivers/rf/chibi/chb_spi.h"
+
+#define SIM_EXPORT          __attribute__((visibility("default")))
+
+// cost of the simulated operations (us)
+#define SIM_SPI_BYTE_US     2       // chb_xfer_byte, waits for each byte
+#define SIM_SPI_BLOCK_US    1       // per byte of chb_xfer_block, FIFO kept full
+#define SIM_TICK_US         1       // reading the systick counter
+#define SIM_DELAY_STEP_US   16      // granularity of busy-wait delays
+
+const simHost_t *simHost;
+int simNode;
+
+static uint64_t simNow;
+static int simIrqEnabled = 1;
+static int simInIsr;
+static int simRadioIntEnabled;
+
+volatile uint32_t simIocon[4];
+static uint8_t simEeprom[64];
+
+// pin state: SSEL, RST and SLPTR
+static uint32_t simSsel = 1, simRst = 1, simSlptr;
+
+// AT86RF212 model
+static struct
+{
+  uint8_t   reg[0x40];
+  uint8_t   state;              // TRX_STATUS
+  uint8_t   trac;               // TRAC_STATUS of the last transmission
+  uint8_t   irqStatus;
+  uint8_t   irqLine;            // interrupt pending at the MCU
+  uint8_t   txBusy;
+  uint8_t   frame[1 + 127 + 1]; // PHR, PSDU, LQI
+} simRadio;
+
+// current SPI transaction
+static struct
+{
+  uint8_t   cmd;
+  uint8_t   addr;
+  uint8_t   value;
+  int       pos;
+} simSpi;
+
+/**************************************************************************/
+/*  Time and interrupts                                                   */
+/**************************************************************************/
+
+// runs the radio ISR if its interrupt is pending and may be taken
+static void simService(void)
+{
+  while (simRadio.irqLine && simIrqEnabled && !simInIsr && simRadioIntEnabled)
+  {
+    simRadio.irqLine = 0;
+    simInIsr = 1;
+    chb_ISR_Handler();
+    simInIsr = 0;
+  }
+}
+
+static void simAdvance(uint32_t us)
+{
+  simNow += us;
+  simHost->advance(simNode, simNow);
+  simService();
+}
+
+static void simDelay(uint32_t us)
+{
+  while (us)
+  {
+    uint32_t step = us > SIM_DELAY_STEP_US ? SIM_DELAY_STEP_US : us;
+    simAdvance(step);
+    us -= step;
+  }
+}
+
+void __disable_irq(void)
+{
+  simIrqEnabled = 0;
+}
+
+void __enable_irq(void)
+{
+  simIrqEnabled = 1;
+
+  // chb_tx() busy-waits on a flag set by the ISR without touching the
+  // hardware, so the wait for TRX_END is done here, at the end of the
+  // register write that started the transmission
+  if (simRadio.txBusy && !simInIsr)
+  {
+    while (simRadio.txBusy || simRadio.irqLine)
+    {
+      simAdvance(SIM_DELAY_STEP_US);
+    }
+  }
+  simService();
+}
+
+/**************************************************************************/
+/*  AT86RF212                                                             */
+/**************************************************************************/
+
+static void simRadioIrq(uint8_t mask)
+{
+  simRadio.irqStatus |= mask;
+  if (simRadio.reg[IRQ_MASK] & mask)
+  {
+    simRadio.irqLine = 1;
+  }
+}
+
+static void simRadioReset(void)
+{
+  memset(simRadio.reg, 0, sizeof(simRadio.reg));
+  simRadio.reg[PHY_CC_CCA] = 0x21;
+  simRadio.reg[TRX_CTRL_2] = 0x0c;
+  simRadio.state = TRX_OFF;
+  simRadio.trac = TRAC_INVALID;
+  simRadio.irqStatus = 0;
+  simRadio.irqLine = 0;
+  simRadio.txBusy = 0;
+}
+
+static uint8_t simRadioChannel(void)
+{
+  return simRadio.reg[PHY_CC_CCA] & 0x1f;
+}
+
+// IEEE 802.15.4 FCS, CRC-16/KERMIT sent LSB first
+static uint16_t simCrc(const uint8_t *data, int len)
+{
+  uint16_t crc = 0;
+  int i;
+
+  while (len--)
+  {
+    crc ^= *data++;
+    for (i = 0; i < 8; i++)
+    {
+      crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : crc >> 1;
+    }
+  }
+  return crc;
+}
+
+static void simRadioCommand(uint8_t cmd)
+{
+  uint8_t len;
+  uint16_t fcs;
+
+  if (simRadio.state == SLEEP)
+  {
+    return;
+  }
+
+  switch (cmd)
+  {
+  case CMD_TX_START:
+    if (simRadio.state != TX_ARET_ON && simRadio.state != PLL_ON)
+    {
+      break;
+    }
+    len = simRadio.frame[0] & 0x7f;
+    if (len < 2)
+    {
+      break;
+    }
+    fcs = simCrc(&simRadio.frame[1], len - 2);
+    simRadio.frame[len - 1] = fcs & 0xff;
+    simRadio.frame[len] = fcs >> 8;
+    simRadio.state = simRadio.state == TX_ARET_ON ? BUSY_TX_ARET : BUSY_TX;
+    simRadio.txBusy = 1;
+    simHost->transmit(simNode, &simRadio.frame[1], len, simRadioChannel(), simNow);
+    break;
+
+  case CMD_FORCE_TRX_OFF:
+  case CMD_TRX_OFF:
+    if (!simRadio.txBusy || cmd == CMD_FORCE_TRX_OFF)
+    {
+      simRadio.state = TRX_OFF;
+    }
+    break;
+
+  case CMD_FORCE_PLL_ON:
+  case CMD_PLL_ON:
+  case CMD_RX_ON:
+  case CMD_RX_AACK_ON:
+  case CMD_TX_ARET_ON:
+    if (!simRadio.txBusy)
+    {
+      simRadio.state = cmd == CMD_FORCE_PLL_ON ? PLL_ON : cmd;
+    }
+    break;
+
+  default:
+    break;
+  }
+}
+
+static uint8_t simRegRead(uint8_t addr)
+{
+  uint8_t val;
+
+  switch (addr)
+  {
+  case TRX_STATUS:
+    return simRadio.state;
+  case TRX_STATE:
+    return (simRadio.trac << CHB_TRAC_STATUS_POS) | (simRadio.reg[TRX_STATE] & 0x1f);
+  case IRQ_STATUS:
+    val = simRadio.irqStatus;
+    simRadio.irqStatus = 0;
+    return val;
+  case PART_NUM:
+    return CHB_AT86RF212_PART_NUM;
+  case VERSION_NUM:
+    return CHB_AT86RF212_VER_NUM;
+  case MAN_ID_0:
+    return 0x1f;
+  default:
+    return simRadio.reg[addr & 0x3f];
+  }
+}
+
+static void simRegWrite(uint8_t addr, uint8_t val)
+{
+  addr &= 0x3f;
+  switch (addr)
+  {
+  case TRX_STATUS:
+  case IRQ_STATUS:
+  case PART_NUM:
+  case VERSION_NUM:
+    break;
+  case TRX_STATE:
+    simRadio.reg[TRX_STATE] = val & 0x1f;
+    simRadioCommand(val & 0x1f);
+    break;
+  case IRQ_MASK:
+    simRadio.reg[IRQ_MASK] = val;
+    if (simRadio.irqStatus & val)
+    {
+      simRadio.irqLine = 1;
+    }
+    break;
+  default:
+    simRadio.reg[addr] = val;
+    break;
+  }
+}
+
+static uint8_t simSpiByte(uint8_t b)
+{
+  uint8_t ret = 0;
+  int idx;
+
+  if (simSsel)
+  {
+    return 0xff;
+  }
+
+  if (simSpi.pos++ == 0)
+  {
+    simSpi.cmd = b;
+    if ((b & 0xc0) == CHB_SPI_CMD_RR)
+    {
+      simSpi.value = simRegRead(b & 0x3f);
+    }
+    return 0;
+  }
+
+  idx = simSpi.pos - 2;
+  switch (simSpi.cmd & 0xe0)
+  {
+  case CHB_SPI_CMD_RR:
+  case CHB_SPI_CMD_RR | 0x20:
+    if (idx == 0)
+    {
+      ret = simSpi.value;
+    }
+    break;
+
+  case CHB_SPI_CMD_RW:
+  case CHB_SPI_CMD_RW | 0x20:
+    if (idx == 0)
+    {
+      simRegWrite(simSpi.cmd, b);
+    }
+    break;
+
+  case CHB_SPI_CMD_FR:
+    if (idx < (int)sizeof(simRadio.frame))
+    {
+      ret = simRadio.frame[idx];
+    }
+    break;
+
+  case CHB_SPI_CMD_FW:
+    if (idx < (int)sizeof(simRadio.frame))
+    {
+      simRadio.frame[idx] = b;
+    }
+    break;
+
+  case CHB_SPI_CMD_SR:
+  case CHB_SPI_CMD_SW:
+    // first byte after the command is the SRAM address
+    if (idx == 0)
+    {
+      simSpi.addr = b;
+    }
+    else if (simSpi.addr < sizeof(simRadio.frame))
+    {
+      if ((simSpi.cmd & 0xe0) == CHB_SPI_CMD_SR)
+      {
+        ret = simRadio.frame[simSpi.addr];
+      }
+      else
+      {
+        simRadio.frame[simSpi.addr] = b;
+      }
+      simSpi.addr++;
+    }
+    break;
+  }
+  return ret;
+}
+
+/**************************************************************************/
+/*  Radio model, called by the host                                       */
+/**************************************************************************/
+
+static int simRxMode(uint8_t channel)
+{
+  if (channel != simRadioChannel())
+  {
+    return 0;
+  }
+  switch (simRadio.state)
+  {
+  case RX_ON:
+    return 1;
+  case RX_AACK_ON:
+    return 2;
+  default:
+    return 0;
+  }
+}
+
+// extended mode address filter (data frames with short addresses)
+static int simAddressed(const uint8_t *psdu, uint8_t len, int *broadcast)
+{
+  uint16_t pan, dest;
+
+  if (len < CHB_HDR_SZ - 1 + CHB_FCS_LEN)
+  {
+    return 0;
+  }
+  pan = psdu[3] | (psdu[4] << 8);
+  dest = psdu[5] | (psdu[6] << 8);
+  *broadcast = dest == 0xffff;
+  if (pan != (simRadio.reg[PAN_ID_0] | (simRadio.reg[PAN_ID_1] << 8)) && pan != 0xffff)
+  {
+    return 0;
+  }
+  return *broadcast || dest == (simRadio.reg[SHORT_ADDR_0] | (simRadio.reg[SHORT_ADDR_1] << 8));
+}
+
+static int simWantsAck(const uint8_t *psdu, uint8_t len)
+{
+  int broadcast;
+
+  return simRadio.state == RX_AACK_ON && (psdu[0] & 0x20) &&
+         simAddressed(psdu, len, &broadcast) && !broadcast;
+}
+
+static void simReceive(const uint8_t *psdu, uint8_t len, int crcOk, uint8_t ed, uint8_t lqi)
+{
+  int broadcast;
+
+  if (simRadio.state == RX_AACK_ON && (!crcOk || !simAddressed(psdu, len, &broadcast)))
+  {
+    return;
+  }
+
+  simRadio.frame[0] = len;
+  memcpy(&simRadio.frame[1], psdu, len);
+  simRadio.frame[1 + len] = lqi;
+  simRadio.reg[PHY_ED_LEVEL] = ed;
+  simRadio.reg[PHY_RSSI] = (crcOk ? 0x80 : 0) | (ed / 3);
+  simRadioIrq(CHB_IRQ_RX_START_MASK | CHB_IRQ_TRX_END_MASK);
+}
+
+static void simTxDone(uint8_t status)
+{
+  simRadio.trac = status;
+  simRadio.txBusy = 0;
+  if (simRadio.state == BUSY_TX_ARET)
+  {
+    simRadio.state = TX_ARET_ON;
+  }
+  else if (simRadio.state == BUSY_TX)
+  {
+    simRadio.state = PLL_ON;
+  }
+  simRadioIrq(CHB_IRQ_TRX_END_MASK);
+}
+
+static const simRadio_t simRadioOps =
+{
+  simRxMode,
+  simWantsAck,
+  simReceive,
+  simTxDone
+};
+
+/**************************************************************************/
+/*  chb_spi.c                                                             */
+/**************************************************************************/
+
+void chb_spi_init()
+{
+  CHB_SPI_DISABLE();
+}
+
+U8 chb_xfer_byte(U8 data)
+{
+  U8 ret = simSpiByte(data);
+
+  simAdvance(SIM_SPI_BYTE_US);
+  return ret;
+}
+
+void chb_xfer_block(const U8 *tx, U8 *rx, U8 len)
+{
+  U8 i, b;
+
+  for (i = 0; i < len; i++)
+  {
+    b = simSpiByte(tx ? tx[i] : 0);
+    if (rx)
+    {
+      rx[i] = b;
+    }
+  }
+  simAdvance(len * SIM_SPI_BLOCK_US);
+}
+
+/**************************************************************************/
+/*  LPC1343 peripherals                                                   */
+/**************************************************************************/
+
+void gpioInit(void)
+{
+}
+
+void gpioSetDir(uint32_t portNum, uint32_t bitPos, gpioDirection_t dir)
+{
+}
+
+uint32_t gpioGetValue(uint32_t portNum, uint32_t bitPos)
+{
+  if (portNum == CHB_SLPTRPORT && bitPos == CHB_SLPTRPIN)
+  {
+    return simSlptr;
+  }
+  if (portNum == CHB_RSTPORT && bitPos == CHB_RSTPIN)
+  {
+    return simRst;
+  }
+  if (portNum == CHB_EINTPORT && bitPos == CHB_EINTPIN)
+  {
+    return !simRadio.irqLine;
+  }
+  return 0;
+}
+
+void gpioSetValue(uint32_t portNum, uint32_t bitPos, uint32_t bitVal)
+{
+  bitVal = bitVal ? 1 : 0;
+
+  if (portNum == CHB_SSPORT && bitPos == CHB_SSPIN)
+  {
+    // falling edge starts a new SPI transaction
+    if (simSsel && !bitVal)
+    {
+      simSpi.pos = 0;
+    }
+    simSsel = bitVal;
+  }
+  else if (portNum == CHB_RSTPORT && bitPos == CHB_RSTPIN)
+  {
+    if (!bitVal)
+    {
+      simRadioReset();
+    }
+    simRst = bitVal;
+  }
+  else if (portNum == CHB_SLPTRPORT && bitPos == CHB_SLPTRPIN)
+  {
+    if (bitVal && simRadio.state == TRX_OFF)
+    {
+      simRadio.state = SLEEP;
+    }
+    else if (!bitVal && simRadio.state == SLEEP)
+    {
+      simRadio.state = TRX_OFF;
+    }
+    simSlptr = bitVal;
+  }
+}
+
+void gpioSetInterrupt(uint32_t portNum, uint32_t bitPos, gpioInterruptSense_t sense, gpioInterruptEdge_t edge, gpioInterruptEvent_t event)
+{
+}
+
+void gpioIntEnable(uint32_t portNum, uint32_t bitPos)
+{
+  if (portNum == CHB_EINTPORT && bitPos == CHB_EINTPIN)
+  {
+    simRadioIntEnabled = 1;
+  }
+}
+
+void gpioIntDisable(uint32_t portNum, uint32_t bitPos)
+{
+  if (portNum == CHB_EINTPORT && bitPos == CHB_EINTPIN)
+  {
+    simRadioIntEnabled = 0;
+  }
+}
+
+void gpioSetPullup(volatile uint32_t *ioconRegister, gpioPullupMode_t mode)
+{
+}
+
+void timer16Init(uint8_t timerNum, uint16_t timerInterval)
+{
+}
+
+void timer16Enable(uint8_t timerNum)
+{
+}
+
+void timer16DelayUS(uint8_t timerNum, uint16_t delayInUs)
+{
+  simDelay(delayInUs);
+}
+
+pmuError_e pmuRegisterHooks(pmuHook_t suspend, pmuHook_t resume)
+{
+  return PMU_ERROR_OK;
+}
+
+void systickDelay(uint32_t delayTicks)
+{
+  simDelay(delayTicks * 1000 * CFG_SYSTICK_DELAY_IN_MS);
+}
+
+uint32_t systickGetTicks(void)
+{
+  simAdvance(SIM_TICK_US);
+  return (uint32_t)(simNow / (1000 * CFG_SYSTICK_DELAY_IN_MS));
+}
+
+uint32_t systickGetMicroseconds(void)
+{
+  return (uint32_t)simNow;
+}
+
+void eepromReadBuffer(uint16_t addr, uint8_t *buffer, uint32_t bufferLength)
+{
+  if (addr + bufferLength <= sizeof(simEeprom))
+  {
+    memcpy(buffer, &simEeprom[addr], bufferLength);
+  }
+}
+
+void eepromWriteBuffer(uint16_t addr, uint8_t *buffer, uint32_t bufferLength)
+{
+  if (addr + bufferLength <= sizeof(simEeprom))
+  {
+    memcpy(&simEeprom[addr], buffer, bufferLength);
+  }
+}
+
+/**************************************************************************/
+/*  Entry points                                                          */
+/**************************************************************************/
+
+uint64_t simTime(void)
+{
+  return simNow;
+}
+
+SIM_EXPORT const simRadio_t *simNodeEntry(const simHost_t *host, int node)
+{
+  int i;
+
+  simHost = host;
+  simNode = node;
+
+  // node n has short address n + 1 and a matching IEEE address
+  simEeprom[CFG_EEPROM_CHIBI_SHORTADDR] = (node + 1) & 0xff;
+  simEeprom[CFG_EEPROM_CHIBI_SHORTADDR + 1] = (node + 1) >> 8;
+  for (i = 0; i < 8; i++)
+  {
+    simEeprom[CFG_EEPROM_CHIBI_IEEEADDR + i] = i ? 0xa0 + i : node + 1;
+  }
+
+  simRadioReset();
+  return &simRadioOps;
+}
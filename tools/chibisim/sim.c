@@ -0,0 +1,727 @@
+/*
+ * Chibi radio simulator - scheduler and radio medium.
+ *
+ * Loads one copy of node.so per node and runs each node's firmware as a
+ * coroutine.  Every node keeps its own clock, advanced by the simulated
+ * hardware in node.c; the scheduler always resumes the node that is
+ * furthest behind and lets it run until it reaches the next medium event
+ * or gets too far ahead of the others.
+ *
+ * The medium models an 868 MHz O-QPSK channel (100 kb/s) shared by all
+ * nodes on the same channel: unslotted CSMA-CA, airtime, collisions
+ * between overlapping frames, random frame loss, extra delivery latency,
+ * automatic ACKs by receivers in RX_AACK_ON and frame retries by senders
+ * in TX_ARET_ON.
+ *
+ * usage: chibisim [options], see simUsage() below.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <ucontext.h>
+
+#include "sim.h"
+
+#define SIM_STACK_SIZE      (256 * 1024)
+#define SIM_MAX_EVENTS      1024
+#define SIM_MAX_AIR         256
+
+// 868 MHz O-QPSK PHY and 802.15.4 MAC timing (us)
+#define SIM_SYMBOL_US       40
+#define SIM_BYTE_US         80
+#define SIM_SHR_BYTES       6           // preamble, SFD and PHR
+#define SIM_CCA_US          (8 * SIM_SYMBOL_US)
+#define SIM_BACKOFF_US      (20 * SIM_SYMBOL_US)
+#define SIM_TURNAROUND_US   (12 * SIM_SYMBOL_US)
+#define SIM_ACK_WAIT_US     (54 * SIM_SYMBOL_US)
+#define SIM_ACK_LEN         5
+#define SIM_MIN_BE          3
+#define SIM_MAX_BE          5
+#define SIM_MAX_CSMA        4
+#define SIM_MAX_RETRIES     3
+
+// a node's transmissions take effect on other nodes no earlier than this,
+// so nodes may run this far ahead of each other
+#define SIM_LOOKAHEAD_US    (SIM_TURNAROUND_US + SIM_SHR_BYTES * SIM_BYTE_US)
+
+// TRAC_STATUS values reported to the radios
+#define SIM_TRAC_SUCCESS    0
+#define SIM_TRAC_CHAN_FAIL  3
+#define SIM_TRAC_NO_ACK     5
+
+// size limits of the node application
+#define SIM_MSG_HDR         5
+#define SIM_MAX_RAW         100         // CHB_MAX_PAYLOAD
+#define SIM_MAX_XPORT       (4 * 96)    // CHB_XPORT_REASM_SIZE
+
+typedef enum
+{
+  SIM_EV_ATTEMPT,                       // CSMA backoff expired, do CCA
+  SIM_EV_TX_END,                        // frame completely on air
+  SIM_EV_RX,                            // frame delivered to a receiver
+  SIM_EV_TX_DONE                        // report the outcome to the sender
+} simEventType_t;
+
+typedef struct
+{
+  uint64_t  time;
+  uint32_t  seq;
+  simEventType_t type;
+  int       node;
+  uint64_t  start;                      // SIM_EV_TX_END
+  uint8_t   status;                     // SIM_EV_TX_DONE
+  uint8_t   channel, crcOk, ed, lqi, len; // SIM_EV_RX
+  uint8_t   psdu[127];
+} simEvent_t;
+
+// a frame on the air
+typedef struct
+{
+  int       node;
+  uint8_t   channel;
+  uint64_t  start, end;
+} simAir_t;
+
+// the pending transmission of a node
+typedef struct
+{
+  uint8_t   psdu[127];
+  uint8_t   len;
+  uint8_t   channel;
+  int       nb, be, retries;
+} simTx_t;
+
+typedef struct
+{
+  void      *dl;
+  const simRadio_t *radio;
+  simNodeMain_t main;
+  ucontext_t ctx;
+  void      *stack;
+  uint64_t  now;
+  int       done;
+  int       sendDone;
+  int       reported;
+  simTx_t   tx;
+  simResult_t result;
+} simNode_t;
+
+static simScenario_t simScenario = { 2, 100, 20, 0, 0 };
+static uint32_t simLoss;                // per mille
+static uint32_t simLatency;             // us
+static int simCollisions = 1;
+static uint64_t simLimit = 60000000;    // us
+static uint64_t simDrain = 1000000;     // us after the last sender finished
+static uint64_t simSeed = 1;
+
+static simNode_t simNodes[SIM_MAX_NODES];
+static ucontext_t simSchedCtx;
+static int simCurrent;
+static uint64_t simHorizon;
+static int simSendersDone;
+static uint64_t simLastSendDone;
+
+static simEvent_t simEvents[SIM_MAX_EVENTS];
+static int simEventCount;
+static uint32_t simEventSeq;
+
+static simAir_t simAir[SIM_MAX_AIR];
+static int simAirCount;
+
+static struct
+{
+  uint32_t  frames, collisions, lost, missed, acks, acksLost;
+  uint32_t  busy, chanFail, noAck, retries;
+} simStats;
+
+/**************************************************************************/
+/*  Helpers                                                               */
+/**************************************************************************/
+
+static uint32_t simRandom(void)
+{
+  // xorshift64*
+  simSeed ^= simSeed >> 12;
+  simSeed ^= simSeed << 25;
+  simSeed ^= simSeed >> 27;
+  return (uint32_t)((simSeed * 0x2545f4914f6cdd1dULL) >> 32);
+}
+
+static uint64_t simMinTime(int except)
+{
+  uint64_t t = UINT64_MAX;
+  int i;
+
+  for (i = 0; i < simScenario.nodes; i++)
+  {
+    if (i != except && !simNodes[i].done && simNodes[i].now < t)
+    {
+      t = simNodes[i].now;
+    }
+  }
+  return t;
+}
+
+/**************************************************************************/
+/*  Event queue, a binary heap ordered by time and insertion order        */
+/**************************************************************************/
+
+static int simEventBefore(const simEvent_t *a, const simEvent_t *b)
+{
+  return a->time < b->time || (a->time == b->time && a->seq < b->seq);
+}
+
+static simEvent_t *simEventAdd(simEventType_t type, int node, uint64_t time)
+{
+  simEvent_t ev, tmp;
+  int i, p;
+
+  if (simEventCount == SIM_MAX_EVENTS)
+  {
+    fprintf(stderr, "chibisim: event queue full\n");
+    exit(1);
+  }
+
+  memset(&ev, 0, sizeof(ev));
+  ev.time = time;
+  ev.seq = simEventSeq++;
+  ev.type = type;
+  ev.node = node;
+
+  i = simEventCount++;
+  simEvents[i] = ev;
+  while (i > 0 && simEventBefore(&simEvents[i], &simEvents[p = (i - 1) / 2]))
+  {
+    tmp = simEvents[i];
+    simEvents[i] = simEvents[p];
+    simEvents[p] = tmp;
+    i = p;
+  }
+
+  // the running node must not pass an event it created
+  if (time < simHorizon)
+  {
+    simHorizon = time;
+  }
+  return &simEvents[i];
+}
+
+static void simEventPop(simEvent_t *ev)
+{
+  simEvent_t tmp;
+  int i = 0, c;
+
+  *ev = simEvents[0];
+  simEvents[0] = simEvents[--simEventCount];
+  for (;;)
+  {
+    c = 2 * i + 1;
+    if (c >= simEventCount)
+    {
+      break;
+    }
+    if (c + 1 < simEventCount && simEventBefore(&simEvents[c + 1], &simEvents[c]))
+    {
+      c++;
+    }
+    if (!simEventBefore(&simEvents[c], &simEvents[i]))
+    {
+      break;
+    }
+    tmp = simEvents[i];
+    simEvents[i] = simEvents[c];
+    simEvents[c] = tmp;
+    i = c;
+  }
+}
+
+/**************************************************************************/
+/*  Medium                                                                */
+/**************************************************************************/
+
+static void simAirAdd(int node, uint8_t channel, uint64_t start, uint64_t end)
+{
+  uint64_t old = simMinTime(-1);
+  int i, j;
+
+  // forget frames that ended long before anything still running
+  for (i = j = 0; i < simAirCount; i++)
+  {
+    if (simAir[i].end + 2 * SIM_ACK_WAIT_US >= old || simAir[i].end >= start)
+    {
+      simAir[j++] = simAir[i];
+    }
+  }
+  simAirCount = j;
+
+  if (simAirCount == SIM_MAX_AIR)
+  {
+    fprintf(stderr, "chibisim: too many frames on air\n");
+    exit(1);
+  }
+  simAir[simAirCount].node = node;
+  simAir[simAirCount].channel = channel;
+  simAir[simAirCount].start = start;
+  simAir[simAirCount].end = end;
+  simAirCount++;
+}
+
+// returns non-zero if a frame from a node other than 'node' (or from
+// 'node' itself if 'own' is set) overlaps [start, end)
+static int simAirOverlaps(int node, int own, uint8_t channel, uint64_t start, uint64_t end)
+{
+  int i;
+
+  for (i = 0; i < simAirCount; i++)
+  {
+    if ((simAir[i].node == node) == own && simAir[i].channel == channel &&
+        simAir[i].start < end && simAir[i].end > start)
+    {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static void simBackoff(int node, uint64_t now)
+{
+  simTx_t *tx = &simNodes[node].tx;
+
+  simEventAdd(SIM_EV_ATTEMPT, node, now + (simRandom() % (1u << tx->be)) * SIM_BACKOFF_US);
+}
+
+static void simTxDone(int node, uint64_t time, uint8_t status)
+{
+  simEventAdd(SIM_EV_TX_DONE, node, time)->status = status;
+}
+
+static void simAttempt(int node, uint64_t now)
+{
+  simTx_t *tx = &simNodes[node].tx;
+  uint64_t start;
+  simEvent_t *ev;
+
+  if (simAirOverlaps(node, 0, tx->channel, now, now + SIM_CCA_US))
+  {
+    simStats.busy++;
+    if (++tx->nb > SIM_MAX_CSMA)
+    {
+      simStats.chanFail++;
+      simTxDone(node, now + SIM_CCA_US, SIM_TRAC_CHAN_FAIL);
+      return;
+    }
+    if (tx->be < SIM_MAX_BE)
+    {
+      tx->be++;
+    }
+    simBackoff(node, now + SIM_CCA_US);
+    return;
+  }
+
+  start = now + SIM_CCA_US + SIM_TURNAROUND_US;
+  ev = simEventAdd(SIM_EV_TX_END, node, start + (SIM_SHR_BYTES + tx->len) * SIM_BYTE_US);
+  ev->start = start;
+  simAirAdd(node, tx->channel, start, ev->time);
+  simStats.frames++;
+}
+
+static void simTxEnd(int node, uint64_t start, uint64_t now)
+{
+  simTx_t *tx = &simNodes[node].tx;
+  int corrupt, acker = -1, mode, r;
+  uint64_t ackStart, ackEnd;
+  simEvent_t *ev;
+
+  corrupt = simCollisions && simAirOverlaps(node, 0, tx->channel, start, now);
+  if (corrupt)
+  {
+    simStats.collisions++;
+  }
+
+  for (r = 0; r < simScenario.nodes; r++)
+  {
+    if (r == node || simNodes[r].done)
+    {
+      continue;
+    }
+
+    // a radio that was transmitting itself cannot have received the frame
+    mode = simNodes[r].radio->rxMode(tx->channel);
+    if (!mode || simAirOverlaps(r, 1, tx->channel, start, now))
+    {
+      simStats.missed++;
+      continue;
+    }
+    if (simRandom() % 1000 < simLoss)
+    {
+      simStats.lost++;
+      continue;
+    }
+
+    ev = simEventAdd(SIM_EV_RX, r, now + simLatency);
+    memcpy(ev->psdu, tx->psdu, tx->len);
+    ev->len = tx->len;
+    ev->channel = tx->channel;
+    ev->crcOk = !corrupt;
+    ev->ed = 40 + simRandom() % 40;
+    ev->lqi = corrupt ? simRandom() % 128 : 255;
+    if (corrupt)
+    {
+      ev->psdu[simRandom() % tx->len] ^= 1 << (simRandom() % 8);
+    }
+    else if (mode == 2 && acker < 0 && simNodes[r].radio->wantsAck(tx->psdu, tx->len))
+    {
+      acker = r;
+    }
+  }
+
+  // data frames without an ACK request complete immediately
+  if (!(tx->psdu[0] & 0x20))
+  {
+    simTxDone(node, now, SIM_TRAC_SUCCESS);
+    return;
+  }
+
+  if (acker >= 0)
+  {
+    ackStart = now + SIM_TURNAROUND_US;
+    ackEnd = ackStart + (SIM_SHR_BYTES + SIM_ACK_LEN) * SIM_BYTE_US;
+    simAirAdd(acker, tx->channel, ackStart, ackEnd);
+    simStats.acks++;
+    if (simRandom() % 1000 >= simLoss)
+    {
+      simTxDone(node, ackEnd, SIM_TRAC_SUCCESS);
+      return;
+    }
+    simStats.acksLost++;
+  }
+
+  if (tx->retries++ >= SIM_MAX_RETRIES)
+  {
+    simStats.noAck++;
+    simTxDone(node, now + SIM_ACK_WAIT_US, SIM_TRAC_NO_ACK);
+    return;
+  }
+  simStats.retries++;
+  tx->nb = 0;
+  tx->be = SIM_MIN_BE;
+  simBackoff(node, now + SIM_ACK_WAIT_US);
+}
+
+static void simProcess(simEvent_t *ev)
+{
+  simNode_t *n = &simNodes[ev->node];
+
+  switch (ev->type)
+  {
+  case SIM_EV_ATTEMPT:
+    simAttempt(ev->node, ev->time);
+    break;
+  case SIM_EV_TX_END:
+    simTxEnd(ev->node, ev->start, ev->time);
+    break;
+  case SIM_EV_RX:
+    if (!n->done && n->radio->rxMode(ev->channel))
+    {
+      n->radio->receive(ev->psdu, ev->len, ev->crcOk, ev->ed, ev->lqi);
+    }
+    else
+    {
+      simStats.missed++;
+    }
+    break;
+  case SIM_EV_TX_DONE:
+    if (!n->done)
+    {
+      n->radio->txDone(ev->status);
+    }
+    break;
+  }
+}
+
+/**************************************************************************/
+/*  Host services                                                         */
+/**************************************************************************/
+
+static void hostAdvance(int node, uint64_t now)
+{
+  simNodes[node].now = now;
+  if (now > simHorizon)
+  {
+    swapcontext(&simNodes[node].ctx, &simSchedCtx);
+  }
+}
+
+static void hostTransmit(int node, const uint8_t *psdu, uint8_t len, uint8_t channel, uint64_t now)
+{
+  simTx_t *tx = &simNodes[node].tx;
+
+  memcpy(tx->psdu, psdu, len);
+  tx->len = len;
+  tx->channel = channel;
+  tx->nb = 0;
+  tx->be = SIM_MIN_BE;
+  tx->retries = 0;
+  simBackoff(node, now);
+}
+
+static void hostSendDone(int node)
+{
+  if (!simNodes[node].sendDone)
+  {
+    simNodes[node].sendDone = 1;
+    simSendersDone++;
+    if (simNodes[node].now > simLastSendDone)
+    {
+      simLastSendDone = simNodes[node].now;
+    }
+  }
+}
+
+static int hostStopping(int node)
+{
+  return simSendersDone == simScenario.nodes &&
+         simNodes[node].now > simLastSendDone + simDrain;
+}
+
+static void hostFinished(int node, const simResult_t *result)
+{
+  simNodes[node].result = *result;
+  simNodes[node].reported = 1;
+}
+
+static uint32_t hostRandom(void)
+{
+  return simRandom();
+}
+
+static const simHost_t simHost =
+{
+  hostAdvance,
+  hostTransmit,
+  hostSendDone,
+  hostStopping,
+  hostFinished,
+  hostRandom,
+  &simScenario
+};
+
+/**************************************************************************/
+/*  Scheduler                                                             */
+/**************************************************************************/
+
+static void simRun(void)
+{
+  simNodes[simCurrent].main();
+  simNodes[simCurrent].done = 1;
+}
+
+// loads a private copy of the node library, dlopen() would otherwise
+// return the same instance (and the same static state) for every node
+static void simLoad(int node, const char *path)
+{
+  simNode_t *n = &simNodes[node];
+  char tmp[] = "/tmp/chibisim-XXXXXX";
+  char buf[4096];
+  simNodeEntry_t entry;
+  FILE *in, *out;
+  size_t len;
+  int fd;
+
+  if ((fd = mkstemp(tmp)) < 0 || !(out = fdopen(fd, "wb")))
+  {
+    perror("chibisim: mkstemp");
+    exit(1);
+  }
+  if (!(in = fopen(path, "rb")))
+  {
+    perror(path);
+    exit(1);
+  }
+  while ((len = fread(buf, 1, sizeof(buf), in)) > 0)
+  {
+    fwrite(buf, 1, len, out);
+  }
+  fclose(in);
+  fclose(out);
+
+  n->dl = dlopen(tmp, RTLD_NOW | RTLD_LOCAL);
+  unlink(tmp);
+  if (!n->dl)
+  {
+    fprintf(stderr, "chibisim: %s\n", dlerror());
+    exit(1);
+  }
+
+  entry = (simNodeEntry_t)dlsym(n->dl, SIM_NODE_ENTRY);
+  n->main = (simNodeMain_t)dlsym(n->dl, SIM_NODE_MAIN);
+  if (!entry || !n->main)
+  {
+    fprintf(stderr, "chibisim: %s is not a node library\n", path);
+    exit(1);
+  }
+  n->radio = entry(&simHost, node);
+
+  n->stack = malloc(SIM_STACK_SIZE);
+  getcontext(&n->ctx);
+  n->ctx.uc_stack.ss_sp = n->stack;
+  n->ctx.uc_stack.ss_size = SIM_STACK_SIZE;
+  n->ctx.uc_link = &simSchedCtx;
+  makecontext(&n->ctx, simRun, 0);
+}
+
+static int simSchedule(void)
+{
+  simEvent_t ev;
+  uint64_t now, t;
+  int k;
+
+  for (;;)
+  {
+    // resume the node that is furthest behind
+    now = UINT64_MAX;
+    k = -1;
+    for (t = 0; t < (uint64_t)simScenario.nodes; t++)
+    {
+      if (!simNodes[t].done && simNodes[t].now < now)
+      {
+        now = simNodes[t].now;
+        k = (int)t;
+      }
+    }
+    if (k < 0)
+    {
+      return 0;
+    }
+    if (now > simLimit)
+    {
+      return 1;
+    }
+
+    // no node can create an event before 'now' any more
+    while (simEventCount && simEvents[0].time <= now)
+    {
+      simEventPop(&ev);
+      simProcess(&ev);
+    }
+
+    simHorizon = simMinTime(k) + SIM_LOOKAHEAD_US;
+    if (simEventCount && simEvents[0].time < simHorizon)
+    {
+      simHorizon = simEvents[0].time;
+    }
+    simCurrent = k;
+    swapcontext(&simSchedCtx, &simNodes[k].ctx);
+  }
+}
+
+/**************************************************************************/
+/*  Main                                                                  */
+/**************************************************************************/
+
+static void simUsage(void)
+{
+  fprintf(stderr,
+    "usage: chibisim [options]\n"
+    "  -n nodes      number of nodes, node 0 is the sink (2..%d, default 2)\n"
+    "  -m messages   messages sent by every other node (default 100)\n"
+    "  -s size       message size in bytes (default 20)\n"
+    "  -x            send through chb_xport instead of chb_write\n"
+    "  -i interval   delay between messages in us (default 0)\n"
+    "  -p loss       frame and ACK loss in per mille (default 0)\n"
+    "  -l latency    extra delivery latency in us (default 0)\n"
+    "  -C            do not corrupt overlapping frames\n"
+    "  -t seconds    simulated time limit (default 60)\n"
+    "  -S seed       random seed (default 1)\n"
+    "  -f library    node library (default node.so next to chibisim)\n",
+    SIM_MAX_NODES);
+  exit(1);
+}
+
+int main(int argc, char **argv)
+{
+  char path[4096], *lib = NULL, *p;
+  const simResult_t *r;
+  uint32_t expected, bytes;
+  int opt, i, timeout;
+
+  while ((opt = getopt(argc, argv, "n:m:s:xi:p:l:Ct:S:f:h")) != -1)
+  {
+    switch (opt)
+    {
+    case 'n': simScenario.nodes = atoi(optarg); break;
+    case 'm': simScenario.messages = atoi(optarg); break;
+    case 's': simScenario.size = atoi(optarg); break;
+    case 'x': simScenario.xport = 1; break;
+    case 'i': simScenario.interval = strtoul(optarg, NULL, 0); break;
+    case 'p': simLoss = strtoul(optarg, NULL, 0); break;
+    case 'l': simLatency = strtoul(optarg, NULL, 0); break;
+    case 'C': simCollisions = 0; break;
+    case 't': simLimit = strtoull(optarg, NULL, 0) * 1000000; break;
+    case 'S': simSeed = strtoull(optarg, NULL, 0) | 1; break;
+    case 'f': lib = optarg; break;
+    default:  simUsage();
+    }
+  }
+
+  if (simScenario.nodes < 2 || simScenario.nodes > SIM_MAX_NODES ||
+      simScenario.messages < 0 || simScenario.size < SIM_MSG_HDR ||
+      simScenario.size > (simScenario.xport ? SIM_MAX_XPORT : SIM_MAX_RAW) ||
+      simLoss > 1000)
+  {
+    simUsage();
+  }
+
+  if (!lib)
+  {
+    i = readlink("/proc/self/exe", path, sizeof(path) - 16);
+    path[i > 0 ? i : 0] = 0;
+    p = strrchr(path, '/');
+    strcpy(p ? p + 1 : path, "node.so");
+    lib = path;
+  }
+
+  for (i = 0; i < simScenario.nodes; i++)
+  {
+    simLoad(i, lib);
+  }
+  timeout = simSchedule();
+
+  printf("node  sent  err  rcvd  bad  dup  frames  ovfl  peak  xretx  xdrop  xtmo  done(ms)\n");
+  for (i = 0; i < simScenario.nodes; i++)
+  {
+    r = &simNodes[i].result;
+    if (!simNodes[i].reported)
+    {
+      printf("%4d  (did not finish)\n", i);
+      continue;
+    }
+    printf("%4d %5u %4u %5u %4u %4u %7u %5u %5u %6u %6u %5u %9.1f\n",
+           i, r->sent, r->sendErrors, r->received, r->corrupt, r->duplicates,
+           r->rxFrames, r->rxOverflow, r->rxPeak,
+           r->xportRetransmits, r->xportDropped, r->xportTimeouts,
+           r->finished / 1000.0);
+  }
+
+  printf("\nmedium: %u frames, %u collisions, %u lost, %u not received (radio busy), %u acks (%u lost), "
+         "%u busy CCAs, %u retries, %u channel access failures, %u no ack\n",
+         simStats.frames, simStats.collisions, simStats.lost, simStats.missed,
+         simStats.acks, simStats.acksLost, simStats.busy, simStats.retries,
+         simStats.chanFail, simStats.noAck);
+
+  expected = simScenario.messages * (simScenario.nodes - 1);
+  bytes = simNodes[0].result.received * simScenario.size;
+  printf("sink: %u of %u messages delivered (%.1f%%), %.2f kbit/s goodput until the last sender finished\n",
+         simNodes[0].result.received, expected,
+         expected ? 100.0 * simNodes[0].result.received / expected : 100.0,
+         simLastSendDone ? bytes * 8000.0 / simLastSendDone : 0.0);
+
+  if (timeout)
+  {
+    printf("time limit reached\n");
+  }
+  return timeout || simNodes[0].result.received != expected;
+}
@@ -0,0 +1,89 @@
+/*
+ * Chibi radio simulator - interface between the host (scheduler and radio
+ * medium, sim.c) and the simulated nodes (node.c + the Chibi stack, built
+ * as node.so and loaded once per node so that every node has its own copy
+ * of the stack's static state).
+ */
+#ifndef _SIM_H_
+#define _SIM_H_
+
+#include <stdint.h>
+
+#define SIM_MAX_NODES       16
+#define SIM_NODE_ENTRY      "simNodeEntry"
+
+// scenario parameters, shared by all nodes
+typedef struct
+{
+  int       nodes;
+  int       messages;       // messages sent by every node except node 0
+  int       size;           // message size in bytes
+  int       xport;          // 1 = chb_xport_send(), 0 = chb_write()
+  uint32_t  interval;       // delay between messages (us)
+} simScenario_t;
+
+// per-node results, filled in by the node when its application exits
+typedef struct
+{
+  uint32_t  sent;
+  uint32_t  sendErrors;
+  uint32_t  received;       // messages received intact
+  uint32_t  corrupt;        // messages with an unexpected length or content
+  uint32_t  duplicates;
+  uint32_t  txdSuccess, txdNoAck, txdChannelFail;
+  uint32_t  rxFrames, rxOverflow, rxPeak;
+  uint32_t  xportRetransmits, xportDropped, xportTimeouts;
+  uint64_t  finished;       // time the application returned (us)
+} simResult_t;
+
+// services the host provides to a node
+typedef struct
+{
+  // The node has advanced its clock to 'now' and must hand control back
+  // to the scheduler if it has run past its horizon
+  void      (*advance)(int node, uint64_t now);
+
+  // Starts a transmission of 'psdu' (including the FCS) with the radio's
+  // extended operating mode (CSMA, ACK wait and retries).  The outcome
+  // is reported through simRadio_t.txDone.
+  void      (*transmit)(int node, const uint8_t *psdu, uint8_t len, uint8_t channel, uint64_t now);
+
+  // The node's application has sent all of its messages
+  void      (*sendDone)(int node);
+
+  // Returns non-zero once the scenario is over and receivers should stop
+  int       (*stopping)(int node);
+
+  // Records that the node's application has returned
+  void      (*finished)(int node, const simResult_t *result);
+
+  uint32_t  (*random)(void);
+  const simScenario_t *scenario;
+} simHost_t;
+
+// services a node's radio model provides to the host
+typedef struct
+{
+  // Returns the receive mode: 0 = not receiving, 1 = RX_ON (basic),
+  // 2 = RX_AACK_ON (address filtering and automatic ACKs)
+  int       (*rxMode)(uint8_t channel);
+
+  // Returns non-zero if the radio would acknowledge this frame
+  int       (*wantsAck)(const uint8_t *psdu, uint8_t len);
+
+  // A frame has been received
+  void      (*receive)(const uint8_t *psdu, uint8_t len, int crcOk, uint8_t ed, uint8_t lqi);
+
+  // The current transmission finished with TRAC_STATUS 'status'
+  void      (*txDone)(uint8_t status);
+} simRadio_t;
+
+// Attaches a loaded node to the host and returns its radio model
+typedef const simRadio_t *(*simNodeEntry_t)(const simHost_t *host, int node);
+
+// Runs the node's firmware, returns when its application exits
+typedef void (*simNodeMain_t)(void);
+
+#define SIM_NODE_MAIN       "simNodeMain"
+
+#endif
@@ -0,0 +1,8 @@
+/*
+ * CRC test harness - stand-in for projectconfig.h.  CFG_CRC_TABLESIZE is
+ * set per object on the compiler command line.
+ */
+#ifndef _PROJECTCONFIG_H_
+#define _PROJECTCONFIG_H_
+
+#endif
@@ -74,7 +74,7 @@ int edToDBM(uint32_t ed)
     --------------------------------------------------
     CFG_CHIBI             -> Enabled
     CFG_CHIBI_PROMISCUOUS -> 0
-    CFG_CHIBI_BUFFERSIZE  -> 128
+    CFG_CHIBI_RXFRAMES    -> 2
 */
 /**************************************************************************/
 int main(void)
@@ -105,7 +105,7 @@ int main(void)
       // make sure the length is nonzero
       if (rx_data.len)
       {
-        int dbm = edToDBM(pcb->ed);
+        int dbm = edToDBM(rx_data.ed);
         printf("Message received from node %02X: %s, len=%d, dBm=%d.%s", rx_data.src_addr, rx_data.data, rx_data.len, dbm, CFG_PRINTF_NEWLINE);
       }
       // Disable LED
@@ -44,7 +44,22 @@
   #include "drivers/rf/chibi/chb.h"
   #include "drivers/rf/chibi/chb_drvr.h"
   #include "core/uart/uart.h"
-  static chb_rx_data_t rx_data;
+  static chb_rx_frame_t rx_frame;
+
+  // Set to 1 to send extended records, which only the Linux version of
+  // wsbridge understands.  The default is the original [len][frame]
+  // record that the Windows version expects.  Extended records carry the
+  // complete frame including the FCS plus the link metadata:
+  //
+  //   [0xC1] [len] [len bytes incl. FCS] [ed] [lqi] [flags] [timestamp, 32-bit LE us]
+  //
+  // flags bit 0 is set if the FCS was valid.  Frames with a bad FCS are
+  // only forwarded in extended records.
+  #ifndef SNIFFER_EXTENDED_RECORDS
+  #define SNIFFER_EXTENDED_RECORDS  0
+  #endif
+  #define SNIFFER_RECORD_EXT        0xC1
+  static uint8_t record[2 + 127 + 7];
 #endif
 
 #ifdef CFG_PRINTF_USBCDC
@@ -65,7 +80,7 @@
     --------------------------------------------------
     CFG_CHIBI             -> Enabled
     CFG_CHIBI_PROMISCUOUS -> 1
-    CFG_CHIBI_BUFFERSIZE  -> 1024   
+    CFG_CHIBI_RXFRAMES    -> 8   
 */
 /**************************************************************************/
 int main(void)
@@ -94,27 +109,50 @@ int main(void)
       // Check for incoming messages 
       while (pcb->data_rcv) 
       { 
-        // get the length of the data
-        rx_data.len = chb_read(&rx_data);
+        // get the length of the data (the frame stays in the chibi
+        // receive queue until chb_read_done is called)
+        chb_read_frame(&rx_frame);
         // make sure the length is nonzero
-        if (rx_data.len)
+        if (rx_frame.len && !rx_frame.crc && !SNIFFER_EXTENDED_RECORDS)
+        {
+          // the original record format has no way to flag a bad FCS
+          chb_read_done();
+        }
+        else if (rx_frame.len)
         {
           // Enable LED to indicate message reception 
           gpioSetValue (CFG_LED_PORT, CFG_LED_PIN, CFG_LED_ON); 
 
-          
-          // Send raw data the to PC for processing using wsbridge
-          uint8_t i;
-          for (i=0; i<rx_data.len; i++)
-          {
-            #ifdef CFG_PRINTF_UART
-              uartSendByte(rx_data.data[i]);
-            #endif
-            #ifdef CFG_PRINTF_USBCDC
+          // Build the record for wsbridge
+          uint32_t n = 0;
+          #if SNIFFER_EXTENDED_RECORDS == 1
+            record[n++] = SNIFFER_RECORD_EXT;
+            memcpy(&record[n], rx_frame.data, rx_frame.len + 1);
+            n += rx_frame.len + 1;
+            record[n++] = rx_frame.ed;
+            record[n++] = rx_frame.lqi;
+            record[n++] = rx_frame.crc ? 1 : 0;
+            record[n++] = rx_frame.timestamp & 0xFF;
+            record[n++] = (rx_frame.timestamp >> 8) & 0xFF;
+            record[n++] = (rx_frame.timestamp >> 16) & 0xFF;
+            record[n++] = (rx_frame.timestamp >> 24) & 0xFF;
+          #else
+            memcpy(record, rx_frame.data, rx_frame.len);
+            n = rx_frame.len;
+          #endif
+
+          // Send the record to the PC for processing using wsbridge
+          #ifdef CFG_PRINTF_UART
+            uartSend(record, n);
+          #endif
+          #ifdef CFG_PRINTF_USBCDC
+            uint32_t i;
+            for (i=0; i<n; i++)
+            {
                // ToDo: This really needs to be refactored!
               if (USB_Configuration) 
               {
-                cdcBufferWrite(rx_data.data[i]);
+                cdcBufferWrite(record[i]);
                 // Check if we can flush the buffer now or if we need to wait
                 unsigned int currentTick = systickGetTicks();
                 if (currentTick != lastTick)
@@ -132,8 +170,11 @@ int main(void)
                   lastTick = currentTick;
                 }
               }  
-            #endif
-          }
+            }
+          #endif
+
+          // Release the frame descriptor
+          chb_read_done();
 
           // Disable LED
           gpioSetValue (CFG_LED_PORT, CFG_LED_PIN, CFG_LED_OFF); 
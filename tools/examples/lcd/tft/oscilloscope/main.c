@@ -34,6 +34,7 @@
 */
 /**************************************************************************/
 #include <stdio.h>
+#include <string.h>
 
 #include "projectconfig.h"
 #include "sysinit.h"
@@ -45,24 +46,35 @@
 #include "drivers/displays/tft/lcd.h"
 #include "drivers/displays/tft/drawing.h"
 #include "drivers/displays/tft/touchscreen.h"
+#include "drivers/displays/tft/controls/scope.h"
 #include "drivers/displays/tft/fonts/dejavusans9.h"
 #include "drivers/displays/tft/fonts/dejavusansbold9.h"
 
-static uint8_t adcBuffer[10] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-static uint8_t digBuffer[10] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+#define SCOPE_WIDTH         (226)     // One sample per pixel
+#define SCOPE_SAMPLERATE    (2500)    // 25 samples per 25 pixel division = 10ms/Div
+#define SCOPE_TRIGGERLEVEL  (512)     // ~1.65V
+#define DIGITAL_PERIOD      (10)      // Digital samples are taken every 10ms
+
+static scope_t scope;
+static uint8_t adcSpans[SCOPE_WIDTH * 2];
+static uint8_t digSpans[SCOPE_WIDTH * 2];
+static uint16_t adcFrame[SCOPE_WIDTH];
+static uint16_t digFrame[SCOPE_WIDTH];
+static uint16_t adcRing[256];
+static scopeTrigger_t trigger = { SCOPE_TRIGGERLEVEL, SCOPE_EDGE_RISING, SCOPE_WIDTH * 2 };
 
 bool adcEnabled = true;
 bool digEnabled = false;
 
 /**************************************************************************/
 /*! 
-    Renders the frame around the data grid
+    Renders the frame around the data grid and an empty data grid
 */
 /**************************************************************************/
 void renderLCDFrame(void)
 {
   // Clear the screen
-  drawFill(COLOR_DARKGRAY);
+  drawFill(COLOR_GRAY_80);
 
   // Render V references
   fontsDrawString(245,  27, COLOR_BLACK, &dejaVuSansBold9ptFontInfo, "3.5V");
@@ -71,19 +83,16 @@ void renderLCDFrame(void)
   fontsDrawString(244, 194, COLOR_WHITE, &dejaVuSansBold9ptFontInfo, "0.0V");
 
   // Div settings
-  fontsDrawString( 10, 10, COLOR_BLACK, &dejaVuSansBold9ptFontInfo, "~100ms/Div");
-  fontsDrawString(  9,  9, COLOR_WHITE, &dejaVuSansBold9ptFontInfo, "~100ms/Div");
+  fontsDrawString( 10, 10, COLOR_BLACK, &dejaVuSansBold9ptFontInfo, "10ms/Div");
+  fontsDrawString(  9,  9, COLOR_WHITE, &dejaVuSansBold9ptFontInfo, "10ms/Div");
   fontsDrawString( 95, 10, COLOR_BLACK, &dejaVuSansBold9ptFontInfo, "500mV/Div");
   fontsDrawString( 94,  9, COLOR_WHITE, &dejaVuSansBold9ptFontInfo, "500mV/Div");
 
-  // Clear the ADC output level just in case
-  drawRectangleFilled(175, 5, 250, 18, COLOR_DARKGRAY);
-
   // Render the channel text
   fontsDrawString( 25, 220, COLOR_BLACK,  &dejaVuSansBold9ptFontInfo, "P1.4 (Analog)");
-  fontsDrawString( 24, 219, adcEnabled ? COLOR_YELLOW : COLOR_MEDIUMGRAY, &dejaVuSansBold9ptFontInfo, "P1.4 (Analog)");
+  fontsDrawString( 24, 219, adcEnabled ? COLOR_YELLOW : COLOR_GRAY_128, &dejaVuSansBold9ptFontInfo, "P1.4 (Analog)");
   fontsDrawString(135, 220, COLOR_BLACK,  &dejaVuSansBold9ptFontInfo, "P2.0 (Digital)");
-  fontsDrawString(134, 219, digEnabled ? COLOR_GREEN : COLOR_MEDIUMGRAY, &dejaVuSansBold9ptFontInfo, "P2.0 (Digital)");
+  fontsDrawString(134, 219, digEnabled ? COLOR_GREEN : COLOR_GRAY_128, &dejaVuSansBold9ptFontInfo, "P2.0 (Digital)");
 
   // ADC Warning
   fontsDrawString(245,  80, COLOR_BLACK, &dejaVuSansBold9ptFontInfo, "Warning:");
@@ -91,110 +100,54 @@ void renderLCDFrame(void)
   fontsDrawString(244,  95, COLOR_WHITE, &dejaVuSans9ptFontInfo, "ADC input");
   fontsDrawString(244, 110, COLOR_WHITE, &dejaVuSans9ptFontInfo, "is not 5.0V");
   fontsDrawString(244, 125, COLOR_WHITE, &dejaVuSans9ptFontInfo, "tolerant!");
-}
 
-/**************************************************************************/
-/*! 
-    Converts the supplied 8-bit value to an approximate pixel height in
-    the data grid
-*/
-/**************************************************************************/
-uint16_t adcValToPixel(uint8_t value)
-{
-  // Since the chart is 175 pixels high and 3.3V is at
-  // approximately 165 pixels height, we need to
-  // divide the 8 bit ADC readings by 1.545 (255/165)
-  // using fixed point math, and then substract
-  // the number from the bottom of the frame
-  uint16_t pixel = 0;
-  pixel = 200 - (value * 1000 / 1545);
-  return pixel;
+  // Draw the border and the empty grid (this also resets the traces)
+  drawRectangle(9, 24, 236, 201, COLOR_GRAY_200);
+  scopeInit(&scope);
 }
 
 /**************************************************************************/
 /*! 
-    Redraws the grid and renders the data points on the LCD
+    Renders the latest ADC value in text
 */
 /**************************************************************************/
-void renderLCDGrid(void)
+void renderLCDValue(uint16_t value)
 {
-  if ((!adcEnabled) && (!digEnabled))
-  {    
-    return;
-  }
+  static uint16_t lastValue = 0xFFFF;
+  char text[10];
+  uint32_t mV;
 
-  // Redraw the grid
-  drawRectangle(9, 24, 236, 201, COLOR_LIGHTGRAY);
-  drawRectangleFilled(10, 25, 235, 200, COLOR_BLACK);
-
-  // Horizontal lines
-  drawLine(10,  50, 235,  50, COLOR_DARKERGRAY);
-  drawLine(10,  75, 235,  75, COLOR_DARKERGRAY);
-  drawLine(10, 100, 235, 100, COLOR_DARKERGRAY);
-  drawLine(10, 125, 235, 125, COLOR_DARKERGRAY);
-  drawLine(10, 150, 235, 150, COLOR_DARKERGRAY);
-  drawLine(10, 175, 235, 175, COLOR_DARKERGRAY);
-
-  // Vertical lines
-  drawLine( 35, 25,  35, 200, COLOR_DARKERGRAY);
-  drawLine( 60, 25,  60, 200, COLOR_DARKERGRAY);
-  drawLine( 85, 25,  85, 200, COLOR_DARKERGRAY);
-  drawLine(110, 25, 110, 200, COLOR_DARKERGRAY);
-  drawLine(135, 25, 135, 200, COLOR_DARKERGRAY);
-  drawLine(160, 25, 160, 200, COLOR_DARKERGRAY);
-  drawLine(185, 25, 185, 200, COLOR_DARKERGRAY);
-  drawLine(210, 25, 210, 200, COLOR_DARKERGRAY);
-
-  // Render the individual data points
-  uint32_t counter;
-  for (counter = 0; counter < 9; counter++)
+  // Only redraw the text when it changes
+  if (value == lastValue)
   {
-    // Draw historical data
-    uint32_t arrayPosition = 9 - counter;
-
-    // Draw analog data points (Yellow)
-    if (adcEnabled)
-    {
-      drawLine(10 + counter * 25, adcValToPixel(adcBuffer[arrayPosition]), 10 + (counter + 1) * 25, adcValToPixel(adcBuffer[arrayPosition - 1]), COLOR_YELLOW);
-    }
-
-    // Draw digital data points (Green)
-    if (digEnabled)
-    {
-      drawLine(10 + counter * 25, adcValToPixel(digBuffer[arrayPosition]), 10 + (counter + 1) * 25, adcValToPixel(digBuffer[arrayPosition - 1]), COLOR_GREEN);
-    }
-  }
-
-  // Render ADC value in text if present
-  if (adcEnabled)
-  {
-    char text[10];
-    // Assuming 3.3V supply and 8-bit ADC values, 1 unit = 12.89mV (3300/256)
-    sprintf(text, "%u.%u V", ((adcBuffer[0] * 1289) / 100) / 1000, ((adcBuffer[0] * 1294) / 100) % 1000);
-    // Clear the previous text
-    drawRectangleFilled(175, 5, 250, 18, COLOR_DARKGRAY);
-    // Render the latest value in mV
-    fontsDrawString(180, 10, COLOR_BLACK, &dejaVuSansBold9ptFontInfo, text);
-    fontsDrawString(179,  9, COLOR_YELLOW, &dejaVuSansBold9ptFontInfo, text);
+    return;
   }
+  lastValue = value;
+
+  // Assuming 3.3V supply and 10-bit ADC values
+  mV = (value * 3300) / 1024;
+  sprintf(text, "%u.%02u V", (unsigned int)(mV / 1000), (unsigned int)((mV % 1000) / 10));
+  // Clear the previous text
+  drawRectangleFilled(175, 5, 250, 18, COLOR_GRAY_80);
+  // Render the latest value
+  fontsDrawString(180, 10, COLOR_BLACK, &dejaVuSansBold9ptFontInfo, text);
+  fontsDrawString(179,  9, COLOR_YELLOW, &dejaVuSansBold9ptFontInfo, text);
 }
 
 /**************************************************************************/
 /*! 
-    Shifts the buffer contents right one byte, and inserts the latest
-    value at the beginning.
+    Starts sampling AD5 in the background at SCOPE_SAMPLERATE
 */
 /**************************************************************************/
-void addToBuffer(uint8_t *buffer, uint8_t value)
+void startAcquisition(void)
 {
-  uint32_t counter;
-  for (counter = 9; counter > 0; counter--)
-  {
-    buffer[counter] = buffer[counter - 1];
-  }
+  adcContinuousSetBuffer(5, adcRing, sizeof(adcRing) / sizeof(adcRing[0]));
+  adcContinuousStart(ADC_AD0CR_SEL_AD5, ADC_TRIGGER_CT16B0, SCOPE_SAMPLERATE, 0);
 
-  // Append the latest value
-  buffer[0] = value;
+  // Start looking for a new trigger
+  trigger.triggered = false;
+  trigger.captured = 0;
+  trigger.waited = 0;
 }
 
 /**************************************************************************/
@@ -212,6 +165,10 @@ int main(void)
     #error "CFG_INTERFACE must be disabled in projectconfig.h for this test (to save space)"
   #endif
 
+  tsTouchData_t touch;
+  uint32_t lastTouch, touchDelay, lastDigital;
+  bool frameDone;
+
   // Configure cpu and mandatory peripherals
   systemInit();
   
@@ -225,48 +182,75 @@ int main(void)
   IOCON_PIO1_4 |=  (IOCON_PIO1_4_FUNC_AD5 &
                     IOCON_PIO1_4_ADMODE_ANALOG);
 
+  // The grid is 175 pixels high with 3.5V at the top, and the 10-bit
+  // ADC readings go up to 3.3V (1023)
+  scope.x = 10;
+  scope.y = 25;
+  scope.width = SCOPE_WIDTH;
+  scope.height = 176;
+  scope.gridX = 25;
+  scope.gridY = 25;
+  scope.colorBackground = COLOR_BLACK;
+  scope.colorGrid = COLOR_GRAY_50;
+  scope.minValue = 0;
+  scope.maxValue = 1085;
+  scopeSetTrace(&scope, 0, COLOR_YELLOW, adcSpans);
+  scopeSetTrace(&scope, 1, COLOR_GREEN, digSpans);
+
   // Rotate the screen and render the area around the data grid
   lcdSetOrientation(LCD_ORIENTATION_LANDSCAPE);
   renderLCDFrame();
 
-  tsTouchData_t touch;
+  if (adcEnabled) startAcquisition();
+  lastTouch = lastDigital = systickGetTicks();
+  touchDelay = 100;
 
-  // Start reading
   while (1)
   {
-    // Wait up to 5ms for a touch event
-    tsTouchError_t error = tsWaitForEvent(&touch, 5);
-    if (!error)
+    // Render a new analog trace as soon as a triggered frame is ready
+    frameDone = adcEnabled && scopeCapture(&trigger, 5, adcFrame, SCOPE_WIDTH);
+    if (frameDone)
     {
-      if (touch.x > 25 && touch.x < 100 && touch.y > 210)
-      {
-        // Analog switch selected
-        adcEnabled = adcEnabled ? false : true;
-      }
-      if (touch.x > 125 && touch.x < 200 && touch.y > 210)
+      scopeRenderTrace(&scope, 0, adcFrame, SCOPE_WIDTH);
+      renderLCDValue(adcFrame[SCOPE_WIDTH - 1]);
+    }
+
+    // The touch screen also uses the ADC, so the acquisition is paused
+    // while it is checked (every 100ms, or 500ms after a touch).  This
+    // is only done between two frames, since restarting the acquisition
+    // starts the search for a trigger over again.
+    if ((frameDone || !adcEnabled) && (systickGetTicks() - lastTouch >= touchDelay))
+    {
+      adcContinuousStop();
+      touchDelay = 100;
+      if (!tsWaitForEvent(&touch, 1))
       {
-        // Digital switch selected
-        digEnabled = digEnabled ? false : true;
+        if (touch.xlcd > 25 && touch.xlcd < 100 && touch.ylcd > 210)
+        {
+          // Analog switch selected
+          adcEnabled = adcEnabled ? false : true;
+        }
+        if (touch.xlcd > 125 && touch.xlcd < 200 && touch.ylcd > 210)
+        {
+          // Digital switch selected
+          digEnabled = digEnabled ? false : true;
+        }
+        // Refresh the frame
+        renderLCDFrame();
+        touchDelay = 500;
       }
-      // Refresh the frame
-      renderLCDFrame();
+      if (adcEnabled) startAcquisition();
+      lastTouch = systickGetTicks();
     }
 
-    // Read pins
-    if (adcEnabled)
-      addToBuffer(adcBuffer, adcRead(5) / 4); // 10-bit value converted to 8-bits
-    if (digEnabled)
-      addToBuffer(digBuffer, gpioGetValue(2, 0) ? 0xFF : 0x00);
-
-    // Update the LCD is required
-    renderLCDGrid();
-
-    // Note, this will actually mean the timing is ~100mS + the amount of
-    // time it took to get the readings and update the LCD
-    // A timer interrupt could be used to get much more accurate results,
-    // filling the buffer inside the IRQ and rendering the screen updates
-    // every x milliseconds
-    systickDelay(100);
+    // The digital trace scrolls from right to left
+    if (digEnabled && (systickGetTicks() - lastDigital >= DIGITAL_PERIOD))
+    {
+      lastDigital = systickGetTicks();
+      memmove(digFrame, &digFrame[1], (SCOPE_WIDTH - 1) * sizeof(digFrame[0]));
+      digFrame[SCOPE_WIDTH - 1] = gpioGetValue(2, 0) ? 1023 : 0;
+      scopeRenderTrace(&scope, 1, digFrame, SCOPE_WIDTH);
+    }
   }
 
   return 0;
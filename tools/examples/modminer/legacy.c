@@ -22,6 +22,9 @@
 
 static uint32_t elen;
 
+// Broadcast programming state
+static uint8_t bchunk, bwindow, bunacked, bmask;
+
 uint8_t fpgamax;
 uint8_t fpgaidx[5] = {0,0,0,0,0xff};
 uint8_t bcs[5];
@@ -168,12 +171,28 @@ void fpgaSetRegister(uint8_t jtag, uint8_t addr, uint32_t nv)
 	jtagRun(jtag);
 }
 
+// Selects the FPGAs in 'mask' (bit n = FPGA index n) for JTAG_BROADCAST
+static void fpgaSelect(uint8_t mask)
+{
+	uint8_t i;
+	for (i=0; i<fpgamax; ++i)
+		jtagSetActive(fpgaidx[i], (mask >> i) & 1);
+}
+
 bool lmmRx(uint8_t c)
 {
 	// Old ModMiner protocol
 	uint8_t jtag, x;
 	msg[msglen++] = c;
-	jtag = fpgaidx[msg[1]];
+	jtag = 0xff;
+	if (msglen >= 2 && msg[0] != 0xf)
+	{
+		// msg[1] is the FPGA index (0xf uses it as a mask, then for data).
+		// Drop requests for FPGAs that Get FPGA Count didn't find.
+		if (msg[1] >= fpgamax)
+			return true;
+		jtag = fpgaidx[msg[1]];
+	}
 	switch (msg[0]) {
 	case 0:  // Ping Pong
 		pf_write("\0", 1);
@@ -365,6 +384,90 @@ bool lmmRx(uint8_t c)
         pf_write(&msg[2], bytes + 1);
         return true;
     }
+    case 0xf:  // Program Bitstream (broadcast)
+		// Programs every selected FPGA in parallel from a single stream.
+		// Request: mask (0 = all), length (32-bit LE), chunk size (bytes,
+		// multiple of 4 up to 252, 0 = 32), ack window (chunks, 0 = 1).
+		// Each window of chunks is acknowledged with 1, and the final
+		// reply is one status byte per FPGA: 1 = done, 0 = failed,
+		// 0xff = not selected.
+		switch (step) {
+		case 0:
+		{
+			uint8_t i, j;
+			if (msglen < 8)
+				break;
+			bmask = msg[1] ? msg[1] : 0xff;
+			elen = msg[2] | ((uint32_t)msg[3] << 8) | ((uint32_t)msg[4] << 16) | ((uint32_t)msg[5] << 24);
+			bchunk = msg[6] & ~3;
+			if (!bchunk)
+				bchunk = 32;
+			bwindow = msg[7] ? msg[7] : 1;
+			bunacked = 0;
+			step = 1;
+			msglen = 1;
+			fpgaSelect(bmask);
+			jtagWrite(JTAG_BROADCAST, JTAG_REG_IR, (const uint8_t*)"\xd0", 6);  // JPROGRAM
+			for (j=0; j<fpgamax; ++j)
+			{
+				if (!((bmask >> j) & 1))
+					continue;
+				do {
+					i = 0xff;  // BYPASS while reading status
+					jtagRead(fpgaidx[j], JTAG_REG_IR, &i, 6);
+				} while (i & 8);
+			}
+			jtagWrite(JTAG_BROADCAST, JTAG_REG_IR, (const uint8_t*)"\xa0", 6);  // CFG_IN
+			pf_write("\1", 1);
+			// NOTE: as above, don't fill DR until the first chunk arrives
+			break;
+		}
+		case 1:
+		case 2:
+		{
+			uint8_t i;
+			uint8_t needlen = (elen < bchunk) ? elen : bchunk;
+			if (msglen < needlen+1)
+				break;
+			elen -= needlen;
+			// Acknowledge before shifting so the host can stream the next
+			// window while this one is clocked out
+			if (elen && ++bunacked == bwindow)
+			{
+				bunacked = 0;
+				pf_write("\1", 1);
+			}
+			if (step == 1)
+			{
+				_jtagReadWrite(JTAG_BROADCAST, JTAG_REG_DR, &msg[1], 8*needlen, 0, elen ? 1 : 3);
+				step = 2;
+			}
+			else
+				jtagSWriteMore(JTAG_BROADCAST, &msg[1], 8*needlen, !elen);
+			msglen = 1;
+			if (elen)
+				break;
+			// Last data block
+			jtagWrite(JTAG_BROADCAST, JTAG_REG_IR, (const uint8_t*)"\x30", 6);  // JSTART
+			for (i=0; i<16; ++i)
+				jtagRun(JTAG_BROADCAST);
+			for (i=0; i<fpgamax; ++i)
+			{
+				if ((bmask >> i) & 1)
+				{
+					msg[i] = 0xff;  // BYPASS
+					jtagRead(fpgaidx[i], JTAG_REG_IR, &msg[i], 6);
+					msg[i] = (msg[i] & 4) ? 1 : 0;
+				}
+				else
+					msg[i] = 0xff;
+			}
+			fpgaSelect(0xff);
+			pf_write(msg, fpgamax);
+			return true;
+		}
+		}
+		break;
     }
 	return false;
 }
@@ -0,0 +1,94 @@
+/**************************************************************************/
+/*! 
+    @file     main.c
+    @author   K. Townsend (microBuilder.eu)
+
+    @section LICENSE
+
+    Software License Agreement (BSD License)
+
+    Copyright (c) 2012, microBuilder SARL
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+    1. Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holders nor the
+    names of its contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ''AS IS'' AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**************************************************************************/
+#include <stdio.h>
+
+#include "projectconfig.h"
+#include "sysinit.h"
+
+#include "drivers/rf/pn532/pn532.h"
+#include "drivers/rf/pn532/pn532_bus.h"
+#include "drivers/rf/pn532/helpers/pn532_poll.h"
+
+/**************************************************************************/
+/*! 
+    Called by the poller whenever a card enters or leaves the field
+*/
+/**************************************************************************/
+void cardEvent(pn532_poll_event_t event, const pn532_poll_target_t * pTarget)
+{
+  printf("%-8s: Type %02X  Tg %d  UID ", 
+         event == PN532_POLL_EVENT_ARRIVE ? "Arrived" : "Left", 
+         pTarget->ucType, pTarget->ucTg);
+  pn532PrintHex(pTarget->abtUID, pTarget->szUIDLen);
+}
+
+/**************************************************************************/
+/*! 
+    Main program entry point.  After reset, normal code execution will
+    begin here.
+*/
+/**************************************************************************/
+int main (void)
+{
+  #if !defined CFG_PRINTF_USBCDC
+    #error "CFG_PRINTF_USBCDC must be enabled in projectconfig.h for this demo"
+  #endif
+
+  // Configure cpu and mandatory peripherals
+  systemInit();
+  
+  // Wait a bit for someone to open the USB connection for printf
+  systickDelay(5000);
+
+  // Initialise the PN532
+  pn532Init();
+
+  // Poll for ISO14443A (Mifare, etc.), FeliCa and ISO14443B cards every 150ms
+  pn532_error_t error = pn532_poll_Start(0, 0, 1, cardEvent);
+  if (error)
+  {
+    printf("Unable to start polling (0x%02X)%s", error, CFG_PRINTF_NEWLINE);
+    while(1);
+  }
+  printf("Waiting for cards ...%s", CFG_PRINTF_NEWLINE);
+
+  while (1)
+  {
+    // Keep the PN532 command queue (and the poller) moving.  Other work
+    // can be done here as well since nothing blocks while polling.
+    pn532Task();
+  }
+}
@@ -89,7 +89,7 @@ int main (void)
 
   pn532_error_t error;
   byte_t abtUID[8];
-  byte_t abtBlock[32];
+  byte_t abtSector[4*16];
   #if CARDFORMAT_NDEF == 1
   byte_t abtAuthKey1[6] = { 0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5 };   // Sector 0 of NXP formatter NDEF cards
   byte_t abtAuthKey2[6] = { 0xd3, 0xf7, 0xd3, 0xf7, 0xd3, 0xf7 };   // All other sectors use standard key (AN1305 p.20, Table 6)
@@ -108,57 +108,27 @@ int main (void)
     error = pn532_mifareclassic_WaitForPassiveTarget(abtUID, &szUIDLen);
     if (!error)
     {
-      // Mifare classic card found ... cycle through each sector
-      uint8_t block;
-      bool authenticated = false;
-      for (block = 0; block < 64; block++)
+      // Mifare classic card found ... read it one sector at a time (the
+      // sector is authenticated once and its four blocks read back to back)
+      uint8_t sector, block;
+      for (sector = 0; sector < 16; sector++)
       {
-        // Check if this is a new block so that we can reauthenticate
-        if (is_first_block(block)) authenticated = false;
-        if (!authenticated)
+        printf("-------------------------Sector %02d--------------------------%s", sector, CFG_PRINTF_NEWLINE);
+        error = pn532_mifareclassic_ReadSector (abtUID, szUIDLen, sector, PN532_MIFARE_CMD_AUTH_A, sector ? abtAuthKey2 : abtAuthKey1, abtSector);
+        for (block = 0; block < 4; block++)
         {
-          // Start of a new sector ... try to to authenticate
-          printf("-------------------------Sector %02d--------------------------%s", block / 4, CFG_PRINTF_NEWLINE);
-          error = pn532_mifareclassic_AuthenticateBlock (abtUID, szUIDLen, block, PN532_MIFARE_CMD_AUTH_A, block / 4 ? abtAuthKey2 : abtAuthKey1);
-          if (error)
+          printf("Block %02d: ", sector * 4 + block);
+          switch(error)
           {
-            switch(error)
-            {
-              default:
-                printf("Authentication error (0x%02x)%s", error, CFG_PRINTF_NEWLINE);
-                break;
-            }
-          }
-          else
-          {
-            authenticated = true;
-          }
-        }
-        // If we're still not authenticated just skip the block
-        if (!authenticated)
-        {
-          printf("Block %02d: ", block);
-          printf("Unable to authenticate%s", CFG_PRINTF_NEWLINE);
-        }
-        else
-        {
-          // Authenticated ... we should be able to read the block now
-          error = pn532_mifareclassic_ReadDataBlock (block, abtBlock);
-          if (error)
-          {
-            switch(error)
-            {
-              default:
-                printf("Block %02d: ", block);
-                printf("Unable to read this block%s", CFG_PRINTF_NEWLINE);
-                break;
-            }
-          }
-          else
-          {
-            // Read successful
-            printf("Block %02d: ", block);
-            pn532PrintHexChar(abtBlock, 16);
+            case PN532_ERROR_NONE:
+              pn532PrintHexChar(abtSector + block * 16, 16);
+              break;
+            case PN532_ERROR_APPLEVELERROR:
+              printf("Unable to authenticate%s", CFG_PRINTF_NEWLINE);
+              break;
+            default:
+              printf("Unable to read this block%s", CFG_PRINTF_NEWLINE);
+              break;
           }
         }
       }
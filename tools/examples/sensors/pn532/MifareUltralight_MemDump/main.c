@@ -75,6 +75,7 @@ int main (void)
 
   pn532_error_t error;
   byte_t        abtBuffer[8];
+  byte_t        abtPages[16*4];
   size_t        szUIDLen;
 
   while(1)
@@ -104,18 +105,21 @@ int main (void)
       printf("%s", CFG_PRINTF_NEWLINE);
       printf("Page  Hex       Text%s", CFG_PRINTF_NEWLINE);
       printf("----  --------  ----%s", CFG_PRINTF_NEWLINE);
-      // Dump the memory contents page by page
-      uint8_t i;
-      for (i = 0; i < 16; i++)
+      // Dump the memory contents (each READ command returns four pages)
+      error = pn532_mifareultralight_ReadPages(0, 16, abtPages);
+      if (!error)
       {
-        // Try to read the current page
-        error = pn532_mifareultralight_ReadPage(i, abtBuffer);
-        if (!error)
+        uint8_t i;
+        for (i = 0; i < 16; i++)
         {
           printf("0x%02x  ", i);
-          pn532PrintHexChar(abtBuffer, 4);
+          pn532PrintHexChar(abtPages + i * 4, 4);
         }
       }
+      else
+      {
+        printf("Unable to read the card (0x%02x)%s", error, CFG_PRINTF_NEWLINE);
+      }
     }
     // Wait a bit before trying again
     printf("%s", CFG_PRINTF_NEWLINE);
@@ -0,0 +1,243 @@
+/*
+ * libc test harness - checks the word-optimised routines in core/libc
+ * against the host C library and times both.
+ *
+ * Every routine is run over all source/destination alignments (0..7) and
+ * lengths up to TEST_MAXLEN, including overlapping memmove in both
+ * directions and memcmp/strcmp with the mismatch at every position.  The
+ * result and the whole destination buffer, including guard bytes on
+ * either side, must match what the host library produces.
+ *
+ * The timing part copies/compares TEST_BENCHBYTES bytes in blocks of
+ * several sizes and prints MB/s for both versions.  The host library uses
+ * SIMD so the absolute figures say little about the LPC1343; the point is
+ * to catch a change that makes one of the paths drastically slower.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TEST_MAXLEN       300
+#define TEST_GUARD        16
+#define TEST_BUFSIZE      (TEST_GUARD + 8 + TEST_MAXLEN + 8 + TEST_GUARD)
+#define TEST_BENCHBYTES   (64UL * 1024 * 1024)
+
+void * cb_memcpy(void *pDestination, const void *pSource, size_t num);
+void * cb_memset(void *pBuffer, int value, size_t num);
+void * cb_memmove(void *s1, const void *s2, size_t n);
+int cb_memcmp(const void *av, const void *bv, size_t len);
+size_t cb_strlen(const char *pString);
+int cb_strcmp(const char *s1, const char *s2);
+
+static unsigned char bufSrc[TEST_BUFSIZE] __attribute__((aligned(8)));
+static unsigned char bufDst[TEST_BUFSIZE] __attribute__((aligned(8)));
+static unsigned char bufRef[TEST_BUFSIZE] __attribute__((aligned(8)));
+static unsigned long testErrors;
+
+static void fail(const char *name, int a, int b, int len)
+{
+  if (testErrors++ < 20)
+  {
+    printf("FAIL %-8s align %d/%d len %d\n", name, a, b, len);
+  }
+}
+
+static int sign(int v)
+{
+  return (v > 0) - (v < 0);
+}
+
+static void fillRandom(unsigned char *p, size_t len)
+{
+  while (len--)
+  {
+    *p++ = rand();
+  }
+}
+
+static void testCopy(void)
+{
+  int da, sa, len;
+
+  for (da = 0; da < 8; da++)
+  for (sa = 0; sa < 8; sa++)
+  for (len = 0; len <= TEST_MAXLEN; len++)
+  {
+    fillRandom(bufSrc, TEST_BUFSIZE);
+    fillRandom(bufDst, TEST_BUFSIZE);
+    memcpy(bufRef, bufDst, TEST_BUFSIZE);
+
+    memcpy(bufRef + TEST_GUARD + da, bufSrc + TEST_GUARD + sa, len);
+    if (cb_memcpy(bufDst + TEST_GUARD + da, bufSrc + TEST_GUARD + sa, len) != bufDst + TEST_GUARD + da ||
+        memcmp(bufDst, bufRef, TEST_BUFSIZE))
+      fail("memcpy", da, sa, len);
+
+    memcpy(bufDst, bufRef, TEST_BUFSIZE);
+    memset(bufRef + TEST_GUARD + da, sa * 37, len);
+    if (cb_memset(bufDst + TEST_GUARD + da, sa * 37, len) != bufDst + TEST_GUARD + da ||
+        memcmp(bufDst, bufRef, TEST_BUFSIZE))
+      fail("memset", da, sa, len);
+  }
+}
+
+static void testMove(void)
+{
+  int from, to, len;
+
+  // Source and destination inside the same buffer, overlapping or not,
+  // in both directions
+  for (from = 0; from < 24; from++)
+  for (to = 0; to < 24; to++)
+  for (len = 0; len <= TEST_MAXLEN; len++)
+  {
+    fillRandom(bufDst, TEST_BUFSIZE);
+    memcpy(bufRef, bufDst, TEST_BUFSIZE);
+
+    memmove(bufRef + TEST_GUARD + to, bufRef + TEST_GUARD + from, len);
+    if (cb_memmove(bufDst + TEST_GUARD + to, bufDst + TEST_GUARD + from, len) != bufDst + TEST_GUARD + to ||
+        memcmp(bufDst, bufRef, TEST_BUFSIZE))
+      fail("memmove", to, from, len);
+  }
+}
+
+static void testCompare(void)
+{
+  int aa, ba, len, pos;
+  unsigned char *a, *b;
+
+  for (aa = 0; aa < 8; aa++)
+  for (ba = 0; ba < 8; ba++)
+  for (len = 0; len <= 64; len++)
+  for (pos = -1; pos < len; pos++)
+  {
+    a = bufSrc + TEST_GUARD + aa;
+    b = bufDst + TEST_GUARD + ba;
+
+    // Printable, non-zero bytes so the same data also works as strings
+    fillRandom(a, len);
+    for (int i = 0; i < len; i++)
+    {
+      a[i] = 'A' + a[i] % 26;
+    }
+    memcpy(b, a, len);
+    a[len] = b[len] = 0;
+    if (pos >= 0)
+    {
+      b[pos] = (pos & 1) ? b[pos] + 1 : b[pos] - 1;
+    }
+
+    if (sign(cb_memcmp(a, b, len)) != sign(memcmp(a, b, len)))
+      fail("memcmp", aa, ba, len);
+    if (sign(cb_strcmp((char *)a, (char *)b)) != sign(strcmp((char *)a, (char *)b)))
+      fail("strcmp", aa, ba, len);
+    if (cb_strlen((char *)a) != strlen((char *)a))
+      fail("strlen", aa, ba, len);
+
+    // Mismatch against the terminator, and bytes above 0x7F
+    if (pos >= 0)
+    {
+      b[pos] = 0;
+      if (sign(cb_strcmp((char *)a, (char *)b)) != sign(strcmp((char *)a, (char *)b)))
+        fail("strcmp", aa, ba, len);
+      b[pos] = 0x80 | a[pos];
+      if (sign(cb_memcmp(a, b, len)) != sign(memcmp(a, b, len)) ||
+          sign(cb_strcmp((char *)a, (char *)b)) != sign(strcmp((char *)a, (char *)b)))
+        fail("cmp 0x80", aa, ba, len);
+    }
+  }
+}
+
+static double now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Some of the glibc entry points are ifuncs; call everything through
+// pointers so neither side gets inlined
+typedef void *(*copyFunc_t)(void *, const void *, size_t);
+typedef int (*cmpFunc_t)(const void *, const void *, size_t);
+
+static volatile copyFunc_t volatileCopy;
+static volatile cmpFunc_t volatileCmp;
+static volatile int benchSink;
+
+static double benchCopy(copyFunc_t f, int size, int misalign)
+{
+  unsigned long n = TEST_BENCHBYTES / size;
+  double t;
+
+  volatileCopy = f;
+  t = now();
+  while (n--)
+  {
+    volatileCopy(bufDst + TEST_GUARD, bufSrc + TEST_GUARD + misalign, size);
+  }
+  return TEST_BENCHBYTES / (now() - t) / 1e6;
+}
+
+static double benchCmp(cmpFunc_t f, int size)
+{
+  unsigned long n = TEST_BENCHBYTES / size;
+  double t;
+
+  volatileCmp = f;
+  memcpy(bufDst, bufSrc, TEST_BUFSIZE);
+  t = now();
+  while (n--)
+  {
+    benchSink += volatileCmp(bufDst + TEST_GUARD, bufSrc + TEST_GUARD, size);
+  }
+  return TEST_BENCHBYTES / (now() - t) / 1e6;
+}
+
+static double benchStrlen(size_t (*f)(const char *), int size)
+{
+  size_t (* volatile fn)(const char *) = f;
+  unsigned long n = TEST_BENCHBYTES / size;
+  double t;
+
+  memset(bufSrc, 'x', TEST_BUFSIZE);
+  bufSrc[TEST_GUARD + size] = 0;
+  t = now();
+  while (n--)
+  {
+    benchSink += fn((char *)bufSrc + TEST_GUARD);
+  }
+  return TEST_BENCHBYTES / (now() - t) / 1e6;
+}
+
+static void bench(void)
+{
+  static const int sizes[] = { 8, 32, 128, TEST_MAXLEN };
+  unsigned int i;
+
+  printf("\n%-22s %10s %10s\n", "MB/s", "core/libc", "host");
+  for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+  {
+    int s = sizes[i];
+    printf("memcpy  %4d aligned    %10.0f %10.0f\n", s, benchCopy(cb_memcpy, s, 0), benchCopy(memcpy, s, 0));
+    printf("memcpy  %4d misaligned %10.0f %10.0f\n", s, benchCopy(cb_memcpy, s, 1), benchCopy(memcpy, s, 1));
+    printf("memmove %4d misaligned %10.0f %10.0f\n", s, benchCopy(cb_memmove, s, 3), benchCopy(memmove, s, 3));
+    printf("memcmp  %4d            %10.0f %10.0f\n", s, benchCmp(cb_memcmp, s), benchCmp(memcmp, s));
+    printf("strlen  %4d            %10.0f %10.0f\n", s, benchStrlen(cb_strlen, s), benchStrlen(strlen, s));
+  }
+}
+
+int main(int argc, char **argv)
+{
+  srand(1);
+  testCopy();
+  testMove();
+  testCompare();
+  printf("%s: %lu error(s)\n", testErrors ? "FAILED" : "OK", testErrors);
+
+  if (argc > 1 && !strcmp(argv[1], "-b"))
+  {
+    bench();
+  }
+  return testErrors != 0;
+}
@@ -0,0 +1,21 @@
+/*
+ * libc test harness - core/libc/string.c built for the host.
+ *
+ * Every public function is renamed with a cb_ prefix so the firmware
+ * versions can be linked and compared against the host C library.
+ */
+#define memcpy    cb_memcpy
+#define memset    cb_memset
+#define memmove   cb_memmove
+#define memcmp    cb_memcmp
+#define strchr    cb_strchr
+#define strlen    cb_strlen
+#define strrchr   cb_strrchr
+#define strcpy    cb_strcpy
+#define strncmp   cb_strncmp
+#define strncpy   cb_strncpy
+#define strcmp    cb_strcmp
+#define strtok    cb_strtok
+#define strtok_r  cb_strtok_r
+
+#include "../../core/libc/string.c"
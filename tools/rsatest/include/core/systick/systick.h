@@ -0,0 +1,12 @@
+/*
+ * RSA test harness - stand-in for core/systick/systick.h (only used by
+ * rsaBigTest; rsatest.c provides it).
+ */
+#ifndef _SYSTICK_H_
+#define _SYSTICK_H_
+
+#include "projectconfig.h"
+
+uint32_t systickGetTicks(void);
+
+#endif
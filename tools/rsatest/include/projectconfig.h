@@ -0,0 +1,19 @@
+/*
+ * RSA test harness - stand-in for projectconfig.h, sized for 2048-bit
+ * keys.
+ */
+#ifndef _PROJECTCONFIG_H_
+#define _PROJECTCONFIG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#define CFG_PRINTF_NEWLINE  "\n"
+
+#define CFG_RSA
+#define CFG_RSA_BITS        (32)
+#define CFG_RSA_MAXBITS     (2048)
+
+#endif
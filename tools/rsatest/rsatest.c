@@ -0,0 +1,212 @@
+/*
+ * RSA test harness - checks the multi-precision RSA in drivers/rsa on
+ * 1024- and 2048-bit keys and times it.
+ *
+ * For each key size the public and private (CRT) operations are checked
+ * against a known message/ciphertext pair, with and without a precomputed
+ * R^2 mod n and with the output overwriting the input.  rsaBigVerify is
+ * checked on the same pair and with one byte changed, along with the edge
+ * values 0, 1 and n - 1 and an input that is out of range.  Random
+ * messages are then run through both operations in either order.
+ *
+ * The timing part runs each operation TEST_BENCHRUNS times and prints the
+ * time per operation.  Host figures only show the relative cost of the key
+ * sizes and of public vs private keys; see rsaBigTest for the LPC1343.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "rsa.h"
+#include "bignum.h"
+#include "rsavectors.h"
+
+#define TEST_RANDOM       200
+#define TEST_BENCHRUNS    200
+
+typedef struct
+{
+  const char *name;
+  rsaBigPubKey_t pub;
+  rsaBigPriKey_t pri;
+  const uint32_t *msg;
+  const uint32_t *cipher;
+} testKey_t;
+
+static const testKey_t keys[] =
+{
+  { "1024", { rsa1024N, NULL, 65537, 32 },
+            { rsa1024P, rsa1024Q, rsa1024DP, rsa1024DQ, rsa1024QInv, 32 },
+            rsa1024Msg, rsa1024Cipher },
+  { "2048", { rsa2048N, NULL, 65537, 64 },
+            { rsa2048P, rsa2048Q, rsa2048DP, rsa2048DQ, rsa2048QInv, 64 },
+            rsa2048Msg, rsa2048Cipher }
+};
+#define KEYS  (sizeof(keys) / sizeof(keys[0]))
+
+static unsigned long testErrors;
+
+static void fail(const char *what, const char *key, int n)
+{
+  if (testErrors++ < 20)
+  {
+    printf("FAIL %-12s key %s (%d)\n", what, key, n);
+  }
+}
+
+static double now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Only referenced by rsaBigTest, which isn't called here
+uint32_t systickGetTicks(void)
+{
+  return (uint32_t)(now() * 1000);
+}
+
+static void testVectors(const testKey_t *k)
+{
+  static uint32_t rr[BN_MAXLIMBS], a[BN_MAXLIMBS], b[BN_MAXLIMBS];
+  static uint8_t sig[BN_MAXLIMBS * 4], expected[BN_MAXLIMBS * 4];
+  rsaBigPubKey_t pub = k->pub;
+  uint32_t limbs = k->pub.limbs, len = limbs * 4;
+  bnMont_t ctx;
+
+  if (rsaBigPublic(a, k->msg, &pub) != RSA_ERROR_OK || bnCmp(a, k->cipher, limbs))
+    fail("public", k->name, 0);
+  if (rsaBigPrivate(a, k->cipher, &k->pri) != RSA_ERROR_OK || bnCmp(a, k->msg, limbs))
+    fail("private", k->name, 0);
+
+  // Precomputed R^2 mod n, and the output overwriting the input
+  bnMontInit(&ctx, pub.n, limbs);
+  bnMontComputeRR(rr, &ctx);
+  pub.rr = rr;
+  memcpy(a, k->msg, len);
+  if (rsaBigPublic(a, a, &pub) != RSA_ERROR_OK || bnCmp(a, k->cipher, limbs))
+    fail("public rr", k->name, 0);
+  if (rsaBigPrivate(a, a, &k->pri) != RSA_ERROR_OK || bnCmp(a, k->msg, limbs))
+    fail("private", k->name, 1);
+
+  // Signing is the private operation, so msg is a signature of cipher
+  bnToBytes(sig, len, k->msg, limbs);
+  bnToBytes(expected, len, k->cipher, limbs);
+  if (rsaBigVerify(sig, expected, len, &pub) != RSA_ERROR_OK)
+    fail("verify", k->name, 0);
+  expected[len / 2] ^= 0x01;
+  if (rsaBigVerify(sig, expected, len, &pub) != RSA_ERROR_MISMATCH)
+    fail("verify", k->name, 1);
+  if (rsaBigVerify(sig, expected, len - 4, &pub) != RSA_ERROR_KEYSIZE)
+    fail("verify", k->name, 2);
+
+  // 0 and 1 map to themselves, and so does n - 1 for an odd exponent
+  memset(a, 0, len);
+  if (rsaBigPublic(b, a, &pub) != RSA_ERROR_OK || bnCmp(b, a, limbs) ||
+      rsaBigPrivate(b, a, &k->pri) != RSA_ERROR_OK || bnCmp(b, a, limbs))
+    fail("edge", k->name, 0);
+  a[0] = 1;
+  if (rsaBigPublic(b, a, &pub) != RSA_ERROR_OK || bnCmp(b, a, limbs) ||
+      rsaBigPrivate(b, a, &k->pri) != RSA_ERROR_OK || bnCmp(b, a, limbs))
+    fail("edge", k->name, 1);
+  memcpy(a, pub.n, len);
+  a[0]--;
+  if (rsaBigPublic(b, a, &pub) != RSA_ERROR_OK || bnCmp(b, a, limbs) ||
+      rsaBigPrivate(b, a, &k->pri) != RSA_ERROR_OK || bnCmp(b, a, limbs))
+    fail("edge", k->name, 2);
+  a[0]++;
+  if (rsaBigPublic(b, a, &pub) != RSA_ERROR_RANGE)
+    fail("range", k->name, 0);
+}
+
+static void randomBelow(uint32_t *r, const uint32_t *n, uint32_t limbs)
+{
+  uint32_t i;
+
+  do
+  {
+    for (i = 0; i < limbs; i++)
+    {
+      r[i] = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+    }
+    r[limbs - 1] %= n[limbs - 1] + 1;
+  } while (bnCmp(r, n, limbs) >= 0);
+}
+
+static void testRandom(const testKey_t *k)
+{
+  static uint32_t m[BN_MAXLIMBS], a[BN_MAXLIMBS], b[BN_MAXLIMBS];
+  uint32_t limbs = k->pub.limbs;
+  int i;
+
+  for (i = 0; i < TEST_RANDOM; i++)
+  {
+    randomBelow(m, k->pub.n, limbs);
+    rsaBigPublic(a, m, &k->pub);
+    rsaBigPrivate(b, a, &k->pri);
+    if (bnCmp(b, m, limbs))
+      fail("public/priv", k->name, i);
+    rsaBigPrivate(a, m, &k->pri);
+    rsaBigPublic(b, a, &k->pub);
+    if (bnCmp(b, m, limbs))
+      fail("priv/public", k->name, i);
+  }
+}
+
+static void bench(void)
+{
+  static uint32_t rr[BN_MAXLIMBS], out[BN_MAXLIMBS];
+  unsigned int i;
+  bnMont_t ctx;
+  double t, pub, pubrr, pri;
+  int n;
+
+  printf("\n%-10s %12s %12s %12s\n", "ms/op", "public", "public rr", "private");
+  for (i = 0; i < KEYS; i++)
+  {
+    const testKey_t *k = &keys[i];
+    rsaBigPubKey_t key = k->pub;
+
+    t = now();
+    for (n = 0; n < TEST_BENCHRUNS; n++)
+      rsaBigPublic(out, k->msg, &key);
+    pub = (now() - t) * 1e3 / TEST_BENCHRUNS;
+
+    bnMontInit(&ctx, key.n, key.limbs);
+    bnMontComputeRR(rr, &ctx);
+    key.rr = rr;
+    t = now();
+    for (n = 0; n < TEST_BENCHRUNS; n++)
+      rsaBigPublic(out, k->msg, &key);
+    pubrr = (now() - t) * 1e3 / TEST_BENCHRUNS;
+
+    t = now();
+    for (n = 0; n < TEST_BENCHRUNS; n++)
+      rsaBigPrivate(out, k->cipher, &k->pri);
+    pri = (now() - t) * 1e3 / TEST_BENCHRUNS;
+
+    printf("%-10s %12.3f %12.3f %12.3f\n", k->name, pub, pubrr, pri);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  unsigned int i;
+
+  srand(1);
+  for (i = 0; i < KEYS; i++)
+  {
+    testVectors(&keys[i]);
+    testRandom(&keys[i]);
+  }
+  printf("%s: %lu error(s)\n", testErrors ? "FAILED" : "OK", testErrors);
+
+  if (argc > 1 && !strcmp(argv[1], "-b"))
+  {
+    bench();
+  }
+  return testErrors != 0;
+}
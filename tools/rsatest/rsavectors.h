@@ -0,0 +1,210 @@
+/*
+ * RSA test harness - 1024- and 2048-bit test keys with a known
+ * message/ciphertext pair each.  The primes were generated with a seeded
+ * Miller-Rabin search and the ciphertexts with Python's pow(); the keys
+ * are for testing only.
+ */
+#ifndef _RSAVECTORS_H_
+#define _RSAVECTORS_H_
+
+/* 1024-bit key (e = 65537) */
+
+static const uint32_t rsa1024N[32] =
+{
+  0x03B57B23, 0x1C2A8DAD, 0x0A8699F1, 0x6A7EFD1B,
+  0x14604E44, 0x0CBBA999, 0xB5A9A889, 0x79F75C64,
+  0x2F5D0AA1, 0x4178BE9B, 0xB9C2E4A2, 0x55613FE9,
+  0xE3E79A22, 0xF05D9272, 0x83324886, 0xA85A3287,
+  0x43171796, 0x2E13931B, 0x08607852, 0x147D9802,
+  0x612ECE2C, 0x73674326, 0x16A51AD5, 0x90488796,
+  0xB4DFE932, 0x0478BC25, 0xC868B88B, 0xC84575F8,
+  0xE4CFBC5F, 0xD1A0B14C, 0x22778614, 0xCDFA9A59
+};
+
+static const uint32_t rsa1024P[16] =
+{
+  0x8A3E1719, 0x932304B6, 0xD178BA5E, 0x0ADC74E6,
+  0x6C92D774, 0x9F3762D0, 0xBE752D09, 0x4D693B4F,
+  0xA5B0CE8F, 0x4DF7BF03, 0x55929782, 0x5CFA2EDE,
+  0x438CEA1C, 0xBC257E81, 0x039F536C, 0xFABF34BD
+};
+
+static const uint32_t rsa1024Q[16] =
+{
+  0x44E4579B, 0xEDA4CB45, 0x54854569, 0x40E5A07D,
+  0x7482A330, 0xE7E49492, 0x39EC64AF, 0xC114AA77,
+  0x597B532E, 0x80A960CA, 0x8A34F0FB, 0x5172D827,
+  0x7DFF2FC4, 0x4431CD90, 0x3D3A8194, 0xD24B4CA4
+};
+
+static const uint32_t rsa1024DP[16] =
+{
+  0xCEAE4359, 0x47DCA854, 0x3D98FD6F, 0x0929C927,
+  0x4DCDC3AE, 0x7BF437A5, 0x338CC633, 0xB5259E0D,
+  0xCBEA491E, 0x28F0493F, 0x7C4D017D, 0x7D827592,
+  0x5B1F0A50, 0x36374816, 0xC58E5538, 0x512579D2
+};
+
+static const uint32_t rsa1024DQ[16] =
+{
+  0x0BBDB857, 0x20060272, 0xA17171F3, 0x33365470,
+  0xC305E2D8, 0x46EC9777, 0x0D6E83CF, 0x30B0F828,
+  0x2E4465C4, 0x39F15F9F, 0xF2063E5B, 0x692B0892,
+  0x6444B7A8, 0x8A0E1DD6, 0xF22470DE, 0xB7DF7D20
+};
+
+static const uint32_t rsa1024QInv[16] =
+{
+  0xF8B67395, 0x5C98E8E6, 0x8327BAE6, 0x3E204ACD,
+  0x5979DC25, 0x2D6E6385, 0x4C1D2817, 0xC5269244,
+  0xF231BA44, 0xE3D01D4C, 0x92A77989, 0x39DAEA62,
+  0x27443B7C, 0xCD86C52C, 0x463908FB, 0xB409C963
+};
+
+static const uint32_t rsa1024Msg[32] =
+{
+  0x9A0157A7, 0x9A45AC91, 0xA805C26E, 0x75867CCF,
+  0x0501E2AF, 0xC012802A, 0xA971E74C, 0xE72333D4,
+  0x79E96EFC, 0x03AAC9E7, 0xDF49BE69, 0xD76783AD,
+  0x66C3917E, 0x61A7DFF6, 0xC1788FB2, 0x49BF3AA0,
+  0x2F110D98, 0x6F72C62A, 0xF3ACE73E, 0x43815DD4,
+  0x9F7041A2, 0xB355FEA1, 0x80828226, 0xCD4176B8,
+  0xFF9DF38B, 0x1B83DA33, 0xE91EC734, 0x5AF9F441,
+  0x0196676B, 0xACB6F547, 0x445F3800, 0x5A513E4C
+};
+
+static const uint32_t rsa1024Cipher[32] =
+{
+  0x82FD7921, 0x531B0B0C, 0xB1E305DA, 0x73C5EBCF,
+  0x5A9C98CA, 0xDA112C7E, 0x06D6FD4A, 0x305F5487,
+  0x10F8641E, 0x0166CD64, 0x37BA828E, 0xB63AF77D,
+  0x10B05FD1, 0x131AC334, 0x1A8C1367, 0x066060EE,
+  0xFD08CEC4, 0xBD024C03, 0x5B42EFFD, 0x55820C6F,
+  0x78E0399A, 0x390F30BC, 0x2A0039E5, 0x687E48E7,
+  0xA440302E, 0x98DE35EF, 0xD1BA7955, 0x422CE214,
+  0x5687691B, 0x6B8D6F5C, 0x7CB47D47, 0x9B1833B3
+};
+
+/* 2048-bit key (e = 65537) */
+
+static const uint32_t rsa2048N[64] =
+{
+  0xD4313779, 0xCDEF69C9, 0xA80F299C, 0x50398FA7,
+  0xCAFCF5C1, 0x9840E18B, 0xF44608B1, 0x83436CA1,
+  0x9AB3E2BD, 0xD174D4EA, 0xA4887711, 0x8D13E168,
+  0x81526603, 0xF32835F0, 0xDCAC7305, 0xBE088B3E,
+  0x6E5BA3C0, 0x43AAC0DF, 0x093EA62F, 0xADD304A3,
+  0x74913B03, 0x77CC9186, 0x3F29405D, 0x2829A1A3,
+  0x2E085CC6, 0x04A38AD2, 0x13C7E3EC, 0x7804FA68,
+  0xEE44B5BA, 0x4BC28ED4, 0xCF56AC17, 0x142D1C9B,
+  0x0C960062, 0xB3D9FF01, 0xDB22998D, 0xDBBB38E4,
+  0xCF656640, 0xFC02394F, 0x028CA138, 0x42907B7B,
+  0x548BBD3A, 0x0E3C07AC, 0x84BF733D, 0xD6942C27,
+  0xB3BEA2D6, 0x0188DE8D, 0x7974165C, 0x48E705D6,
+  0x20419944, 0x8FBE4CF5, 0x96C78DEF, 0x5A5B4AF3,
+  0x425467C2, 0x49117F57, 0x4B8CE8C2, 0xE789BA0E,
+  0x79339C71, 0x42F3ADB3, 0x382FCECF, 0x2434A27E,
+  0x027C3A6C, 0x1DC34E0A, 0xE40D5F39, 0xEA6D0A95
+};
+
+static const uint32_t rsa2048P[32] =
+{
+  0x07382435, 0x06AD6EB3, 0xDB3EC3F8, 0x3BE0595E,
+  0x58DAC1A7, 0x7A877F2D, 0x9408EE88, 0x2EAC0576,
+  0xCEFEE19E, 0x312F8AD8, 0x0A791D4A, 0x89ACE8E2,
+  0xA489AF66, 0x96705750, 0x316DE6D9, 0xE755ACE3,
+  0x339D1FE5, 0xDC6289E8, 0x695AAC40, 0x02E3E09B,
+  0x237ED4E2, 0xEDDEED94, 0x398DF673, 0x4D39A9B0,
+  0xBFF33843, 0x52DA130D, 0x04665A9C, 0x08CCBAEA,
+  0x40BC30CA, 0x7C17A0A9, 0xA30B5B67, 0xF80D4FC3
+};
+
+static const uint32_t rsa2048Q[32] =
+{
+  0xD418E6B5, 0xFA3276D2, 0x837B0D73, 0xD96D835A,
+  0x1B0C581E, 0xA61A4CD7, 0x26AE7B53, 0xF1F6649E,
+  0x64A061F2, 0x857AA27F, 0xD976ABEC, 0x06AC4AB2,
+  0x6D736811, 0x8B9CE2E6, 0x5FCAEF50, 0x03DD479F,
+  0xBFEC6281, 0xFB3BC9C0, 0x7FC02BD6, 0x3FF247C4,
+  0xD40F22C2, 0xD08AE28D, 0x6821E5BC, 0xCA651F94,
+  0x5DD5CC2A, 0xDDD3FAA6, 0x1288B961, 0x7EA6E66C,
+  0xF728E874, 0x9DAD3DAD, 0x099F3F66, 0xF1EFF5B2
+};
+
+static const uint32_t rsa2048DP[32] =
+{
+  0xC43C5A65, 0x65354FF7, 0x79AC0AC8, 0x1EBF2F05,
+  0x3D68E28F, 0x29BE680F, 0x7A34537A, 0xEE8FE7F9,
+  0x61482058, 0x94261B00, 0xE231E975, 0xA6859FA1,
+  0x8414AEE6, 0x08C3A0BB, 0xCEE09830, 0x281EBAC1,
+  0x3E4C0DAD, 0x8AE2E0A6, 0x6967DEFB, 0x1A721EF6,
+  0x3F48A13A, 0x7F55D111, 0x5BF80F27, 0xBFF97B52,
+  0x66F4B76E, 0xF82D882E, 0x2483E488, 0x6839AB7E,
+  0x49406F68, 0x54B7EDE9, 0x4F824195, 0x467A99C8
+};
+
+static const uint32_t rsa2048DQ[32] =
+{
+  0xFB381FD5, 0xD1C91BC3, 0x1D18320E, 0xCADF1377,
+  0x6E1E34F5, 0x70E6F97D, 0x13CF992B, 0x14BEF5E4,
+  0xDBE17625, 0x5CA9B6F2, 0x4F21B808, 0x9698AF68,
+  0x181F3938, 0x19A3C612, 0x884D1FD9, 0x7AABC40A,
+  0x378A0CBA, 0xE43BA082, 0x74F3F658, 0xF8BB8A9C,
+  0x4D9E90EE, 0x8C39590F, 0xAA554849, 0xD0DED68D,
+  0xF03B45FA, 0xD18AA9BB, 0x3DEC7353, 0x0889C6B8,
+  0x9DC2DF13, 0xE6476D7C, 0xEBB8EE84, 0x1EA11B80
+};
+
+static const uint32_t rsa2048QInv[32] =
+{
+  0xA2000914, 0x1DAAAC0D, 0xDD1694CB, 0xDF02D183,
+  0xCE402DB6, 0x1E59CC7E, 0xB0058A5D, 0xE9B10098,
+  0x3F7D361E, 0xE441C567, 0xC536FE9E, 0xA84B1FC4,
+  0x65FD0010, 0x4C7C11EB, 0xBFF9482A, 0x72738B59,
+  0x4422299C, 0xA712CFFE, 0x998F1939, 0xFC172171,
+  0x884ACBC8, 0x24A0076D, 0x8529CFCD, 0xF1E66F92,
+  0x36A5B568, 0x228DCB71, 0x45EFE484, 0xFAFFE81B,
+  0x18106BA1, 0x8E4ABB71, 0xDFAD948B, 0x59630558
+};
+
+static const uint32_t rsa2048Msg[64] =
+{
+  0x4D56D36D, 0x936A7A93, 0x4020678F, 0x660ACBD1,
+  0x71C078F7, 0xA46A3546, 0x4D8EA107, 0x9C9E57A5,
+  0x3B3E5C7D, 0x8AD092F5, 0xD7E17882, 0xC77E0347,
+  0x864188D2, 0x16ADD8E4, 0x719E8CDD, 0xB733456F,
+  0x07E4C635, 0x7425B351, 0xC09AD80A, 0xF74197B1,
+  0x7D575ADE, 0x09E3F97C, 0x80A2B92D, 0x88362FC6,
+  0x4081B952, 0xC77DFCDA, 0x3D989D48, 0xDB9470CF,
+  0x38DE7B32, 0x9D0FAC8A, 0xB75E9576, 0xBF290F5C,
+  0x390E3D6C, 0x885D4B3A, 0xD4D52A2F, 0xC599B749,
+  0xB6673DED, 0x59CDB81A, 0x06FDBAB5, 0xE4E05C0F,
+  0x4617B734, 0x1D44495C, 0xDBB7621E, 0xCECBEB8B,
+  0x77B8C21B, 0x8C61F965, 0xFAA84C2E, 0xDF8A560E,
+  0x2B702245, 0x51D66246, 0x45420786, 0x9D5FEA2E,
+  0xBF4C52E3, 0x79BFC3A9, 0xBB35DCDA, 0x1BC76A6E,
+  0x9FF3CBA9, 0x69570D0E, 0x8DA7BD04, 0x190482D3,
+  0x1657D529, 0xA6EDF905, 0xFBCB6894, 0x25154AB9
+};
+
+static const uint32_t rsa2048Cipher[64] =
+{
+  0x59E9E94D, 0x55246D1C, 0xF1C7A82B, 0xFA4175E0,
+  0x88658786, 0x759EC2C4, 0xE4290A2F, 0x30F9148D,
+  0x74EDABB6, 0xBC39874E, 0xBFECD71C, 0x668A3C61,
+  0x0BDD86B2, 0x427518C4, 0xD777CD82, 0xA412C158,
+  0x6CD310B2, 0xA765B451, 0x670C1097, 0x170C8B2F,
+  0x172FEAE0, 0x33C4C105, 0xC5A520C7, 0x8568B12F,
+  0x2DD9D2A2, 0x1D439A20, 0x64104559, 0x0435D740,
+  0xF06741F3, 0x8450EA42, 0x590EF0D5, 0x514017CB,
+  0x82A1E647, 0x36FEEB94, 0x94BC5605, 0xC998CD4A,
+  0x8A938A60, 0x04354A77, 0x4C6F50F2, 0xD1A7976E,
+  0x239ED51D, 0xDC0701E9, 0xE93A52ED, 0xE2330757,
+  0x9A849E13, 0x00EAC40A, 0x397613D6, 0x1BA09323,
+  0xAFB98C88, 0xD58B489D, 0x4BCE361B, 0x5E4D44E0,
+  0x247D7944, 0x0B0BF26C, 0x57A05F64, 0x6A53C29F,
+  0x7BEDF139, 0x3C77AAB6, 0x9C3DD11F, 0xF51A39A5,
+  0x89D27E00, 0xB37CCB88, 0x7712093C, 0x1793576C
+};
+
+#endif
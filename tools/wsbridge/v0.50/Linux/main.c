@@ -33,15 +33,35 @@
 *******************************************************************/
 /*!
     FreakLabs Freakduino/Wireshark Bridge
- 
+
     This program allows data from the Freakduino to be piped into wireshark.
     When the sniffer firmware is loaded into the Freakduino, then the Freakduino
     will be in promiscuous mode and will just dump any frames it sees. This
-    program takes the frame dump and sends it into Wireshark for analysis. The
-    global header is already set up to inform wireshark that the link layer for
-    all frames will be in IEEE 802.15.4 format. After that, it is up to the user
-    to choose any higher layer protocols to decode above 802.15.4 via the
-    wireshark "enable protocols" menu. 
+    program takes the frame dump and sends it into Wireshark for analysis,
+    through a named pipe, into a capture file, or both. After that, it is up
+    to the user to choose any higher layer protocols to decode above 802.15.4
+    via the wireshark "enable protocols" menu.
+
+    The serial port is read in large non-blocking chunks and every complete
+    record in a chunk is converted in one pass, so a busy capture costs a
+    handful of system calls per chunk rather than several per byte.  The
+    pipe is written non-blocking as well: if wireshark falls behind, output
+    is queued up to PIPE_BACKLOG bytes and whole chunks are dropped beyond
+    that, while the capture file still receives every frame.
+
+    Two record formats are understood on the serial port:
+
+    [len] [len - 1 bytes]           original sniffer format, the frame
+                                    without its last FCS byte
+    [0xC1] [len] [len bytes]        extended format, the complete frame
+    [ed] [lqi] [flags]              including the FCS, followed by the
+    [timestamp, 32-bit LE]          link metadata (flags bit 0 = FCS valid)
+                                    and the sniffer's receive time in us
+
+    The default output format is pcapng with the IEEE 802.15.4 TAP link
+    type, which lets wireshark show the RSSI and LQI of every frame and
+    check its FCS.  Use '-F pcap' for the classic libpcap format (frames
+    without the FCS) for older versions of wireshark.
 */
 /**************************************************************************/
 #include <stddef.h>
@@ -52,239 +72,658 @@
 #include <time.h>
 #include <stdint.h>
 #include <signal.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/time.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <termios.h>
 
-#define PORTBUFSIZE     32
-#define BUFSIZE         1024
+#define SERBUFSIZE      65536           // serial read chunk
+#define PIPE_BACKLOG    (4 * 1024 * 1024)
 #define PACKET_FCS      2
-#define DEBUG           1
+#define MIN_FRAME_LEN   3
+#define MAX_FRAME_LEN   127
 #define PIPENAME        "/tmp/wireshark"
 #define BAUDRATE        B115200
-
-enum FSM
+#define CONNECT_POLL_MS 250             // retry interval while waiting for wireshark
+
+#define RECORD_EXT          0xC1
+#define RECORD_EXT_HDR      2           // type, len
+#define RECORD_EXT_TRAILER  7           // ed, lqi, flags, timestamp
+#define RECORD_FLAG_CRC     0x01
+
+// sniffer and host clocks are re-aligned if they drift further apart
+#define TS_MAX_LAG_US       1000000
+
+// RSSI_BASE_VAL of the AT86RF212 in O-QPSK mode, one ED step is ~1 dB
+#define RSSI_BASE_DBM       (-98.0f)
+#define RSSI_ED_STEP_DB     (1.03f)
+
+#define LINKTYPE_IEEE802_15_4_NOFCS 230
+#define LINKTYPE_IEEE802_15_4_TAP   283
+
+// pcapng block types and options
+#define PCAPNG_SHB          0x0A0D0D0A
+#define PCAPNG_IDB          0x00000001
+#define PCAPNG_EPB          0x00000006
+#define PCAPNG_BOM          0x1A2B3C4D
+#define PCAPNG_OPT_END      0
+#define PCAPNG_OPT_NAME     2           // if_name
+#define PCAPNG_OPT_FLAGS    2           // epb_flags
+#define PCAPNG_FLAG_INBOUND 0x00000001
+#define PCAPNG_FLAG_CRCERR  0x01000000
+
+// IEEE 802.15.4 TAP TLVs
+#define TAP_FCS_TYPE        0
+#define TAP_RSS             1
+#define TAP_LQI             10
+#define TAP_FCS_NONE        0
+#define TAP_FCS_16BIT       1
+
+enum FORMAT
 {
-    START_CAPTURE,
-    PACKET_CAPTURE
+    FORMAT_PCAPNG,
+    FORMAT_PCAP
 };
 
+// one captured frame, pointing into the serial buffer
+typedef struct
+{
+    const uint8_t *data;
+    uint8_t len;            // bytes at data
+    uint8_t has_fcs;        // data ends with the complete FCS
+    uint8_t has_meta;       // ed, lqi, crc and timestamp are valid
+    uint8_t ed;
+    uint8_t lqi;
+    uint8_t crc;
+    uint32_t timestamp;
+} frame_t;
+
+// growable byte buffer
+typedef struct
+{
+    uint8_t *data;
+    size_t len;
+    size_t size;
+} buf_t;
+
+typedef struct
+{
+    uint32_t frames;
+    uint32_t ext_frames;
+    uint32_t bad_fcs;
+    uint32_t resyncs;
+    uint32_t pipe_dropped;
+    uint64_t bytes_in;
+} stats_t;
+
 static int FD_pipe = -1;
+static int FD_file = -1;
 static int FD_com = -1;
-static uint8_t port_buf[PORTBUFSIZE];
-static uint8_t circ_buf[BUFSIZE];
-static uint16_t rd_idx = 0;
-static uint16_t wr_idx = 0;
-static uint8_t len;
-static uint8_t state = START_CAPTURE;
-static uint8_t file_write = 0;
+static char *pipe_name = NULL;
+static char *port_name = NULL;
+static uint8_t format = FORMAT_PCAPNG;
+static uint8_t verbose = 0;
+static volatile sig_atomic_t quit = 0;
+
+static uint8_t ser_buf[SERBUFSIZE];
+static size_t ser_len = 0;
+static buf_t out;           // records converted from the current chunk
+static buf_t pipe_out;      // output not yet accepted by the pipe
+static stats_t stats;
+
+// sniffer timestamp tracking
+static uint8_t ts_valid = 0;
+static uint32_t ts_last;
+static uint64_t ts_base;    // host time (us) of sniffer time ts_ext == 0
+static uint64_t ts_ext;     // sniffer time extended to 64 bits
 
 /**************************************************************************/
 /*!
-    Open the serial port that we'll be communicating with the Freakduino (sniffer)
-    through.
+    Append data to a buffer, growing it as required.
 */
 /**************************************************************************/
-static int serial_open(char *portname)
+static void buf_append(buf_t *b, const void *data, size_t len)
 {
-    int FD_com; // file descriptor for the serial port
-    struct termios term;
-
-    FD_com = open(portname, O_RDONLY | O_NOCTTY | O_NDELAY);
-    
-    if(FD_com == -1) // if open is unsucessful
+    if (b->len + len > b->size)
     {
-        printf("serial_open: Unable to open %s.\n", portname);
+        size_t size = b->size ? b->size : 4096;
+        while (size < b->len + len)
+        {
+            size *= 2;
+        }
+        if ((b->data = realloc(b->data, size)) == NULL)
+        {
+            perror("wsbridge");
+            exit(1);
+        }
+        b->size = size;
     }
-    else
-    {
-        // set speed of port
-        cfsetspeed(&term, BAUDRATE);
+    memcpy(b->data + b->len, data, len);
+    b->len += len;
+}
 
-        // set to 8-bits, no parity, 1 stop bit
-        term.c_cflag &= ~PARENB;
-        term.c_cflag &= ~CSTOPB;
-        term.c_cflag &= ~CSIZE;
-        term.c_cflag |= CS8;
+static void buf_u8(buf_t *b, uint8_t v)
+{
+    buf_append(b, &v, 1);
+}
 
-        term.c_cflag |= (CLOCAL | CREAD);
-        tcsetattr(FD_com, TCSANOW, &term);
-    }
-    return(FD_com);
+static void buf_u16(buf_t *b, uint16_t v)
+{
+    buf_append(b, &v, 2);
+}
+
+static void buf_u32(buf_t *b, uint32_t v)
+{
+    buf_append(b, &v, 4);
+}
+
+static void buf_pad32(buf_t *b)
+{
+    static const uint8_t zero[3];
+    buf_append(b, zero, (4 - (b->len & 3)) & 3);
+}
+
+/**************************************************************************/
+/*!
+    Current host time in microseconds.
+*/
+/**************************************************************************/
+static uint64_t host_time_us()
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
 }
 
 /**************************************************************************/
 /*!
-    Create the named pipe that we will be communicating with wireshark through.
+    Time stamp for a frame.  Frames from the extended format are stamped
+    with the sniffer's receive time mapped onto the host clock, so the
+    spacing between frames is exact no matter how they were batched on
+    the way to the PC.
 */
 /**************************************************************************/
-static void named_pipe_create(char *name)
+static uint64_t frame_time(const frame_t *f)
 {
-    int rv = 0;
-    rv = mkfifo(name, 0666);
-    if ((rv == -1) && (errno != EEXIST)) 
+    uint64_t now = host_time_us();
+    uint64_t t;
+
+    if (!f->has_meta)
     {
-        perror("Error creating named pipe");
-        exit(1);
+        return now;
     }
 
-    FD_pipe = open(name, O_WRONLY);
+    if (!ts_valid)
+    {
+        ts_valid = 1;
+        ts_ext = 0;
+        ts_base = now;
+    }
+    else
+    {
+        ts_ext += (uint32_t)(f->timestamp - ts_last);
+    }
+    ts_last = f->timestamp;
 
-    if (FD_pipe == -1) 
+    // a frame can't have been received after it arrived here, nor long
+    // before. if it was, the clocks have drifted or the sniffer was reset.
+    t = ts_base + ts_ext;
+    if ((t > now) || (t + TS_MAX_LAG_US < now))
     {
-        perror("Error connecting to named pipe");
-        exit(1);
+        ts_base = now - ts_ext;
+        t = now;
     }
+    return t;
 }
 
 /**************************************************************************/
 /*!
-    Write data to the pipe
+    Write the file header. pcapng needs a section header and one interface
+    description, libpcap a single global header.
 */
 /**************************************************************************/
-size_t data_write(const void *ptr, size_t size)
+static void write_global_hdr(buf_t *b)
 {
-    ssize_t bytes = 0;
-    if (FD_pipe != -1) 
+    size_t start, name_len;
+
+    if (format == FORMAT_PCAP)
     {
-        bytes = write(FD_pipe, ptr, size);
+        buf_u32(b, 0xa1b2c3d4);     // magic number
+        buf_u16(b, 2);              // major version number
+        buf_u16(b, 4);              // minor version number
+        buf_u32(b, 0);              // GMT to local correction
+        buf_u32(b, 0);              // accuracy of timestamps
+        buf_u32(b, 65535);          // max length of captured packets, in octets
+        buf_u32(b, LINKTYPE_IEEE802_15_4_NOFCS);
+        return;
     }
+
+    // section header block
+    buf_u32(b, PCAPNG_SHB);
+    buf_u32(b, 28);
+    buf_u32(b, PCAPNG_BOM);
+    buf_u16(b, 1);                  // major version
+    buf_u16(b, 0);                  // minor version
+    buf_u32(b, 0xffffffff);         // section length unknown
+    buf_u32(b, 0xffffffff);
+    buf_u32(b, 28);
+
+    // interface description block, named after the serial port
+    start = b->len;
+    name_len = strlen(port_name);
+    buf_u32(b, PCAPNG_IDB);
+    buf_u32(b, 0);                  // block length, filled in below
+    buf_u16(b, LINKTYPE_IEEE802_15_4_TAP);
+    buf_u16(b, 0);
+    buf_u32(b, 0);                  // no snap length
+    buf_u16(b, PCAPNG_OPT_NAME);
+    buf_u16(b, name_len);
+    buf_append(b, port_name, name_len);
+    buf_pad32(b);
+    buf_u16(b, PCAPNG_OPT_END);
+    buf_u16(b, 0);
+    buf_u32(b, b->len - start + 4);
+    *(uint32_t *)(b->data + start + 4) = b->len - start;
 }
 
 /**************************************************************************/
 /*!
-    Write the global header to wireshark. This is only done once at the
-    beginning of the capture. 
+    Append a TAP TLV, padded to a multiple of 4 bytes.
 */
 /**************************************************************************/
-static void write_global_hdr()
+static void write_tlv(buf_t *b, uint16_t type, const void *value, uint16_t len)
 {
-    uint32_t magic_number = 0xa1b2c3d4; /* magic number */
-    uint16_t version_major = 2; /* major version number */
-    uint16_t version_minor = 4; /* minor version number */
-    int32_t thiszone = 0;       /* GMT to local correction */
-    uint32_t sigfigs = 0;       /* accuracy of timestamps */
-    uint32_t snaplen = 65535;   /* max length of captured packets, in octets */
-    uint32_t network = 195;     /* data link type (DLT) - IEEE 802.15.4 */
-
-    data_write(&magic_number, sizeof(magic_number));
-    data_write(&version_major, sizeof(version_major));
-    data_write(&version_minor, sizeof(version_minor));
-    data_write(&thiszone, sizeof(thiszone));
-    data_write(&sigfigs, sizeof(sigfigs));
-    data_write(&snaplen, sizeof(snaplen));
-    data_write(&network, sizeof(network));
+    buf_u16(b, type);
+    buf_u16(b, len);
+    buf_append(b, value, len);
+    buf_pad32(b);
 }
 
 /**************************************************************************/
 /*!
-    Write the frame header into wireshark. This is required for the libpcap
-    format and informs wireshark that a new frame is coming.
+    Convert one frame into a pcapng enhanced packet block or a libpcap
+    record.
 */
 /**************************************************************************/
-static void write_frame_hdr(uint8_t len)
+static void write_frame(buf_t *b, const frame_t *f)
 {
-    uint32_t ts_sec;    /* timestamp seconds */
-    uint32_t ts_usec;   /* timestamp microseconds */
-    uint32_t incl_len;  /* number of octets of packet saved in file */
-    uint32_t orig_len;  /* actual length of packet */
-    struct timeval tv;
+    uint64_t t = frame_time(f);
+    size_t start, tap, caplen;
+    uint8_t fcs_type, lqi;
+    uint32_t flags;
+    float rss;
 
-    gettimeofday(&tv, NULL);
-    ts_sec      = tv.tv_sec;
-    ts_usec     = tv.tv_usec;
-    incl_len    = len;
-    orig_len    = len + PACKET_FCS;
-
-    data_write(&ts_sec, sizeof(ts_sec));
-    data_write(&ts_usec, sizeof(ts_usec));
-    data_write(&incl_len, sizeof(incl_len));
-    data_write(&orig_len, sizeof(orig_len));
+    if (format == FORMAT_PCAP)
+    {
+        // actual frame length for wireshark should not include FCS
+        caplen = f->has_fcs ? f->len - PACKET_FCS : f->len;
+        buf_u32(b, t / 1000000);
+        buf_u32(b, t % 1000000);
+        buf_u32(b, caplen);
+        buf_u32(b, caplen);
+        buf_append(b, f->data, caplen);
+        return;
+    }
+
+    start = b->len;
+    buf_u32(b, PCAPNG_EPB);
+    buf_u32(b, 0);                  // block length, filled in below
+    buf_u32(b, 0);                  // interface id
+    buf_u32(b, t >> 32);
+    buf_u32(b, (uint32_t)t);
+    buf_u32(b, 0);                  // captured length, filled in below
+    buf_u32(b, 0);                  // original length, filled in below
+
+    // TAP header and TLVs
+    tap = b->len;
+    buf_u8(b, 0);                   // version
+    buf_u8(b, 0);
+    buf_u16(b, 0);                  // header length, filled in below
+    fcs_type = f->has_fcs ? TAP_FCS_16BIT : TAP_FCS_NONE;
+    write_tlv(b, TAP_FCS_TYPE, &fcs_type, 1);
+    if (f->has_meta)
+    {
+        rss = RSSI_BASE_DBM + RSSI_ED_STEP_DB * f->ed;
+        lqi = f->lqi;
+        write_tlv(b, TAP_RSS, &rss, sizeof(rss));
+        write_tlv(b, TAP_LQI, &lqi, 1);
+    }
+    *(uint16_t *)(b->data + tap + 2) = b->len - tap;
+
+    buf_append(b, f->data, f->len);
+    caplen = b->len - tap;
+    buf_pad32(b);
+
+    // flag frames that arrived with a bad FCS
+    flags = PCAPNG_FLAG_INBOUND;
+    if (f->has_meta && !f->crc)
+    {
+        flags |= PCAPNG_FLAG_CRCERR;
+    }
+    buf_u16(b, PCAPNG_OPT_FLAGS);
+    buf_u16(b, 4);
+    buf_u32(b, flags);
+    buf_u16(b, PCAPNG_OPT_END);
+    buf_u16(b, 0);
+    buf_u32(b, b->len - start + 4);
+
+    *(uint32_t *)(b->data + start + 4) = b->len - start;
+    *(uint32_t *)(b->data + start + 20) = caplen;
+    *(uint32_t *)(b->data + start + 24) = caplen;
 }
 
 /**************************************************************************/
 /*!
-    Write one frame into wireshark (via the pipe).
+    Convert all complete records at the start of buf and return the number
+    of bytes consumed.  Bytes that can't start a record are skipped so the
+    parser resynchronises after a corrupted record.
 */
 /**************************************************************************/
-static void write_frame(uint8_t frame_len)
+static size_t parse_records(const uint8_t *buf, size_t len)
 {
-    uint8_t i;
+    size_t pos = 0, need;
+    frame_t f;
+    uint8_t type;
 
-    // actual frame length for wireshark should not include FCS
-    frame_len -= PACKET_FCS;
+    while (pos < len)
+    {
+        type = buf[pos];
+        memset(&f, 0, sizeof(f));
 
-    // write header to inform WS that new frame has arrived
-    write_frame_hdr(frame_len);
+        if (type == RECORD_EXT)
+        {
+            if (pos + RECORD_EXT_HDR > len)
+            {
+                break;
+            }
+            f.len = buf[pos + 1];
+            if ((f.len < MIN_FRAME_LEN) || (f.len > MAX_FRAME_LEN))
+            {
+                stats.resyncs++;
+                pos++;
+                continue;
+            }
+            need = RECORD_EXT_HDR + f.len + RECORD_EXT_TRAILER;
+            if (pos + need > len)
+            {
+                break;
+            }
+            f.data = &buf[pos + RECORD_EXT_HDR];
+            f.has_fcs = 1;
+            f.has_meta = 1;
+            f.ed = f.data[f.len];
+            f.lqi = f.data[f.len + 1];
+            f.crc = f.data[f.len + 2] & RECORD_FLAG_CRC;
+            f.timestamp = f.data[f.len + 3] | (f.data[f.len + 4] << 8) |
+                          (f.data[f.len + 5] << 16) | ((uint32_t)f.data[f.len + 6] << 24);
+            stats.ext_frames++;
+            if (!f.crc)
+            {
+                stats.bad_fcs++;
+            }
+        }
+        else if ((type >= MIN_FRAME_LEN) && (type <= MAX_FRAME_LEN))
+        {
+            // the length byte is followed by the frame minus the last FCS
+            // byte. the first FCS byte is dropped as well.
+            need = type;
+            if (pos + need > len)
+            {
+                break;
+            }
+            f.data = &buf[pos + 1];
+            f.len = type - PACKET_FCS;
+        }
+        else
+        {
+            stats.resyncs++;
+            pos++;
+            continue;
+        }
 
-    // bump rd_idx. we don't want to write the length byte
-    rd_idx = (rd_idx + 1) % BUFSIZE;
+        if (verbose)
+        {
+            if (f.has_meta)
+            {
+                printf("len %3d  ed %3d  lqi %3d  fcs %s\n", f.len, f.ed, f.lqi, f.crc ? "ok" : "bad");
+            }
+            else
+            {
+                printf("len %3d\n", f.len);
+            }
+        }
 
-    // write frame into wireshark
-    for (i=0; i<frame_len; i++)
-    {
-        data_write(&circ_buf[rd_idx], 1);
-        rd_idx = (rd_idx + 1) % BUFSIZE;
+        write_frame(&out, &f);
+        stats.frames++;
+        pos += need;
     }
+    return pos;
+}
 
-    // bump rd_idx. we're not using the trailing FCS value
-    rd_idx = (rd_idx + 1) % BUFSIZE;
+/**************************************************************************/
+/*!
+    Open the serial port that we'll be communicating with the Freakduino (sniffer)
+    through. Anything that isn't a terminal (e.g. a recorded dump) is read
+    as is until its end.
+*/
+/**************************************************************************/
+static int serial_open(char *portname, speed_t baud)
+{
+    int FD_com; // file descriptor for the serial port
+    struct termios term;
+
+    FD_com = open(portname, O_RDONLY | O_NOCTTY | O_NONBLOCK);
+
+    if(FD_com == -1) // if open is unsucessful
+    {
+        printf("serial_open: Unable to open %s.\n", portname);
+    }
+    else if (isatty(FD_com))
+    {
+        // raw 8-bit data, no parity, 1 stop bit
+        tcgetattr(FD_com, &term);
+        cfmakeraw(&term);
+        cfsetspeed(&term, baud);
+        term.c_cflag &= ~CSTOPB;
+        term.c_cflag |= (CLOCAL | CREAD);
+        term.c_cc[VMIN] = 1;
+        term.c_cc[VTIME] = 0;
+        tcsetattr(FD_com, TCSANOW, &term);
+        tcflush(FD_com, TCIFLUSH);
+    }
+    return(FD_com);
 }
 
 /**************************************************************************/
 /*!
-    Calculate total number of bytes in buffer.
+    Create the named pipe that we will be communicating with wireshark
+    through, and connect to it if wireshark is listening.  Blocks until
+    wireshark connects if 'wait' is set.
 */
 /**************************************************************************/
-static uint16_t calc_bytes_in_buf()
+static void named_pipe_connect(uint8_t wait)
 {
-    if (rd_idx > wr_idx)
+    int rv, flags;
+
+    if (FD_pipe != -1)
     {
-        // read index is greater than write. we must have wrapped around
-        return (BUFSIZE - (rd_idx - wr_idx));
+        return;
     }
-    else
+
+    rv = mkfifo(pipe_name, 0666);
+    if ((rv == -1) && (errno != EEXIST))
+    {
+        perror("Error creating named pipe");
+        exit(1);
+    }
+
+    FD_pipe = open(pipe_name, O_WRONLY | (wait ? 0 : O_NONBLOCK));
+    if (FD_pipe == -1)
     {
-        return (wr_idx - rd_idx);
+        if (errno == ENXIO)
+        {
+            // nobody is reading the pipe yet
+            return;
+        }
+        perror("Error connecting to named pipe");
+        exit(1);
     }
+
+    // writes must never stall the serial port
+    flags = fcntl(FD_pipe, F_GETFL);
+    fcntl(FD_pipe, F_SETFL, flags | O_NONBLOCK);
+
+    pipe_out.len = 0;
+    write_global_hdr(&pipe_out);
+    printf("Client connected to pipe.\n");
 }
 
 /**************************************************************************/
 /*!
-    Deal with any received signals. This includes ctrl-C to stop the program.
+    Write as much of the queued output to the pipe as it will take.
 */
 /**************************************************************************/
-static void sig_int(int signo)
+static void pipe_flush()
 {
-    (void) signo;
-    if (FD_pipe != -1) 
+    ssize_t bytes;
+
+    if ((FD_pipe == -1) || !pipe_out.len)
+    {
+        return;
+    }
+
+    bytes = write(FD_pipe, pipe_out.data, pipe_out.len);
+    if (bytes > 0)
     {
-        printf("\nClosing pipe.\n");
+        memmove(pipe_out.data, pipe_out.data + bytes, pipe_out.len - bytes);
+        pipe_out.len -= bytes;
+    }
+    else if ((bytes == -1) && (errno != EAGAIN) && (errno != EINTR))
+    {
+        // wireshark went away
+        printf("Client disconnected from pipe.\n");
         close(FD_pipe);
+        FD_pipe = -1;
+        pipe_out.len = 0;
+
+        // without a capture file there's nothing left to do
+        if (FD_file == -1)
+        {
+            quit = 1;
+        }
     }
+}
 
-    if (FD_com != -1)
+/**************************************************************************/
+/*!
+    Hand the records converted from the last chunk to the outputs.
+*/
+/**************************************************************************/
+static void data_write(uint32_t frames)
+{
+    size_t done = 0;
+    ssize_t bytes;
+
+    if (!out.len)
     {
-        printf("\nClosing serial port.\n");
-        close(FD_com);
+        return;
     }
 
-    printf("\nSignal captured and devices shut down.\n");
+    while ((FD_file != -1) && (done < out.len))
+    {
+        if ((bytes = write(FD_file, out.data + done, out.len - done)) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            perror("Error writing capture file");
+            exit(1);
+        }
+        done += bytes;
+    }
 
-    exit(0);
+    if (FD_pipe != -1)
+    {
+        if (pipe_out.len + out.len <= PIPE_BACKLOG)
+        {
+            buf_append(&pipe_out, out.data, out.len);
+        }
+        else
+        {
+            stats.pipe_dropped += frames;
+        }
+        pipe_flush();
+    }
+    out.len = 0;
+}
+
+/**************************************************************************/
+/*!
+    Deal with any received signals. This includes ctrl-C to stop the program.
+*/
+/**************************************************************************/
+static void sig_int(int signo)
+{
+    (void) signo;
+    quit = 1;
 }
 
 /**************************************************************************/
 /*!
-    Init the signals we'll be checking for. 
+    Init the signals we'll be checking for.
 */
 /**************************************************************************/
 static void signal_init(void)
 {
-    signal(SIGINT, sig_int);
-    signal(SIGHUP, sig_int);
-    signal(SIGTERM, sig_int);
+    struct sigaction sa;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = sig_int;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGHUP, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    // a closed pipe is reported by write() instead
+    signal(SIGPIPE, SIG_IGN);
+}
+
+/**************************************************************************/
+/*!
+    Map a numeric baud rate to its termios constant.
+*/
+/**************************************************************************/
+static speed_t baud_parse(const char *s)
+{
+    switch (atoi(s))
+    {
+    case 9600:      return B9600;
+    case 19200:     return B19200;
+    case 38400:     return B38400;
+    case 57600:     return B57600;
+    case 115200:    return B115200;
+    case 230400:    return B230400;
+    case 460800:    return B460800;
+    case 921600:    return B921600;
+    default:
+        printf("Unsupported baud rate %s.\n", s);
+        exit(1);
+    }
+}
+
+static void usage()
+{
+    printf("Usage: wsbridge [options] <portname>\n"
+           "  -p pipe     named pipe for wireshark (default %s unless -w is given)\n"
+           "  -w file     also write the capture to a file\n"
+           "  -F format   pcapng (default) or pcap\n"
+           "  -b baud     serial port baud rate (default 115200)\n"
+           "  -v          print a line for every frame\n", PIPENAME);
+    exit(0);
 }
 
 /**************************************************************************/
@@ -294,126 +733,196 @@ static void signal_init(void)
 /**************************************************************************/
 int main(int argc, char *argv[])
 {
-    int nbytes;
-    uint8_t i;
+    char *file_name = NULL;
+    speed_t baud = BAUDRATE;
+    struct pollfd pfd[2];
+    ssize_t nbytes;
+    size_t used;
+    uint32_t frames;
+    int opt, nfds, timeout;
+    buf_t hdr = { 0 };
+
+    while ((opt = getopt(argc, argv, "p:w:F:b:vh")) != -1)
+    {
+        switch (opt)
+        {
+        case 'p':   pipe_name = optarg; break;
+        case 'w':   file_name = optarg; break;
+        case 'b':   baud = baud_parse(optarg); break;
+        case 'v':   verbose = 1; break;
+        case 'F':
+            if (!strcmp(optarg, "pcap"))
+            {
+                format = FORMAT_PCAP;
+            }
+            else if (strcmp(optarg, "pcapng"))
+            {
+                usage();
+            }
+            break;
+        default:
+            usage();
+        }
+    }
+
+    // make sure the COM port is specified
+    if (optind != argc - 1)
+    {
+        usage();
+    }
+    port_name = argv[optind];
+    if (!file_name && !pipe_name)
+    {
+        pipe_name = PIPENAME;
+    }
 
     // capture any signals that will terminate program
     signal_init();
 
-    // make sure the COM port is specified
-    if (argc == 2) 
+    // open the COM port
+    if ((FD_com = serial_open(port_name, baud)) == -1)
+    {
+        printf("Serial port not opened.\n");
+        return 0;
+    }
+    printf("Serial port connected.\n");
+
+    if (file_name)
     {
-        // open the COM port
-        if ((FD_com = serial_open(argv[1])) == -1)
+        if ((FD_file = open(file_name, O_WRONLY | O_CREAT | O_TRUNC, 0666)) == -1)
         {
-            printf("Serial port not opened.\n");
-            return 0;
+            perror(file_name);
+            return 1;
         }
-        else
+        write_global_hdr(&hdr);
+        if (write(FD_file, hdr.data, hdr.len) != (ssize_t)hdr.len)
         {
-            printf("Serial port connected. Waiting for wireshark connection.\n");
-            printf("Open wireshark and connect to local interface: %s\n", PIPENAME);
+            perror(file_name);
+            return 1;
         }
+        printf("Writing capture to %s.\n", file_name);
     }
-    else
-    {
-        printf("Usage: wsbridge <portname>.\n");
-        return 0;
-    }
-
-
-    // create and open pipe for wireshark
-    named_pipe_create(PIPENAME);
 
-    // wait for wireshark to connect to pipe. Once wireshark
-    // connects, then the global header will be written to it.
-    if (FD_pipe != -1)
+    if (pipe_name)
     {
-        write_global_hdr();
-        printf("Client connected to pipe.\n");
+        // without a capture file there's no point starting before
+        // wireshark is listening
+        printf("Open wireshark and connect to local interface: %s\n", pipe_name);
+        if (!file_name)
+        {
+            printf("Waiting for wireshark connection.\n");
+        }
+        named_pipe_connect(!file_name);
     }
 
-    for (;;) 
+    while (!quit)
     {
-        uint16_t bytes_in_buf;
-        uint8_t frame_len, byte_ctr;
+        pfd[0].fd = FD_com;
+        pfd[0].events = POLLIN;
+        pfd[0].revents = 0;
+        nfds = 1;
+        if ((FD_pipe != -1) && pipe_out.len)
+        {
+            pfd[1].fd = FD_pipe;
+            pfd[1].events = POLLOUT;
+            pfd[1].revents = 0;
+            nfds = 2;
+        }
+        timeout = (pipe_name && (FD_pipe == -1)) ? CONNECT_POLL_MS : -1;
 
-        // wait for data to come in on the serial port
-        if ((nbytes = read(FD_com, port_buf, PORTBUFSIZE)) > 0)
+        if (poll(pfd, nfds, timeout) < 0)
         {
-            // write data to circular buffer. loop through all received bytes
-            for (i=0; i<nbytes; i++)
+            if (errno == EINTR)
             {
-                switch (state)
-                {
-                    case START_CAPTURE:
-                        // new frame starting
-                        len = port_buf[i];
-                        byte_ctr = 0;
-
-                        printf("Len = %02X.\n", len);
-
-                        circ_buf[wr_idx] = len;
-                        wr_idx = (wr_idx + 1) % BUFSIZE;
-                        state = PACKET_CAPTURE;
-                        break;
-
-
-                    case PACKET_CAPTURE:
-                        // continue capturing bytes until end of frame
-
-                        // write data to circular buffer and increment index
-                        circ_buf[wr_idx] = port_buf[i];
-                        
-                        printf("%02X ", circ_buf[wr_idx]);
-
-                        wr_idx = (wr_idx + 1) % BUFSIZE;
-
-                        // track number of received bytes. when received bytes
-                        // equals frame length, then restart state machine and 
-                        // write bytes to wireshark
-                        byte_ctr++;
-                        if (byte_ctr == (len - 1))
-                        {
-                            state = START_CAPTURE;
-                            file_write = 1;
-                            printf("\n");
-                        }
-                        break;
-                }
-                fflush(stdout);
+                continue;
             }
+            perror("poll");
+            break;
+        }
 
-            // at least one frame has been written. loop through circular buffer 
-            // and write out all completed frames
-            while (file_write)
+        if (pfd[0].revents)
+        {
+            nbytes = read(FD_com, ser_buf + ser_len, SERBUFSIZE - ser_len);
+            if (nbytes == 0)
             {
-                // capture frame length and check buffer to see if one or more frames 
-                // are available.
-                frame_len = circ_buf[rd_idx];
-                bytes_in_buf = calc_bytes_in_buf();
-            
-                if (bytes_in_buf > frame_len)
-                {
-                    // if more than one frame is available, then write one frame to 
-                    // wireshark and then see if any more are available.
-                    write_frame(frame_len);
-                }
-                else if (bytes_in_buf == frame_len)
+                // end of a recorded dump, or the device went away
+                break;
+            }
+            if (nbytes < 0)
+            {
+                if ((errno != EAGAIN) && (errno != EINTR))
                 {
-                    // only one frame is available. write to wireshark and then quit
-                    // the loop
-                    write_frame(frame_len);
-                    file_write = 0;
+                    perror("Error reading serial port");
+                    break;
                 }
-                else
+            }
+            else
+            {
+                stats.bytes_in += nbytes;
+                ser_len += nbytes;
+
+                // convert every complete record in one go and keep the
+                // partial one for the next chunk
+                frames = stats.frames;
+                used = parse_records(ser_buf, ser_len);
+                memmove(ser_buf, ser_buf + used, ser_len - used);
+                ser_len -= used;
+                data_write(stats.frames - frames);
+                if (verbose)
                 {
-                    // less than one frame is available. quit the loop and collect more 
-                    // bytes. we normally should not get here.
-                    file_write = 0;
+                    fflush(stdout);
                 }
             }
         }
+
+        if (nfds == 2 && pfd[1].revents)
+        {
+            pipe_flush();
+        }
+
+        if (pipe_name && (FD_pipe == -1) && !quit)
+        {
+            named_pipe_connect(0);
+        }
+    }
+
+    // give wireshark what's still queued, within reason
+    while ((FD_pipe != -1) && pipe_out.len)
+    {
+        pfd[0].fd = FD_pipe;
+        pfd[0].events = POLLOUT;
+        if (poll(pfd, 1, 1000) <= 0)
+        {
+            break;
+        }
+        pipe_flush();
+    }
+
+    printf("\n%u frames (%u extended, %u with bad FCS), %llu bytes read, %u resyncs",
+           stats.frames, stats.ext_frames, stats.bad_fcs, (unsigned long long)stats.bytes_in, stats.resyncs);
+    if (pipe_name)
+    {
+        printf(", %u frames dropped at the pipe", stats.pipe_dropped);
+    }
+    printf(".\n");
+
+    if (FD_pipe != -1)
+    {
+        printf("Closing pipe.\n");
+        close(FD_pipe);
+    }
+
+    if (FD_file != -1)
+    {
+        printf("Closing capture file.\n");
+        close(FD_file);
+    }
+
+    if (FD_com != -1)
+    {
+        printf("Closing serial port.\n");
+        close(FD_com);
     }
-}
 
+    return 0;
+}